@@ -0,0 +1,829 @@
+/* clu_bench_e2e.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <math.h>
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_optargs.h>
+#include <wolfclu/benchmark/clu_bench.h>
+#include <wolfclu/sign-verify/clu_sign_verify_setup.h>
+#include <wolfssl/wolfcrypt/signature.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+
+#if !defined(USE_WINDOWS_API)
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#define WOLFCLU_E2E_PATH_SZ 512
+
+/* password and iteration count used by the enc and dec stages, the same as
+ * running "wolfssl enc -aes-256-cbc -pbkdf2 -k ..." */
+#define WOLFCLU_E2E_PWD  "wolfclu e2e benchmark"
+#define WOLFCLU_E2E_ITER 10000
+
+/* "Salted__" and the salt written at the start of an encrypted file */
+#define WOLFCLU_E2E_SALT_HDR 16
+
+/* room for an encrypted file header and padding past the largest file */
+#define WOLFCLU_E2E_EXTRA 64
+
+/* largest signature read back by the verify stage */
+#define WOLFCLU_E2E_SIG_SZ 512
+
+#if defined(HAVE_ECC) && defined(WOLFSSL_KEY_GEN) && !defined(NO_SHA256)
+    #define WOLFCLU_E2E_DGST
+#endif
+
+typedef struct WOLFCLU_E2E_CTX {
+    char    dir[WOLFCLU_E2E_PATH_SZ];     /* corpus directory */
+    char    keyPath[WOLFCLU_E2E_PATH_SZ]; /* PEM private key for dgst */
+    char    pubPath[WOLFCLU_E2E_PATH_SZ]; /* PEM public key for dgst */
+    char    scratch[WOLFCLU_E2E_PATH_SZ]; /* used to time output writes */
+    word32* sizes;      /* size of each file in the corpus */
+    int     files;
+    byte*   buf;        /* contents of the file being processed */
+    byte*   out;        /* output of the crypto only runs */
+    word32  bufSz;
+    byte    sig[WOLFCLU_E2E_SIG_SZ];
+    word32  sigSz;
+    WC_RNG  rng;
+#ifdef WOLFCLU_E2E_DGST
+    ecc_key ecc;
+    int     eccInit;
+#endif
+} WOLFCLU_E2E_CTX;
+
+/* one command run over every file in the corpus
+ *
+ * cmd runs the real command entry point on the file at 'base'
+ * kernel runs only the cryptographic work on the file contents in buf
+ */
+typedef struct WOLFCLU_E2E_STAGE {
+    const char* name;
+    const char* inExt;  /* suffix of the file the command reads */
+    const char* outExt; /* suffix of the file the command writes, or NULL */
+    const char* sigExt; /* suffix of a signature also read, or NULL */
+    int (*cmd)(WOLFCLU_E2E_CTX* e2e, const char* base);
+    int (*kernel)(WOLFCLU_E2E_CTX* e2e, const byte* in, word32 inSz);
+} WOLFCLU_E2E_STAGE;
+
+/* time spent in a stage, all in nanoseconds */
+typedef struct WOLFCLU_E2E_TIMES {
+    word64 files;
+    word64 bytes;
+    word64 cmdNs;   /* the real command */
+    word64 ioNs;    /* reading its input and writing its output */
+    word64 cryptoNs;/* the cryptographic work alone */
+} WOLFCLU_E2E_TIMES;
+
+
+/* fills path with base followed by ext */
+static int wolfCLU_E2EPath(char* path, const char* base, const char* ext)
+{
+    int ret = XSNPRINTF(path, WOLFCLU_E2E_PATH_SZ, "%s%s", base,
+            (ext != NULL)? ext : "");
+
+    return (ret > 0 && ret < WOLFCLU_E2E_PATH_SZ)? WOLFCLU_SUCCESS :
+        BUFFER_E;
+}
+
+
+/* reads the whole of path into buf, returns the size read or a negative
+ * value on error */
+static int wolfCLU_E2ERead(const char* path, byte* buf, word32 bufSz)
+{
+    XFILE  f;
+    size_t sz;
+
+    f = XFOPEN(path, "rb");
+    if (f == XBADFILE) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    sz = XFREAD(buf, 1, bufSz, f);
+    XFCLOSE(f);
+    return (int)sz;
+}
+
+
+/* writes sz bytes of buf to path, returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_E2EWrite(const char* path, const byte* buf, word32 sz)
+{
+    XFILE f;
+    int   ret = WOLFCLU_SUCCESS;
+
+    f = XFOPEN(path, "wb");
+    if (f == XBADFILE) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (sz > 0 && XFWRITE(buf, 1, sz, f) != sz) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    XFCLOSE(f);
+    return ret;
+}
+
+
+/* returns the size of the file at path, or a negative value on error */
+static long wolfCLU_E2EFileSz(const char* path)
+{
+    XFILE f;
+    long  sz = WOLFCLU_FATAL_ERROR;
+
+    f = XFOPEN(path, "rb");
+    if (f == XBADFILE) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (XFSEEK(f, 0, XSEEK_END) == 0) {
+        sz = XFTELL(f);
+    }
+    XFCLOSE(f);
+    return sz;
+}
+
+
+#ifndef NO_SHA256
+/* wolfssl -hash sha256 -in <file> -out <file>.sha256 */
+static int wolfCLU_E2EHashCmd(WOLFCLU_E2E_CTX* e2e, const char* base)
+{
+    char out[WOLFCLU_E2E_PATH_SZ];
+    WOLFSSL_BIO* bioIn;
+    WOLFSSL_BIO* bioOut;
+    int ret;
+
+    (void)e2e;
+    if (wolfCLU_E2EPath(out, base, ".sha256") != WOLFCLU_SUCCESS) {
+        return BUFFER_E;
+    }
+    bioIn  = wolfSSL_BIO_new_file(base, "rb");
+    bioOut = wolfSSL_BIO_new_file(out, "wb");
+    if (bioIn == NULL || bioOut == NULL) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    else {
+        ret = wolfCLU_hash(bioIn, bioOut, "sha256", WC_SHA256_DIGEST_SIZE);
+    }
+    wolfSSL_BIO_free(bioIn);
+    wolfSSL_BIO_free(bioOut);
+    return ret;
+}
+
+
+static int wolfCLU_E2EHashKernel(WOLFCLU_E2E_CTX* e2e, const byte* in,
+        word32 inSz)
+{
+    return (wc_Sha256Hash(in, inSz, e2e->out) == 0)? WOLFCLU_SUCCESS :
+        WOLFCLU_FATAL_ERROR;
+}
+#endif /* !NO_SHA256 */
+
+
+#if !defined(NO_AES) && !defined(NO_SHA256)
+/* wolfssl enc -aes-256-cbc -pbkdf2 [-d] -in <in> -out <out> -k <pwd> */
+static int wolfCLU_E2ECrypt(const char* in, const char* out, int enc)
+{
+    byte pwd[AES_256_KEY_SIZE + AES_BLOCK_SIZE + 1];
+    byte key[AES_256_KEY_SIZE];
+    byte iv[AES_BLOCK_SIZE];
+    char inPath[WOLFCLU_E2E_PATH_SZ];
+    char outPath[WOLFCLU_E2E_PATH_SZ];
+    int  ret;
+
+    /* the password buffer is overwritten with the derived key and iv */
+    XMEMSET(pwd, 0, sizeof(pwd));
+    XSTRNCPY((char*)pwd, WOLFCLU_E2E_PWD, sizeof(pwd) - 1);
+    XSTRNCPY(inPath, in, sizeof(inPath) - 1);
+    inPath[sizeof(inPath) - 1] = '\0';
+    XSTRNCPY(outPath, out, sizeof(outPath) - 1);
+    outPath[sizeof(outPath) - 1] = '\0';
+
+    ret = wolfCLU_evp_crypto(wolfSSL_EVP_aes_256_cbc(), (char*)"cbc", pwd,
+            key, AES_256_KEY_SIZE, inPath, outPath, NULL, iv, 0, enc,
+            WOLFCLU_PBKDF2, wolfSSL_EVP_sha256(), 0, 0, 0, WOLFCLU_E2E_ITER,
+            0);
+    wolfCLU_ForceZero(pwd, sizeof(pwd));
+    wolfCLU_ForceZero(key, sizeof(key));
+    return ret;
+}
+
+
+static int wolfCLU_E2EEncCmd(WOLFCLU_E2E_CTX* e2e, const char* base)
+{
+    char out[WOLFCLU_E2E_PATH_SZ];
+
+    (void)e2e;
+    if (wolfCLU_E2EPath(out, base, ".enc") != WOLFCLU_SUCCESS) {
+        return BUFFER_E;
+    }
+    return wolfCLU_E2ECrypt(base, out, 1);
+}
+
+
+static int wolfCLU_E2EDecCmd(WOLFCLU_E2E_CTX* e2e, const char* base)
+{
+    char in[WOLFCLU_E2E_PATH_SZ];
+    char out[WOLFCLU_E2E_PATH_SZ];
+
+    (void)e2e;
+    if (wolfCLU_E2EPath(in, base, ".enc") != WOLFCLU_SUCCESS ||
+            wolfCLU_E2EPath(out, base, ".dec") != WOLFCLU_SUCCESS) {
+        return BUFFER_E;
+    }
+    return wolfCLU_E2ECrypt(in, out, 0);
+}
+
+
+/* the key derivation and cipher work of enc or dec on a buffer */
+static int wolfCLU_E2ECryptKernel(WOLFCLU_E2E_CTX* e2e, const byte* in,
+        word32 inSz, int enc)
+{
+    WOLFSSL_EVP_CIPHER_CTX* ctx;
+    byte derived[AES_256_KEY_SIZE + AES_BLOCK_SIZE];
+    byte salt[WOLFCLU_E2E_SALT_HDR / 2];
+    int  outSz = 0;
+    int  finalSz = 0;
+    int  ret = WOLFCLU_SUCCESS;
+
+    if (enc) {
+        if (wc_RNG_GenerateBlock(&e2e->rng, salt, sizeof(salt)) != 0) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+    else {
+        /* salt is after "Salted__", the rest of the file is ciphertext */
+        if (inSz < WOLFCLU_E2E_SALT_HDR) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+        XMEMCPY(salt, in + sizeof(salt), sizeof(salt));
+        in   += WOLFCLU_E2E_SALT_HDR;
+        inSz -= WOLFCLU_E2E_SALT_HDR;
+    }
+
+    if (wolfSSL_PKCS5_PBKDF2_HMAC(WOLFCLU_E2E_PWD,
+                (int)XSTRLEN(WOLFCLU_E2E_PWD), salt, sizeof(salt),
+                WOLFCLU_E2E_ITER, wolfSSL_EVP_sha256(), sizeof(derived),
+                derived) != WOLFSSL_SUCCESS) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    ctx = wolfSSL_EVP_CIPHER_CTX_new();
+    if (ctx == NULL) {
+        ret = MEMORY_E;
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        wolfSSL_EVP_CIPHER_CTX_init(ctx);
+        if (wolfSSL_EVP_CipherInit(ctx, wolfSSL_EVP_aes_256_cbc(), derived,
+                    derived + AES_256_KEY_SIZE, enc) != WOLFSSL_SUCCESS ||
+            wolfSSL_EVP_CipherUpdate(ctx, e2e->out, &outSz, in, (int)inSz)
+                    != WOLFSSL_SUCCESS ||
+            wolfSSL_EVP_CipherFinal(ctx, e2e->out + outSz, &finalSz)
+                    != WOLFSSL_SUCCESS) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+    wolfSSL_EVP_CIPHER_CTX_free(ctx);
+    wolfCLU_ForceZero(derived, sizeof(derived));
+    return ret;
+}
+
+
+static int wolfCLU_E2EEncKernel(WOLFCLU_E2E_CTX* e2e, const byte* in,
+        word32 inSz)
+{
+    return wolfCLU_E2ECryptKernel(e2e, in, inSz, 1);
+}
+
+
+static int wolfCLU_E2EDecKernel(WOLFCLU_E2E_CTX* e2e, const byte* in,
+        word32 inSz)
+{
+    return wolfCLU_E2ECryptKernel(e2e, in, inSz, 0);
+}
+#endif /* !NO_AES && !NO_SHA256 */
+
+
+#ifdef WOLFCLU_E2E_DGST
+/* wolfssl dgst -sha256 -sign <key> -out <file>.sig <file> */
+static int wolfCLU_E2ESignCmd(WOLFCLU_E2E_CTX* e2e, const char* base)
+{
+    char  sig[WOLFCLU_E2E_PATH_SZ];
+    char  data[WOLFCLU_E2E_PATH_SZ];
+    char* argv[8];
+
+    if (wolfCLU_E2EPath(sig, base, ".sig") != WOLFCLU_SUCCESS ||
+            wolfCLU_E2EPath(data, base, NULL) != WOLFCLU_SUCCESS) {
+        return BUFFER_E;
+    }
+    argv[0] = (char*)"wolfssl";
+    argv[1] = (char*)"dgst";
+    argv[2] = (char*)"-sha256";
+    argv[3] = (char*)"-sign";
+    argv[4] = e2e->keyPath;
+    argv[5] = (char*)"-out";
+    argv[6] = sig;
+    argv[7] = data;
+    return wolfCLU_dgst_setup(8, argv);
+}
+
+
+/* wolfssl dgst -sha256 -verify <pub> -signature <file>.sig <file> */
+static int wolfCLU_E2EVerifyCmd(WOLFCLU_E2E_CTX* e2e, const char* base)
+{
+    char  sig[WOLFCLU_E2E_PATH_SZ];
+    char  data[WOLFCLU_E2E_PATH_SZ];
+    char* argv[8];
+
+    if (wolfCLU_E2EPath(sig, base, ".sig") != WOLFCLU_SUCCESS ||
+            wolfCLU_E2EPath(data, base, NULL) != WOLFCLU_SUCCESS) {
+        return BUFFER_E;
+    }
+    argv[0] = (char*)"wolfssl";
+    argv[1] = (char*)"dgst";
+    argv[2] = (char*)"-sha256";
+    argv[3] = (char*)"-verify";
+    argv[4] = e2e->pubPath;
+    argv[5] = (char*)"-signature";
+    argv[6] = sig;
+    argv[7] = data;
+    return wolfCLU_dgst_setup(8, argv);
+}
+
+
+static int wolfCLU_E2ESignKernel(WOLFCLU_E2E_CTX* e2e, const byte* in,
+        word32 inSz)
+{
+    word32 sigSz = WOLFCLU_E2E_SIG_SZ;
+
+    return (wc_SignatureGenerate(WC_HASH_TYPE_SHA256, WC_SIGNATURE_TYPE_ECC,
+                in, inSz, e2e->out, &sigSz, &e2e->ecc, sizeof(e2e->ecc),
+                &e2e->rng) == 0)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+static int wolfCLU_E2EVerifyKernel(WOLFCLU_E2E_CTX* e2e, const byte* in,
+        word32 inSz)
+{
+    return (wc_SignatureVerify(WC_HASH_TYPE_SHA256, WC_SIGNATURE_TYPE_ECC,
+                in, inSz, e2e->sig, e2e->sigSz, &e2e->ecc, sizeof(e2e->ecc))
+            == 0)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+/* writes der to path as PEM of the given type */
+static int wolfCLU_E2EWritePem(const char* path, const byte* der,
+        word32 derSz, int type)
+{
+    byte* pem;
+    int   pemSz;
+    int   ret = WOLFCLU_SUCCESS;
+
+    pemSz = wc_DerToPem(der, derSz, NULL, 0, type);
+    if (pemSz <= 0) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    pem = (byte*)XMALLOC(pemSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (pem == NULL) {
+        return MEMORY_E;
+    }
+    pemSz = wc_DerToPem(der, derSz, pem, pemSz, type);
+    if (pemSz <= 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_E2EWrite(path, pem, (word32)pemSz);
+    }
+    XFREE(pem, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+
+/* makes the P-256 key pair used by the dgst stages and writes it out */
+static int wolfCLU_E2EMakeKey(WOLFCLU_E2E_CTX* e2e)
+{
+    byte der[256];
+    int  derSz;
+    int  ret = WOLFCLU_SUCCESS;
+
+    if (wc_ecc_init(&e2e->ecc) != 0) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    e2e->eccInit = 1;
+
+    if (wc_ecc_make_key(&e2e->rng, 32, &e2e->ecc) != 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        derSz = wc_EccKeyToDer(&e2e->ecc, der, sizeof(der));
+        if (derSz <= 0 || wolfCLU_E2EWritePem(e2e->keyPath, der,
+                    (word32)derSz, ECC_PRIVATEKEY_TYPE) != WOLFCLU_SUCCESS) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        derSz = wc_EccPublicKeyToDer(&e2e->ecc, der, sizeof(der), 1);
+        if (derSz <= 0 || wolfCLU_E2EWritePem(e2e->pubPath, der,
+                    (word32)derSz, PUBLICKEY_TYPE) != WOLFCLU_SUCCESS) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+    wolfCLU_ForceZero(der, sizeof(der));
+
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to create the dgst test key");
+    }
+    return ret;
+}
+#endif /* WOLFCLU_E2E_DGST */
+
+
+/* stages run in order, dec reads the output of enc and verify reads the
+ * output of sign */
+static const WOLFCLU_E2E_STAGE e2eStages[] = {
+#ifndef NO_SHA256
+    { "hash sha256", "", ".sha256", NULL,
+        wolfCLU_E2EHashCmd, wolfCLU_E2EHashKernel },
+#endif
+#if !defined(NO_AES) && !defined(NO_SHA256)
+    { "enc aes-256-cbc", "", ".enc", NULL,
+        wolfCLU_E2EEncCmd, wolfCLU_E2EEncKernel },
+    { "dec aes-256-cbc", ".enc", ".dec", NULL,
+        wolfCLU_E2EDecCmd, wolfCLU_E2EDecKernel },
+#endif
+#ifdef WOLFCLU_E2E_DGST
+    { "dgst -sign", "", ".sig", NULL,
+        wolfCLU_E2ESignCmd, wolfCLU_E2ESignKernel },
+    { "dgst -verify", "", NULL, ".sig",
+        wolfCLU_E2EVerifyCmd, wolfCLU_E2EVerifyKernel },
+#endif
+    { NULL, NULL, NULL, NULL, NULL, NULL }
+};
+
+/* suffixes of every file written next to a corpus file */
+static const char* e2eOutExts[] = {
+    ".sha256", ".enc", ".dec", ".sig", NULL
+};
+
+
+/* picks the size of each file, spread evenly on a log scale between the
+ * minimum and maximum or cycling through a list of sizes */
+static void wolfCLU_E2ESizes(const WOLFCLU_BENCH_OPTS* opts, word32* sizes,
+        int files)
+{
+    double minSz, maxSz;
+    int i;
+
+    for (i = 0; i < files; i++) {
+        if (!opts->fileSzRange) {
+            sizes[i] = opts->fileSz[i % opts->fileSzCount];
+        }
+        else if (files == 1) {
+            sizes[i] = opts->fileSz[0];
+        }
+        else {
+            minSz = log((double)opts->fileSz[0]);
+            maxSz = log((double)opts->fileSz[1]);
+            sizes[i] = (word32)(exp(minSz + (maxSz - minSz) * i /
+                        (files - 1)) + 0.5);
+        }
+    }
+}
+
+
+/* returns the directory used when -dir is not given, tmpfs if available
+ * so the run measures the commands and not the disk */
+static const char* wolfCLU_E2EDefaultDir(void)
+{
+#if !defined(USE_WINDOWS_API)
+    if (access("/dev/shm", W_OK) == 0) {
+        return "/dev/shm";
+    }
+#endif
+    return ".";
+}
+
+
+/* creates a new empty directory for the corpus under parent */
+static int wolfCLU_E2EMakeDir(WOLFCLU_E2E_CTX* e2e, const char* parent)
+{
+#if !defined(USE_WINDOWS_API)
+    int ret = XSNPRINTF(e2e->dir, sizeof(e2e->dir), "%s/wolfclu-e2e-XXXXXX",
+            parent);
+
+    if (ret <= 0 || ret >= (int)sizeof(e2e->dir) - 16) {
+        return BUFFER_E;
+    }
+    if (mkdtemp(e2e->dir) == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to create a directory in %s", parent);
+        e2e->dir[0] = '\0';
+        return WOLFCLU_FATAL_ERROR;
+    }
+    return WOLFCLU_SUCCESS;
+#else
+    (void)e2e;
+    (void)parent;
+    WOLFCLU_LOG(WOLFCLU_E0, "-e2e is not supported on this platform");
+    return NOT_COMPILED_IN;
+#endif
+}
+
+
+/* removes every file written by the run and the corpus directory */
+static void wolfCLU_E2ERemove(WOLFCLU_E2E_CTX* e2e)
+{
+#if !defined(USE_WINDOWS_API)
+    char base[WOLFCLU_E2E_PATH_SZ];
+    char path[WOLFCLU_E2E_PATH_SZ];
+    int i, j;
+
+    if (e2e->dir[0] == '\0') {
+        return;
+    }
+    for (i = 0; i < e2e->files; i++) {
+        XSNPRINTF(base, sizeof(base), "%s/f%06d", e2e->dir, i);
+        unlink(base);
+        for (j = 0; e2eOutExts[j] != NULL; j++) {
+            if (wolfCLU_E2EPath(path, base, e2eOutExts[j]) ==
+                    WOLFCLU_SUCCESS) {
+                unlink(path);
+            }
+        }
+    }
+    unlink(e2e->keyPath);
+    unlink(e2e->pubPath);
+    unlink(e2e->scratch);
+    rmdir(e2e->dir);
+#else
+    (void)e2e;
+#endif
+}
+
+
+/* writes the corpus files filled with random data */
+static int wolfCLU_E2ECorpus(WOLFCLU_E2E_CTX* e2e)
+{
+    char   base[WOLFCLU_E2E_PATH_SZ];
+    word64 total = 0;
+    word64 start;
+    double sec;
+    int    i;
+    int    ret = WOLFCLU_SUCCESS;
+
+    start = wolfCLU_TimerNs();
+    for (i = 0; i < e2e->files && ret == WOLFCLU_SUCCESS; i++) {
+        XSNPRINTF(base, sizeof(base), "%s/f%06d", e2e->dir, i);
+        if (wolfCLU_RandGenerate(&e2e->rng, e2e->buf, e2e->sizes[i])
+                != WOLFCLU_SUCCESS ||
+            wolfCLU_E2EWrite(base, e2e->buf, e2e->sizes[i])
+                != WOLFCLU_SUCCESS) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to write corpus file %s", base);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        total += e2e->sizes[i];
+    }
+    sec = (double)(wolfCLU_TimerNs() - start) / 1000000000.0;
+
+    if (ret == WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Corpus of %d files, %llu bytes, written in "
+                "%.3f seconds", e2e->files, (unsigned long long)total, sec);
+        WOLFCLU_LOG(WOLFCLU_L0, "in %s", e2e->dir);
+        WOLFCLU_LOG(WOLFCLU_L0, " ");
+    }
+    return ret;
+}
+
+
+/* runs the command, the I/O and the crypto only work of one stage on one
+ * file, adding the time taken by each to t */
+static int wolfCLU_E2EFile(WOLFCLU_E2E_CTX* e2e,
+        const WOLFCLU_E2E_STAGE* stage, int idx, WOLFCLU_E2E_TIMES* t)
+{
+    char   base[WOLFCLU_E2E_PATH_SZ];
+    char   path[WOLFCLU_E2E_PATH_SZ];
+    word64 t0, t1, t2, t3;
+    long   outSz = 0;
+    int    inSz;
+    int    ret;
+
+    XSNPRINTF(base, sizeof(base), "%s/f%06d", e2e->dir, idx);
+
+    /* the real command, with its normal messages turned off */
+    wolfCLU_OutputOFF();
+    t0  = wolfCLU_TimerNs();
+    ret = stage->cmd(e2e, base);
+    t1  = wolfCLU_TimerNs();
+    wolfCLU_OutputON();
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "%s failed on %s", stage->name, base);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (stage->outExt != NULL) {
+        if (wolfCLU_E2EPath(path, base, stage->outExt) != WOLFCLU_SUCCESS) {
+            return BUFFER_E;
+        }
+        outSz = wolfCLU_E2EFileSz(path);
+        if (outSz < 0 || outSz > (long)e2e->bufSz) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    /* the same file reads and writes done outside of the command */
+    if (wolfCLU_E2EPath(path, base, stage->inExt) != WOLFCLU_SUCCESS) {
+        return BUFFER_E;
+    }
+    t2 = wolfCLU_TimerNs();
+    inSz = wolfCLU_E2ERead(path, e2e->buf, e2e->bufSz);
+    if (inSz >= 0 && stage->sigExt != NULL) {
+        if (wolfCLU_E2EPath(path, base, stage->sigExt) != WOLFCLU_SUCCESS) {
+            return BUFFER_E;
+        }
+        ret = wolfCLU_E2ERead(path, e2e->sig, sizeof(e2e->sig));
+        e2e->sigSz = (ret > 0)? (word32)ret : 0;
+    }
+    if (inSz >= 0 && outSz > 0) {
+        ret = wolfCLU_E2EWrite(e2e->scratch, e2e->buf, (word32)outSz);
+    }
+    t3 = wolfCLU_TimerNs();
+    if (inSz < 0 || ret < 0) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    /* the crypto alone on data already in memory */
+    ret = stage->kernel(e2e, e2e->buf, (word32)inSz);
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "%s crypto only run failed", stage->name);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    t->files++;
+    t->bytes    += (word64)inSz;
+    t->cmdNs    += t1 - t0;
+    t->ioNs     += t3 - t2;
+    t->cryptoNs += wolfCLU_TimerNs() - t3;
+    return WOLFCLU_SUCCESS;
+}
+
+
+static void wolfCLU_E2EReport(const WOLFCLU_E2E_STAGE* stage,
+        const WOLFCLU_E2E_TIMES* t)
+{
+    double sec   = (double)t->cmdNs / 1000000000.0;
+    double io    = (double)t->ioNs;
+    double cr    = (double)t->cryptoNs;
+    double other = (double)t->cmdNs - io - cr;
+    double total = (double)t->cmdNs;
+
+    if (t->files == 0 || total <= 0.0) {
+        return;
+    }
+    /* what is left of the command time after the I/O and crypto is the
+     * parsing, formatting and set up done by the command, the I/O and
+     * crypto are timed on their own so with page cache effects they can
+     * add up to more than the command took */
+    if (other < 0.0) {
+        other = 0.0;
+        total = io + cr;
+    }
+
+    WOLFCLU_LOG(WOLFCLU_L0, "%-16s took %7.3f seconds, files = %llu",
+            stage->name, sec, (unsigned long long)t->files);
+    WOLFCLU_LOG(WOLFCLU_L0, "Files/s = %10.1f, MB/s = %8.1f",
+            (double)t->files / sec, (double)t->bytes / sec / MEGABYTE);
+    WOLFCLU_LOG(WOLFCLU_L0, "Per file: I/O %9.3f ms, crypto %9.3f ms",
+            io / t->files / 1000000.0, cr / t->files / 1000000.0);
+    WOLFCLU_LOG(WOLFCLU_L0, "          other %7.3f ms (parsing, formatting)",
+            other / t->files / 1000000.0);
+    WOLFCLU_LOG(WOLFCLU_L0, "Stages: I/O %5.1f%%, crypto %5.1f%%, other %5.1f%%",
+            100.0 * io / total, 100.0 * cr / total, 100.0 * other / total);
+    WOLFCLU_LOG(WOLFCLU_L0, " ");
+}
+
+
+/* runs one stage over the corpus, repeating whole passes until opts->timer
+ * seconds have gone by */
+static int wolfCLU_E2EStage(WOLFCLU_E2E_CTX* e2e,
+        const WOLFCLU_E2E_STAGE* stage, const WOLFCLU_BENCH_OPTS* opts)
+{
+    WOLFCLU_E2E_TIMES t;
+    word64 limit = (word64)opts->timer * 1000000000ULL;
+    word64 start;
+    int i;
+    int ret = WOLFCLU_SUCCESS;
+
+    XMEMSET(&t, 0, sizeof(t));
+    start = wolfCLU_TimerNs();
+    do {
+        for (i = 0; i < e2e->files && ret == WOLFCLU_SUCCESS; i++) {
+            ret = wolfCLU_E2EFile(e2e, stage, i, &t);
+        }
+    } while (ret == WOLFCLU_SUCCESS && wolfCLU_TimerNs() - start < limit);
+
+    if (ret == WOLFCLU_SUCCESS) {
+        wolfCLU_E2EReport(stage, &t);
+    }
+    return ret;
+}
+
+
+int wolfCLU_benchE2E(const WOLFCLU_BENCH_OPTS* opts)
+{
+    WOLFCLU_E2E_CTX e2e;
+    word32 maxSz = 0;
+    int i;
+    int rngInit = 0;
+    int ret = WOLFCLU_SUCCESS;
+
+    if (opts == NULL || opts->e2eFiles <= 0 || opts->fileSzCount <= 0) {
+        return BAD_FUNC_ARG;
+    }
+
+    XMEMSET(&e2e, 0, sizeof(e2e));
+    e2e.files = opts->e2eFiles;
+    e2e.sizes = (word32*)XMALLOC(sizeof(word32) * e2e.files, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (e2e.sizes == NULL) {
+        return MEMORY_E;
+    }
+    wolfCLU_E2ESizes(opts, e2e.sizes, e2e.files);
+    for (i = 0; i < e2e.files; i++) {
+        maxSz = (e2e.sizes[i] > maxSz)? e2e.sizes[i] : maxSz;
+    }
+
+    e2e.bufSz = maxSz + WOLFCLU_E2E_EXTRA;
+    e2e.buf = (byte*)XMALLOC(e2e.bufSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    e2e.out = (byte*)XMALLOC(e2e.bufSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (e2e.buf == NULL || e2e.out == NULL) {
+        ret = MEMORY_E;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        if (wc_InitRng(&e2e.rng) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to initialize RNG");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            rngInit = 1;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_E2EMakeDir(&e2e, (opts->e2eDir != NULL)?
+                opts->e2eDir : wolfCLU_E2EDefaultDir());
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        XSNPRINTF(e2e.keyPath, sizeof(e2e.keyPath), "%s/key.pem", e2e.dir);
+        XSNPRINTF(e2e.pubPath, sizeof(e2e.pubPath), "%s/pub.pem", e2e.dir);
+        XSNPRINTF(e2e.scratch, sizeof(e2e.scratch), "%s/scratch", e2e.dir);
+        ret = wolfCLU_E2ECorpus(&e2e);
+    }
+#ifdef WOLFCLU_E2E_DGST
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_E2EMakeKey(&e2e);
+    }
+#endif
+
+    for (i = 0; e2eStages[i].name != NULL && ret == WOLFCLU_SUCCESS; i++) {
+        ret = wolfCLU_E2EStage(&e2e, &e2eStages[i], opts);
+    }
+
+    if (opts->e2eKeep && e2e.dir[0] != '\0') {
+        WOLFCLU_LOG(WOLFCLU_L0, "Corpus kept in %s", e2e.dir);
+    }
+    else {
+        wolfCLU_E2ERemove(&e2e);
+    }
+
+#ifdef WOLFCLU_E2E_DGST
+    if (e2e.eccInit) {
+        wc_ecc_free(&e2e.ecc);
+    }
+#endif
+    if (rngInit) {
+        wc_FreeRng(&e2e.rng);
+    }
+    if (e2e.buf != NULL) {
+        XMEMSET(e2e.buf, 0, e2e.bufSz);
+    }
+    wolfCLU_freeBins(e2e.buf, e2e.out, (byte*)e2e.sizes, NULL, NULL);
+    return ret;
+}
@@ -0,0 +1,277 @@
+/* clu_bench_latency.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <math.h>
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/benchmark/clu_bench.h>
+
+/* two sided 95% Student's t values for 1 to 30 degrees of freedom */
+static const double tValues[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+     2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+     2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+
+/* returns the position of the highest set bit, v must not be 0 */
+static WC_INLINE int wolfCLU_HistMsb(word64 v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int msb = 0;
+
+    while (v >>= 1) {
+        msb++;
+    }
+    return msb;
+#endif
+}
+
+
+/* values below WOLFCLU_HIST_SUB_COUNT get their own bucket, above that each
+ * power of two is split into WOLFCLU_HIST_SUB_COUNT linear buckets */
+static WC_INLINE int wolfCLU_HistIndex(word64 v)
+{
+    int shift;
+
+    if (v < WOLFCLU_HIST_SUB_COUNT) {
+        return (int)v;
+    }
+    shift = wolfCLU_HistMsb(v) - WOLFCLU_HIST_SUB_BITS;
+    return (shift + 1) * WOLFCLU_HIST_SUB_COUNT +
+        (int)((v >> shift) - WOLFCLU_HIST_SUB_COUNT);
+}
+
+
+/* returns the largest value that falls into bucket idx */
+static word64 wolfCLU_HistValue(int idx)
+{
+    int    shift;
+    word64 top;
+
+    if (idx < WOLFCLU_HIST_SUB_COUNT) {
+        return (word64)idx;
+    }
+    shift = idx / WOLFCLU_HIST_SUB_COUNT - 1;
+    top   = (word64)(idx % WOLFCLU_HIST_SUB_COUNT + WOLFCLU_HIST_SUB_COUNT);
+    return ((top + 1) << shift) - 1;
+}
+
+
+void wolfCLU_HistInit(WOLFCLU_BENCH_HIST* hist)
+{
+    if (hist != NULL) {
+        XMEMSET(hist, 0, sizeof(WOLFCLU_BENCH_HIST));
+        hist->min = (word64)-1;
+    }
+}
+
+
+void wolfCLU_HistRecord(WOLFCLU_BENCH_HIST* hist, word64 value)
+{
+    double v = (double)value;
+
+    hist->counts[wolfCLU_HistIndex(value)]++;
+    hist->total++;
+    hist->sum   += v;
+    hist->sumSq += v * v;
+    if (value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+
+void wolfCLU_HistMerge(WOLFCLU_BENCH_HIST* dst, const WOLFCLU_BENCH_HIST* src)
+{
+    int i;
+
+    if (dst == NULL || src == NULL || src->total == 0) {
+        return;
+    }
+
+    for (i = 0; i < WOLFCLU_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->sum   += src->sum;
+    dst->sumSq += src->sumSq;
+    if (src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+
+word64 wolfCLU_HistPercentile(const WOLFCLU_BENCH_HIST* hist, double pct)
+{
+    word64 target;
+    word64 seen = 0;
+    word64 value;
+    int i;
+
+    if (hist == NULL || hist->total == 0) {
+        return 0;
+    }
+    if (pct <= 0.0) {
+        return hist->min;
+    }
+
+    target = (word64)ceil((pct / 100.0) * (double)hist->total);
+    if (target == 0) {
+        target = 1;
+    }
+
+    for (i = 0; i < WOLFCLU_HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= target) {
+            value = wolfCLU_HistValue(i);
+            return (value > hist->max)? hist->max : value;
+        }
+    }
+    return hist->max;
+}
+
+
+/* returns WOLFCLU_SUCCESS on success */
+int wolfCLU_benchLatency(wolfCLU_BenchOp op, void* ctx, int timer,
+        int warmup, WOLFCLU_BENCH_HIST* hist)
+{
+    word64 limit;
+    word64 start, t0, t1;
+    int i;
+
+    if (op == NULL || hist == NULL || timer <= 0) {
+        return BAD_FUNC_ARG;
+    }
+    wolfCLU_TimerInit();
+
+    for (i = 0; i < warmup; i++) {
+        if (op(ctx) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Benchmark operation failed");
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    /* the run length is checked against the time stamp already taken after
+     * each operation so no extra clock reads are needed */
+    limit = (word64)(((double)timer * 1000000000.0) /
+            wolfCLU_TimerTicksToNs(1.0));
+    start = wolfCLU_TimerTicks();
+    do {
+        t0 = wolfCLU_TimerTicks();
+        if (op(ctx) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Benchmark operation failed");
+            return WOLFCLU_FATAL_ERROR;
+        }
+        t1 = wolfCLU_TimerTicks();
+        wolfCLU_HistRecord(hist, t1 - t0);
+    } while (t1 - start < limit);
+
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* converts ticks to microseconds for printing */
+static double wolfCLU_TicksToUs(double ticks)
+{
+    return wolfCLU_TimerTicksToNs(ticks) / 1000.0;
+}
+
+
+/* returns the half width of the 95% confidence interval of the mean of v */
+static double wolfCLU_ConfInterval(const double* v, int n, double* mean)
+{
+    double sum = 0.0;
+    double var = 0.0;
+    double t;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        sum += v[i];
+    }
+    *mean = sum / n;
+
+    if (n < 2) {
+        return 0.0;
+    }
+    for (i = 0; i < n; i++) {
+        var += (v[i] - *mean) * (v[i] - *mean);
+    }
+    var /= (n - 1);
+
+    t = (n - 1 <= (int)(sizeof(tValues) / sizeof(tValues[0])))?
+        tValues[n - 2] : 1.960;
+    return t * sqrt(var / n);
+}
+
+
+void wolfCLU_benchLatencyReport(const char* name,
+        const WOLFCLU_BENCH_HIST* hist, const double* runMeans,
+        const double* runP99s, int reps, int warmup)
+{
+    double mean;
+    double var;
+    double ciMean, ciP99;
+    double avgMean, avgP99;
+
+    if (name == NULL || hist == NULL || hist->total == 0) {
+        return;
+    }
+
+    mean = hist->sum / (double)hist->total;
+    var  = hist->sumSq / (double)hist->total - mean * mean;
+    if (var < 0.0) {
+        var = 0.0; /* rounding error on near constant values */
+    }
+
+    WOLFCLU_LOG(WOLFCLU_L0, "%s latency: %llu ops in %d run(s)", name,
+            (unsigned long long)hist->total, reps);
+    WOLFCLU_LOG(WOLFCLU_L0, "(%d warm-up ops per run not counted)", warmup);
+    WOLFCLU_LOG(WOLFCLU_L0, "min  = %10.3f us  p50   = %10.3f us",
+            wolfCLU_TicksToUs((double)hist->min),
+            wolfCLU_TicksToUs((double)wolfCLU_HistPercentile(hist, 50.0)));
+    WOLFCLU_LOG(WOLFCLU_L0, "p90  = %10.3f us  p99   = %10.3f us",
+            wolfCLU_TicksToUs((double)wolfCLU_HistPercentile(hist, 90.0)),
+            wolfCLU_TicksToUs((double)wolfCLU_HistPercentile(hist, 99.0)));
+    WOLFCLU_LOG(WOLFCLU_L0, "p99.9= %10.3f us  max   = %10.3f us",
+            wolfCLU_TicksToUs((double)wolfCLU_HistPercentile(hist, 99.9)),
+            wolfCLU_TicksToUs((double)hist->max));
+    WOLFCLU_LOG(WOLFCLU_L0, "mean = %10.3f us  stddev= %10.3f us",
+            wolfCLU_TicksToUs(mean), wolfCLU_TicksToUs(sqrt(var)));
+
+    if (reps > 1 && runMeans != NULL && runP99s != NULL) {
+        ciMean = wolfCLU_ConfInterval(runMeans, reps, &avgMean);
+        ciP99  = wolfCLU_ConfInterval(runP99s, reps, &avgP99);
+        WOLFCLU_LOG(WOLFCLU_L0, "95%% CI mean = %.3f +/- %.3f us",
+                wolfCLU_TicksToUs(avgMean), wolfCLU_TicksToUs(ciMean));
+        WOLFCLU_LOG(WOLFCLU_L0, "95%% CI p99  = %.3f +/- %.3f us",
+                wolfCLU_TicksToUs(avgP99), wolfCLU_TicksToUs(ciP99));
+    }
+    WOLFCLU_LOG(WOLFCLU_L0, " ");
+}
@@ -0,0 +1,271 @@
+/* clu_bench_perf.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/benchmark/clu_bench.h>
+
+#if defined(__linux__)
+    #include <errno.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <linux/perf_event.h>
+    #if defined(SYS_perf_event_open) || defined(__NR_perf_event_open)
+        #define WOLFCLU_HAVE_PERF
+    #endif
+#endif
+
+#ifdef WOLFCLU_HAVE_PERF
+#ifndef SYS_perf_event_open
+    #define SYS_perf_event_open __NR_perf_event_open
+#endif
+
+/* type and config of each counter, in the order of WOLFCLU_PERF_* */
+static const struct {
+    word32 type;
+    word64 config;
+} perfEvents[WOLFCLU_PERF_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+/* opens one counter for this thread on any CPU, returns -1 on failure */
+static int wolfCLU_PerfOpenEvent(word32 type, word64 config)
+{
+    struct perf_event_attr attr;
+
+    XMEMSET(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = type;
+    attr.config         = config;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    /* counters may be multiplexed, read the times to scale the counts */
+    attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                          PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif /* WOLFCLU_HAVE_PERF */
+
+
+/* returns WOLFCLU_SUCCESS if at least the cycle and instruction counters
+ * could be opened */
+int wolfCLU_PerfOpen(WOLFCLU_BENCH_PERF* perf)
+{
+#ifdef WOLFCLU_HAVE_PERF
+    int i;
+    int err = 0;
+
+    if (perf == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    XMEMSET(perf, 0, sizeof(WOLFCLU_BENCH_PERF));
+
+    for (i = 0; i < WOLFCLU_PERF_COUNT; i++) {
+        perf->fd[i] = wolfCLU_PerfOpenEvent(perfEvents[i].type,
+                perfEvents[i].config);
+        if (perf->fd[i] < 0 && err == 0) {
+            err = errno;
+        }
+    }
+
+    if (perf->fd[WOLFCLU_PERF_CYCLES] < 0 ||
+            perf->fd[WOLFCLU_PERF_INSTR] < 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Hardware counters unavailable: %s",
+                strerror(err));
+        if (err == EACCES || err == EPERM) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Check "
+                    "/proc/sys/kernel/perf_event_paranoid or CAP_PERFMON");
+        }
+        WOLFCLU_LOG(WOLFCLU_E0, "Running without -perf");
+        wolfCLU_PerfClose(perf);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    for (i = 0; i < WOLFCLU_PERF_COUNT; i++) {
+        if (perf->fd[i] < 0) {
+            WOLFCLU_LOG(WOLFCLU_L0, "Counter %s is not supported here",
+                    wolfCLU_PerfName(i));
+        }
+    }
+    perf->enabled = 1;
+    return WOLFCLU_SUCCESS;
+#else
+    if (perf != NULL) {
+        XMEMSET(perf, 0, sizeof(WOLFCLU_BENCH_PERF));
+    }
+    WOLFCLU_LOG(WOLFCLU_E0, "Hardware counters need Linux perf_event_open");
+    WOLFCLU_LOG(WOLFCLU_E0, "Running without -perf");
+    return WOLFCLU_FATAL_ERROR;
+#endif
+}
+
+
+void wolfCLU_PerfClose(WOLFCLU_BENCH_PERF* perf)
+{
+#ifdef WOLFCLU_HAVE_PERF
+    int i;
+
+    if (perf == NULL) {
+        return;
+    }
+    for (i = 0; i < WOLFCLU_PERF_COUNT; i++) {
+        if (perf->fd[i] >= 0) {
+            close(perf->fd[i]);
+        }
+        perf->fd[i] = -1;
+    }
+#endif
+    if (perf != NULL) {
+        perf->enabled = 0;
+    }
+}
+
+
+void wolfCLU_PerfStart(WOLFCLU_BENCH_PERF* perf)
+{
+#ifdef WOLFCLU_HAVE_PERF
+    int i;
+
+    if (perf == NULL || !perf->enabled) {
+        return;
+    }
+    for (i = 0; i < WOLFCLU_PERF_COUNT; i++) {
+        if (perf->fd[i] >= 0) {
+            ioctl(perf->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)perf;
+#endif
+}
+
+
+void wolfCLU_PerfStop(WOLFCLU_BENCH_PERF* perf)
+{
+#ifdef WOLFCLU_HAVE_PERF
+    int i;
+    word64 val[3]; /* count, time enabled, time running */
+
+    if (perf == NULL || !perf->enabled) {
+        return;
+    }
+    for (i = 0; i < WOLFCLU_PERF_COUNT; i++) {
+        if (perf->fd[i] >= 0) {
+            ioctl(perf->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (i = 0; i < WOLFCLU_PERF_COUNT; i++) {
+        perf->counts[i] = 0;
+        perf->valid[i]  = 0;
+        if (perf->fd[i] < 0 ||
+                read(perf->fd[i], val, sizeof(val)) != (ssize_t)sizeof(val) ||
+                val[2] == 0) {
+            continue;
+        }
+        perf->counts[i] = (val[2] < val[1])?
+            (word64)((double)val[0] * ((double)val[1] / (double)val[2])) :
+            val[0];
+        perf->valid[i] = 1;
+    }
+#else
+    (void)perf;
+#endif
+}
+
+
+const char* wolfCLU_PerfName(int idx)
+{
+    switch (idx) {
+        case WOLFCLU_PERF_CYCLES:
+            return "cycles";
+        case WOLFCLU_PERF_INSTR:
+            return "instructions";
+        case WOLFCLU_PERF_L1D_MISS:
+            return "L1d-misses";
+        case WOLFCLU_PERF_LLC_MISS:
+            return "LLC-misses";
+        case WOLFCLU_PERF_BR_MISS:
+            return "branch-misses";
+        default:
+            return "unknown";
+    }
+}
+
+
+/* formats a miss count per KB processed, or per operation when no bytes
+ * were processed */
+static void wolfCLU_PerfPer(const WOLFCLU_BENCH_PERF* perf, int idx,
+        const WOLFCLU_BENCH_RESULT* res, char* buf, int bufSz)
+{
+    double div;
+
+    if (!perf->valid[idx]) {
+        XSNPRINTF(buf, bufSz, "%s", "-");
+        return;
+    }
+    div = (res->bytes > 0)? (double)res->bytes / 1024.0 : (double)res->ops;
+    XSNPRINTF(buf, bufSz, "%.2f", (div > 0.0)?
+            (double)perf->counts[idx] / div : 0.0);
+}
+
+
+void wolfCLU_PerfReport(const WOLFCLU_BENCH_PERF* perf, const char* label,
+        const WOLFCLU_BENCH_RESULT* res)
+{
+    char   l1[24];
+    char   llc[24];
+    char   br[24];
+    double ipc = 0.0;
+    double ghz = 0.0;
+
+    if (perf == NULL || !perf->enabled || res == NULL || res->ops == 0) {
+        return;
+    }
+
+    if (perf->valid[WOLFCLU_PERF_CYCLES] && perf->counts[WOLFCLU_PERF_CYCLES]) {
+        ipc = (double)perf->counts[WOLFCLU_PERF_INSTR] /
+              (double)perf->counts[WOLFCLU_PERF_CYCLES];
+        if (res->ns > 0) {
+            /* core cycles per ns shows frequency scaling, unlike the TSC */
+            ghz = (double)perf->counts[WOLFCLU_PERF_CYCLES] / (double)res->ns;
+        }
+    }
+    wolfCLU_PerfPer(perf, WOLFCLU_PERF_L1D_MISS, res, l1, sizeof(l1));
+    wolfCLU_PerfPer(perf, WOLFCLU_PERF_LLC_MISS, res, llc, sizeof(llc));
+    wolfCLU_PerfPer(perf, WOLFCLU_PERF_BR_MISS, res, br, sizeof(br));
+
+    WOLFCLU_LOG(WOLFCLU_L0, "%sIPC = %.2f, core clock = %.2f GHz",
+            (label != NULL)? label : "", ipc, ghz);
+    WOLFCLU_LOG(WOLFCLU_L0, "%smisses per %s: L1d %s, LLC %s, branch %s",
+            (label != NULL)? label : "", (res->bytes > 0)? "KB" : "op",
+            l1, llc, br);
+}
@@ -20,53 +20,105 @@
  */
 
 #include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/benchmark/clu_bench.h>
+
+#define MAX_BENCH_REPS 100
+
+/* default AEAD sweep, TLS record sized messages with and without a TLS 1.2
+ * sized AAD */
+static const word32 defaultMsgSz[] = { 16, 256, 1024, 16384 };
+static const word32 defaultAadSz[] = { 0, 13 };
+
+
+/* parses a comma separated list of sizes such as "16,256,1024"
+ * returns the number of sizes found or a negative value on error */
+static int wolfCLU_benchParseSizes(const char* in, word32* sizes, int max,
+        int allowZero, long maxSz)
+{
+    int  count = 0;
+    long val;
+    char* end;
+
+    while (in != NULL && *in != '\0') {
+        if (count >= max) {
+            return USER_INPUT_ERROR;
+        }
+        val = strtol(in, &end, 10);
+        if (end == in || val < (allowZero? 0 : 1) ||
+                val > maxSz) {
+            return USER_INPUT_ERROR;
+        }
+        sizes[count++] = (word32)val;
+        in = (*end == ',')? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return USER_INPUT_ERROR;
+        }
+    }
+    return count;
+}
+
+
+/* parses the -filesz argument, either "<min>-<max>" for sizes spread on a
+ * log scale or a comma separated list of sizes
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_benchParseFileSz(const char* in, WOLFCLU_BENCH_OPTS* opts)
+{
+    const char* dash = XSTRSTR(in, "-");
+    char* end;
+    long  minSz, maxSz;
+    int   ret;
+
+    if (dash != NULL) {
+        minSz = strtol(in, &end, 10);
+        if (end != dash) {
+            return USER_INPUT_ERROR;
+        }
+        maxSz = strtol(dash + 1, &end, 10);
+        if (*end != '\0' || minSz < 1 || maxSz < minSz ||
+                maxSz > WOLFCLU_BENCH_MAX_FILE_SZ) {
+            return USER_INPUT_ERROR;
+        }
+        opts->fileSz[0]   = (word32)minSz;
+        opts->fileSz[1]   = (word32)maxSz;
+        opts->fileSzCount = 2;
+        opts->fileSzRange = 1;
+        return WOLFCLU_SUCCESS;
+    }
+
+    ret = wolfCLU_benchParseSizes(in, opts->fileSz, WOLFCLU_BENCH_MAX_SIZES,
+            0, WOLFCLU_BENCH_MAX_FILE_SZ);
+    if (ret <= 0) {
+        return USER_INPUT_ERROR;
+    }
+    opts->fileSzCount = ret;
+    opts->fileSzRange = 0;
+    return WOLFCLU_SUCCESS;
+}
+
 
 int wolfCLU_benchSetup(int argc, char** argv)
 {
     int     ret     =   0;          /* return variable */
     int     time    =   3;          /* timer variable */
-    int     i, j    =   0;          /* second loop variable */
-    const char* algs[]  = {         /* list of acceptable algorithms */
-#ifndef NO_AES
-        "aes-cbc",
-#endif
-#ifdef WOLFSSL_AES_COUNTER
-        "aes-ctr",
-#endif
-#ifndef NO_DES3
-        "3des",
-#endif
-#ifdef HAVE_CAMELLIA
-        "camellia",
-#endif
-#ifndef NO_MD5
-        "md5",
-#endif
-#ifndef NO_SHA
-        "sha",
-#endif
-#ifndef NO_SHA256
-        "sha256",
-#endif
-#ifdef WOLFSSL_SHA384
-        "sha384",
-#endif
-#ifdef WOLFSSL_SHA512
-        "sha512",
-#endif
-#ifdef HAVE_BLAKE2
-        "blake2b",
-#endif
-        NULL /* terminal argument (also stops us from having an empty list) */
-    };
-    size_t algsSz = sizeof(algs) / sizeof(algs[0]) - 1; /* -1 to ignore NULL */
-
-    /* acceptable options */
-    int option[sizeof(algs) / sizeof(algs[0])] = {0};
-
     /* acceptable option check */
     int optionCheck = 0;
 
+    WOLFCLU_BENCH_OPTS opts;
+
+    XMEMSET(&opts, 0, sizeof(opts));
+    opts.warmup = WOLFCLU_BENCH_WARMUP;
+    opts.reps   = 1;
+    opts.msgSzCount = (int)(sizeof(defaultMsgSz) / sizeof(defaultMsgSz[0]));
+    XMEMCPY(opts.msgSz, defaultMsgSz, sizeof(defaultMsgSz));
+    opts.aadSzCount = (int)(sizeof(defaultAadSz) / sizeof(defaultAadSz[0]));
+    XMEMCPY(opts.aadSz, defaultAadSz, sizeof(defaultAadSz));
+    opts.e2eFiles    = WOLFCLU_BENCH_E2E_FILES;
+    opts.fileSz[0]   = WOLFCLU_BENCH_E2E_MIN_SZ;
+    opts.fileSz[1]   = WOLFCLU_BENCH_E2E_MAX_SZ;
+    opts.fileSzCount = 2;
+    opts.fileSzRange = 1;
+
     ret = wolfCLU_checkForArg("-help", 5, argc, argv);
     if (ret > 0) {
             wolfCLU_benchHelp();
@@ -84,21 +136,143 @@ int wolfCLU_benchSetup(int argc, char** argv)
         }
     }
 
+    ret = wolfCLU_checkForArg("-latency", 8, argc, argv);
+    if (ret > 0) {
+        opts.latency = 1;
+    }
+
+    ret = wolfCLU_checkForArg("-perf", 5, argc, argv);
+    if (ret > 0) {
+        opts.perf = 1;
+    }
+
+    ret = wolfCLU_checkForArg("-warmup", 7, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        /* untimed operations before each latency run */
+        opts.warmup = XATOI(argv[ret+1]);
+        if (opts.warmup < 0) {
+            printf("Invalid warm-up count, using default of %d.\n",
+                    WOLFCLU_BENCH_WARMUP);
+            opts.warmup = WOLFCLU_BENCH_WARMUP;
+        }
+    }
+
+    ret = wolfCLU_checkForArg("-reps", 5, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        /* number of latency runs used for the confidence intervals */
+        opts.reps = XATOI(argv[ret+1]);
+        if (opts.reps < 1 || opts.reps > MAX_BENCH_REPS) {
+            printf("Invalid repetition count, must be between 1-%d. Using"
+                    " default of one.\n", MAX_BENCH_REPS);
+            opts.reps = 1;
+        }
+    }
+
+    ret = wolfCLU_checkForArg("-msgsz", 6, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        /* AEAD message sizes to sweep over */
+        ret = wolfCLU_benchParseSizes(argv[ret+1], opts.msgSz,
+                WOLFCLU_BENCH_MAX_SIZES, 0, WOLFCLU_BENCH_MAX_SWEEP_SZ);
+        if (ret <= 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Invalid -msgsz list, expecting up to %d"
+                    " comma separated sizes", WOLFCLU_BENCH_MAX_SIZES);
+            return USER_INPUT_ERROR;
+        }
+        opts.msgSzCount = ret;
+    }
+
+    ret = wolfCLU_checkForArg("-aadsz", 6, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        /* AEAD additional authenticated data sizes to sweep over */
+        ret = wolfCLU_benchParseSizes(argv[ret+1], opts.aadSz,
+                WOLFCLU_BENCH_MAX_SIZES, 1, WOLFCLU_BENCH_MAX_SWEEP_SZ);
+        if (ret <= 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Invalid -aadsz list, expecting up to %d"
+                    " comma separated sizes", WOLFCLU_BENCH_MAX_SIZES);
+            return USER_INPUT_ERROR;
+        }
+        opts.aadSzCount = ret;
+    }
+
+    ret = wolfCLU_checkForArg("-e2e", 4, argc, argv);
+    if (ret > 0) {
+        opts.e2e = 1;
+    }
+
+    ret = wolfCLU_checkForArg("-files", 6, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        /* number of files in the -e2e corpus */
+        opts.e2eFiles = XATOI(argv[ret+1]);
+        if (opts.e2eFiles < 1 ||
+                opts.e2eFiles > WOLFCLU_BENCH_E2E_MAX_FILES) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Invalid -files, must be between 1-%d",
+                    WOLFCLU_BENCH_E2E_MAX_FILES);
+            return USER_INPUT_ERROR;
+        }
+    }
+
+    ret = wolfCLU_checkForArg("-filesz", 7, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        if (wolfCLU_benchParseFileSz(argv[ret+1], &opts) != WOLFCLU_SUCCESS) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Invalid -filesz, expecting <min>-<max> "
+                    "or a list of sizes");
+            return USER_INPUT_ERROR;
+        }
+    }
+
+    ret = wolfCLU_checkForArg("-dir", 4, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        /* put the corpus on disk, or any other file system, instead */
+        opts.e2eDir = argv[ret+1];
+    }
+
+    ret = wolfCLU_checkForArg("-keep", 5, argc, argv);
+    if (ret > 0) {
+        opts.e2eKeep = 1;
+    }
+
+    ret = wolfCLU_checkForArg("-tls", 4, argc, argv);
+    if (ret > 0) {
+        opts.tls = 1;
+    }
+
+    ret = wolfCLU_checkForArg("-suite", 6, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        /* only run the TLS cipher suites with this in their name */
+        opts.tlsSuite = argv[ret+1];
+    }
+
+    ret = wolfCLU_checkForArg("-group", 6, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        /* only run the TLS key exchange groups with this in their name */
+        opts.tlsGroup = argv[ret+1];
+    }
+
     ret = wolfCLU_checkForArg("-all", 4, argc, argv);
     if (ret > 0) {
         /* perform all available tests */
-        for (j = 0; j < (int)algsSz; j++) {
-            option[j] = 1;
-            optionCheck = 1;
-        }
+        opts.all = 1;
     }
 
     /* pull as many of the algorithms out of the argv as posible */
-    for (i = 0; i < (int)algsSz; ++i) {
-        ret = wolfCLU_checkForArg(algs[i], (int)XSTRLEN(algs[i]), argc, argv);
-        if (ret > 0) {
-            option[i] = 1;
-            optionCheck = 1;
+    optionCheck = (wolfCLU_benchSelected(&opts, argc, argv) > 0);
+
+    if (opts.e2e) {
+        opts.timer = time;
+        printf("\nRunning commands over files for %d second(s) each\n\n",
+                time);
+        ret = wolfCLU_benchE2E(&opts);
+        if (ret != WOLFCLU_SUCCESS || (optionCheck != 1 && !opts.tls)) {
+            return ret;
+        }
+    }
+
+    if (opts.tls) {
+        opts.timer = time;
+        printf("\nRunning in-memory TLS for %d second(s) each\n\n", time);
+        ret = wolfCLU_benchTls(&opts);
+        if (ret != WOLFCLU_SUCCESS || optionCheck != 1) {
+            return ret;
         }
     }
 
@@ -108,8 +282,15 @@ int wolfCLU_benchSetup(int argc, char** argv)
     }
     else {
         /* benchmarking function */
-        printf("\nTesting for %d second(s)\n", time);
-        ret = wolfCLU_benchmark(time, option);
+        opts.timer = time;
+        if (opts.latency && opts.reps > 1) {
+            printf("\nTesting for %d run(s) of %d second(s)\n", opts.reps,
+                    time);
+        }
+        else {
+            printf("\nTesting for %d second(s)\n", time);
+        }
+        ret = wolfCLU_benchmark(&opts, argc, argv);
     }
     return ret;
 }
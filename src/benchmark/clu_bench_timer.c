@@ -0,0 +1,241 @@
+/* clu_bench_timer.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <time.h>
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/benchmark/clu_bench.h>
+
+#ifndef SINGLE_THREADED
+    #include <pthread.h>
+#endif
+
+/* prefer the raw monotonic clock, it is not slewed by NTP adjustments */
+#if defined(CLOCK_MONOTONIC_RAW)
+    #define WOLFCLU_CLOCK CLOCK_MONOTONIC_RAW
+#elif defined(CLOCK_MONOTONIC)
+    #define WOLFCLU_CLOCK CLOCK_MONOTONIC
+#endif
+
+/* time spent calibrating the cycle counter, in nanoseconds */
+#define WOLFCLU_CALIBRATE_NS 50000000
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define WOLFCLU_HAVE_CYCLES
+#endif
+
+/* set once by wolfCLU_TimerCalibrate and only read after, bench can run on
+ * several threads at once when used from libwolfclu */
+static int    haveCycles   = 0;
+static double cyclesPerNs  = 0.0;
+#ifndef SINGLE_THREADED
+static pthread_once_t timerOnce = PTHREAD_ONCE_INIT;
+#else
+static int    timerInit    = 0;
+#endif
+
+
+#ifdef WOLFCLU_HAVE_CYCLES
+/* reads the time stamp counter */
+static WC_INLINE word64 wolfCLU_ReadCycles(void)
+{
+    unsigned int lo, hi;
+
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((word64)hi << 32) | lo;
+}
+#endif
+
+
+word64 wolfCLU_TimerNs(void)
+{
+#ifdef WOLFCLU_CLOCK
+    struct timespec ts;
+
+    if (clock_gettime(WOLFCLU_CLOCK, &ts) == 0) {
+        return (word64)ts.tv_sec * 1000000000ULL + (word64)ts.tv_nsec;
+    }
+#endif
+    {
+        struct timeval tv;
+
+        gettimeofday(&tv, 0);
+        return (word64)tv.tv_sec * 1000000000ULL + (word64)tv.tv_usec * 1000;
+    }
+}
+
+
+word64 wolfCLU_TimerCycles(void)
+{
+#ifdef WOLFCLU_HAVE_CYCLES
+    if (haveCycles) {
+        return wolfCLU_ReadCycles();
+    }
+#endif
+    return 0;
+}
+
+
+word64 wolfCLU_TimerTicks(void)
+{
+#ifdef WOLFCLU_HAVE_CYCLES
+    if (haveCycles) {
+        return wolfCLU_ReadCycles();
+    }
+#endif
+    return wolfCLU_TimerNs();
+}
+
+
+double wolfCLU_TimerTicksToNs(double ticks)
+{
+    if (haveCycles) {
+        return ticks / cyclesPerNs;
+    }
+    return ticks;
+}
+
+
+int wolfCLU_TimerHasCycles(void)
+{
+    return haveCycles;
+}
+
+
+static void wolfCLU_TimerCalibrate(void)
+{
+#ifdef WOLFCLU_HAVE_CYCLES
+    word64 startNs, endNs;
+    word64 startCyc, endCyc;
+
+    /* spin on the monotonic clock for a short period and compare against the
+     * counter to find the counter frequency */
+    startCyc = wolfCLU_ReadCycles();
+    startNs  = wolfCLU_TimerNs();
+    do {
+        endNs = wolfCLU_TimerNs();
+    } while (endNs - startNs < WOLFCLU_CALIBRATE_NS);
+    endCyc = wolfCLU_ReadCycles();
+
+    if (endCyc > startCyc) {
+        cyclesPerNs = (double)(endCyc - startCyc) / (double)(endNs - startNs);
+        haveCycles  = 1;
+        WOLFCLU_LOG(WOLFCLU_L0, "Cycle counter calibrated at %.0f MHz",
+                cyclesPerNs * 1000.0);
+    }
+#endif
+}
+
+
+void wolfCLU_TimerInit(void)
+{
+#ifndef SINGLE_THREADED
+    pthread_once(&timerOnce, wolfCLU_TimerCalibrate);
+#else
+    if (!timerInit) {
+        timerInit = 1;
+        wolfCLU_TimerCalibrate();
+    }
+#endif
+}
+
+
+/* returns WOLFCLU_SUCCESS on success */
+int wolfCLU_benchRun(wolfCLU_BenchOp op, void* ctx, word32 opSz, int timer,
+        WOLFCLU_BENCH_RESULT* res)
+{
+    word64 limit = (word64)timer * 1000000000ULL;
+    word64 batch = 1;
+    word64 start, batchStart, now;
+    word64 startCyc;
+    word64 i;
+
+    if (op == NULL || res == NULL || timer <= 0) {
+        return BAD_FUNC_ARG;
+    }
+    XMEMSET(res, 0, sizeof(WOLFCLU_BENCH_RESULT));
+    wolfCLU_TimerInit();
+
+    startCyc = wolfCLU_TimerCycles();
+    start    = wolfCLU_TimerNs();
+    now      = start;
+    do {
+        batchStart = now;
+        for (i = 0; i < batch; i++) {
+            if (op(ctx) != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Benchmark operation failed");
+                return WOLFCLU_FATAL_ERROR;
+            }
+        }
+        res->ops += batch;
+        now = wolfCLU_TimerNs();
+
+        /* grow the batch until the clock read is a small fraction of it */
+        if (now - batchStart < WOLFCLU_BENCH_BATCH_NS) {
+            batch <<= 1;
+        }
+    } while (now - start < limit);
+
+    res->cycles = wolfCLU_TimerCycles() - startCyc;
+    res->ns     = now - start;
+    res->bytes  = res->ops * opSz;
+
+    return WOLFCLU_SUCCESS;
+}
+
+
+void wolfCLU_benchReport(const char* name, word32 opSz,
+        const WOLFCLU_BENCH_RESULT* res)
+{
+    double sec;
+    double mbs;
+
+    if (name == NULL || res == NULL || res->ops == 0 || res->ns == 0) {
+        return;
+    }
+
+    sec = (double)res->ns / 1000000000.0;
+    mbs = ((double)res->bytes / MEGABYTE) / sec;
+
+    WOLFCLU_LOG(WOLFCLU_L0, "%s took %6.3f seconds, ops = %llu", name, sec,
+            (unsigned long long)res->ops);
+    WOLFCLU_LOG(WOLFCLU_L0, "Average MB/s = %8.1f", mbs);
+    if (mbs >= 1024.0) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Average GB/s = %8.2f", mbs / 1024.0);
+    }
+    if (haveCycles && res->cycles > 0 && res->bytes > 0) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Cycles/byte  = %8.2f, cycles/op = %.1f",
+                (double)res->cycles / (double)res->bytes,
+                (double)res->cycles / (double)res->ops);
+    }
+    else if (haveCycles && res->cycles > 0) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Cycles/op    = %.1f",
+                (double)res->cycles / (double)res->ops);
+    }
+    if (opSz != MEGABYTE) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Block size of this algorithm is: %u.\n",
+                opSz);
+    }
+    else {
+        WOLFCLU_LOG(WOLFCLU_L0, "Benchmarked using 1 Megabyte at a time\n");
+    }
+}
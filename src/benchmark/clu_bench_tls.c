@@ -0,0 +1,637 @@
+/* clu_bench_tls.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/benchmark/clu_bench.h>
+
+#if !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER) && \
+    (!defined(NO_RSA) || defined(HAVE_ECC))
+    #define WOLFCLU_BENCH_TLS
+#endif
+
+#ifdef WOLFCLU_BENCH_TLS
+
+/* the server certificates and keys are compiled in, so no files are read */
+#undef USE_CERT_BUFFERS_256
+#define USE_CERT_BUFFERS_256
+#undef USE_CERT_BUFFERS_2048
+#define USE_CERT_BUFFERS_2048
+#include <wolfssl/certs_test.h>
+
+/* room in each direction for a full handshake flight or one record of the
+ * largest size with its header, padding and tag */
+#define WOLFCLU_TLS_PIPE_SZ (32 * 1024)
+
+/* largest plaintext that fits in a single TLS record */
+#define WOLFCLU_TLS_MAX_RECORD 16384
+
+/* connect and accept calls made before a handshake is given up on */
+#define WOLFCLU_TLS_MAX_ROUNDS 64
+
+enum {
+    WOLFCLU_TLS_CERT_RSA,
+    WOLFCLU_TLS_CERT_ECC
+};
+
+typedef WOLFSSL_METHOD* (*wolfCLU_TlsMethod)(void);
+
+typedef struct WOLFCLU_TLS_SUITE {
+    const char* name;   /* as given to wolfSSL_CTX_set_cipher_list */
+    int tls13;          /* 1 for a TLS 1.3 suite, 0 for TLS 1.2 */
+    int cert;           /* WOLFCLU_TLS_CERT_* used by the server */
+} WOLFCLU_TLS_SUITE;
+
+typedef struct WOLFCLU_TLS_GROUP {
+    const char* name;
+    int group;          /* WOLFSSL_ECC_* or WOLFSSL_FFDHE_* */
+    int ecdhe;          /* 1 if usable with the TLS 1.2 ECDHE suites */
+} WOLFCLU_TLS_GROUP;
+
+static const WOLFCLU_TLS_SUITE tlsSuites[] = {
+#ifdef WOLFSSL_TLS13
+    #if defined(HAVE_AESGCM) && !defined(NO_RSA)
+    { "TLS13-AES128-GCM-SHA256",        1, WOLFCLU_TLS_CERT_RSA },
+    #endif
+    #if defined(HAVE_AESGCM) && defined(HAVE_ECC)
+    { "TLS13-AES128-GCM-SHA256",        1, WOLFCLU_TLS_CERT_ECC },
+    #endif
+    #if defined(HAVE_AESGCM) && defined(WOLFSSL_SHA384) && !defined(NO_RSA)
+    { "TLS13-AES256-GCM-SHA384",        1, WOLFCLU_TLS_CERT_RSA },
+    #endif
+    #if defined(HAVE_CHACHA) && defined(HAVE_POLY1305) && !defined(NO_RSA)
+    { "TLS13-CHACHA20-POLY1305-SHA256", 1, WOLFCLU_TLS_CERT_RSA },
+    #endif
+#endif
+#if !defined(WOLFSSL_NO_TLS12) && defined(HAVE_ECC)
+    #if defined(HAVE_AESGCM) && !defined(NO_RSA)
+    { "ECDHE-RSA-AES128-GCM-SHA256",    0, WOLFCLU_TLS_CERT_RSA },
+    #endif
+    #ifdef HAVE_AESGCM
+    { "ECDHE-ECDSA-AES128-GCM-SHA256",  0, WOLFCLU_TLS_CERT_ECC },
+    #endif
+    #if defined(HAVE_CHACHA) && defined(HAVE_POLY1305) && !defined(NO_RSA)
+    { "ECDHE-RSA-CHACHA20-POLY1305",    0, WOLFCLU_TLS_CERT_RSA },
+    #endif
+#endif
+    { NULL, 0, 0 }
+};
+
+static const WOLFCLU_TLS_GROUP tlsGroups[] = {
+#ifdef HAVE_ECC
+    { "P-256",      WOLFSSL_ECC_SECP256R1, 1 },
+#endif
+#ifdef HAVE_CURVE25519
+    { "X25519",     WOLFSSL_ECC_X25519,    1 },
+#endif
+#if !defined(NO_DH) && defined(HAVE_FFDHE_2048)
+    { "FFDHE-2048", WOLFSSL_FFDHE_2048,    0 },
+#endif
+    { NULL, 0, 0 }
+};
+
+/* one direction of the in-memory connection, data lives in
+ * buf[start, start + len) */
+typedef struct WOLFCLU_TLS_PIPE {
+    byte buf[WOLFCLU_TLS_PIPE_SZ];
+    int  start;
+    int  len;
+} WOLFCLU_TLS_PIPE;
+
+typedef struct WOLFCLU_TLS_BENCH {
+    WOLFSSL_CTX* cliCtx;
+    WOLFSSL_CTX* srvCtx;
+    WOLFSSL*     cli;
+    WOLFSSL*     srv;
+    WOLFCLU_TLS_PIPE toSrv;
+    WOLFCLU_TLS_PIPE toCli;
+    const WOLFCLU_TLS_SUITE* suite;
+    int          group;
+    WOLFSSL_SESSION* session;   /* resumed by each connection when set */
+    byte*        msg;           /* record payloads for the bulk test */
+    byte*        rcv;
+    word32       msgSz;
+} WOLFCLU_TLS_BENCH;
+
+
+/* I/O send callback, appends to the peer's pipe */
+static int wolfCLU_TlsPipeSend(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    WOLFCLU_TLS_PIPE* pipe = (WOLFCLU_TLS_PIPE*)ctx;
+    int room;
+
+    (void)ssl;
+
+    if (pipe->start > 0 && pipe->start + pipe->len + sz > WOLFCLU_TLS_PIPE_SZ) {
+        XMEMMOVE(pipe->buf, pipe->buf + pipe->start, pipe->len);
+        pipe->start = 0;
+    }
+    room = WOLFCLU_TLS_PIPE_SZ - pipe->start - pipe->len;
+    if (room == 0) {
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    }
+    if (sz > room) {
+        sz = room;
+    }
+    XMEMCPY(pipe->buf + pipe->start + pipe->len, buf, sz);
+    pipe->len += sz;
+    return sz;
+}
+
+
+/* I/O receive callback, takes from this side's pipe */
+static int wolfCLU_TlsPipeRecv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    WOLFCLU_TLS_PIPE* pipe = (WOLFCLU_TLS_PIPE*)ctx;
+
+    (void)ssl;
+
+    if (pipe->len == 0) {
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    }
+    if (sz > pipe->len) {
+        sz = pipe->len;
+    }
+    XMEMCPY(buf, pipe->buf + pipe->start, sz);
+    pipe->start += sz;
+    pipe->len   -= sz;
+    if (pipe->len == 0) {
+        pipe->start = 0;
+    }
+    return sz;
+}
+
+
+/* returns 1 if ret from a non-blocking call only means the peer has to run */
+static int wolfCLU_TlsWouldBlock(WOLFSSL* ssl, int ret)
+{
+    int err = wolfSSL_get_error(ssl, ret);
+
+    return (err == WOLFSSL_ERROR_WANT_READ || err == WOLFSSL_ERROR_WANT_WRITE);
+}
+
+
+/* creates the client and server contexts for suite, with the server using
+ * the compiled in certificate and the client trusting its CA */
+static int wolfCLU_TlsCtxNew(WOLFCLU_TLS_BENCH* b,
+        const WOLFCLU_TLS_SUITE* suite)
+{
+    wolfCLU_TlsMethod cliMethod = NULL;
+    wolfCLU_TlsMethod srvMethod = NULL;
+    const byte* cert = NULL;
+    const byte* key  = NULL;
+    const byte* ca   = NULL;
+    long certSz = 0, keySz = 0, caSz = 0;
+    int  ret = WOLFCLU_SUCCESS;
+
+#ifdef WOLFSSL_TLS13
+    if (suite->tls13) {
+        cliMethod = wolfTLSv1_3_client_method;
+        srvMethod = wolfTLSv1_3_server_method;
+    }
+#endif
+#ifndef WOLFSSL_NO_TLS12
+    if (!suite->tls13) {
+        cliMethod = wolfTLSv1_2_client_method;
+        srvMethod = wolfTLSv1_2_server_method;
+    }
+#endif
+
+#ifndef NO_RSA
+    if (suite->cert == WOLFCLU_TLS_CERT_RSA) {
+        cert = server_cert_der_2048; certSz = sizeof_server_cert_der_2048;
+        key  = server_key_der_2048;  keySz  = sizeof_server_key_der_2048;
+        ca   = ca_cert_der_2048;     caSz   = sizeof_ca_cert_der_2048;
+    }
+#endif
+#ifdef HAVE_ECC
+    if (suite->cert == WOLFCLU_TLS_CERT_ECC) {
+        cert = serv_ecc_der_256;    certSz = sizeof_serv_ecc_der_256;
+        key  = ecc_key_der_256;     keySz  = sizeof_ecc_key_der_256;
+        ca   = ca_ecc_cert_der_256; caSz   = sizeof_ca_ecc_cert_der_256;
+    }
+#endif
+
+    if (cliMethod == NULL || cert == NULL) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    b->cliCtx = wolfSSL_CTX_new(cliMethod());
+    b->srvCtx = wolfSSL_CTX_new(srvMethod());
+    if (b->cliCtx == NULL || b->srvCtx == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to create TLS contexts");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && (
+            wolfSSL_CTX_use_certificate_buffer(b->srvCtx, cert, certSz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_use_PrivateKey_buffer(b->srvCtx, key, keySz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_load_verify_buffer(b->cliCtx, ca, caSz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to load the built in certificates");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && (
+            wolfSSL_CTX_set_cipher_list(b->cliCtx, suite->name)
+                != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_set_cipher_list(b->srvCtx, suite->name)
+                != WOLFSSL_SUCCESS)) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Cipher suite %s is not available",
+                suite->name);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        wolfSSL_CTX_SetIORecv(b->cliCtx, wolfCLU_TlsPipeRecv);
+        wolfSSL_CTX_SetIOSend(b->cliCtx, wolfCLU_TlsPipeSend);
+        wolfSSL_CTX_SetIORecv(b->srvCtx, wolfCLU_TlsPipeRecv);
+        wolfSSL_CTX_SetIOSend(b->srvCtx, wolfCLU_TlsPipeSend);
+        b->suite = suite;
+    }
+    return ret;
+}
+
+
+static void wolfCLU_TlsCtxFree(WOLFCLU_TLS_BENCH* b)
+{
+    if (b->cliCtx != NULL) {
+        wolfSSL_CTX_free(b->cliCtx);
+    }
+    if (b->srvCtx != NULL) {
+        wolfSSL_CTX_free(b->srvCtx);
+    }
+    b->cliCtx = NULL;
+    b->srvCtx = NULL;
+}
+
+
+static void wolfCLU_TlsClose(WOLFCLU_TLS_BENCH* b)
+{
+    if (b->cli != NULL) {
+        wolfSSL_free(b->cli);
+    }
+    if (b->srv != NULL) {
+        wolfSSL_free(b->srv);
+    }
+    b->cli = NULL;
+    b->srv = NULL;
+}
+
+
+/* creates a client and server pair and runs the handshake between them,
+ * resuming b->session when it is set */
+static int wolfCLU_TlsConnect(WOLFCLU_TLS_BENCH* b)
+{
+    int cliDone = 0;
+    int srvDone = 0;
+    int i, ret;
+
+    b->toSrv.start = b->toSrv.len = 0;
+    b->toCli.start = b->toCli.len = 0;
+
+    b->cli = wolfSSL_new(b->cliCtx);
+    b->srv = wolfSSL_new(b->srvCtx);
+    if (b->cli == NULL || b->srv == NULL) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    wolfSSL_SetIOWriteCtx(b->cli, &b->toSrv);
+    wolfSSL_SetIOReadCtx(b->cli, &b->toCli);
+    wolfSSL_SetIOWriteCtx(b->srv, &b->toCli);
+    wolfSSL_SetIOReadCtx(b->srv, &b->toSrv);
+
+#ifdef HAVE_SUPPORTED_CURVES
+    if (b->suite->tls13) {
+    #ifdef WOLFSSL_TLS13
+        if (wolfSSL_UseKeyShare(b->cli, (word16)b->group) != WOLFSSL_SUCCESS ||
+                wolfSSL_set_groups(b->cli, &b->group, 1) != WOLFSSL_SUCCESS) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+    #endif
+    }
+    else if (wolfSSL_UseSupportedCurve(b->cli, (word16)b->group)
+            != WOLFSSL_SUCCESS) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+#endif
+
+    if (b->session != NULL &&
+            wolfSSL_set_session(b->cli, b->session) != WOLFSSL_SUCCESS) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    for (i = 0; i < WOLFCLU_TLS_MAX_ROUNDS && !(cliDone && srvDone); i++) {
+        if (!cliDone) {
+            ret = wolfSSL_connect(b->cli);
+            if (ret == WOLFSSL_SUCCESS) {
+                cliDone = 1;
+            }
+            else if (!wolfCLU_TlsWouldBlock(b->cli, ret)) {
+                return WOLFCLU_FATAL_ERROR;
+            }
+        }
+        if (!srvDone) {
+            ret = wolfSSL_accept(b->srv);
+            if (ret == WOLFSSL_SUCCESS) {
+                srvDone = 1;
+            }
+            else if (!wolfCLU_TlsWouldBlock(b->srv, ret)) {
+                return WOLFCLU_FATAL_ERROR;
+            }
+        }
+    }
+
+    return (cliDone && srvDone)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+/* one full or resumed handshake, including creating and freeing the
+ * WOLFSSL objects as a server would per connection */
+static int wolfCLU_TlsHandshakeOp(void* ctx)
+{
+    WOLFCLU_TLS_BENCH* b = (WOLFCLU_TLS_BENCH*)ctx;
+    int ret;
+
+    ret = wolfCLU_TlsConnect(b);
+    wolfCLU_TlsClose(b);
+    return (ret == WOLFCLU_SUCCESS)? 0 : -1;
+}
+
+
+/* sends one record from the client and reads it on the server */
+static int wolfCLU_TlsRecordOp(void* ctx)
+{
+    WOLFCLU_TLS_BENCH* b = (WOLFCLU_TLS_BENCH*)ctx;
+    word32 got = 0;
+    int ret;
+
+    if (wolfSSL_write(b->cli, b->msg, (int)b->msgSz) != (int)b->msgSz) {
+        return -1;
+    }
+    while (got < b->msgSz) {
+        ret = wolfSSL_read(b->srv, b->rcv + got, (int)(b->msgSz - got));
+        if (ret <= 0) {
+            return -1;
+        }
+        got += (word32)ret;
+    }
+    return 0;
+}
+
+
+/* makes one connection and keeps its session for the resumed handshakes,
+ * returns WOLFCLU_SUCCESS only if resumption was seen to work */
+static int wolfCLU_TlsGetSession(WOLFCLU_TLS_BENCH* b)
+{
+    byte tmp;
+    int  ret;
+
+    ret = wolfCLU_TlsConnect(b);
+    if (ret == WOLFCLU_SUCCESS) {
+        /* TLS 1.3 tickets arrive after the handshake, let the client read
+         * them before taking the session */
+        ret = wolfSSL_read(b->cli, &tmp, 1);
+        ret = (ret > 0 || wolfCLU_TlsWouldBlock(b->cli, ret))?
+            WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        b->session = wolfSSL_get1_session(b->cli);
+    }
+    wolfCLU_TlsClose(b);
+    if (b->session == NULL) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    ret = wolfCLU_TlsConnect(b);
+    if (ret == WOLFCLU_SUCCESS && wolfSSL_session_reused(b->cli) != 1) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    wolfCLU_TlsClose(b);
+    if (ret != WOLFCLU_SUCCESS) {
+        wolfSSL_SESSION_free(b->session);
+        b->session = NULL;
+    }
+    return ret;
+}
+
+
+static void wolfCLU_TlsReport(const char* kind, const WOLFCLU_BENCH_RESULT* res)
+{
+    double sec;
+
+    if (res->ops == 0 || res->ns == 0) {
+        return;
+    }
+    sec = (double)res->ns / 1000000000.0;
+    WOLFCLU_LOG(WOLFCLU_L0, "  %-7s %9.1f handshakes/s, %8.3f ms each", kind,
+            (double)res->ops / sec, (sec * 1000.0) / (double)res->ops);
+}
+
+
+/* full and resumed handshakes for one suite and group */
+static int wolfCLU_TlsBenchHandshakes(WOLFCLU_TLS_BENCH* b,
+        const WOLFCLU_TLS_GROUP* group, int timer)
+{
+    WOLFCLU_BENCH_RESULT res;
+    int ret;
+
+    b->group = group->group;
+    WOLFCLU_LOG(WOLFCLU_L0, "%s, %s, %s", b->suite->name,
+            (b->suite->cert == WOLFCLU_TLS_CERT_RSA)? "RSA-2048" : "ECDSA-P256",
+            group->name);
+
+    /* a single connection first so that a setup problem is reported as
+     * such instead of as a failed run */
+    ret = wolfCLU_TlsConnect(b);
+    wolfCLU_TlsClose(b);
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "  handshake failed");
+        return ret;
+    }
+
+    ret = wolfCLU_benchRun(wolfCLU_TlsHandshakeOp, b, 0, timer, &res);
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "  handshake failed");
+        return ret;
+    }
+    wolfCLU_TlsReport("full", &res);
+
+    if (wolfCLU_TlsGetSession(b) != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_L0, "  resumed handshakes not available");
+    }
+    else {
+        ret = wolfCLU_benchRun(wolfCLU_TlsHandshakeOp, b, 0, timer, &res);
+        wolfSSL_SESSION_free(b->session);
+        b->session = NULL;
+        if (ret != WOLFCLU_SUCCESS) {
+            WOLFCLU_LOG(WOLFCLU_E0, "  resumed handshake failed");
+            return ret;
+        }
+        wolfCLU_TlsReport("resumed", &res);
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* record throughput for one suite over an established connection */
+static int wolfCLU_TlsBenchRecords(WOLFCLU_TLS_BENCH* b,
+        const WOLFCLU_BENCH_OPTS* opts)
+{
+    WOLFCLU_BENCH_RESULT res;
+    double sec;
+    int ret;
+    int i;
+
+    b->msg = (byte*)XMALLOC(WOLFCLU_TLS_MAX_RECORD, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    b->rcv = (byte*)XMALLOC(WOLFCLU_TLS_MAX_RECORD, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (b->msg == NULL || b->rcv == NULL) {
+        wolfCLU_freeBins(b->msg, b->rcv, NULL, NULL, NULL);
+        b->msg = b->rcv = NULL;
+        return MEMORY_E;
+    }
+    XMEMSET(b->msg, 0x5a, WOLFCLU_TLS_MAX_RECORD);
+
+    ret = wolfCLU_TlsConnect(b);
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < opts->msgSzCount; i++) {
+        b->msgSz = opts->msgSz[i];
+        if (b->msgSz == 0 || b->msgSz > WOLFCLU_TLS_MAX_RECORD) {
+            WOLFCLU_LOG(WOLFCLU_L0, "  skipping %u byte records, the most a "
+                    "record holds is %d", b->msgSz, WOLFCLU_TLS_MAX_RECORD);
+            continue;
+        }
+        ret = wolfCLU_benchRun(wolfCLU_TlsRecordOp, b, b->msgSz, opts->timer,
+                &res);
+        if (ret == WOLFCLU_SUCCESS && res.ns > 0) {
+            sec = (double)res.ns / 1000000000.0;
+            WOLFCLU_LOG(WOLFCLU_L0, "  %5u byte records: %9.1f MB/s, "
+                    "%10.1f records/s", b->msgSz,
+                    ((double)res.bytes / MEGABYTE) / sec,
+                    (double)res.ops / sec);
+        }
+    }
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "  record test failed");
+    }
+    wolfCLU_TlsClose(b);
+
+    wolfCLU_freeBins(b->msg, b->rcv, NULL, NULL, NULL);
+    b->msg = b->rcv = NULL;
+    return ret;
+}
+
+
+/* runs the handshake and record tests of one suite, for every group the
+ * suite can use that matches opts->tlsGroup */
+static int wolfCLU_TlsBenchSuite(WOLFCLU_TLS_BENCH* b,
+        const WOLFCLU_TLS_SUITE* suite, const WOLFCLU_BENCH_OPTS* opts)
+{
+    const WOLFCLU_TLS_GROUP* group;
+    const WOLFCLU_TLS_GROUP* first = NULL;
+    int ret;
+
+    ret = wolfCLU_TlsCtxNew(b, suite);
+    for (group = tlsGroups; ret == WOLFCLU_SUCCESS && group->name != NULL;
+            group++) {
+        if ((!suite->tls13 && !group->ecdhe) || (opts->tlsGroup != NULL &&
+                XSTRSTR(group->name, opts->tlsGroup) == NULL)) {
+            continue;
+        }
+        if (first == NULL) {
+            first = group;
+        }
+        ret = wolfCLU_TlsBenchHandshakes(b, group, opts->timer);
+    }
+
+    /* the key exchange does not change the record layer, so one group is
+     * enough for the throughput test */
+    if (ret == WOLFCLU_SUCCESS && first != NULL) {
+        b->group = first->group;
+        WOLFCLU_LOG(WOLFCLU_L0, "%s records", suite->name);
+        ret = wolfCLU_TlsBenchRecords(b, opts);
+    }
+    if (first != NULL) {
+        WOLFCLU_LOG(WOLFCLU_L0, "%s", "");
+    }
+
+    wolfCLU_TlsCtxFree(b);
+    return ret;
+}
+#endif /* WOLFCLU_BENCH_TLS */
+
+
+int wolfCLU_benchTls(const WOLFCLU_BENCH_OPTS* opts)
+{
+#ifdef WOLFCLU_BENCH_TLS
+    WOLFCLU_TLS_BENCH* b;
+    const WOLFCLU_TLS_SUITE* suite;
+    int ret = WOLFCLU_SUCCESS;
+    int ran = 0;
+
+    if (opts == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    /* the pipes are large, keep them off of the stack */
+    b = (WOLFCLU_TLS_BENCH*)XMALLOC(sizeof(WOLFCLU_TLS_BENCH), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (b == NULL) {
+        return MEMORY_E;
+    }
+    XMEMSET(b, 0, sizeof(WOLFCLU_TLS_BENCH));
+
+    if (wolfSSL_Init() != WOLFSSL_SUCCESS) {
+        XFREE(b, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    wolfCLU_TimerInit();
+
+    for (suite = tlsSuites; ret == WOLFCLU_SUCCESS && suite->name != NULL;
+            suite++) {
+        if (opts->tlsSuite != NULL &&
+                XSTRSTR(suite->name, opts->tlsSuite) == NULL) {
+            continue;
+        }
+        ret = wolfCLU_TlsBenchSuite(b, suite, opts);
+        ran = 1;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && !ran) {
+        WOLFCLU_LOG(WOLFCLU_E0, "No cipher suite matched, available suites:");
+        for (suite = tlsSuites; suite->name != NULL; suite++) {
+            WOLFCLU_LOG(WOLFCLU_E0, "    %s", suite->name);
+        }
+        ret = USER_INPUT_ERROR;
+    }
+
+    wolfSSL_Cleanup();
+    XFREE(b, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+#else
+    (void)opts;
+    WOLFCLU_LOG(WOLFCLU_E0, "TLS benchmark needs wolfSSL built with client "
+            "and server support");
+    return NOT_COMPILED_IN;
+#endif
+}
@@ -20,504 +20,852 @@
  */
 
 #include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/benchmark/clu_bench.h>
+#include <wolfclu/clu_memstats.h>
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    #include <wolfssl/wolfcrypt/chacha20_poly1305.h>
+#endif
 
 
 #define DES3_BLOCK_SIZE 24
 
+/* size of the random key and iv buffers handed to each algorithm */
+#define BENCH_KEY_SZ 32
+
+/* AEAD nonce and tag sizes used for every AEAD benchmark */
+#define BENCH_AEAD_NONCE_SZ 12
+#define BENCH_AEAD_TAG_SZ   16
+
+/* password size, derived key size and iterations for each KDF operation,
+ * the salt is taken from the iv buffer */
+#define BENCH_KDF_PWD_SZ  16
+#define BENCH_KDF_SALT_SZ 16
+#define BENCH_KDF_KEY_SZ  32
+#define BENCH_KDF_ITER    1000
+
+/* state shared between the init, op and final callbacks of a benchmark */
+typedef struct WOLFCLU_BENCH_CTX {
+    union {
+#ifndef NO_AES
+        Aes       aes;
+#endif
+#ifndef NO_DES3
+        Des3      des3;
+#endif
+#ifdef HAVE_CAMELLIA
+        Camellia  camellia;
+#endif
+#ifndef NO_MD5
+        wc_Md5    md5;
+#endif
+#ifndef NO_SHA
+        wc_Sha    sha;
+#endif
+#ifndef NO_SHA256
+        wc_Sha256 sha256;
+#endif
+#ifdef WOLFSSL_SHA384
+        wc_Sha384 sha384;
+#endif
+#ifdef WOLFSSL_SHA512
+        wc_Sha512 sha512;
+#endif
 #ifdef HAVE_BLAKE2
+        Blake2b   b2b;
+#endif
+#ifndef WC_NO_RNG
+        WC_RNG    rng;
+#endif
+        byte      unused;
+    } alg;
+    byte*  in;      /* input for each operation */
+    byte*  out;     /* output of each operation */
+    word32 sz;      /* bytes of input processed by each operation */
+    byte*  aad;     /* additional authenticated data, AEAD only */
+    word32 aadSz;
+    byte   key[BENCH_KEY_SZ];
+    byte   iv[BENCH_KEY_SZ];
+    byte   tag[BENCH_AEAD_TAG_SZ];
+} WOLFCLU_BENCH_CTX;
+
+/* describes one benchmark, init and final are optional. AEADs set dec and
+ * are run over the message and AAD sizes from the command line, inSz and
+ * outSz are then taken from the largest message size */
+typedef struct WOLFCLU_BENCH_ALG {
+    const char*     name;   /* printed with the results */
+    const char*     arg;    /* selects it on the command line */
+    word32          inSz;   /* bytes processed by each operation */
+    word32          outSz;  /* size of the output buffer */
+    int (*init)(WOLFCLU_BENCH_CTX* ctx);
+    wolfCLU_BenchOp op;
+    int (*final)(WOLFCLU_BENCH_CTX* ctx);
+    wolfCLU_BenchOp dec;    /* decrypt and verify of op's output */
+    word32          iter;   /* KDF iterations per operation, 0 otherwise */
+} WOLFCLU_BENCH_ALG;
 
-#endif /* HAVE_BLAKE2 */
 
-/*
- * benchmarking funciton 
- */
-int wolfCLU_benchmark(int timer, int* option)
+#ifndef NO_AES
+static int benchAesCbcInit(WOLFCLU_BENCH_CTX* ctx)
 {
-    int i              =   0;       /* A looping variable */
+    return wc_AesSetKey(&ctx->alg.aes, ctx->key, AES_BLOCK_SIZE, ctx->iv,
+            AES_ENCRYPTION);
+}
 
-    int     loop       =   1;       /* benchmarking loop */
-    int64_t blocks     =   0;       /* blocks used during benchmarking */
-#ifndef NO_AES
-    Aes aes;                        /* aes declaration */
+static int benchAesCbc(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_AesCbcEncrypt(&ctx->alg.aes, ctx->out, ctx->in, ctx->sz);
+}
+#endif
+
+#ifdef WOLFSSL_AES_COUNTER
+static int benchAesCtrInit(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_AesSetKeyDirect(&ctx->alg.aes, ctx->key, AES_BLOCK_SIZE,
+            ctx->iv, AES_ENCRYPTION);
+}
+
+static int benchAesCtr(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_AesCtrEncrypt(&ctx->alg.aes, ctx->out, ctx->in, ctx->sz);
+}
 #endif
 
 #ifndef NO_DES3
-    Des3 des3;                      /* 3des declaration */
+static int benchDes3Init(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_Des3_SetKey(&ctx->alg.des3, ctx->key, ctx->iv, DES_ENCRYPTION);
+}
+
+static int benchDes3(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_Des3_CbcEncrypt(&ctx->alg.des3, ctx->out, ctx->in, ctx->sz);
+}
 #endif
 
-    WC_RNG rng;                     /* random number generator */
+#ifdef HAVE_CAMELLIA
+static int benchCamelliaInit(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_CamelliaSetKey(&ctx->alg.camellia, ctx->key,
+            CAMELLIA_BLOCK_SIZE, ctx->iv);
+}
+
+static int benchCamellia(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_CamelliaCbcEncrypt(&ctx->alg.camellia, ctx->out, ctx->in,
+            ctx->sz);
+}
+#endif
 
-    int             ret  = 0;       /* return variable */
-    double          stop = 0.0;     /* stop breaks loop */
-    double          start;          /* start time */
-    double          currTime;       /* current time*/
+#ifndef NO_MD5
+static int benchMd5Init(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_InitMd5(&ctx->alg.md5);
+}
 
+static int benchMd5(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_Md5Update(&ctx->alg.md5, ctx->in, ctx->sz);
+}
 
-    ALIGN16 byte*   plain;          /* plain text */
-    ALIGN16 byte*   cipher;         /* cipher */
-    ALIGN16 byte*   key;            /* key for testing */
-    ALIGN16 byte*   iv;             /* iv for initial encoding */
+static int benchMd5Final(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_Md5Final(&ctx->alg.md5, ctx->out);
+}
+#endif
 
-    byte*           digest;         /* message digest */
+#ifndef NO_SHA
+static int benchShaInit(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_InitSha(&ctx->alg.sha);
+}
 
-    wc_InitRng(&rng);
+static int benchSha(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_ShaUpdate(&ctx->alg.sha, ctx->in, ctx->sz);
+}
 
-    signal(SIGALRM, wolfCLU_stop);
+static int benchShaFinal(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_ShaFinal(&ctx->alg.sha, ctx->out);
+}
+#endif
 
-    /* @fragile:
-     * this function assumes that it perfectly knows the order and length of
-     * the option array in clu_src/benchmark/clu_bench_setup.c. Looping over a
-     * switch on an enum would be much more robust.
-     */
+#ifndef NO_SHA256
+static int benchSha256Init(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_InitSha256(&ctx->alg.sha256);
+}
 
-    i = 0;
-#ifndef NO_AES
-    /* aes test */
-    if (option[i] == 1) {
-        plain = XMALLOC(AES_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            return MEMORY_E;
-        }
-        cipher = XMALLOC(AES_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (cipher == NULL) {
-            wolfCLU_freeBins(plain, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        key = XMALLOC(AES_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (key == NULL) {
-            wolfCLU_freeBins(plain, cipher, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        iv = XMALLOC(AES_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (iv == NULL) {
-            wolfCLU_freeBins(plain, cipher, key, NULL, NULL);
-            return MEMORY_E;
-        }
+static int benchSha256(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_Sha256Update(&ctx->alg.sha256, ctx->in, ctx->sz);
+}
 
-        wc_RNG_GenerateBlock(&rng, plain, AES_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, cipher, AES_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, key, AES_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, iv, AES_BLOCK_SIZE);
-        start = wolfCLU_getTime();
-        alarm(timer);
-
-        wc_AesSetKey(&aes, key, AES_BLOCK_SIZE, iv, AES_ENCRYPTION);
-
-        while (loop) {
-            wc_AesCbcEncrypt(&aes, cipher, plain, AES_BLOCK_SIZE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
-        }
-        printf("\n");
-        printf("AES-CBC ");
-        wolfCLU_stats(start, AES_BLOCK_SIZE, blocks);
-        XMEMSET(plain, 0, AES_BLOCK_SIZE);
-        XMEMSET(cipher, 0, AES_BLOCK_SIZE);
-        XMEMSET(key, 0, AES_BLOCK_SIZE);
-        XMEMSET(iv, 0, AES_BLOCK_SIZE);
-        wolfCLU_freeBins(plain, cipher, key, iv, NULL);
-        blocks = 0;
-        loop = 1;
-    }
-    i++;
+static int benchSha256Final(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_Sha256Final(&ctx->alg.sha256, ctx->out);
+}
 #endif
-#ifdef WOLFSSL_AES_COUNTER
-    /* aes-ctr test */
-    if (option[i] == 1) {
-        plain = XMALLOC(AES_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            return MEMORY_E;
-        }
-        cipher = XMALLOC(AES_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (cipher == NULL) {
-            wolfCLU_freeBins(plain, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        key = XMALLOC(AES_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (key == NULL) {
-            wolfCLU_freeBins(plain, cipher, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        iv = XMALLOC(AES_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (iv == NULL) {
-            wolfCLU_freeBins(plain, cipher, key, NULL, NULL);
-            return MEMORY_E;
-        }
 
-        wc_RNG_GenerateBlock(&rng, plain, AES_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, cipher, AES_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, key, AES_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, iv, AES_BLOCK_SIZE);
-        start = wolfCLU_getTime();
-        alarm(timer);
-
-        wc_AesSetKeyDirect(&aes, key, AES_BLOCK_SIZE, iv, AES_ENCRYPTION);
-        while (loop) {
-            wc_AesCtrEncrypt(&aes, cipher, plain, AES_BLOCK_SIZE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
-        }
-        printf("AES-CTR ");
-        wolfCLU_stats(start, AES_BLOCK_SIZE, blocks);
-        XMEMSET(plain, 0, AES_BLOCK_SIZE);
-        XMEMSET(cipher, 0, AES_BLOCK_SIZE);
-        XMEMSET(key, 0, AES_BLOCK_SIZE);
-        XMEMSET(iv, 0, AES_BLOCK_SIZE);
-        wolfCLU_freeBins(plain, cipher, key, iv, NULL);
-        blocks = 0;
-        loop = 1;
-    }
-    i++;
+#ifdef WOLFSSL_SHA384
+static int benchSha384Init(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_InitSha384(&ctx->alg.sha384);
+}
+
+static int benchSha384(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_Sha384Update(&ctx->alg.sha384, ctx->in, ctx->sz);
+}
+
+static int benchSha384Final(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_Sha384Final(&ctx->alg.sha384, ctx->out);
+}
 #endif
-#ifndef NO_DES3
-    /* 3des test */
-    if (option[i] == 1) {
-        plain = XMALLOC(DES3_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            return MEMORY_E;
-        }
-        cipher = XMALLOC(DES3_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (cipher == NULL) {
-            wolfCLU_freeBins(plain, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        key = XMALLOC(DES3_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (key == NULL) {
-            wolfCLU_freeBins(plain, cipher, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        iv = XMALLOC(DES3_BLOCK_SIZE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (iv == NULL) {
-            wolfCLU_freeBins(plain, cipher, key, NULL, NULL);
-            return MEMORY_E;
-        }
 
-        wc_RNG_GenerateBlock(&rng, plain, DES3_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, cipher, DES3_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, key, DES3_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, iv, DES3_BLOCK_SIZE);
-
-        start = wolfCLU_getTime();
-        alarm(timer);
-
-        wc_Des3_SetKey(&des3, key, iv, DES_ENCRYPTION);
-        while (loop) {
-            wc_Des3_CbcEncrypt(&des3, cipher, plain, DES3_BLOCK_SIZE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
-        }
-        printf("3DES ");
-        wolfCLU_stats(start, DES3_BLOCK_SIZE, blocks);
-        XMEMSET(plain, 0, DES3_BLOCK_SIZE);
-        XMEMSET(cipher, 0, DES3_BLOCK_SIZE);
-        XMEMSET(key, 0, DES3_BLOCK_SIZE);
-        XMEMSET(iv, 0, DES3_BLOCK_SIZE);
-        wolfCLU_freeBins(plain, cipher, key, iv, NULL);
-        blocks = 0;
-        loop = 1;
-    }
-    i++;
+#ifdef WOLFSSL_SHA512
+static int benchSha512Init(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_InitSha512(&ctx->alg.sha512);
+}
+
+static int benchSha512(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_Sha512Update(&ctx->alg.sha512, ctx->in, ctx->sz);
+}
+
+static int benchSha512Final(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_Sha512Final(&ctx->alg.sha512, ctx->out);
+}
 #endif
-#ifdef HAVE_CAMELLIA
-    #define CAM_SZ CAMELLIA_BLOCK_SIZE
-    /* camellia test */
-    if (option[i] == 1) {
-        Camellia camellia;
-
-        plain = XMALLOC(CAM_SZ, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            return MEMORY_E;
-        }
-        cipher = XMALLOC(CAM_SZ, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (cipher == NULL) {
-            wolfCLU_freeBins(plain, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        key = XMALLOC(CAM_SZ, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (key == NULL) {
-            wolfCLU_freeBins(plain, cipher, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        iv = XMALLOC(CAM_SZ, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (iv == NULL) {
-            wolfCLU_freeBins(plain, cipher, key, NULL, NULL);
-            return MEMORY_E;
-        }
 
-        wc_RNG_GenerateBlock(&rng, plain, CAMELLIA_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, cipher, CAMELLIA_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, key, CAMELLIA_BLOCK_SIZE);
-        wc_RNG_GenerateBlock(&rng, iv, CAMELLIA_BLOCK_SIZE);
-
-        start = wolfCLU_getTime();
-        alarm(timer);
-
-        wc_CamelliaSetKey(&camellia, key, CAMELLIA_BLOCK_SIZE, iv);
-        while (loop) {
-            wc_CamelliaCbcEncrypt(&camellia, cipher, plain, CAMELLIA_BLOCK_SIZE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
-        }
-        printf("Camellia ");
-        wolfCLU_stats(start, CAMELLIA_BLOCK_SIZE, blocks);
-        XMEMSET(plain, 0, CAMELLIA_BLOCK_SIZE);
-        XMEMSET(cipher, 0, CAMELLIA_BLOCK_SIZE);
-        XMEMSET(key, 0, CAMELLIA_BLOCK_SIZE);
-        XMEMSET(iv, 0, CAMELLIA_BLOCK_SIZE);
-        wolfCLU_freeBins(plain, cipher, key, iv, NULL);
-        blocks = 0;
-        loop = 1;
-    }
-    i++;
+#ifdef HAVE_BLAKE2
+static int benchBlake2bInit(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_InitBlake2b(&ctx->alg.b2b, BLAKE2B_OUTBYTES);
+}
+
+static int benchBlake2b(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_Blake2bUpdate(&ctx->alg.b2b, ctx->in, ctx->sz);
+}
+
+static int benchBlake2bFinal(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_Blake2bFinal(&ctx->alg.b2b, ctx->out, BLAKE2B_OUTBYTES);
+}
 #endif
-#ifndef NO_MD5
-    /* md5 test */
-    if (option[i] == 1) {
-        wc_Md5 md5;
-
-        digest = XMALLOC(WC_MD5_DIGEST_SIZE, HEAP_HINT,
-                         DYNAMIC_TYPE_TMP_BUFFER);
-        if (digest == NULL)
-            return MEMORY_E;
-        plain = XMALLOC(MEGABYTE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            wolfCLU_freeBins(digest, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        wc_RNG_GenerateBlock(&rng, plain, MEGABYTE);
-
-        wc_InitMd5(&md5);
-        start = wolfCLU_getTime();
-        alarm(timer);
-
-        while (loop) {
-            wc_Md5Update(&md5, plain, MEGABYTE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
-        }
-        wc_Md5Final(&md5, digest);
-        printf("MD5 ");
-        wolfCLU_stats(start, MEGABYTE, blocks);
-        XMEMSET(plain, 0, MEGABYTE);
-        XMEMSET(digest, 0, WC_MD5_DIGEST_SIZE);
-        wolfCLU_freeBins(digest, plain, NULL, NULL, NULL);
-        blocks = 0;
-        loop = 1;
-    }
-    i++;
+
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+static int benchAesGcm128Init(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_AesGcmSetKey(&ctx->alg.aes, ctx->key, AES_128_KEY_SIZE);
+}
+
+static int benchAesGcm256Init(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_AesGcmSetKey(&ctx->alg.aes, ctx->key, AES_256_KEY_SIZE);
+}
+
+static int benchAesGcmEnc(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_AesGcmEncrypt(&ctx->alg.aes, ctx->out, ctx->in, ctx->sz,
+            ctx->iv, BENCH_AEAD_NONCE_SZ, ctx->tag, BENCH_AEAD_TAG_SZ,
+            ctx->aad, ctx->aadSz);
+}
+
+/* the recovered plain text is the same as ctx->in so it is written back
+ * over it */
+static int benchAesGcmDec(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_AesGcmDecrypt(&ctx->alg.aes, ctx->in, ctx->out, ctx->sz,
+            ctx->iv, BENCH_AEAD_NONCE_SZ, ctx->tag, BENCH_AEAD_TAG_SZ,
+            ctx->aad, ctx->aadSz);
+}
+#endif
+
+#if !defined(NO_AES) && defined(HAVE_AESCCM)
+static int benchAesCcmInit(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_AesCcmSetKey(&ctx->alg.aes, ctx->key, AES_128_KEY_SIZE);
+}
+
+static int benchAesCcmEnc(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_AesCcmEncrypt(&ctx->alg.aes, ctx->out, ctx->in, ctx->sz,
+            ctx->iv, BENCH_AEAD_NONCE_SZ, ctx->tag, BENCH_AEAD_TAG_SZ,
+            ctx->aad, ctx->aadSz);
+}
+
+static int benchAesCcmDec(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_AesCcmDecrypt(&ctx->alg.aes, ctx->in, ctx->out, ctx->sz,
+            ctx->iv, BENCH_AEAD_NONCE_SZ, ctx->tag, BENCH_AEAD_TAG_SZ,
+            ctx->aad, ctx->aadSz);
+}
+#endif
+
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+static int benchChaChaPolyEnc(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_ChaCha20Poly1305_Encrypt(ctx->key, ctx->iv, ctx->aad,
+            ctx->aadSz, ctx->in, ctx->sz, ctx->out, ctx->tag);
+}
+
+static int benchChaChaPolyDec(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_ChaCha20Poly1305_Decrypt(ctx->key, ctx->iv, ctx->aad,
+            ctx->aadSz, ctx->out, ctx->sz, ctx->tag, ctx->in);
+}
 #endif
+
+#ifndef NO_PWDBASED
+/* one PBKDF2 derivation, ctx->in holds the password */
+static int benchPbkdf2(WOLFCLU_BENCH_CTX* ctx, int hashType)
+{
+    return wc_PBKDF2(ctx->out, ctx->in, ctx->sz, ctx->iv, BENCH_KDF_SALT_SZ,
+            BENCH_KDF_ITER, BENCH_KDF_KEY_SZ, hashType);
+}
+
 #ifndef NO_SHA
-    /* sha test */
-    if (option[i] == 1) {
-        wc_Sha sha;
-
-        digest = XMALLOC(WC_SHA_DIGEST_SIZE, HEAP_HINT,
-                         DYNAMIC_TYPE_TMP_BUFFER);
-        if (digest == NULL)
-            return MEMORY_E;
-        plain = XMALLOC(MEGABYTE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            wolfCLU_freeBins(digest, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
-        wc_RNG_GenerateBlock(&rng, plain, MEGABYTE);
-
-        wc_InitSha(&sha);
-        start = wolfCLU_getTime();
-        alarm(timer);
-
-        while (loop) {
-            wc_ShaUpdate(&sha, plain, MEGABYTE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
-        }
-        wc_ShaFinal(&sha, digest);
-        printf("Sha ");
-        wolfCLU_stats(start, MEGABYTE, blocks);
-        XMEMSET(plain, 0, MEGABYTE);
-        XMEMSET(digest, 0, WC_SHA_DIGEST_SIZE);
-        wolfCLU_freeBins(plain, digest, NULL, NULL, NULL);
-        blocks = 0;
-        loop = 1;
-    }
-    i++;
+static int benchPbkdf2Sha(void* c)
+{
+    return benchPbkdf2((WOLFCLU_BENCH_CTX*)c, WC_HASH_TYPE_SHA);
+}
 #endif
+
 #ifndef NO_SHA256
-    #define SHA256_SZ WC_SHA256_DIGEST_SIZE
-    /* sha256 test */
-    if (option[i] == 1) {
-        wc_Sha256 sha256;
+static int benchPbkdf2Sha256(void* c)
+{
+    return benchPbkdf2((WOLFCLU_BENCH_CTX*)c, WC_HASH_TYPE_SHA256);
+}
+#endif
 
-        digest = XMALLOC(SHA256_SZ, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (digest == NULL)
-            return MEMORY_E;
-        plain = XMALLOC(MEGABYTE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            wolfCLU_freeBins(digest, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
-        }
+#ifdef WOLFSSL_SHA384
+static int benchPbkdf2Sha384(void* c)
+{
+    return benchPbkdf2((WOLFCLU_BENCH_CTX*)c, WC_HASH_TYPE_SHA384);
+}
+#endif
 
-        wc_RNG_GenerateBlock(&rng, plain, MEGABYTE);
+#ifdef WOLFSSL_SHA512
+static int benchPbkdf2Sha512(void* c)
+{
+    return benchPbkdf2((WOLFCLU_BENCH_CTX*)c, WC_HASH_TYPE_SHA512);
+}
+#endif
 
-        wc_InitSha256(&sha256);
-        start = wolfCLU_getTime();
-        alarm(timer);
+#if defined(HAVE_PKCS12) && !defined(NO_SHA256)
+/* PKCS#12 key derivation (RFC 7292 appendix B) as used by PBE, id 1 is
+ * for the encryption key */
+static int benchPkcs12Sha256(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return wc_PKCS12_PBKDF(ctx->out, ctx->in, ctx->sz, ctx->iv,
+            BENCH_KDF_SALT_SZ, BENCH_KDF_ITER, BENCH_KDF_KEY_SZ,
+            WC_HASH_TYPE_SHA256, 1);
+}
+#endif
+#endif /* !NO_PWDBASED */
 
-        while (loop) {
-            wc_Sha256Update(&sha256, plain, MEGABYTE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
-        }
-        wc_Sha256Final(&sha256, digest);
-        printf("Sha256 ");
-        wolfCLU_stats(start, MEGABYTE, blocks);
-        XMEMSET(plain, 0, MEGABYTE);
-        XMEMSET(digest, 0, WC_SHA256_DIGEST_SIZE);
-        wolfCLU_freeBins(plain, digest, NULL, NULL, NULL);
-        /* resets used for debug, uncomment if needed */
-        blocks = 0;
-        loop = 1;
-    }
-    i++;
+#ifndef WC_NO_RNG
+/* uses the same chunked generation as the rand command */
+static int benchDrbgInit(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_InitRng(&ctx->alg.rng);
+}
+
+static int benchDrbg(void* c)
+{
+    WOLFCLU_BENCH_CTX* ctx = (WOLFCLU_BENCH_CTX*)c;
+    return (wolfCLU_RandGenerate(&ctx->alg.rng, ctx->out, ctx->sz) ==
+            WOLFCLU_SUCCESS)? 0 : -1;
+}
+
+static int benchDrbgFinal(WOLFCLU_BENCH_CTX* ctx)
+{
+    return wc_FreeRng(&ctx->alg.rng);
+}
+#endif
+
+
+/* every algorithm bench can time, -all runs each one in this order */
+static const WOLFCLU_BENCH_ALG benchAlgs[] = {
+#ifndef NO_AES
+    { "AES-CBC", "aes-cbc", AES_BLOCK_SIZE, AES_BLOCK_SIZE,
+        benchAesCbcInit, benchAesCbc, NULL, NULL, 0 },
+#endif
+#ifdef WOLFSSL_AES_COUNTER
+    { "AES-CTR", "aes-ctr", AES_BLOCK_SIZE, AES_BLOCK_SIZE,
+        benchAesCtrInit, benchAesCtr, NULL, NULL, 0 },
+#endif
+#ifndef NO_DES3
+    { "3DES", "3des", DES3_BLOCK_SIZE, DES3_BLOCK_SIZE,
+        benchDes3Init, benchDes3, NULL, NULL, 0 },
+#endif
+#ifdef HAVE_CAMELLIA
+    { "Camellia", "camellia", CAMELLIA_BLOCK_SIZE, CAMELLIA_BLOCK_SIZE,
+        benchCamelliaInit, benchCamellia, NULL, NULL, 0 },
+#endif
+#ifndef NO_MD5
+    { "MD5", "md5", MEGABYTE, WC_MD5_DIGEST_SIZE,
+        benchMd5Init, benchMd5, benchMd5Final, NULL, 0 },
+#endif
+#ifndef NO_SHA
+    { "Sha", "sha", MEGABYTE, WC_SHA_DIGEST_SIZE,
+        benchShaInit, benchSha, benchShaFinal, NULL, 0 },
+#endif
+#ifndef NO_SHA256
+    { "Sha256", "sha256", MEGABYTE, WC_SHA256_DIGEST_SIZE,
+        benchSha256Init, benchSha256, benchSha256Final, NULL, 0 },
 #endif
 #ifdef WOLFSSL_SHA384
-    #define SHA384_SZ WC_SHA384_DIGEST_SIZE
-    /* sha384 test */
-    if (option[i] == 1) {
-        wc_Sha384 sha384;
+    { "Sha384", "sha384", MEGABYTE, WC_SHA384_DIGEST_SIZE,
+        benchSha384Init, benchSha384, benchSha384Final, NULL, 0 },
+#endif
+#ifdef WOLFSSL_SHA512
+    { "Sha512", "sha512", MEGABYTE, WC_SHA512_DIGEST_SIZE,
+        benchSha512Init, benchSha512, benchSha512Final, NULL, 0 },
+#endif
+#ifdef HAVE_BLAKE2
+    { "Blake2b", "blake2b", MEGABYTE, BLAKE2B_OUTBYTES,
+        benchBlake2bInit, benchBlake2b, benchBlake2bFinal, NULL, 0 },
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+    { "AES-128-GCM", "aes-128-gcm", 0, 0,
+        benchAesGcm128Init, benchAesGcmEnc, NULL, benchAesGcmDec, 0 },
+    { "AES-256-GCM", "aes-256-gcm", 0, 0,
+        benchAesGcm256Init, benchAesGcmEnc, NULL, benchAesGcmDec, 0 },
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESCCM)
+    { "AES-128-CCM", "aes-ccm", 0, 0,
+        benchAesCcmInit, benchAesCcmEnc, NULL, benchAesCcmDec, 0 },
+#endif
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    { "ChaCha20-Poly1305", "chacha20-poly1305", 0, 0,
+        NULL, benchChaChaPolyEnc, NULL, benchChaChaPolyDec, 0 },
+#endif
+#ifndef NO_PWDBASED
+#ifndef NO_SHA
+    { "PBKDF2-SHA", "pbkdf2-sha", BENCH_KDF_PWD_SZ, BENCH_KDF_KEY_SZ,
+        NULL, benchPbkdf2Sha, NULL, NULL, BENCH_KDF_ITER },
+#endif
+#ifndef NO_SHA256
+    { "PBKDF2-SHA256", "pbkdf2-sha256", BENCH_KDF_PWD_SZ, BENCH_KDF_KEY_SZ,
+        NULL, benchPbkdf2Sha256, NULL, NULL, BENCH_KDF_ITER },
+#endif
+#ifdef WOLFSSL_SHA384
+    { "PBKDF2-SHA384", "pbkdf2-sha384", BENCH_KDF_PWD_SZ, BENCH_KDF_KEY_SZ,
+        NULL, benchPbkdf2Sha384, NULL, NULL, BENCH_KDF_ITER },
+#endif
+#ifdef WOLFSSL_SHA512
+    { "PBKDF2-SHA512", "pbkdf2-sha512", BENCH_KDF_PWD_SZ, BENCH_KDF_KEY_SZ,
+        NULL, benchPbkdf2Sha512, NULL, NULL, BENCH_KDF_ITER },
+#endif
+#if defined(HAVE_PKCS12) && !defined(NO_SHA256)
+    { "PKCS12-SHA256", "pkcs12-sha256", BENCH_KDF_PWD_SZ, BENCH_KDF_KEY_SZ,
+        NULL, benchPkcs12Sha256, NULL, NULL, BENCH_KDF_ITER },
+#endif
+#endif /* !NO_PWDBASED */
+#ifndef WC_NO_RNG
+    { "DRBG", "drbg", MEGABYTE, MEGABYTE,
+        benchDrbgInit, benchDrbg, benchDrbgFinal, NULL, 0 },
+#endif
+    { NULL, NULL, 0, 0, NULL, NULL, NULL, NULL, 0 }
+};
+
+
+/* runs opts->reps latency runs of op, ctx has already been set up
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_benchOpLatency(const char* name, wolfCLU_BenchOp op,
+        WOLFCLU_BENCH_CTX* ctx, const WOLFCLU_BENCH_OPTS* opts)
+{
+    int ret = WOLFCLU_SUCCESS;
+    int i;
+    WOLFCLU_BENCH_HIST* run;
+    WOLFCLU_BENCH_HIST* all;
+    double* runMeans;
+    double* runP99s;
+
+    run = (WOLFCLU_BENCH_HIST*)XMALLOC(sizeof(WOLFCLU_BENCH_HIST), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    all = (WOLFCLU_BENCH_HIST*)XMALLOC(sizeof(WOLFCLU_BENCH_HIST), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    runMeans = (double*)XMALLOC(sizeof(double) * opts->reps, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    runP99s  = (double*)XMALLOC(sizeof(double) * opts->reps, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (run == NULL || all == NULL || runMeans == NULL || runP99s == NULL) {
+        ret = MEMORY_E;
+    }
 
-        digest = XMALLOC(SHA384_SZ, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (digest == NULL)
-            return MEMORY_E;
-        plain = XMALLOC(MEGABYTE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            wolfCLU_freeBins(digest, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
+    if (ret == WOLFCLU_SUCCESS) {
+        wolfCLU_HistInit(all);
+        for (i = 0; i < opts->reps && ret == WOLFCLU_SUCCESS; i++) {
+            wolfCLU_HistInit(run);
+            ret = wolfCLU_benchLatency(op, ctx, opts->timer,
+                    opts->warmup, run);
+            if (ret == WOLFCLU_SUCCESS) {
+                runMeans[i] = run->sum / (double)run->total;
+                runP99s[i]  = (double)wolfCLU_HistPercentile(run, 99.0);
+                wolfCLU_HistMerge(all, run);
+            }
         }
+    }
 
-        wc_RNG_GenerateBlock(&rng, plain, MEGABYTE);
+    if (ret == WOLFCLU_SUCCESS) {
+        wolfCLU_benchLatencyReport(name, all, runMeans, runP99s,
+                opts->reps, opts->warmup);
+    }
 
-        wc_InitSha384(&sha384);
-        start = wolfCLU_getTime();
-        alarm(timer);
+    XFREE(run, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(all, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(runMeans, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(runP99s, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
 
-        while (loop) {
-            wc_Sha384Update(&sha384, plain, MEGABYTE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
+
+/* prints MB/s for a run, followed by cycles per byte when available */
+static void wolfCLU_benchAeadCols(const WOLFCLU_BENCH_RESULT* res,
+        char* buf, int bufSz)
+{
+    double mbs = 0.0;
+
+    if (res->ns > 0) {
+        mbs = ((double)res->bytes / MEGABYTE) /
+              ((double)res->ns / 1000000000.0);
+    }
+    if (res->cycles > 0 && res->bytes > 0) {
+        XSNPRINTF(buf, bufSz, "%9.1f %8.2f", mbs,
+                (double)res->cycles / (double)res->bytes);
+    }
+    else {
+        XSNPRINTF(buf, bufSz, "%9.1f %8s", mbs, "-");
+    }
+}
+
+
+/* runs an AEAD over every message and AAD size combination, timing
+ * encryption and decryption with tag verification separately
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_benchAead(const WOLFCLU_BENCH_ALG* alg,
+        WOLFCLU_BENCH_CTX* ctx, const WOLFCLU_BENCH_OPTS* opts,
+        WOLFCLU_BENCH_PERF* perf)
+{
+    int ret = WOLFCLU_SUCCESS;
+    int m, a;
+    char name[MAX_TERM_WIDTH];
+    char encCols[32];
+    char decCols[32];
+    WOLFCLU_BENCH_RESULT encRes;
+    WOLFCLU_BENCH_RESULT decRes;
+    WOLFCLU_BENCH_PERF   encPerf;
+
+    if (!opts->latency) {
+        WOLFCLU_LOG(WOLFCLU_L0, "%s", alg->name);
+        WOLFCLU_LOG(WOLFCLU_L0, "%8s %6s %9s %8s %9s %8s", "msg", "aad",
+                "enc MB/s", "enc c/B", "dec MB/s", "dec c/B");
+    }
+
+    for (m = 0; m < opts->msgSzCount && ret == WOLFCLU_SUCCESS; m++) {
+        for (a = 0; a < opts->aadSzCount && ret == WOLFCLU_SUCCESS; a++) {
+            ctx->sz    = opts->msgSz[m];
+            ctx->aadSz = opts->aadSz[a];
+
+            /* produce a valid cipher text and tag for the decrypt runs */
+            if (alg->op(ctx) != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "%s encrypt failed", alg->name);
+                ret = WOLFCLU_FATAL_ERROR;
+                break;
+            }
+
+            if (opts->latency) {
+                XSNPRINTF(name, sizeof(name), "%s enc %u/%u", alg->name,
+                        ctx->sz, ctx->aadSz);
+                ret = wolfCLU_benchOpLatency(name, alg->op, ctx, opts);
+                if (ret == WOLFCLU_SUCCESS) {
+                    XSNPRINTF(name, sizeof(name), "%s dec %u/%u", alg->name,
+                            ctx->sz, ctx->aadSz);
+                    ret = wolfCLU_benchOpLatency(name, alg->dec, ctx, opts);
+                }
+                continue;
+            }
+
+            wolfCLU_PerfStart(perf);
+            ret = wolfCLU_benchRun(alg->op, ctx, ctx->sz, opts->timer,
+                    &encRes);
+            wolfCLU_PerfStop(perf);
+            if (perf != NULL) {
+                encPerf = *perf;
+            }
+            if (ret == WOLFCLU_SUCCESS) {
+                wolfCLU_PerfStart(perf);
+                ret = wolfCLU_benchRun(alg->dec, ctx, ctx->sz, opts->timer,
+                        &decRes);
+                wolfCLU_PerfStop(perf);
+            }
+            if (ret == WOLFCLU_SUCCESS) {
+                wolfCLU_benchAeadCols(&encRes, encCols, sizeof(encCols));
+                wolfCLU_benchAeadCols(&decRes, decCols, sizeof(decCols));
+                WOLFCLU_LOG(WOLFCLU_L0, "%8u %6u %s %s", ctx->sz, ctx->aadSz,
+                        encCols, decCols);
+                if (perf != NULL) {
+                    wolfCLU_PerfReport(&encPerf, "    enc ", &encRes);
+                    wolfCLU_PerfReport(perf, "    dec ", &decRes);
+                }
+            }
         }
-        wc_Sha384Final(&sha384, digest);
-        printf("Sha384 ");
-        wolfCLU_stats(start, MEGABYTE, blocks);
-        XMEMSET(plain, 0, MEGABYTE);
-        XMEMSET(digest, 0, WC_SHA384_DIGEST_SIZE);
-        wolfCLU_freeBins(plain, digest, NULL, NULL, NULL);
-        blocks = 0;
-        loop = 1;
     }
-    i++;
-#endif
-#ifdef WOLFSSL_SHA512
-    #define SHA512_SZ WC_SHA512_DIGEST_SIZE
-    /* sha512 test */
-    if (option[i] == 1) {
-        wc_Sha512 sha512;
+    WOLFCLU_LOG(WOLFCLU_L0, " ");
+
+    return ret;
+}
+
+
+/* prints derivations and iterations per second for a KDF run */
+static void wolfCLU_benchKdfReport(const WOLFCLU_BENCH_ALG* alg,
+        const WOLFCLU_BENCH_RESULT* res)
+{
+    double sec;
+    double perSec;
+
+    if (res->ops == 0 || res->ns == 0) {
+        return;
+    }
+    sec    = (double)res->ns / 1000000000.0;
+    perSec = (double)res->ops / sec;
+
+    WOLFCLU_LOG(WOLFCLU_L0, "%s took %6.3f seconds, ops = %llu", alg->name,
+            sec, (unsigned long long)res->ops);
+    WOLFCLU_LOG(WOLFCLU_L0, "Derivations/s = %10.1f (%u iterations each)",
+            perSec, alg->iter);
+    WOLFCLU_LOG(WOLFCLU_L0, "Iterations/s  = %10.0f", perSec * alg->iter);
+    if (res->cycles > 0) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Cycles/iteration = %.1f\n",
+                (double)res->cycles / ((double)res->ops * alg->iter));
+    }
+    else {
+        WOLFCLU_LOG(WOLFCLU_L0, " ");
+    }
+}
+
+
+/* prints the heap use of one algorithm from set up to tear down, only done
+ * when the counting allocators were installed with -memstats */
+static void wolfCLU_benchMemReport(const char* name,
+        const WOLFCLU_MEM_STATS* mark)
+{
+    WOLFCLU_MEM_STATS use;
+
+    wolfCLU_MemStatsSince(mark, &use);
+    WOLFCLU_LOG(WOLFCLU_L0, "%s heap: %llu allocs, %llu bytes total",
+            name, (unsigned long long)use.allocs,
+            (unsigned long long)use.totalBytes);
+    WOLFCLU_LOG(WOLFCLU_L0, "%s heap: peak %llu bytes, largest %llu bytes",
+            name, (unsigned long long)use.peakBytes,
+            (unsigned long long)use.maxAlloc);
+    if (use.curBytes > 0) {
+        WOLFCLU_LOG(WOLFCLU_L0, "%s heap: %llu bytes not freed", name,
+                (unsigned long long)use.curBytes);
+    }
+    WOLFCLU_LOG(WOLFCLU_L0, " ");
+}
+
+
+/* sets up, times and tears down a single algorithm
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_benchAlg(const WOLFCLU_BENCH_ALG* alg, WC_RNG* rng,
+        const WOLFCLU_BENCH_OPTS* opts, WOLFCLU_BENCH_PERF* perf)
+{
+    int ret = WOLFCLU_SUCCESS;
+    int reportDone = 0;
+    int i;
+    word32 inSz  = alg->inSz;
+    word32 outSz = alg->outSz;
+    word32 aadSz = 0;
+    WOLFCLU_BENCH_CTX    ctx;
+    WOLFCLU_BENCH_RESULT res;
+    WOLFCLU_MEM_STATS    mark;
+
+    wolfCLU_MemStatsMark(&mark);
+
+    if (alg->dec != NULL) {
+        /* AEAD buffers are sized for the largest point of the sweep */
+        for (i = 0; i < opts->msgSzCount; i++) {
+            inSz = (opts->msgSz[i] > inSz)? opts->msgSz[i] : inSz;
+        }
+        for (i = 0; i < opts->aadSzCount; i++) {
+            aadSz = (opts->aadSz[i] > aadSz)? opts->aadSz[i] : aadSz;
+        }
+        outSz = inSz;
+    }
 
-        digest = XMALLOC(SHA512_SZ, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (digest == NULL)
-            return MEMORY_E;
-        plain = XMALLOC(MEGABYTE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            wolfCLU_freeBins(digest, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
+    XMEMSET(&ctx, 0, sizeof(ctx));
+    ctx.sz  = inSz;
+    ctx.in  = (byte*)XMALLOC(inSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    ctx.out = (byte*)XMALLOC(outSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (ctx.in == NULL || ctx.out == NULL) {
+        ret = MEMORY_E;
+    }
+    if (ret == WOLFCLU_SUCCESS && aadSz > 0) {
+        ctx.aad = (byte*)XMALLOC(aadSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (ctx.aad == NULL) {
+            ret = MEMORY_E;
         }
+    }
 
-        wc_RNG_GenerateBlock(&rng, plain, MEGABYTE);
+    if (ret == WOLFCLU_SUCCESS) {
+        if (wc_RNG_GenerateBlock(rng, ctx.in, ctx.sz) != 0 ||
+                (aadSz > 0 &&
+                 wc_RNG_GenerateBlock(rng, ctx.aad, aadSz) != 0) ||
+                wc_RNG_GenerateBlock(rng, ctx.key, BENCH_KEY_SZ) != 0 ||
+                wc_RNG_GenerateBlock(rng, ctx.iv, BENCH_KEY_SZ) != 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
 
-        wc_InitSha512(&sha512);
-        start = wolfCLU_getTime();
-        alarm(timer);
+    if (ret == WOLFCLU_SUCCESS && alg->init != NULL &&
+            alg->init(&ctx) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to set up %s", alg->name);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
 
-        while (loop) {
-            wc_Sha512Update(&sha512, plain, MEGABYTE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
+    if (ret == WOLFCLU_SUCCESS) {
+        if (alg->dec != NULL) {
+            ret = wolfCLU_benchAead(alg, &ctx, opts, perf);
+            reportDone = 1;
+        }
+        else if (opts->latency) {
+            ret = wolfCLU_benchOpLatency(alg->name, alg->op, &ctx, opts);
+            reportDone = 1;
+        }
+        else {
+            /* a KDF has no throughput in bytes, only in derivations */
+            wolfCLU_PerfStart(perf);
+            ret = wolfCLU_benchRun(alg->op, &ctx,
+                    (alg->iter > 0)? 0 : ctx.sz, opts->timer, &res);
+            wolfCLU_PerfStop(perf);
         }
-        wc_Sha512Final(&sha512, digest);
-        printf("Sha512 ");
-        wolfCLU_stats(start, MEGABYTE, blocks);
-        XMEMSET(plain, 0, MEGABYTE);
-        XMEMSET(digest, 0, WC_SHA512_DIGEST_SIZE);
-        wolfCLU_freeBins(plain, digest, NULL, NULL, NULL);
-        blocks = 0;
-        loop = 1;
     }
-    i++;
-#endif
-#ifdef HAVE_BLAKE2
-    /* blake2b test */
-    if (option[i] == 1) {
-        Blake2b  b2b;
-
-        digest = XMALLOC(BLAKE2B_OUTBYTES, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (digest == NULL)
-            return MEMORY_E;
-        plain = XMALLOC(MEGABYTE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (plain == NULL) {
-            wolfCLU_freeBins(digest, NULL, NULL, NULL, NULL);
-            return MEMORY_E;
+
+    if (ret == WOLFCLU_SUCCESS && alg->final != NULL &&
+            alg->final(&ctx) != 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && !reportDone) {
+        if (alg->iter > 0) {
+            wolfCLU_benchKdfReport(alg, &res);
+        }
+        else {
+            wolfCLU_benchReport(alg->name, ctx.sz, &res);
         }
+        wolfCLU_PerfReport(perf, NULL, &res);
+    }
+
+    if (ctx.in != NULL) {
+        XMEMSET(ctx.in, 0, inSz);
+    }
+    if (ctx.out != NULL) {
+        XMEMSET(ctx.out, 0, outSz);
+    }
+    wolfCLU_ForceZero(&ctx.alg, sizeof(ctx.alg));
+    wolfCLU_ForceZero(ctx.key, BENCH_KEY_SZ);
+    wolfCLU_ForceZero(ctx.iv, BENCH_KEY_SZ);
+    wolfCLU_freeBins(ctx.in, ctx.out, ctx.aad, NULL, NULL);
+
+    if (ret == WOLFCLU_SUCCESS && wolfCLU_MemStatsEnabled()) {
+        wolfCLU_benchMemReport(alg->name, &mark);
+    }
+
+    return ret;
+}
+
+
+/*
+ * benchmarking funciton
+ */
+/* returns 1 if alg was named on the command line or -all was given */
+static int wolfCLU_benchWanted(const WOLFCLU_BENCH_ALG* alg,
+        const WOLFCLU_BENCH_OPTS* opts, int argc, char** argv)
+{
+    if (opts->all) {
+        return 1;
+    }
+    return wolfCLU_checkForArg(alg->arg, (int)XSTRLEN(alg->arg), argc,
+            argv) > 0;
+}
+
+
+int wolfCLU_benchSelected(const WOLFCLU_BENCH_OPTS* opts, int argc,
+        char** argv)
+{
+    int i;
+    int count = 0;
+
+    for (i = 0; benchAlgs[i].name != NULL; i++) {
+        count += wolfCLU_benchWanted(&benchAlgs[i], opts, argc, argv);
+    }
+    return count;
+}
 
-        wc_RNG_GenerateBlock(&rng, plain, MEGABYTE);
 
-        wc_InitBlake2b(&b2b, BLAKE2B_OUTBYTES);
-        start = wolfCLU_getTime();
-        alarm(timer);
+int wolfCLU_benchmark(const WOLFCLU_BENCH_OPTS* opts, int argc, char** argv)
+{
+    int     i;
+    int     ret = WOLFCLU_SUCCESS;
+    WC_RNG  rng;
+    WOLFCLU_BENCH_PERF  perf;
+    WOLFCLU_BENCH_PERF* perfPtr = NULL;
+
+    if (wc_InitRng(&rng) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to initialize RNG");
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    /* calibrate the cycle counter once, before any timed runs */
+    wolfCLU_TimerInit();
 
-        while (loop) {
-            wc_Blake2bUpdate(&b2b, plain, MEGABYTE);
-            blocks++;
-            currTime = wolfCLU_getTime();
-            stop = currTime - start;
-            /* if stop >= timer, loop = 0 */
-            loop = (stop >= timer) ? 0 : 1;
+    /* counters are optional, results are still useful without them */
+    if (opts->perf) {
+        if (opts->latency) {
+            WOLFCLU_LOG(WOLFCLU_L0, "-perf is not used with -latency");
+        }
+        else if (wolfCLU_PerfOpen(&perf) == WOLFCLU_SUCCESS) {
+            perfPtr = &perf;
         }
-        wc_Blake2bFinal(&b2b, digest, BLAKE2B_OUTBYTES);
-        printf("Blake2b ");
-        wolfCLU_stats(start, MEGABYTE, blocks);
-        XMEMSET(plain, 0, MEGABYTE);
-        XMEMSET(digest, 0, BLAKE2B_OUTBYTES);
-        wolfCLU_freeBins(digest, plain, NULL, NULL, NULL);
     }
-#endif
-    (void)blocks;
-    (void)loop;
+    printf("\n");
+
+    for (i = 0; benchAlgs[i].name != NULL && ret == WOLFCLU_SUCCESS; i++) {
+        if (wolfCLU_benchWanted(&benchAlgs[i], opts, argc, argv)) {
+            ret = wolfCLU_benchAlg(&benchAlgs[i], &rng, opts, perfPtr);
+        }
+    }
+
+    if (perfPtr != NULL) {
+        wolfCLU_PerfClose(perfPtr);
+    }
+    wc_FreeRng(&rng);
     return ret;
 }
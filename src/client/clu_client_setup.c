@@ -76,6 +76,7 @@ int wolfCLU_Client(int argc, char** argv)
     func_args args;
     int ret     = WOLFCLU_SUCCESS;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     int option;
     char* host = NULL;
     int   idx  = 0;
@@ -86,26 +87,25 @@ int wolfCLU_Client(int argc, char** argv)
     /* burn one argv for executable name spot */
     ret = _addClientArg(clientArgv, "wolfclu", &clientArgc);
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "", client_options,
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv, client_options,
                     &longIndex )) != -1) {
         switch (option) {
             case WOLFCLU_CONNECT:
-                if (XSTRSTR(optarg, ":") == NULL) {
+                if (XSTRSTR(opt.arg, ":") == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "connect string does not have ':'");
                     ret = WOLFCLU_FATAL_ERROR;
                 }
 
                 if (ret == WOLFCLU_SUCCESS) {
-                    idx = (int)strcspn(optarg, ":");
+                    idx = (int)strcspn(opt.arg, ":");
                     host = (char*)XMALLOC(idx + 1, HEAP_HINT,
                             DYNAMIC_TYPE_TMP_BUFFER);
                     if (host == NULL) {
                         ret = WOLFCLU_FATAL_ERROR;
                     }
                     else {
-                        XMEMCPY(host, optarg, idx);
+                        XMEMCPY(host, opt.arg, idx);
                         host[idx] = '\0';
                         ret = _addClientArg(clientArgv, hostFlag, &clientArgc);
                         if (ret == WOLFCLU_SUCCESS) {
@@ -117,7 +117,7 @@ int wolfCLU_Client(int argc, char** argv)
                 if (ret == WOLFCLU_SUCCESS) {
                     ret = _addClientArg(clientArgv, portFlag, &clientArgc);
                     if (ret == WOLFCLU_SUCCESS) {
-                        ret = _addClientArg(clientArgv, optarg + idx + 1,
+                        ret = _addClientArg(clientArgv, opt.arg + idx + 1,
                                 &clientArgc);
                     }
                 }
@@ -127,7 +127,7 @@ int wolfCLU_Client(int argc, char** argv)
                 if (ret == WOLFCLU_SUCCESS) {
                     ret = _addClientArg(clientArgv, startTLSFlag, &clientArgc);
                     if (ret == WOLFCLU_SUCCESS) {
-                        ret = _addClientArg(clientArgv, optarg, &clientArgc);
+                        ret = _addClientArg(clientArgv, opt.arg, &clientArgc);
                     }
                 }
                 break;
@@ -0,0 +1,213 @@
+/* clu_lib.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_lib.h>
+#include <wolfclu/x509/clu_cert.h>
+#include <wolfclu/x509/clu_request.h>
+#include <wolfclu/sign-verify/clu_sign_verify_setup.h>
+
+struct WOLFCLU_CTX {
+    WOLFCLU_LOG_CONFIG log;
+};
+
+typedef int (*wolfCLU_SetupFunc)(int argc, char** argv);
+
+
+int wolfCLU_LibInit(void)
+{
+#ifdef HAVE_FIPS
+    if (wolfCrypt_GetStatus_fips() == IN_CORE_FIPS_E) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Linked to a FIPS version of wolfSSL that has "
+                "failed the in core integrity check");
+        return WOLFCLU_FATAL_ERROR;
+    }
+#endif
+    if (wolfCrypt_Init() != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "wolfCrypt initialization failed!");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+void wolfCLU_LibCleanup(void)
+{
+    wolfCrypt_Cleanup();
+}
+
+
+WOLFCLU_CTX* wolfCLU_CTX_new(void)
+{
+    WOLFCLU_CTX* ctx;
+
+    ctx = (WOLFCLU_CTX*)XMALLOC(sizeof(WOLFCLU_CTX), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (ctx != NULL) {
+        wolfCLU_LogConfigInit(&ctx->log);
+    }
+    return ctx;
+}
+
+
+void wolfCLU_CTX_free(WOLFCLU_CTX* ctx)
+{
+    if (ctx != NULL) {
+        XFREE(ctx, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+}
+
+
+int wolfCLU_CTX_SetLoggingCb(WOLFCLU_CTX* ctx, wolfCLU_LoggingCtxCb cb,
+        void* cbCtx)
+{
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    ctx->log.cb    = cb;
+    ctx->log.cbCtx = cbCtx;
+    return WOLFCLU_SUCCESS;
+}
+
+
+int wolfCLU_CTX_SetQuiet(WOLFCLU_CTX* ctx, int quiet)
+{
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    ctx->log.quiet = quiet;
+    return WOLFCLU_SUCCESS;
+}
+
+
+int wolfCLU_CTX_SetLogFormat(WOLFCLU_CTX* ctx, int format)
+{
+    if (ctx == NULL ||
+            (format != WOLFCLU_LOG_TEXT && format != WOLFCLU_LOG_JSON)) {
+        return BAD_FUNC_ARG;
+    }
+    ctx->log.format = format;
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* 'enc' is encrypt unless -d is given, as in main */
+static int wolfCLU_EncSetup(int argc, char** argv)
+{
+    if (wolfCLU_checkForArg("-d", 2, argc, argv) > 0) {
+        return wolfCLU_setup(argc, argv, 'd');
+    }
+    return wolfCLU_setup(argc, argv, 'e');
+}
+
+
+/* runs setup with argv laid out as main would pass it, "wolfssl <mode>"
+ * followed by the callers arguments. The arguments are copied since some
+ * commands change them in place, and the calling thread logs with the
+ * settings in ctx until the command returns */
+static int wolfCLU_CTX_Run(WOLFCLU_CTX* ctx, const char* mode, int argc,
+        const char* const* argv, wolfCLU_SetupFunc setup)
+{
+    WOLFCLU_LOG_CONFIG* prev;
+    char**  args;
+    char*   str;
+    word32  sz;
+    int     ret;
+    int     i;
+
+    if (ctx == NULL || argc < 0 || (argc > 0 && argv == NULL)) {
+        return BAD_FUNC_ARG;
+    }
+
+    /* one allocation for the pointers followed by the strings */
+    sz = (word32)((argc + 3) * sizeof(char*));
+    sz += (word32)XSTRLEN("wolfssl") + 1 + (word32)XSTRLEN(mode) + 1;
+    for (i = 0; i < argc; i++) {
+        if (argv[i] == NULL) {
+            return BAD_FUNC_ARG;
+        }
+        sz += (word32)XSTRLEN(argv[i]) + 1;
+    }
+    args = (char**)XMALLOC(sz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (args == NULL) {
+        return MEMORY_E;
+    }
+
+    str = (char*)(args + argc + 3);
+    for (i = 0; i < argc + 2; i++) {
+        const char* src = (i == 0)? "wolfssl" : (i == 1)? mode : argv[i - 2];
+        word32 len = (word32)XSTRLEN(src) + 1;
+
+        XMEMCPY(str, src, len);
+        args[i] = str;
+        str += len;
+    }
+    args[argc + 2] = NULL;
+
+    ctx->log.command = mode;
+    prev = wolfCLU_LogSetThreadConfig(&ctx->log);
+    ret  = setup(argc + 2, args);
+    wolfCLU_LogSetThreadConfig(prev);
+
+    XFREE(args, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+
+    if (ret != WOLFCLU_SUCCESS && ret >= 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    return ret;
+}
+
+
+int wolfCLU_Hash(WOLFCLU_CTX* ctx, int argc, const char* const* argv)
+{
+    return wolfCLU_CTX_Run(ctx, "hash", argc, argv, wolfCLU_hashSetup);
+}
+
+
+int wolfCLU_Enc(WOLFCLU_CTX* ctx, int argc, const char* const* argv)
+{
+    return wolfCLU_CTX_Run(ctx, "enc", argc, argv, wolfCLU_EncSetup);
+}
+
+
+int wolfCLU_Dgst(WOLFCLU_CTX* ctx, int argc, const char* const* argv)
+{
+    return wolfCLU_CTX_Run(ctx, "dgst", argc, argv, wolfCLU_dgst_setup);
+}
+
+
+int wolfCLU_X509(WOLFCLU_CTX* ctx, int argc, const char* const* argv)
+{
+    return wolfCLU_CTX_Run(ctx, "x509", argc, argv, wolfCLU_certSetup);
+}
+
+
+int wolfCLU_Req(WOLFCLU_CTX* ctx, int argc, const char* const* argv)
+{
+    return wolfCLU_CTX_Run(ctx, "req", argc, argv, wolfCLU_requestSetup);
+}
+
+
+int wolfCLU_CA(WOLFCLU_CTX* ctx, int argc, const char* const* argv)
+{
+    return wolfCLU_CTX_Run(ctx, "ca", argc, argv, wolfCLU_CASetup);
+}
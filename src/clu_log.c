@@ -21,36 +21,150 @@
 
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
+#include <time.h>
 
+#if !defined(SINGLE_THREADED) && (defined(__GNUC__) || defined(__clang__))
+    #include <pthread.h>
+    #include <sched.h>
+    #define WOLFCLU_LOG_ASYNC
+#endif
+
+/* messages up to this size are formatted on the stack, or in place in the
+ * ring, longer ones are formatted again into a heap buffer of the right
+ * size so nothing is cut off */
 #ifndef WOLCLU_LOG_LINE_WIDTH
-#define WOLCLU_LOG_LINE_WIDTH 80
+#define WOLCLU_LOG_LINE_WIDTH 256
 #endif
 
-static int loggingLevel = 0; /* 0 is error level and always print,
-                                1 is some extra info, 2 is more verbose and so
-                                on */
-static int loggingEnabled = 1; /* default to on and at level 0 for errors */
+/* settings used by threads that have not installed their own */
+static WOLFCLU_LOG_CONFIG logDefault = {
+    0,                  /* level, 0 is error level and always print, 1 is some
+                         * extra info, 2 is more verbose and so on */
+    1,                  /* enabled, default to on and at level 0 for errors */
+    0,                  /* quiet */
+    WOLFCLU_LOG_TEXT,   /* format */
+    NULL,               /* command */
+    NULL,               /* cb */
+    NULL                /* cbCtx */
+};
+static WOLFCLU_THREAD_LS WOLFCLU_LOG_CONFIG* logThreadConfig = NULL;
+
+/* the settings that apply to the calling thread */
+#define LOG_CFG ((logThreadConfig != NULL)? logThreadConfig : &logDefault)
+
 void DefaultLoggingCb(int logLevel, const char *const msgStr);
-static wolfCLU_LoggingCb logFunction = DefaultLoggingCb;
 
+/* where a message goes, decided when it is logged so that turning output
+ * off and on again applies to queued messages as well */
+#define WOLFCLU_LOG_TO_STDOUT 1
+#define WOLFCLU_LOG_TO_STDERR 2
+
+#ifdef WOLFCLU_LOG_ASYNC
+/* number of queued messages, a power of two */
+#define WOLFCLU_LOG_RING_SZ 1024
+
+/* longest time the flusher sleeps while the ring is empty */
+#define WOLFCLU_LOG_IDLE_NS 1000000
+
+/* longest command name kept with a queued message, longer ones are cut */
+#define WOLFCLU_LOG_CMD_SZ 32
+
+/* one queued message, seq follows the bounded MPMC queue by Dmitry Vyukov:
+ * it equals the slot position when free and position + 1 once written */
+typedef struct WOLFCLU_LOG_SLOT {
+    word64 seq;
+    int    level;
+    int    dest;        /* WOLFCLU_LOG_TO_* */
+    int    len;
+    int    format;      /* of the config it was logged with */
+    int    hasCmd;      /* cmd holds the config's command */
+    char*  heap;        /* set when the message did not fit in text */
+    struct timeval tv;  /* when the message was logged */
+    char   cmd[WOLFCLU_LOG_CMD_SZ];
+    char   text[WOLCLU_LOG_LINE_WIDTH];
+} WOLFCLU_LOG_SLOT;
+
+static WOLFCLU_LOG_SLOT* logRing = NULL;
+static word64    logHead = 0;   /* next position claimed by a producer */
+static word64    logTail = 0;   /* next position read by the flusher */
+static int       logAsync = 0;
+static int       logStopping = 0;
+static int       logInFlight = 0;   /* producers that may be queueing */
+static pthread_t logThread;
+#endif
+
+
+void wolfCLU_LogConfigInit(WOLFCLU_LOG_CONFIG* cfg)
+{
+    if (cfg != NULL) {
+        cfg->level   = 0;
+        cfg->enabled = 1;
+        cfg->quiet   = 0;
+        cfg->format  = WOLFCLU_LOG_TEXT;
+        cfg->command = NULL;
+        cfg->cb      = NULL;
+        cfg->cbCtx   = NULL;
+    }
+}
+
+
+void wolfCLU_LogConfigGet(WOLFCLU_LOG_CONFIG* cfg)
+{
+    if (cfg != NULL) {
+        XMEMCPY(cfg, LOG_CFG, sizeof(WOLFCLU_LOG_CONFIG));
+    }
+}
+
+
+WOLFCLU_LOG_CONFIG* wolfCLU_LogSetThreadConfig(WOLFCLU_LOG_CONFIG* cfg)
+{
+    WOLFCLU_LOG_CONFIG* prev = logThreadConfig;
+
+    logThreadConfig = cfg;
+    return prev;
+}
 
 
 /* turn debugging off */
 void wolfCLU_OutputOFF(void)
 {
-    loggingEnabled = 0;
+    LOG_CFG->enabled = 0;
 }
 
 
 void wolfCLU_OutputON(void)
 {
-    loggingEnabled = 1;
+    LOG_CFG->enabled = 1;
+}
+
+
+void wolfCLU_LogSetQuiet(int quiet)
+{
+    LOG_CFG->quiet = quiet;
+}
+
+
+int wolfCLU_LogSetFormat(int format)
+{
+    if (format != WOLFCLU_LOG_TEXT && format != WOLFCLU_LOG_JSON) {
+        return BAD_FUNC_ARG;
+    }
+    LOG_CFG->format = format;
+    return WOLFCLU_SUCCESS;
+}
+
+
+void wolfCLU_LogSetCommand(const char* cmd)
+{
+    LOG_CFG->command = cmd;
 }
 
 
 void DefaultLoggingCb(int logLevel, const char *const msgStr)
 {
-    if (loggingEnabled && loggingLevel <= logLevel) {
+    const WOLFCLU_LOG_CONFIG* cfg = LOG_CFG;
+
+    if (cfg->enabled && cfg->level <= logLevel) {
         printf("%s\r\n", msgStr);
     }
 
@@ -60,20 +174,404 @@ void DefaultLoggingCb(int logLevel, const char *const msgStr)
 }
 
 
+static const char* wolfCLU_LogLevelName(int logLevel)
+{
+    switch (logLevel) {
+        case WOLFCLU_E0:
+            return "error";
+        case WOLFCLU_L0:
+            return "info";
+        case WOLFCLU_L1:
+            return "verbose";
+        default:
+            return "debug";
+    }
+}
+
+
+/* writes s as the contents of a JSON string */
+static void wolfCLU_LogJsonString(FILE* f, const char* s, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        }
+        else if (c == '\n') {
+            fputs("\\n", f);
+        }
+        else if (c == '\r') {
+            fputs("\\r", f);
+        }
+        else if (c == '\t') {
+            fputs("\\t", f);
+        }
+        else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        }
+        else {
+            fputc(c, f);
+        }
+    }
+}
+
+
+/* one JSON object per line with the time in UTC, level and command */
+static void wolfCLU_LogJsonLine(FILE* f, const WOLFCLU_LOG_CONFIG* cfg,
+        const struct timeval* tv, int logLevel, const char* msg, int len)
+{
+    time_t    sec = (time_t)tv->tv_sec;
+    struct tm tmBuf;
+    struct tm* t;
+    char      ts[32];
+
+#ifdef USE_WINDOWS_API
+    t = gmtime(&sec);
+    (void)tmBuf;
+#else
+    t = gmtime_r(&sec, &tmBuf);
+#endif
+    if (t == NULL || strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", t) == 0) {
+        ts[0] = '\0';
+    }
+
+    fprintf(f, "{\"ts\":\"%s.%03dZ\",\"level\":\"%s\"", ts,
+            (int)(tv->tv_usec / 1000), wolfCLU_LogLevelName(logLevel));
+    if (cfg->command != NULL) {
+        fputs(",\"cmd\":\"", f);
+        wolfCLU_LogJsonString(f, cfg->command, (int)XSTRLEN(cfg->command));
+        fputc('"', f);
+    }
+    fputs(",\"msg\":\"", f);
+    wolfCLU_LogJsonString(f, msg, len);
+    fputs("\"}\n", f);
+}
+
+
+/* writes one line to f, locked so that lines from threads writing
+ * directly, and from the flusher, are not mixed together */
+static void wolfCLU_LogLine(FILE* f, const WOLFCLU_LOG_CONFIG* cfg,
+        const struct timeval* tv, int logLevel, const char* msg, int len)
+{
+#ifndef USE_WINDOWS_API
+    flockfile(f);
+#endif
+    if (cfg->format == WOLFCLU_LOG_JSON) {
+        wolfCLU_LogJsonLine(f, cfg, tv, logLevel, msg, len);
+    }
+    else {
+        fwrite(msg, 1, len, f);
+        fputs("\r\n", f);
+    }
+#ifndef USE_WINDOWS_API
+    funlockfile(f);
+#endif
+}
+
+
+/* writes one formatted message to each destination in dest */
+static void wolfCLU_LogWrite(const WOLFCLU_LOG_CONFIG* cfg, int logLevel,
+        int dest, const struct timeval* tv, const char* msg, int len)
+{
+    if (dest & WOLFCLU_LOG_TO_STDOUT) {
+        wolfCLU_LogLine(stdout, cfg, tv, logLevel, msg, len);
+    }
+    if (dest & WOLFCLU_LOG_TO_STDERR) {
+        wolfCLU_LogLine(stderr, cfg, tv, logLevel, msg, len);
+    }
+}
+
+
+#ifdef WOLFCLU_LOG_ASYNC
+static void wolfCLU_LogSleep(long ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec  = 0;
+    ts.tv_nsec = ns;
+    nanosleep(&ts, NULL);
+}
+
+
+/* writes out every message queued so far, returns the number written */
+static int wolfCLU_LogDrain(void)
+{
+    WOLFCLU_LOG_SLOT* slot;
+    WOLFCLU_LOG_CONFIG cfg;
+    word64 seq;
+    int    count = 0;
+
+    wolfCLU_LogConfigInit(&cfg);
+    for (;;) {
+        slot = &logRing[logTail & (WOLFCLU_LOG_RING_SZ - 1)];
+        seq  = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq != logTail + 1) {
+            break; /* empty, or the producer is still writing this slot */
+        }
+
+        /* written with the settings the message was logged with, which
+         * may have changed since */
+        cfg.format  = slot->format;
+        cfg.command = slot->hasCmd? slot->cmd : NULL;
+        wolfCLU_LogWrite(&cfg, slot->level, slot->dest, &slot->tv,
+                (slot->heap != NULL)? slot->heap : slot->text, slot->len);
+        if (slot->heap != NULL) {
+            XFREE(slot->heap, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+            slot->heap = NULL;
+        }
+
+        /* hand the slot back for the position one lap ahead */
+        __atomic_store_n(&slot->seq, logTail + WOLFCLU_LOG_RING_SZ,
+                __ATOMIC_RELEASE);
+        logTail++;
+        count++;
+    }
+
+    if (count > 0) {
+        fflush(stdout);
+        fflush(stderr);
+    }
+    return count;
+}
+
+
+static void* wolfCLU_LogFlusher(void* arg)
+{
+    long idle = 1000;
+
+    (void)arg;
+
+    while (!__atomic_load_n(&logStopping, __ATOMIC_ACQUIRE)) {
+        if (wolfCLU_LogDrain() > 0) {
+            idle = 1000;
+        }
+        else {
+            /* back off while nothing is being logged */
+            wolfCLU_LogSleep(idle);
+            if (idle < WOLFCLU_LOG_IDLE_NS) {
+                idle *= 2;
+            }
+        }
+    }
+    wolfCLU_LogDrain();
+    return NULL;
+}
+
+
+/* claims the next free slot, waiting for the flusher if the ring is full */
+static WOLFCLU_LOG_SLOT* wolfCLU_LogClaim(word64* posOut)
+{
+    WOLFCLU_LOG_SLOT* slot;
+    word64 pos = __atomic_load_n(&logHead, __ATOMIC_RELAXED);
+    word64 seq;
+
+    for (;;) {
+        slot = &logRing[pos & (WOLFCLU_LOG_RING_SZ - 1)];
+        seq  = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&logHead, &pos, pos + 1, 1,
+                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *posOut = pos;
+                return slot;
+            }
+            /* pos was reloaded by the failed exchange */
+        }
+        else if ((long long)(seq - pos) < 0) {
+            /* full, the flusher has not written this slot out yet */
+            sched_yield();
+            pos = __atomic_load_n(&logHead, __ATOMIC_RELAXED);
+        }
+        else {
+            pos = __atomic_load_n(&logHead, __ATOMIC_RELAXED);
+        }
+    }
+}
+#endif /* WOLFCLU_LOG_ASYNC */
+
+
+int wolfCLU_LogStartAsync(void)
+{
+#ifdef WOLFCLU_LOG_ASYNC
+    int i;
+
+    if (logAsync) {
+        return WOLFCLU_SUCCESS;
+    }
+
+    logRing = (WOLFCLU_LOG_SLOT*)XMALLOC(
+            WOLFCLU_LOG_RING_SZ * sizeof(WOLFCLU_LOG_SLOT), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (logRing == NULL) {
+        return MEMORY_E;
+    }
+    for (i = 0; i < WOLFCLU_LOG_RING_SZ; i++) {
+        logRing[i].seq  = (word64)i;
+        logRing[i].heap = NULL;
+    }
+    logHead = 0;
+    logTail = 0;
+    logStopping = 0;
+
+    if (pthread_create(&logThread, NULL, wolfCLU_LogFlusher, NULL) != 0) {
+        XFREE(logRing, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        logRing = NULL;
+        return WOLFCLU_FATAL_ERROR;
+    }
+    __atomic_store_n(&logAsync, 1, __ATOMIC_RELEASE);
+    return WOLFCLU_SUCCESS;
+#else
+    /* messages are written as they are logged */
+    return WOLFCLU_SUCCESS;
+#endif
+}
+
+
+void wolfCLU_LogStop(void)
+{
+#ifdef WOLFCLU_LOG_ASYNC
+    if (!logAsync) {
+        return;
+    }
+
+    /* anything logged from here on is written straight away, and a
+     * producer that saw logAsync set before this is waited for so that its
+     * message is in the ring before the flusher's last drain */
+    __atomic_store_n(&logAsync, 0, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&logInFlight, __ATOMIC_SEQ_CST) != 0) {
+        sched_yield();
+    }
+    __atomic_store_n(&logStopping, 1, __ATOMIC_RELEASE);
+    pthread_join(logThread, NULL);
+
+    XFREE(logRing, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    logRing = NULL;
+#endif
+    fflush(stdout);
+    fflush(stderr);
+}
+
+
 /* our default logger */
 void wolfCLU_Log(int logLevel, const char *const fmt, ...)
 {
     va_list vlist;
     char    msgStr[WOLCLU_LOG_LINE_WIDTH];
+    char*   msg = msgStr;
+    int     len;
+    int     dest = 0;
+    struct timeval tv;
+    const WOLFCLU_LOG_CONFIG* cfg = LOG_CFG;
 
-    if (loggingLevel < logLevel)
+    if (cfg->level < logLevel)
         return;   /* don't need to output */
 
+    if (cfg->quiet && logLevel != WOLFCLU_E0)
+        return;   /* -quiet, do not even format the message */
+
+    if (cfg->enabled && cfg->level <= logLevel) {
+        dest |= WOLFCLU_LOG_TO_STDOUT;
+    }
+    if (logLevel == WOLFCLU_E0) {
+        dest |= WOLFCLU_LOG_TO_STDERR;
+    }
+    if (dest == 0) {
+        return;   /* output is turned off */
+    }
+
+    if (cfg->cb == NULL && cfg->format == WOLFCLU_LOG_JSON) {
+        gettimeofday(&tv, NULL);
+    }
+    else {
+        tv.tv_sec  = 0;
+        tv.tv_usec = 0;
+    }
+
+#ifdef WOLFCLU_LOG_ASYNC
+    /* counted before logAsync is read, wolfCLU_LogStop waits for it */
+    if (cfg->cb == NULL) {
+        __atomic_add_fetch(&logInFlight, 1, __ATOMIC_SEQ_CST);
+    }
+    if (cfg->cb == NULL && __atomic_load_n(&logAsync, __ATOMIC_SEQ_CST)) {
+        WOLFCLU_LOG_SLOT* slot;
+        word64 pos;
+
+        slot = wolfCLU_LogClaim(&pos);
+        va_start(vlist, fmt);
+        len = XVSNPRINTF(slot->text, sizeof(slot->text), fmt, vlist);
+        va_end(vlist);
+        if (len < 0) {
+            len = 0;
+            slot->text[0] = '\0';
+        }
+        else if (len >= (int)sizeof(slot->text)) {
+            slot->heap = (char*)XMALLOC(len + 1, HEAP_HINT,
+                    DYNAMIC_TYPE_TMP_BUFFER);
+            if (slot->heap != NULL) {
+                va_start(vlist, fmt);
+                XVSNPRINTF(slot->heap, len + 1, fmt, vlist);
+                va_end(vlist);
+            }
+            else {
+                len = (int)sizeof(slot->text) - 1;
+            }
+        }
+        slot->level = logLevel;
+        slot->dest  = dest;
+        slot->len   = len;
+        slot->tv    = tv;
+        slot->format = cfg->format;
+        slot->hasCmd = (cfg->command != NULL);
+        if (slot->hasCmd) {
+            XSTRNCPY(slot->cmd, cfg->command, sizeof(slot->cmd) - 1);
+            slot->cmd[sizeof(slot->cmd) - 1] = '\0';
+        }
+
+        /* publish the message to the flusher */
+        __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+        __atomic_sub_fetch(&logInFlight, 1, __ATOMIC_SEQ_CST);
+        return;
+    }
+    if (cfg->cb == NULL) {
+        __atomic_sub_fetch(&logInFlight, 1, __ATOMIC_SEQ_CST);
+    }
+#endif
+
     /* format msg */
     va_start(vlist, fmt);
-    XVSNPRINTF(msgStr, sizeof(msgStr), fmt, vlist);
+    len = XVSNPRINTF(msgStr, sizeof(msgStr), fmt, vlist);
     va_end(vlist);
+    if (len < 0) {
+        return;
+    }
+    if (len >= (int)sizeof(msgStr)) {
+        msg = (char*)XMALLOC(len + 1, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (msg == NULL) {
+            msg = msgStr; /* print what fit rather than nothing */
+            len = (int)sizeof(msgStr) - 1;
+        }
+        else {
+            va_start(vlist, fmt);
+            XVSNPRINTF(msg, len + 1, fmt, vlist);
+            va_end(vlist);
+        }
+    }
 
-    if (logFunction)
-        logFunction(logLevel, msgStr);
+    if (cfg->cb != NULL) {
+        cfg->cb(cfg->cbCtx, logLevel, msg);
+    }
+    else if (cfg->format == WOLFCLU_LOG_JSON) {
+        wolfCLU_LogWrite(cfg, logLevel, dest, &tv, msg, len);
+    }
+    else {
+        DefaultLoggingCb(logLevel, msg);
+    }
+
+    if (msg != msgStr) {
+        XFREE(msg, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
 }
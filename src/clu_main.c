@@ -21,6 +21,8 @@
 
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
+#include <wolfclu/clu_memstats.h>
+#include <wolfclu/clu_stats.h>
 #include <wolfclu/x509/clu_cert.h>
 #include <wolfclu/clu_optargs.h>
 #include <wolfclu/clu_error_codes.h>
@@ -29,6 +31,7 @@
 #include <wolfclu/pkey/clu_pkey.h>
 #include <wolfclu/sign-verify/clu_sign_verify_setup.h>
 #include <wolfclu/sign-verify/clu_verify.h>
+#include <wolfclu/sign-verify/clu_signd.h>
 /* enumerate optionals beyond ascii range to dis-allow use of alias IE we
  * do not want "-e" to work for encrypt, user must use "encrypt"
  */
@@ -60,6 +63,9 @@ static const struct option mode_options[] = {
     {"rand",      no_argument,       0, WOLFCLU_RAND        },
     {"dsaparam",  no_argument,       0, WOLFCLU_DSA         },
     {"dhparam",   no_argument,       0, WOLFCLU_DH          },
+    {"batch",     no_argument,       0, WOLFCLU_BATCH       },
+    {"signd",     no_argument,       0, WOLFCLU_SIGND       },
+    {"pkeyutl",   no_argument,       0, WOLFCLU_PKEYUTL     },
     {"help",      no_argument,       0, WOLFCLU_HELP        },
     {"h",         no_argument,       0, WOLFCLU_HELP        },
     {"v",         no_argument,       0, 'v'       },
@@ -110,66 +116,35 @@ static void myFipsCb(int ok, int err, const char* hash)
 }
 #endif
 
-int main(int argc, char** argv)
+/* parses the mode from argv[1] and runs it, this is all of a command after
+ * the global options and library setup so batch can call it for each line
+ *
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_RunCommand(int argc, char** argv)
 {
-    int     flag = 0;
-    int     ret = WOLFCLU_SUCCESS;
-    int     longIndex = 0;
-#ifdef HAVE_FIPS
-    WC_RNG rng;
-
-    wolfCrypt_SetCb_fips(myFipsCb);
-
-    #ifdef WC_RNG_SEED_CB
-        wc_SetSeed_Cb(wc_GenerateSeed);
-    #endif
-
-    ret = wc_InitRng(&rng);
-
-    if (ret != 0) {
-        WOLFCLU_LOG(WOLFCLU_E0, "Err %d, update the FIPS hash\n", ret);
-        return ret;
-    }
-
-    wc_FreeRng(&rng);
-#endif
-
-    if (argc == 1) {
-        WOLFCLU_LOG(WOLFCLU_L0, "Main Help.");
-        wolfCLU_help();
-    }
-
-#ifdef HAVE_FIPS
-    if (wolfCrypt_GetStatus_fips() == IN_CORE_FIPS_E) {
-        WOLFCLU_LOG(WOLFCLU_L0, "Linked to a FIPS version of wolfSSL that has failed the in core"
-               "integrity check. ALL FIPS crypto will report ERRORS when used."
-               "To resolve please recompile wolfSSL with the correct integrity"
-               "hash. If the issue continues, contact fips @ wolfssl.com");
-    }
-#endif
-
-    if (wolfCrypt_Init() != 0) {
-        WOLFCLU_LOG(WOLFCLU_E0, "wolfCyprt initialization failed!");
-        return -1;
-    }
-#ifdef DEBUG_WOLFSSL
-    wolfSSL_Debugging_ON();
-#endif
+    int flag = 0;
+    int ret  = WOLFCLU_SUCCESS;
+    int longIndex = 0;
+    WOLFCLU_GETOPT opt;
+    int phase;
 
     /* If the first string does not have a '-' in front of it then try to
      * get the mode to use i.e. x509, req, version ... this is for
      * compatibility with the behavior of the OpenSSL command line utility
      */
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_ARGS);
     if (argc > 1 && argv[1] != NULL && argv[1][0] != '-') {
         flag = getMode(argv[1]);
     }
     else {
         /* retain old version of modes where '-' is used. i.e -x509, -req */
-        flag = getopt_long_only(argc, argv,"", mode_options, &longIndex);
+        wolfCLU_GetOptInit(&opt);
+        flag = wolfCLU_GetOpt(&opt, argc, argv, mode_options, &longIndex);
 
         /* if -rsa was used then it is the older sign/verify version of rsa */
         if (flag == WOLFCLU_RSA) flag = WOLFCLU_RSALEGACY;
     }
+    wolfCLU_StatsEnd(phase);
 
     switch (flag) {
         case 0:
@@ -244,6 +219,10 @@ int main(int argc, char** argv)
             ret = wolfCLU_pKeySetup(argc, argv);
             break;
 
+        case WOLFCLU_PKEYUTL:
+            ret = wolfCLU_PkeyUtl(argc, argv);
+            break;
+
         case WOLFCLU_DGST:
             ret = wolfCLU_dgst_setup(argc, argv);
             break;
@@ -286,6 +265,14 @@ int main(int argc, char** argv)
             ret = wolfCLU_DhParamSetup(argc, argv);
             break;
 
+        case WOLFCLU_BATCH:
+            ret = wolfCLU_Batch(argc, argv, wolfCLU_RunCommand);
+            break;
+
+        case WOLFCLU_SIGND:
+            ret = wolfCLU_SignDSetup(argc, argv);
+            break;
+
         case WOLFCLU_HELP:
             /* only print for -help if no mode has been declared */
             WOLFCLU_LOG(WOLFCLU_L0, "Main help menu:");
@@ -306,11 +293,136 @@ int main(int argc, char** argv)
             ret = WOLFCLU_FATAL_ERROR;
     }
 
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    int     ret = WOLFCLU_SUCCESS;
+    int     i;
+    int     phase;
+    int     stats = 0;
+    int     logAsync = 0;
+    const char* tracePath = NULL;
+#ifdef HAVE_FIPS
+    WC_RNG rng;
+#endif
+
+    /* global options can be given anywhere on the command line, they are
+     * removed from argv before the mode is parsed */
+    for (i = 1; i < argc; i++) {
+        if (XSTRCMP(argv[i], "-memstats") == 0) {
+            /* installed first so that every allocation is counted */
+            if (wolfCLU_MemStatsInstall() != WOLFCLU_SUCCESS) {
+                return WOLFCLU_FATAL_ERROR;
+            }
+            XMEMMOVE(&argv[i], &argv[i + 1], (argc - i) * sizeof(char*));
+            argc--;
+            i--;
+        }
+        else if (XSTRCMP(argv[i], "-stats") == 0) {
+            stats = 1;
+            XMEMMOVE(&argv[i], &argv[i + 1], (argc - i) * sizeof(char*));
+            argc--;
+            i--;
+        }
+        else if (XSTRCMP(argv[i], "-stats-trace") == 0 && i + 1 < argc) {
+            /* Chrome trace JSON of every span, implies -stats */
+            stats = 1;
+            tracePath = argv[i + 1];
+            XMEMMOVE(&argv[i], &argv[i + 2], (argc - i - 1) * sizeof(char*));
+            argc -= 2;
+            i--;
+        }
+        else if (XSTRCMP(argv[i], "-quiet") == 0) {
+            wolfCLU_LogSetQuiet(1);
+            XMEMMOVE(&argv[i], &argv[i + 1], (argc - i) * sizeof(char*));
+            argc--;
+            i--;
+        }
+        else if (XSTRCMP(argv[i], "-logjson") == 0) {
+            wolfCLU_LogSetFormat(WOLFCLU_LOG_JSON);
+            XMEMMOVE(&argv[i], &argv[i + 1], (argc - i) * sizeof(char*));
+            argc--;
+            i--;
+        }
+        else if (XSTRCMP(argv[i], "-logasync") == 0) {
+            logAsync = 1;
+            XMEMMOVE(&argv[i], &argv[i + 1], (argc - i) * sizeof(char*));
+            argc--;
+            i--;
+        }
+    }
+
+    /* command tag used in JSON log lines, the mode without its leading '-' */
+    if (argc > 1) {
+        wolfCLU_LogSetCommand((argv[1][0] == '-')? argv[1] + 1 : argv[1]);
+    }
+
+    /* the flusher thread is stopped from atexit so that messages logged
+     * before an early return are still written */
+    if (logAsync) {
+        if (wolfCLU_LogStartAsync() != WOLFCLU_SUCCESS ||
+                atexit(wolfCLU_LogStop) != 0) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (stats && wolfCLU_StatsEnable(tracePath) != WOLFCLU_SUCCESS) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_INIT);
+
+#ifdef HAVE_FIPS
+
+    wolfCrypt_SetCb_fips(myFipsCb);
+
+    #ifdef WC_RNG_SEED_CB
+        wc_SetSeed_Cb(wc_GenerateSeed);
+    #endif
+
+    ret = wc_InitRng(&rng);
+
+    if (ret != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Err %d, update the FIPS hash\n", ret);
+        return ret;
+    }
+
+    wc_FreeRng(&rng);
+#endif
+
+    if (argc == 1) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Main Help.");
+        wolfCLU_help();
+    }
+
+#ifdef HAVE_FIPS
+    if (wolfCrypt_GetStatus_fips() == IN_CORE_FIPS_E) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Linked to a FIPS version of wolfSSL that has failed the in core"
+               "integrity check. ALL FIPS crypto will report ERRORS when used."
+               "To resolve please recompile wolfSSL with the correct integrity"
+               "hash. If the issue continues, contact fips @ wolfssl.com");
+    }
+#endif
+
+    if (wolfCrypt_Init() != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "wolfCyprt initialization failed!");
+        return -1;
+    }
+#ifdef DEBUG_WOLFSSL
+    wolfSSL_Debugging_ON();
+#endif
+    wolfCLU_StatsEnd(phase);
+
+    ret = wolfCLU_RunCommand(argc, argv);
+
     if (ret <= 0) {
         WOLFCLU_LOG(WOLFCLU_E0, "Error returned: %d.", ret);
         ret = WOLFCLU_FATAL_ERROR;
     }
     wolfCrypt_Cleanup();
+    wolfCLU_StatsReport();
+    wolfCLU_MemStatsReport();
 
     /* main function we want to return 0 on success so that the executable
      * returns the expected 0 on success */
@@ -44,9 +44,43 @@ static const struct option crypt_options[] = {
     {"k",         required_argument, 0, WOLFCLU_PASSWORD  },
     {"base64",    no_argument,       0, WOLFCLU_BASE64    },
     {"nosalt",    no_argument,       0, WOLFCLU_NOSALT    },
+    {"iter",      required_argument, 0, WOLFCLU_ITER      },
     {0, 0, 0, 0} /* terminal element */
 };
 
+/* parses the argument to -iter, either an iteration count or "auto:<ms>"
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_parseIter(const char* arg, int* iter, int* iterMs)
+{
+    const char autoPrefix[] = "auto:";
+    char* end = NULL;
+    long  val;
+
+    if (arg == NULL) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    if (XSTRNCMP(arg, autoPrefix, XSTRLEN(autoPrefix)) == 0) {
+        val = strtol(arg + XSTRLEN(autoPrefix), &end, 10);
+        if (end == arg + XSTRLEN(autoPrefix) || *end != '\0' || val <= 0 ||
+                val > 60000) {
+            WOLFCLU_LOG(WOLFCLU_E0, "-iter auto:<ms> needs a time between 1 "
+                    "and 60000 milliseconds");
+            return WOLFCLU_FATAL_ERROR;
+        }
+        *iterMs = (int)val;
+    }
+    else {
+        val = strtol(arg, &end, 10);
+        if (end == arg || *end != '\0' || val <= 0 || val > 0x7FFFFFFF) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Invalid -iter value %s", arg);
+            return WOLFCLU_FATAL_ERROR;
+        }
+        *iter = (int)val;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
 /* returns WOLFCLU_SUCCESS on success */
 int wolfCLU_setup(int argc, char** argv, char action)
 {
@@ -81,6 +115,8 @@ int wolfCLU_setup(int argc, char** argv, char action)
                                  */
     int      verbose   =   0;  /* flag to print out key/iv/salt */
     int      pbkVersion =   1;
+    int      iter       =   0;  /* PBKDF2 iterations, 0 for default */
+    int      iterMs     =   0;  /* time to calibrate iterations to */
     const WOLFSSL_EVP_MD* hashType = wolfSSL_EVP_sha256();
 
     const WOLFSSL_EVP_CIPHER* cphr = NULL;
@@ -89,6 +125,7 @@ int wolfCLU_setup(int argc, char** argv, char action)
     word32   numBits    =   0;  /* number of bits in argument from the user */
     int      option;
     int      longIndex = 0;
+    WOLFCLU_GETOPT opt;
 
     if (action == 'e')
         encCheck = 1;
@@ -134,18 +171,17 @@ int wolfCLU_setup(int argc, char** argv, char action)
     }
     XMEMSET(key, 0, keySize);
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    crypt_options, &longIndex )) != -1) {
 
         switch (option) {
         case WOLFCLU_PASSWORD:
-            if (optarg == NULL) {
+            if (opt.arg == NULL) {
                 return WOLFCLU_FATAL_ERROR;
             }
             else {
-                XSTRNCPY((char*)pwdKey, optarg, keySize);
+                XSTRNCPY((char*)pwdKey, opt.arg, keySize);
                 pwdKeyChk = 1;
                 keyType   = 1;
             }
@@ -163,24 +199,32 @@ int wolfCLU_setup(int argc, char** argv, char action)
             noSalt = 1;
             break;
 
+        case WOLFCLU_ITER:
+            if (wolfCLU_parseIter(opt.arg, &iter, &iterMs) != WOLFCLU_SUCCESS) {
+                wolfCLU_freeBins(pwdKey, iv, key, NULL, NULL);
+                return WOLFCLU_FATAL_ERROR;
+            }
+            pbkVersion = WOLFCLU_PBKDF2; /* iteration count implies PBKDF2 */
+            break;
+
         case WOLFCLU_KEY: /* Key if used must be in hex */
             break;
 
         case WOLFCLU_IV:  /* IV if used must be in hex */
             {
                 char* ivString;
-                if (optarg == NULL) {
+                if (opt.arg == NULL) {
                     return WOLFCLU_FATAL_ERROR;
                 }
                 else {
-                    ivString = (char*)XMALLOC(XSTRLEN(optarg), HEAP_HINT,
+                    ivString = (char*)XMALLOC(XSTRLEN(opt.arg), HEAP_HINT,
                         DYNAMIC_TYPE_TMP_BUFFER);
                     if (ivString == NULL) {
                         wolfCLU_freeBins(pwdKey, iv, key, NULL, NULL);
                         return MEMORY_E;
                     }
 
-                    XSTRNCPY(ivString, optarg, XSTRLEN(optarg));
+                    XSTRNCPY(ivString, opt.arg, XSTRLEN(opt.arg));
                     ret = wolfCLU_hexToBin(ivString, &iv, &ivSize,
                                        NULL, NULL, NULL,
                                        NULL, NULL, NULL,
@@ -217,22 +261,22 @@ int wolfCLU_setup(int argc, char** argv, char action)
 
 
             /* The cases above have their arguments converted to lower case */
-            if (optarg) wolfCLU_convertToLower(optarg, (int)XSTRLEN(optarg));
+            if (opt.arg) wolfCLU_convertToLower(opt.arg, (int)XSTRLEN(opt.arg));
             /* The cases below won't have their argument's molested */
             FALL_THROUGH;
 
         case WOLFCLU_INFILE:
-            in = optarg;
+            in = opt.arg;
             inCheck = 1;
             break;
 
         case WOLFCLU_OUTFILE:
-            out = optarg;
+            out = opt.arg;
             outCheck = 1;
             break;
 
         case WOLFCLU_INKEY:
-            if (optarg == NULL) {
+            if (opt.arg == NULL) {
                 WOLFCLU_LOG(WOLFCLU_E0, "no key passed in..");
                 wolfCLU_freeBins(pwdKey, iv, key, NULL, NULL);
                 return WOLFCLU_FATAL_ERROR;
@@ -240,7 +284,7 @@ int wolfCLU_setup(int argc, char** argv, char action)
 
             /* 2 characters = 1 byte. 1 byte = 8 bits
              */
-            numBits = (word32)(XSTRLEN(optarg) * 4);
+            numBits = (word32)(XSTRLEN(opt.arg) * 4);
             /* Key for encryption */
             if ((int)numBits != keySize) {
                 WOLFCLU_LOG(WOLFCLU_L0,
@@ -255,14 +299,14 @@ int wolfCLU_setup(int argc, char** argv, char action)
             else {
                 char* keyString;
 
-                keyString = (char*)XMALLOC(XSTRLEN(optarg), HEAP_HINT,
+                keyString = (char*)XMALLOC(XSTRLEN(opt.arg), HEAP_HINT,
                         DYNAMIC_TYPE_TMP_BUFFER);
                 if (keyString == NULL) {
                     wolfCLU_freeBins(pwdKey, iv, key, NULL, NULL);
                     return MEMORY_E;
                 }
 
-                XSTRNCPY(keyString, optarg, XSTRLEN(optarg));
+                XSTRNCPY(keyString, opt.arg, XSTRLEN(opt.arg));
                 ret = wolfCLU_hexToBin(keyString, &key, &numBits,
                                        NULL, NULL, NULL,
                                        NULL, NULL, NULL,
@@ -292,7 +336,7 @@ int wolfCLU_setup(int argc, char** argv, char action)
             break;
 
         case WOLFCLU_MD:
-            hashType = wolfSSL_EVP_get_digestbyname(optarg);
+            hashType = wolfSSL_EVP_get_digestbyname(opt.arg);
             if (hashType == NULL) {
                 WOLFCLU_LOG(WOLFCLU_E0, "Invalid digest name");
                 return WOLFCLU_FATAL_ERROR;
@@ -376,7 +420,7 @@ int wolfCLU_setup(int argc, char** argv, char action)
         if (cphr != NULL) {
             ret = wolfCLU_evp_crypto(cphr, mode, pwdKey, key, (keySize+7)/8, in,
                   out, NULL, iv, 0, 1, pbkVersion, hashType, verbose, isBase64,
-                  noSalt);
+                  noSalt, iter, iterMs);
         }
         else {
             if (outCheck == 0) {
@@ -398,7 +442,7 @@ int wolfCLU_setup(int argc, char** argv, char action)
         if (cphr != NULL) {
             ret = wolfCLU_evp_crypto(cphr, mode, pwdKey, key, (keySize+7)/8, in,
                     out, NULL, iv, 0, 0, pbkVersion, hashType, verbose,
-                    isBase64, noSalt);
+                    isBase64, noSalt, iter, 0);
         }
         else {
             if (outCheck == 0) {
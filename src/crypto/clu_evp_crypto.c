@@ -23,17 +23,251 @@
 #include <wolfclu/clu_log.h>
 #include <wolfclu/clu_optargs.h>
 #include <wolfclu/genkey/clu_genkey.h>
+#include <wolfclu/benchmark/clu_bench.h>
+#include <wolfclu/clu_stats.h>
+
+#ifndef SINGLE_THREADED
+    #include <pthread.h>
+#endif
 
 #ifndef WOLFCLU_MAX_BUFFER
 #define WOLFCLU_MAX_BUFFER 1024
 #endif
 
+/* header written before "Salted__" when the PBKDF2 iteration count is
+ * stored in the file, followed by the count as a 4 byte big endian value */
+#define WOLFCLU_ITER_MAGIC    "wcluIter"
+#define WOLFCLU_ITER_MAGIC_SZ 8
+
+/* PBKDF2 iteration count used when none is given, for interop */
+#define WOLFCLU_DEFAULT_ITER 10000
+
+/* bounds on automatically chosen iteration counts, a count read from a file
+ * outside of them is refused so a crafted file can not ask for hours of
+ * PBKDF2 */
+#define WOLFCLU_MIN_AUTO_ITER 1000
+#define WOLFCLU_MAX_AUTO_ITER 100000000
+
+/* iterations per millisecond taken from the rate cache file, anything
+ * outside of this is ignored and measured again */
+#define WOLFCLU_MIN_ITER_RATE 1.0
+#define WOLFCLU_MAX_ITER_RATE 1000000.0
+
+/* minimum time spent measuring PBKDF2 speed, in nanoseconds */
+#define WOLFCLU_ITER_CALIBRATE_NS 50000000
+
+/* environment variable that overrides the iteration rate cache location */
+#define WOLFCLU_ITER_CACHE_ENV  "WOLFCLU_ITER_CACHE"
+#define WOLFCLU_ITER_CACHE_FILE ".wolfclu_iter_cache"
+
+#define WOLFCLU_ITER_CACHE_MAX 8
+
+/* measured PBKDF2 iterations per millisecond for a digest and key length */
+typedef struct WOLFCLU_ITER_RATE {
+    int    md;      /* digest type from wolfSSL_EVP_MD_type */
+    int    keyLen;  /* derived key length, longer keys take more blocks */
+    double perMs;
+} WOLFCLU_ITER_RATE;
+
+static WOLFCLU_ITER_RATE iterRates[WOLFCLU_ITER_CACHE_MAX];
+static int iterRatesSz = 0;
+#ifndef SINGLE_THREADED
+/* enc can run on several threads at once when used from libwolfclu */
+static pthread_mutex_t iterRatesLock = PTHREAD_MUTEX_INITIALIZER;
+    #define ITER_RATES_LOCK()   pthread_mutex_lock(&iterRatesLock)
+    #define ITER_RATES_UNLOCK() pthread_mutex_unlock(&iterRatesLock)
+#else
+    #define ITER_RATES_LOCK()
+    #define ITER_RATES_UNLOCK()
+#endif
+
+
+/* gets the path of the iteration rate cache file
+ * returns WOLFCLU_SUCCESS if a path is available */
+static int wolfCLU_IterCachePath(char* path, int pathSz)
+{
+    char* env;
+
+    env = getenv(WOLFCLU_ITER_CACHE_ENV);
+    if (env != NULL && *env != '\0') {
+        XSNPRINTF(path, pathSz, "%s", env);
+        return WOLFCLU_SUCCESS;
+    }
+
+    env = getenv("HOME");
+    if (env != NULL && *env != '\0') {
+        XSNPRINTF(path, pathSz, "%s/%s", env, WOLFCLU_ITER_CACHE_FILE);
+        return WOLFCLU_SUCCESS;
+    }
+    return WOLFCLU_FAILURE;
+}
+
+
+/* adds a rate to the in memory cache */
+static void wolfCLU_IterCacheAdd(int md, int keyLen, double perMs)
+{
+    ITER_RATES_LOCK();
+    if (iterRatesSz < WOLFCLU_ITER_CACHE_MAX) {
+        iterRates[iterRatesSz].md     = md;
+        iterRates[iterRatesSz].keyLen = keyLen;
+        iterRates[iterRatesSz].perMs  = perMs;
+        iterRatesSz++;
+    }
+    ITER_RATES_UNLOCK();
+}
+
+
+/* looks for a previously measured rate, first in memory then in the cache
+ * file. Each line of the file is "<digest type> <key length> <iter/ms>"
+ * returns WOLFCLU_SUCCESS if found */
+static int wolfCLU_IterCacheFind(int md, int keyLen, double* perMs)
+{
+    char  path[MAX_FILENAME_SZ];
+    char  line[MAX_TERM_WIDTH];
+    int   fileMd, fileKeyLen;
+    double fileRate;
+    int   i;
+    XFILE f;
+
+    ITER_RATES_LOCK();
+    for (i = 0; i < iterRatesSz; i++) {
+        if (iterRates[i].md == md && iterRates[i].keyLen == keyLen) {
+            *perMs = iterRates[i].perMs;
+            ITER_RATES_UNLOCK();
+            return WOLFCLU_SUCCESS;
+        }
+    }
+    ITER_RATES_UNLOCK();
+
+    if (wolfCLU_IterCachePath(path, sizeof(path)) != WOLFCLU_SUCCESS) {
+        return WOLFCLU_FAILURE;
+    }
+    f = XFOPEN(path, "rb");
+    if (f == XBADFILE) {
+        return WOLFCLU_FAILURE;
+    }
+
+    while (XFGETS(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "%d %d %lf", &fileMd, &fileKeyLen, &fileRate) == 3 &&
+                fileMd == md && fileKeyLen == keyLen &&
+                fileRate >= WOLFCLU_MIN_ITER_RATE &&
+                fileRate <= WOLFCLU_MAX_ITER_RATE) {
+            XFCLOSE(f);
+            wolfCLU_IterCacheAdd(md, keyLen, fileRate);
+            *perMs = fileRate;
+            return WOLFCLU_SUCCESS;
+        }
+    }
+    XFCLOSE(f);
+    return WOLFCLU_FAILURE;
+}
+
+
+/* stores a newly measured rate, failing to write the file is not an error
+ * since the rate can always be measured again */
+static void wolfCLU_IterCacheStore(int md, int keyLen, double perMs)
+{
+    char  path[MAX_FILENAME_SZ];
+    XFILE f;
+
+    wolfCLU_IterCacheAdd(md, keyLen, perMs);
+    if (wolfCLU_IterCachePath(path, sizeof(path)) == WOLFCLU_SUCCESS) {
+        f = XFOPEN(path, "ab");
+        if (f != XBADFILE) {
+            fprintf(f, "%d %d %.3f\n", md, keyLen, perMs);
+            XFCLOSE(f);
+        }
+    }
+}
+
+
+/* measures how many PBKDF2 iterations per millisecond this host does,
+ * doubling the count until one derivation takes long enough to time
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_IterMeasure(const WOLFSSL_EVP_MD* md, int keyLen,
+        double* perMs)
+{
+    const char pwd[] = "wolfCLU iteration calibration";
+    byte   salt[SALT_SIZE] = {0};
+    byte*  out;
+    int    iter = WOLFCLU_MIN_AUTO_ITER;
+    int    ret  = WOLFCLU_SUCCESS;
+    word64 start, elapsed = 0;
+
+    out = (byte*)XMALLOC(keyLen, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (out == NULL) {
+        return MEMORY_E;
+    }
+
+    for (;;) {
+        start = wolfCLU_TimerNs();
+        if (wolfSSL_PKCS5_PBKDF2_HMAC(pwd, (int)XSTRLEN(pwd), salt, SALT_SIZE,
+                    iter, md, keyLen, out) != WOLFSSL_SUCCESS) {
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        elapsed = wolfCLU_TimerNs() - start;
+        if (elapsed >= WOLFCLU_ITER_CALIBRATE_NS || iter >= (1 << 29)) {
+            break;
+        }
+        iter *= 2;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        if (elapsed == 0) {
+            elapsed = 1;
+        }
+        *perMs = ((double)iter * 1000000.0) / (double)elapsed;
+    }
+
+    XFREE(out, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+
+/* returns WOLFCLU_SUCCESS on success */
+int wolfCLU_PBKDF2AutoIter(const WOLFSSL_EVP_MD* md, int keyLen, int ms,
+        int* iter)
+{
+    int    ret = WOLFCLU_SUCCESS;
+    int    mdType;
+    double perMs = 0.0;
+    double count;
+
+    if (md == NULL || keyLen <= 0 || ms <= 0 || iter == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    mdType = wolfSSL_EVP_MD_type(md);
+    if (wolfCLU_IterCacheFind(mdType, keyLen, &perMs) != WOLFCLU_SUCCESS) {
+        ret = wolfCLU_IterMeasure(md, keyLen, &perMs);
+        if (ret == WOLFCLU_SUCCESS) {
+            wolfCLU_IterCacheStore(mdType, keyLen, perMs);
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        count = perMs * ms;
+        if (count > (double)WOLFCLU_MAX_AUTO_ITER) {
+            count = (double)WOLFCLU_MAX_AUTO_ITER;
+        }
+        *iter = (int)count;
+        if (*iter < WOLFCLU_MIN_AUTO_ITER) {
+            WOLFCLU_LOG(WOLFCLU_E0, "%d ms only allows %d iterations, using "
+                    "%d", ms, *iter, WOLFCLU_MIN_AUTO_ITER);
+            *iter = WOLFCLU_MIN_AUTO_ITER;
+        }
+    }
+    return ret;
+}
+
 
 /* return WOLFCLU_SUCCESS on success */
 int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
         byte* key, int keySz, char* fileIn, char* fileOut, char* hexIn,
         byte* iv, int hexOut, int enc, int pbkVersion,
-        const WOLFSSL_EVP_MD* hashType, int printOut, int isBase64, int noSalt)
+        const WOLFSSL_EVP_MD* hashType, int printOut, int isBase64, int noSalt,
+        int iter, int iterMs)
 {
     WOLFSSL_BIO *out = NULL;
     WOLFSSL_BIO *in  = NULL;
@@ -50,7 +284,10 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
     int     hexRet          = 0;    /* hex -> bin return*/
     int     ivSz            = 0;
     int     outputSz        = 0;
-    int     iter            = 10000; /* default value for interop */
+    int     saveIter        = 0;    /* store iteration count in header */
+    int     phase;
+    int     cryptoPhase;
+    byte    iterBuf[4];
 
     word32  tempInputL      = 0;    /* temporary input Length */
     word32  tempMax         = WOLFCLU_MAX_BUFFER; /* controls encryption amount */
@@ -62,6 +299,10 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
         return BAD_FUNC_ARG;
     }
 
+    if (iter <= 0) {
+        iter = WOLFCLU_DEFAULT_ITER;
+    }
+
     /* Start up the random number generator */
     if (wc_InitRng(&rng) != 0) {
         WOLFCLU_LOG(WOLFCLU_E0, "Random Number Generator failed to start.");
@@ -136,12 +377,35 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
             if (!noSalt) {
                 char s[sizeof(isSalted)];
 
-                if (wolfSSL_BIO_read(in, s, (int)XSTRLEN(isSalted)) <= 0) {
+                if (wolfSSL_BIO_read(in, s, (int)XSTRLEN(isSalted)) !=
+                        (int)XSTRLEN(isSalted)) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Error reading salted string");
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 s[XSTRLEN(isSalted)] = '\0';
 
+                /* iteration count stored by "-iter auto:<ms>" */
+                if (ret == WOLFCLU_SUCCESS &&
+                    XMEMCMP(s, WOLFCLU_ITER_MAGIC, WOLFCLU_ITER_MAGIC_SZ) == 0) {
+                    if (wolfSSL_BIO_read(in, iterBuf, sizeof(iterBuf)) !=
+                            (int)sizeof(iterBuf) ||
+                        wolfSSL_BIO_read(in, s, (int)XSTRLEN(isSalted)) !=
+                            (int)XSTRLEN(isSalted)) {
+                        WOLFCLU_LOG(WOLFCLU_E0, "Error reading iteration count");
+                        ret = WOLFCLU_FATAL_ERROR;
+                    }
+                    else {
+                        iter = ((int)iterBuf[0] << 24) | (iterBuf[1] << 16) |
+                               (iterBuf[2] << 8) | iterBuf[3];
+                        if (iter < WOLFCLU_MIN_AUTO_ITER ||
+                                iter > WOLFCLU_MAX_AUTO_ITER) {
+                            WOLFCLU_LOG(WOLFCLU_E0, "Bad iteration count");
+                            ret = WOLFCLU_FATAL_ERROR;
+                        }
+                        pbkVersion = WOLFCLU_PBKDF2;
+                    }
+                }
+
                 if (ret >= 0 &&
                     XMEMCMP(s, isSalted, (int)XSTRLEN(isSalted)) != 0) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Was expecting salt");
@@ -158,7 +422,22 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
         }
     }
 
+    /* pick the iteration count that fits in the time budget */
+    if (ret == WOLFCLU_SUCCESS && enc && iterMs > 0) {
+        if (noSalt) {
+            WOLFCLU_LOG(WOLFCLU_E0, "-iter auto needs a salt to store the "
+                    "iteration count with");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            ret = wolfCLU_PBKDF2AutoIter(hashType, keySz + ivSz, iterMs,
+                    &iter);
+            saveIter = 1;
+        }
+    }
+
     /* stretches pwdKey */
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_KEY);
     if (ret == WOLFCLU_SUCCESS) {
         if (pbkVersion == WOLFCLU_PBKDF2) {
         #ifdef HAVE_FIPS
@@ -214,6 +493,7 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
             }
         }
     }
+    wolfCLU_StatsEnd(phase);
 
     /* open the outFile in write mode */
     if (ret == WOLFCLU_SUCCESS) {
@@ -241,6 +521,22 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
         }
     }
 
+    /* the iteration count goes first so "Salted__" and the salt still
+     * follow in the usual layout */
+    if (ret == WOLFCLU_SUCCESS && enc && saveIter) {
+        iterBuf[0] = (byte)(iter >> 24);
+        iterBuf[1] = (byte)(iter >> 16);
+        iterBuf[2] = (byte)(iter >> 8);
+        iterBuf[3] = (byte)iter;
+        if (wolfSSL_BIO_write(out, WOLFCLU_ITER_MAGIC, WOLFCLU_ITER_MAGIC_SZ)
+                != WOLFCLU_ITER_MAGIC_SZ ||
+            wolfSSL_BIO_write(out, iterBuf, sizeof(iterBuf)) !=
+                (int)sizeof(iterBuf)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "issue writing out iteration count");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
     /* when encrypting a file write out the salt value generated */
     if (ret == WOLFCLU_SUCCESS && enc) {
         if (wolfSSL_BIO_write(out, isSalted, (int)XSTRLEN(isSalted)) !=
@@ -303,6 +599,7 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
     }
 
     /* loop, encrypt 1kB at a time till length <= 0 */
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_IO);
     while (ret == WOLFCLU_SUCCESS && wolfSSL_BIO_get_len(in) > 0) {
         int err;
 
@@ -333,8 +630,11 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
         if (err >= 0) {
             tempMax  = err;
             outputSz = WOLFCLU_MAX_BUFFER + AES_BLOCK_SIZE;
-            if (wolfSSL_EVP_CipherUpdate(ctx, output, &outputSz, input, tempMax)
-                    != WOLFSSL_SUCCESS) {
+            cryptoPhase = wolfCLU_StatsBegin(WOLFCLU_STAT_CRYPTO);
+            err = wolfSSL_EVP_CipherUpdate(ctx, output, &outputSz, input,
+                    tempMax);
+            wolfCLU_StatsEnd(cryptoPhase);
+            if (err != WOLFSSL_SUCCESS) {
                 WOLFCLU_LOG(WOLFCLU_E0, "Error with cipher update");
                 ret = WOLFCLU_FATAL_ERROR;
                 break;
@@ -353,16 +653,19 @@ int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
     if (ret == WOLFCLU_SUCCESS) {
         /* flush out last block (could have padding) */
         outputSz = tempMax + AES_BLOCK_SIZE;
+        cryptoPhase = wolfCLU_StatsBegin(WOLFCLU_STAT_CRYPTO);
         if (wolfSSL_EVP_CipherFinal(ctx, output, &outputSz)
                 != WOLFSSL_SUCCESS) {
             WOLFCLU_LOG(WOLFCLU_E0, "Error decrypting message");
             ret = WOLFCLU_FATAL_ERROR;
         }
+        wolfCLU_StatsEnd(cryptoPhase);
     }
 
     if (ret == WOLFCLU_SUCCESS) {
         wolfSSL_BIO_write(out, output, outputSz);
     }
+    wolfCLU_StatsEnd(phase);
 
     /* write out stored up output in base64 encrypt case */
     if (ret == WOLFCLU_SUCCESS && enc && isBase64) {
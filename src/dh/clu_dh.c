@@ -67,6 +67,7 @@ int wolfCLU_DhParamSetup(int argc, char** argv)
     int ret    = WOLFCLU_SUCCESS;
     int option;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     char* out = NULL;
     byte genKey = 0;
     byte check  = 0;
@@ -86,21 +87,21 @@ int wolfCLU_DhParamSetup(int argc, char** argv)
         }
     }
 
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    dh_options, &longIndex )) != -1) {
         switch (option) {
             case WOLFCLU_INFILE:
-                bioIn = wolfSSL_BIO_new_file(optarg, "rb");
+                bioIn = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (bioIn == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open input file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_OUTFILE:
-                out = optarg;
+                out = opt.arg;
                 break;
 
             case WOLFCLU_GEN_KEY:
@@ -190,7 +191,7 @@ int wolfCLU_DhParamSetup(int argc, char** argv)
             bioOut = wolfSSL_BIO_new_file(out, "wb");
             if (bioOut == NULL) {
                 WOLFCLU_LOG(WOLFCLU_E0, "Unable to open output file %s",
-                        optarg);
+                        out);
                 ret = WOLFCLU_FATAL_ERROR;
             }
         }
@@ -56,6 +56,7 @@ int wolfCLU_DsaParamSetup(int argc, char** argv)
     int ret    = WOLFCLU_SUCCESS;
     int option;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     char* out = NULL;
     byte genKey = 0;
     byte noOut  = 0;
@@ -74,21 +75,21 @@ int wolfCLU_DsaParamSetup(int argc, char** argv)
         }
     }
 
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    dsa_options, &longIndex )) != -1) {
         switch (option) {
             case WOLFCLU_INFILE:
-                bioIn = wolfSSL_BIO_new_file(optarg, "rb");
+                bioIn = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (bioIn == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open input file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_OUTFILE:
-                out = optarg;
+                out = opt.arg;
                 break;
 
             case WOLFCLU_GEN_KEY:
@@ -174,7 +175,7 @@ int wolfCLU_DsaParamSetup(int argc, char** argv)
             bioOut = wolfSSL_BIO_new_file(out, "wb");
             if (bioOut == NULL) {
                 WOLFCLU_LOG(WOLFCLU_E0, "Unable to open output file %s",
-                        optarg);
+                        opt.arg);
                 ret = WOLFCLU_FATAL_ERROR;
             }
         }
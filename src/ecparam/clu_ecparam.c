@@ -58,6 +58,7 @@ int wolfCLU_ecparam(int argc, char** argv)
     char* out  = NULL;    /* default output file name */
     int   ret        = WOLFCLU_SUCCESS;
     int   longIndex  = 0;
+    WOLFCLU_GETOPT opt;
     int   genKey     = 0;
     int   textOut    = 0;
     int   outForm    = PEM_FORM;
@@ -73,26 +74,25 @@ int wolfCLU_ecparam(int argc, char** argv)
         return WOLFCLU_SUCCESS;
     }
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    ecparam_options, &longIndex )) != -1) {
 
         switch (option) {
             case WOLFCLU_OUTFILE:
-                out = optarg;
+                out = opt.arg;
                 break;
 
             case WOLFCLU_INFILE:
-                in = wolfSSL_BIO_new_file(optarg, "rb");
+                in = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (in == NULL) {
-                    WOLFCLU_LOG(WOLFCLU_E0, "Error opening file %s", optarg);
+                    WOLFCLU_LOG(WOLFCLU_E0, "Error opening file %s", opt.arg);
                     ret = USER_INPUT_ERROR;
                 }
                 break;
 
             case WOLFCLU_OUTFORM:
-                outForm = wolfCLU_checkOutform(optarg);
+                outForm = wolfCLU_checkOutform(opt.arg);
                 if (outForm < 0) {
                     WOLFCLU_LOG(WOLFCLU_E0, "bad outform");
                     ret = USER_INPUT_ERROR;
@@ -100,7 +100,7 @@ int wolfCLU_ecparam(int argc, char** argv)
                 break;
 
             case WOLFCLU_INFORM:
-                inForm = wolfCLU_checkInform(optarg);
+                inForm = wolfCLU_checkInform(opt.arg);
                 if (inForm < 0) {
                     WOLFCLU_LOG(WOLFCLU_E0, "bad inform");
                     ret = USER_INPUT_ERROR;
@@ -125,7 +125,7 @@ int wolfCLU_ecparam(int argc, char** argv)
                     ret = MEMORY_E;
                     break;
                 }
-                XSTRNCPY(name, optarg, ECC_MAXNAME);
+                XSTRNCPY(name, opt.arg, ECC_MAXNAME);
 
                 /* convert name to upper case */
                 for (i = 0; i < (int)XSTRLEN(name); i++)
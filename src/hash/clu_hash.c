@@ -22,6 +22,7 @@
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
 #include <wolfclu/clu_optargs.h>
+#include <wolfclu/clu_stats.h>
 
 #define MAX_STDINSZ 8192
 
@@ -43,6 +44,7 @@ int wolfCLU_hash(WOLFSSL_BIO* bioIn, WOLFSSL_BIO* bioOut, const char* alg,
     int     i  =   0;           /* loop variable */
     int     ret = WOLFCLU_SUCCESS;
     int     inputSz = MAX_STDINSZ;
+    int     phase;
     WOLFSSL_BIO* tmp;
 
     if (bioIn == NULL) {
@@ -76,9 +78,11 @@ int wolfCLU_hash(WOLFSSL_BIO* bioIn, WOLFSSL_BIO* bioOut, const char* alg,
             wolfSSL_BIO_free(tmp);
         return MEMORY_E;
     }
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_IO);
     inputSz = wolfSSL_BIO_read(tmp, input, inputSz);
     if (bioIn == NULL)
         wolfSSL_BIO_free(tmp);
+    wolfCLU_StatsEnd(phase);
 
     /* if size not provided then use input length to find max possible size */
     if (size == 0) {
@@ -100,6 +104,7 @@ int wolfCLU_hash(WOLFSSL_BIO* bioIn, WOLFSSL_BIO* bioOut, const char* alg,
     XMEMSET(output, 0, size);
 
     /* hashes using accepted algorithm */
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_CRYPTO);
 #ifndef NO_MD5
     if (ret == WOLFCLU_SUCCESS && XSTRNCMP(alg, "md5", 3) == 0) {
         ret = wc_Md5Hash(input, inputSz, output);
@@ -146,7 +151,9 @@ int wolfCLU_hash(WOLFSSL_BIO* bioIn, WOLFSSL_BIO* bioOut, const char* alg,
         ret = Base64_Decode(input, inputSz, output, (word32*)&size);
     }
 #endif /* !NO_CODING */
+    wolfCLU_StatsEnd(phase);
 
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_FORMAT);
     if (ret == 0) {
         if (bioOut != NULL) {
             if (wolfSSL_BIO_write(bioOut, output, size) == size) {
@@ -178,5 +185,6 @@ int wolfCLU_hash(WOLFSSL_BIO* bioIn, WOLFSSL_BIO* bioOut, const char* alg,
     XMEMSET(input, 0, inputSz);
     XMEMSET(output, 0, size);
     wolfCLU_freeBins(input, output, NULL, NULL, NULL);
+    wolfCLU_StatsEnd(phase);
     return ret;
 }
@@ -65,6 +65,7 @@ int wolfCLU_PKCS12(int argc, char** argv)
     int printKeys  = 1; /* default to yes*/
     int option;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     WOLFSSL_EVP_PKEY *pkey = NULL;
     WOLFSSL_X509     *cert = NULL;
     WC_PKCS12        *pkcs12 = NULL;
@@ -72,9 +73,8 @@ int wolfCLU_PKCS12(int argc, char** argv)
     WOLFSSL_BIO *bioIn  = NULL;
     WOLFSSL_BIO *bioOut = NULL;
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    pkcs12_options, &longIndex )) != -1) {
         switch (option) {
             case WOLFCLU_NODES:
@@ -91,26 +91,26 @@ int wolfCLU_PKCS12(int argc, char** argv)
 
             case WOLFCLU_PASSWORD:
                 passwordSz = MAX_PASSWORD_SIZE;
-                ret = wolfCLU_GetPassword(password, &passwordSz, optarg);
+                ret = wolfCLU_GetPassword(password, &passwordSz, opt.arg);
                 break;
 
             case WOLFCLU_PASSWORD_OUT:
                 break;
 
             case WOLFCLU_INFILE:
-                bioIn = wolfSSL_BIO_new_file(optarg, "rb");
+                bioIn = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (bioIn == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open pkcs12 file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_OUTFILE:
-                bioOut = wolfSSL_BIO_new_file(optarg, "wb");
+                bioOut = wolfSSL_BIO_new_file(opt.arg, "wb");
                 if (bioOut == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open output file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
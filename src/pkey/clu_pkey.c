@@ -411,12 +411,13 @@ int wolfCLU_pKeySetup(int argc, char** argv)
     int pubOut = 0;
     int option;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     WOLFSSL_EVP_PKEY *pkey = NULL;
     WOLFSSL_BIO *bioIn  = NULL;
     WOLFSSL_BIO *bioOut = NULL;
 
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    pkey_options, &longIndex )) != -1) {
         switch (option) {
             case WOLFCLU_PUBOUT:
@@ -429,29 +430,29 @@ int wolfCLU_pKeySetup(int argc, char** argv)
                 break;
 
             case WOLFCLU_INFILE:
-                bioIn = wolfSSL_BIO_new_file(optarg, "rb");
+                bioIn = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (bioIn == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open public key file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_OUTFILE:
-                bioOut = wolfSSL_BIO_new_file(optarg, "wb");
+                bioOut = wolfSSL_BIO_new_file(opt.arg, "wb");
                 if (bioOut == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open output file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_INFORM:
-                inForm = wolfCLU_checkInform(optarg);
+                inForm = wolfCLU_checkInform(opt.arg);
                 break;
 
             case WOLFCLU_OUTFORM:
-                outForm = wolfCLU_checkOutform(optarg);
+                outForm = wolfCLU_checkOutform(opt.arg);
                 break;
 
             case WOLFCLU_HELP:
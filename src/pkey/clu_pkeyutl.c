@@ -0,0 +1,1055 @@
+/* clu_pkeyutl.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_optargs.h>
+#include <wolfclu/clu_cache.h>
+#include <wolfclu/pkey/clu_pkey.h>
+
+#ifndef SINGLE_THREADED
+    #include <pthread.h>
+#endif
+
+/* most records handed to a worker at a time */
+#define WOLFCLU_PKEYUTL_BLOCK 256
+
+/* largest record, also where a block stops taking more records */
+#define WOLFCLU_PKEYUTL_MAX_RECORD (1024 * 1024)
+
+/* operations */
+enum {
+    WOLFCLU_PKEYUTL_NONE = 0,
+    WOLFCLU_PKEYUTL_SIGN,
+    WOLFCLU_PKEYUTL_VERIFY,
+    WOLFCLU_PKEYUTL_ENCRYPT,
+    WOLFCLU_PKEYUTL_DECRYPT,
+    WOLFCLU_PKEYUTL_DERIVE
+};
+
+static const struct option pkeyutl_options[] = {
+    {"sign",    no_argument,       0, WOLFCLU_SIGN       },
+    {"verify",  no_argument,       0, WOLFCLU_VERIFY     },
+    {"encrypt", no_argument,       0, WOLFCLU_ENCRYPT    },
+    {"decrypt", no_argument,       0, WOLFCLU_DECRYPT    },
+    {"derive",  no_argument,       0, WOLFCLU_DERIVE     },
+    {"inkey",   required_argument, 0, WOLFCLU_INKEY      },
+    {"pubin",   no_argument,       0, WOLFCLU_PUBIN      },
+    {"in",      required_argument, 0, WOLFCLU_INFILE     },
+    {"out",     required_argument, 0, WOLFCLU_OUTFILE    },
+    {"base64",  no_argument,       0, WOLFCLU_BASE64     },
+    {"threads", required_argument, 0, WOLFCLU_THREADS    },
+
+    {"md5",     no_argument,       0, WOLFCLU_MD5        },
+    {"sha",     no_argument,       0, WOLFCLU_CERT_SHA   },
+    {"sha224",  no_argument,       0, WOLFCLU_CERT_SHA224},
+    {"sha256",  no_argument,       0, WOLFCLU_CERT_SHA256},
+    {"sha384",  no_argument,       0, WOLFCLU_CERT_SHA384},
+    {"sha512",  no_argument,       0, WOLFCLU_CERT_SHA512},
+
+    {"help",    no_argument,       0, WOLFCLU_HELP       },
+    {"h",       no_argument,       0, WOLFCLU_HELP       },
+
+    {0, 0, 0, 0} /* terminal element */
+};
+
+static void wolfCLU_PkeyUtlHelp(void)
+{
+    WOLFCLU_LOG(WOLFCLU_L0, "wolfssl pkeyutl -sign|-verify|-encrypt|-decrypt|"
+            "-derive -inkey <file> [-pubin] [-in <file>] [-out <file>]"
+            " [-base64] [-threads <n>] [-sha256 ...]");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-sign    sign each record, RSA or ECC");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-verify  verify each record, followed by its"
+            " signature as the next record");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-encrypt RSA encrypt each record");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-decrypt RSA decrypt each record");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-derive  ECDH with each record, a DER public"
+            " key");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-inkey   PEM key, private unless -pubin is given");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-in      file of records (default stdin)");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-out     file for results (default stdout)");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-base64  one base64 record per line instead of"
+            " a 4 byte big endian length before each record");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-threads <n> process records with n threads,"
+            " results stay in order");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-md5, -sha, -sha224, -sha256, -sha384, -sha512"
+            " hash for -sign and -verify (default sha256)");
+}
+
+
+/* where a record and its signature sit in the worker's input */
+typedef struct WOLFCLU_PKEYUTL_RECORD {
+    word32 off;
+    word32 sz;
+    word32 sigOff;      /* -verify only */
+    word32 sigSz;
+    word32 outSz;
+} WOLFCLU_PKEYUTL_RECORD;
+
+/* settings shared by all workers */
+typedef struct WOLFCLU_PKEYUTL_STATE {
+    int    op;
+    int    keyType;     /* EVP_PKEY_RSA or EVP_PKEY_EC */
+    int    pubIn;
+    byte*  der;         /* the key, decoded again by each worker */
+    word32 derSz;
+    word32 maxOut;      /* largest result of one record */
+    enum wc_HashType      hashType;
+    enum wc_SignatureType sigType;
+    int    useBase64;
+    int    threads;
+    XFILE  in;
+    XFILE  out;
+    char*  line;        /* -base64 input line */
+    word32 lineSz;
+    byte*  enc;         /* -base64 output line */
+    word32 encSz;
+    word64 records;     /* records read so far */
+    word64 failed;      /* -verify records that did not verify */
+} WOLFCLU_PKEYUTL_STATE;
+
+/* one worker's key, buffers and block of records */
+typedef struct WOLFCLU_PKEYUTL_WORKER {
+    union {
+    #ifndef NO_RSA
+        RsaKey rsa;
+    #endif
+    #ifdef HAVE_ECC
+        ecc_key ecc;
+    #endif
+        byte unused;
+    } k;
+    int    keyInit;
+    WC_RNG rng;
+    int    rngInit;
+    byte*  in;          /* the block's records, back to back */
+    word32 inSz;
+    word32 inMax;
+    byte*  out;         /* maxOut bytes for each record */
+    WOLFCLU_PKEYUTL_RECORD recs[WOLFCLU_PKEYUTL_BLOCK];
+    int    count;
+    word64 first;       /* number of the block's first record */
+    int    ret;
+    int    bad;         /* index of the record that failed */
+#ifndef SINGLE_THREADED
+    pthread_t       tid;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int             queued; /* holds a block not yet written out */
+    int             done;   /* the queued block has been processed */
+    int             stop;
+    const WOLFCLU_PKEYUTL_STATE* state;
+#endif
+} WOLFCLU_PKEYUTL_WORKER;
+
+
+/* makes room for sz more bytes of input in the worker
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_PkeyUtlReserve(WOLFCLU_PKEYUTL_WORKER* w, word32 sz)
+{
+    word32 max = w->inMax;
+    byte*  tmp;
+
+    if (w->inSz + sz <= max) {
+        return WOLFCLU_SUCCESS;
+    }
+    while (max < w->inSz + sz) {
+        max *= 2;
+    }
+    tmp = (byte*)XREALLOC(w->in, max, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (tmp == NULL) {
+        return MEMORY_E;
+    }
+    w->in    = tmp;
+    w->inMax = max;
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* reads one base64 line, decoding it onto the end of the worker's input
+ * returns WOLFCLU_SUCCESS on success, 0 at the end of the input */
+static int wolfCLU_PkeyUtlReadLine(WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* w)
+{
+    word32 len = 0;
+    word32 decSz;
+    int    ret;
+
+    for (;;) {
+        if (state->lineSz - len < 2) {
+            char* tmp;
+
+            if (state->lineSz >= WOLFCLU_PKEYUTL_MAX_RECORD * 2) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Record %llu is too long",
+                        (unsigned long long)state->records + 1);
+                return WOLFCLU_FATAL_ERROR;
+            }
+            tmp = (char*)XREALLOC(state->line, state->lineSz * 2, HEAP_HINT,
+                    DYNAMIC_TYPE_TMP_BUFFER);
+            if (tmp == NULL) {
+                return MEMORY_E;
+            }
+            state->line    = tmp;
+            state->lineSz *= 2;
+        }
+        if (XFGETS(state->line + len, state->lineSz - len, state->in) ==
+                NULL) {
+            break;
+        }
+        len += (word32)XSTRLEN(state->line + len);
+        if (len > 0 && state->line[len - 1] == '\n') {
+            break;
+        }
+    }
+    if (len == 0) {
+        return 0;
+    }
+    while (len > 0 && (state->line[len - 1] == '\n' ||
+                state->line[len - 1] == '\r')) {
+        len--;
+    }
+
+    /* an empty line is an empty record */
+    if (len == 0) {
+        return WOLFCLU_SUCCESS;
+    }
+
+    /* base64 decodes to less than it takes up */
+    ret = wolfCLU_PkeyUtlReserve(w, len);
+    if (ret != WOLFCLU_SUCCESS) {
+        return ret;
+    }
+    decSz = w->inMax - w->inSz;
+    if (Base64_Decode((const byte*)state->line, len, w->in + w->inSz,
+                &decSz) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Record %llu is not valid base64",
+                (unsigned long long)state->records + 1);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    w->inSz += decSz;
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* reads the next record onto the end of the worker's input
+ * returns WOLFCLU_SUCCESS on success, 0 at the end of the input */
+static int wolfCLU_PkeyUtlReadRecord(WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* w, word32* off, word32* sz)
+{
+    byte   len[4];
+    word32 recSz;
+    int    ret;
+
+    *off = w->inSz;
+    if (state->useBase64) {
+        ret = wolfCLU_PkeyUtlReadLine(state, w);
+    }
+    else {
+        recSz = (word32)XFREAD(len, 1, sizeof(len), state->in);
+        if (recSz == 0) {
+            return 0;
+        }
+        if (recSz != sizeof(len)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Record %llu is cut short",
+                    (unsigned long long)state->records + 1);
+            return WOLFCLU_FATAL_ERROR;
+        }
+        recSz = ((word32)len[0] << 24) | ((word32)len[1] << 16) |
+                ((word32)len[2] << 8)  |  (word32)len[3];
+        if (recSz > WOLFCLU_PKEYUTL_MAX_RECORD) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Record %llu is larger than %d bytes",
+                    (unsigned long long)state->records + 1,
+                    WOLFCLU_PKEYUTL_MAX_RECORD);
+            return WOLFCLU_FATAL_ERROR;
+        }
+        ret = wolfCLU_PkeyUtlReserve(w, recSz);
+        if (ret == WOLFCLU_SUCCESS) {
+            if (XFREAD(w->in + w->inSz, 1, recSz, state->in) != recSz) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Record %llu is cut short",
+                        (unsigned long long)state->records + 1);
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            w->inSz += recSz;
+        }
+    }
+    *sz = w->inSz - *off;
+    return ret;
+}
+
+
+/* fills the worker with the next block of records, w->count is 0 once the
+ * input has ended
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_PkeyUtlFill(WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* w)
+{
+    WOLFCLU_PKEYUTL_RECORD* rec;
+    int ret = WOLFCLU_SUCCESS;
+
+    w->inSz  = 0;
+    w->count = 0;
+    w->first = state->records;
+    w->ret   = WOLFCLU_SUCCESS;
+    while (w->count < WOLFCLU_PKEYUTL_BLOCK &&
+            w->inSz < WOLFCLU_PKEYUTL_MAX_RECORD) {
+        rec = &w->recs[w->count];
+        ret = wolfCLU_PkeyUtlReadRecord(state, w, &rec->off, &rec->sz);
+        if (ret == 0) {
+            ret = WOLFCLU_SUCCESS;
+            break;
+        }
+        if (ret == WOLFCLU_SUCCESS && state->op == WOLFCLU_PKEYUTL_VERIFY) {
+            ret = wolfCLU_PkeyUtlReadRecord(state, w, &rec->sigOff,
+                    &rec->sigSz);
+            if (ret == 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Record %llu has no signature",
+                        (unsigned long long)state->records + 1);
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+        }
+        if (ret != WOLFCLU_SUCCESS) {
+            break;
+        }
+        state->records++;
+        w->count++;
+    }
+    return ret;
+}
+
+
+/* runs the operation on one record, writing the result to out
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_PkeyUtlRecord(const WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* w, WOLFCLU_PKEYUTL_RECORD* rec, byte* out)
+{
+    const byte* in = w->in + rec->off;
+    void*  key   = (void*)&w->k;
+    word32 keySz = (state->keyType == EVP_PKEY_RSA)? sizeof(RsaKey) :
+                                                     sizeof(ecc_key);
+    int    ret   = -1;
+
+    rec->outSz = state->maxOut;
+    switch (state->op) {
+        case WOLFCLU_PKEYUTL_SIGN:
+            ret = wc_SignatureGenerate(state->hashType, state->sigType, in,
+                    rec->sz, out, &rec->outSz, key, keySz, &w->rng);
+            break;
+
+        case WOLFCLU_PKEYUTL_VERIFY:
+            out[0] = (wc_SignatureVerify(state->hashType, state->sigType, in,
+                        rec->sz, w->in + rec->sigOff, rec->sigSz, key,
+                        keySz) == 0);
+            rec->outSz = 1;
+            ret = 0;
+            break;
+
+    #ifndef NO_RSA
+        case WOLFCLU_PKEYUTL_ENCRYPT:
+            ret = wc_RsaPublicEncrypt(in, rec->sz, out, state->maxOut,
+                    &w->k.rsa, &w->rng);
+            if (ret >= 0) {
+                rec->outSz = (word32)ret;
+                ret = 0;
+            }
+            break;
+
+        case WOLFCLU_PKEYUTL_DECRYPT:
+            /* an empty plaintext is a valid result of size 0 */
+            ret = wc_RsaPrivateDecrypt(in, rec->sz, out, state->maxOut,
+                    &w->k.rsa);
+            if (ret >= 0) {
+                rec->outSz = (word32)ret;
+                ret = 0;
+            }
+            break;
+    #endif
+
+    #ifdef HAVE_ECC
+        case WOLFCLU_PKEYUTL_DERIVE:
+        {
+            ecc_key peer;
+            word32  idx = 0;
+
+            if (wc_ecc_init(&peer) != 0) {
+                break;
+            }
+            ret = wc_EccPublicKeyDecode(in, &idx, &peer, rec->sz);
+            if (ret == 0) {
+                ret = wc_ecc_shared_secret(&w->k.ecc, &peer, out,
+                        &rec->outSz);
+            }
+            wc_ecc_free(&peer);
+            break;
+        }
+    #endif
+    }
+
+    return (ret == 0)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+/* runs the operation on the worker's block, stopping at the first record
+ * that fails */
+static void wolfCLU_PkeyUtlProcess(const WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* w)
+{
+    int i;
+
+    for (i = 0; i < w->count; i++) {
+        if (wolfCLU_PkeyUtlRecord(state, w, &w->recs[i],
+                    w->out + (word32)i * state->maxOut) != WOLFCLU_SUCCESS) {
+            w->ret = WOLFCLU_FATAL_ERROR;
+            w->bad = i;
+            break;
+        }
+    }
+}
+
+
+/* writes out the results of a processed block
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_PkeyUtlWrite(WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* w)
+{
+    WOLFCLU_PKEYUTL_RECORD* rec;
+    byte*  out;
+    byte   len[4];
+    word32 encSz;
+    int    i;
+
+    if (w->ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to process record %llu",
+                (unsigned long long)(w->first + w->bad + 1));
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    for (i = 0; i < w->count; i++) {
+        rec = &w->recs[i];
+        out = w->out + (word32)i * state->maxOut;
+
+        if (state->op == WOLFCLU_PKEYUTL_VERIFY) {
+            if (out[0] == 0) {
+                state->failed++;
+            }
+            if (state->useBase64) {
+                /* a line of text reads better than the base64 of one byte */
+                out   = (byte*)((out[0] == 1)? "OK\n" : "FAIL\n");
+                encSz = (word32)XSTRLEN((const char*)out);
+                if (XFWRITE(out, 1, encSz, state->out) != encSz) {
+                    break;
+                }
+                continue;
+            }
+        }
+
+        if (state->useBase64) {
+            encSz = state->encSz;
+            if (rec->outSz > 0 &&
+                    Base64_Encode_NoNl(out, rec->outSz, state->enc,
+                        &encSz) != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Error base64 encoding");
+                return WOLFCLU_FATAL_ERROR;
+            }
+            if (rec->outSz == 0) {
+                encSz = 0;
+            }
+            state->enc[encSz++] = '\n';
+            if (XFWRITE(state->enc, 1, encSz, state->out) != encSz) {
+                break;
+            }
+        }
+        else {
+            len[0] = (byte)(rec->outSz >> 24);
+            len[1] = (byte)(rec->outSz >> 16);
+            len[2] = (byte)(rec->outSz >> 8);
+            len[3] = (byte)rec->outSz;
+            if (XFWRITE(len, 1, sizeof(len), state->out) != sizeof(len) ||
+                    XFWRITE(out, 1, rec->outSz, state->out) != rec->outSz) {
+                break;
+            }
+        }
+    }
+    if (i < w->count) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Error writing out results");
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    /* results may be secrets, such as decrypted or derived data */
+    if (state->op == WOLFCLU_PKEYUTL_DECRYPT ||
+            state->op == WOLFCLU_PKEYUTL_DERIVE) {
+        wolfCLU_ForceZero(w->out, (word32)w->count * state->maxOut);
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* sets up the worker's RNG, buffers and own copy of the key, the first
+ * worker set up also works out state->maxOut
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_PkeyUtlWorkerInit(WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* w)
+{
+    word32 idx = 0;
+    int    ret = -1;
+    int    outSz;
+
+    XMEMSET(w, 0, sizeof(WOLFCLU_PKEYUTL_WORKER));
+    if (wc_InitRng(&w->rng) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to initialize RNG");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    w->rngInit = 1;
+
+    switch (state->keyType) {
+    #ifndef NO_RSA
+        case EVP_PKEY_RSA:
+            if (wc_InitRsaKey(&w->k.rsa, HEAP_HINT) != 0) {
+                break;
+            }
+            w->keyInit = 1;
+            if (state->pubIn) {
+                ret = wc_RsaPublicKeyDecode(state->der, &idx, &w->k.rsa,
+                        state->derSz);
+            }
+            else {
+                ret = wc_RsaPrivateKeyDecode(state->der, &idx, &w->k.rsa,
+                        state->derSz);
+            }
+        #ifdef WC_RSA_BLINDING
+            if (ret == 0 && !state->pubIn) {
+                ret = wc_RsaSetRNG(&w->k.rsa, &w->rng);
+            }
+        #endif
+            break;
+    #endif
+
+    #ifdef HAVE_ECC
+        case EVP_PKEY_EC:
+            if (wc_ecc_init(&w->k.ecc) != 0) {
+                break;
+            }
+            w->keyInit = 1;
+            if (state->pubIn) {
+                ret = wc_EccPublicKeyDecode(state->der, &idx, &w->k.ecc,
+                        state->derSz);
+            }
+            else {
+                ret = wc_EccPrivateKeyDecode(state->der, &idx, &w->k.ecc,
+                        state->derSz);
+            }
+        #ifdef ECC_TIMING_RESISTANT
+            if (ret == 0 && !state->pubIn) {
+                ret = wc_ecc_set_rng(&w->k.ecc, &w->rng);
+            }
+        #endif
+            break;
+    #endif
+    }
+    if (ret != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to decode key");
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    if (state->maxOut == 0) {
+        switch (state->op) {
+            case WOLFCLU_PKEYUTL_SIGN:
+                outSz = wc_SignatureGetSize(state->sigType, &w->k,
+                        (state->keyType == EVP_PKEY_RSA)? sizeof(RsaKey) :
+                                                          sizeof(ecc_key));
+                break;
+        #ifndef NO_RSA
+            case WOLFCLU_PKEYUTL_ENCRYPT:
+            case WOLFCLU_PKEYUTL_DECRYPT:
+                outSz = wc_RsaEncryptSize(&w->k.rsa);
+                break;
+        #endif
+        #ifdef HAVE_ECC
+            case WOLFCLU_PKEYUTL_DERIVE:
+                outSz = wc_ecc_size(&w->k.ecc);
+                break;
+        #endif
+            default:
+                outSz = 1;
+        }
+        if (outSz <= 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to get result size for key");
+            return WOLFCLU_FATAL_ERROR;
+        }
+        state->maxOut = (word32)outSz;
+    }
+
+    w->inMax = 4096;
+    w->in = (byte*)XMALLOC(w->inMax, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    w->out = (byte*)XMALLOC(WOLFCLU_PKEYUTL_BLOCK * state->maxOut, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (w->in == NULL || w->out == NULL) {
+        return MEMORY_E;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+static void wolfCLU_PkeyUtlWorkerFree(const WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* w)
+{
+    if (w->keyInit) {
+    #ifndef NO_RSA
+        if (state->keyType == EVP_PKEY_RSA) {
+            wc_FreeRsaKey(&w->k.rsa);
+        }
+    #endif
+    #ifdef HAVE_ECC
+        if (state->keyType == EVP_PKEY_EC) {
+            wc_ecc_free(&w->k.ecc);
+        }
+    #endif
+    }
+    if (w->rngInit) {
+        wc_FreeRng(&w->rng);
+    }
+    if (w->in != NULL) {
+        wolfCLU_ForceZero(w->in, w->inMax);
+    }
+    if (w->out != NULL) {
+        wolfCLU_ForceZero(w->out, WOLFCLU_PKEYUTL_BLOCK * state->maxOut);
+    }
+    wolfCLU_freeBins(w->in, w->out, NULL, NULL, NULL);
+    w->in  = NULL;
+    w->out = NULL;
+}
+
+
+#ifndef SINGLE_THREADED
+/* processes each block queued on the worker until told to stop */
+static void* wolfCLU_PkeyUtlThread(void* arg)
+{
+    WOLFCLU_PKEYUTL_WORKER* w = (WOLFCLU_PKEYUTL_WORKER*)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&w->lock);
+        while (!(w->queued && !w->done) && !w->stop) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+        if (w->stop) {
+            pthread_mutex_unlock(&w->lock);
+            break;
+        }
+        pthread_mutex_unlock(&w->lock);
+
+        wolfCLU_PkeyUtlProcess(w->state, w);
+
+        pthread_mutex_lock(&w->lock);
+        w->done = 1;
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+    return NULL;
+}
+
+
+/* hands blocks to the workers in turn while this thread reads the input and
+ * writes each block's results out in the order the records came in
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_PkeyUtlThreaded(WOLFCLU_PKEYUTL_STATE* state,
+        WOLFCLU_PKEYUTL_WORKER* workers)
+{
+    WOLFCLU_PKEYUTL_WORKER* w;
+    int ret = WOLFCLU_SUCCESS;
+    int started = 0;
+    int pending = 0;
+    int eof = 0;
+    int i;
+
+    for (i = 0; i < state->threads; i++) {
+        workers[i].state = state;
+        pthread_mutex_init(&workers[i].lock, NULL);
+        pthread_cond_init(&workers[i].cond, NULL);
+    }
+    for (i = 0; i < state->threads; i++) {
+        if (pthread_create(&workers[i].tid, NULL, wolfCLU_PkeyUtlThread,
+                    &workers[i]) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to create thread");
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        started++;
+    }
+
+    /* the block a worker had before is the oldest one still out, so write
+     * it before handing the worker the next one */
+    for (i = 0; started == state->threads; i = (i + 1) % state->threads) {
+        w = &workers[i];
+        if (w->queued) {
+            pthread_mutex_lock(&w->lock);
+            while (!w->done) {
+                pthread_cond_wait(&w->cond, &w->lock);
+            }
+            w->queued = 0;
+            pthread_mutex_unlock(&w->lock);
+            pending--;
+            if (ret == WOLFCLU_SUCCESS) {
+                ret = wolfCLU_PkeyUtlWrite(state, w);
+            }
+        }
+
+        if (ret != WOLFCLU_SUCCESS || eof) {
+            if (pending == 0) {
+                break;
+            }
+            continue;
+        }
+
+        ret = wolfCLU_PkeyUtlFill(state, w);
+        if (ret == WOLFCLU_SUCCESS && w->count == 0) {
+            eof = 1;
+        }
+        else if (ret == WOLFCLU_SUCCESS) {
+            pthread_mutex_lock(&w->lock);
+            w->done   = 0;
+            w->queued = 1;
+            pthread_cond_broadcast(&w->cond);
+            pthread_mutex_unlock(&w->lock);
+            pending++;
+        }
+        else if (pending == 0) {
+            break;
+        }
+    }
+
+    for (i = 0; i < started; i++) {
+        pthread_mutex_lock(&workers[i].lock);
+        workers[i].stop = 1;
+        pthread_cond_broadcast(&workers[i].cond);
+        pthread_mutex_unlock(&workers[i].lock);
+        pthread_join(workers[i].tid, NULL);
+    }
+    for (i = 0; i < state->threads; i++) {
+        pthread_mutex_destroy(&workers[i].lock);
+        pthread_cond_destroy(&workers[i].cond);
+    }
+    return ret;
+}
+#endif /* !SINGLE_THREADED */
+
+
+/* loads the key once and keeps it as DER for the workers to decode
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_PkeyUtlLoadKey(WOLFCLU_PKEYUTL_STATE* state,
+        const char* path)
+{
+    WOLFSSL_EVP_PKEY* pkey;
+    int ret = WOLFCLU_SUCCESS;
+    int derSz;
+    int priv = (state->op == WOLFCLU_PKEYUTL_SIGN ||
+                state->op == WOLFCLU_PKEYUTL_DECRYPT ||
+                state->op == WOLFCLU_PKEYUTL_DERIVE);
+
+    if (priv && state->pubIn) {
+        WOLFCLU_LOG(WOLFCLU_E0, "A private key is needed, not -pubin");
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    if (state->pubIn) {
+        pkey = wolfCLU_LoadPublicKey(path);
+    }
+    else {
+        pkey = wolfCLU_LoadPrivateKey(path);
+    }
+    if (pkey == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to load key %s", path);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    state->keyType = wolfSSL_EVP_PKEY_id(pkey);
+    switch (state->keyType) {
+        case EVP_PKEY_RSA:
+            state->sigType = WC_SIGNATURE_TYPE_RSA_W_ENC;
+            if (state->op == WOLFCLU_PKEYUTL_DERIVE) {
+                WOLFCLU_LOG(WOLFCLU_E0, "-derive needs an ECC key");
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            break;
+
+        case EVP_PKEY_EC:
+            state->sigType = WC_SIGNATURE_TYPE_ECC;
+            if (state->op == WOLFCLU_PKEYUTL_ENCRYPT ||
+                    state->op == WOLFCLU_PKEYUTL_DECRYPT) {
+                WOLFCLU_LOG(WOLFCLU_E0, "-encrypt and -decrypt need an RSA"
+                        " key");
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            break;
+
+        default:
+            WOLFCLU_LOG(WOLFCLU_E0, "Key type not yet supported");
+            ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* a private key is turned into just its public part for -verify and
+     * -encrypt */
+    if (ret == WOLFCLU_SUCCESS) {
+        if (priv) {
+            derSz = wolfCLU_pKeytoPriKey(pkey, &state->der);
+        }
+        else {
+            derSz = wolfCLU_pKeytoPubKey(pkey, &state->der);
+            state->pubIn = 1;
+        }
+        if (derSz <= 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to extract der key");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            state->derSz = (word32)derSz;
+        }
+    }
+
+    wolfSSL_EVP_PKEY_free(pkey);
+    return ret;
+}
+
+
+/* returns WOLFCLU_SUCCESS on success */
+int wolfCLU_PkeyUtl(int argc, char** argv)
+{
+    WOLFCLU_PKEYUTL_STATE state;
+    WOLFCLU_PKEYUTL_WORKER* workers = NULL;
+    WOLFCLU_GETOPT opt;
+    const char* keyFile = NULL;
+    const char* inFile  = NULL;
+    const char* outFile = NULL;
+    int ret = WOLFCLU_SUCCESS;
+    int option;
+    int longIndex = 0;
+    int inited = 0;
+    int i;
+
+    XMEMSET(&state, 0, sizeof(state));
+    state.hashType = WC_HASH_TYPE_SHA256;
+    state.threads  = 1;
+
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv, pkeyutl_options,
+                    &longIndex)) != -1) {
+        switch (option) {
+            case WOLFCLU_SIGN:
+                state.op = WOLFCLU_PKEYUTL_SIGN;
+                break;
+
+            case WOLFCLU_VERIFY:
+                state.op = WOLFCLU_PKEYUTL_VERIFY;
+                break;
+
+            case WOLFCLU_ENCRYPT:
+                state.op = WOLFCLU_PKEYUTL_ENCRYPT;
+                break;
+
+            case WOLFCLU_DECRYPT:
+                state.op = WOLFCLU_PKEYUTL_DECRYPT;
+                break;
+
+            case WOLFCLU_DERIVE:
+                state.op = WOLFCLU_PKEYUTL_DERIVE;
+                break;
+
+            case WOLFCLU_INKEY:
+                keyFile = opt.arg;
+                break;
+
+            case WOLFCLU_PUBIN:
+                state.pubIn = 1;
+                break;
+
+            case WOLFCLU_INFILE:
+                inFile = opt.arg;
+                break;
+
+            case WOLFCLU_OUTFILE:
+                outFile = opt.arg;
+                break;
+
+            case WOLFCLU_BASE64:
+                state.useBase64 = 1;
+                break;
+
+            case WOLFCLU_THREADS:
+                if (wolfCLU_ParseNum(opt.arg, 1, MAX_THREADS, &state.threads)
+                        != WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "-threads must be between 1 and"
+                            " %d", MAX_THREADS);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+            #ifdef SINGLE_THREADED
+                else if (state.threads > 1) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "Threads are not available in "
+                            "this build");
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+            #endif
+                break;
+
+            case WOLFCLU_MD5:
+                state.hashType = WC_HASH_TYPE_MD5;
+                break;
+
+            case WOLFCLU_CERT_SHA:
+                state.hashType = WC_HASH_TYPE_SHA;
+                break;
+
+            case WOLFCLU_CERT_SHA224:
+                state.hashType = WC_HASH_TYPE_SHA224;
+                break;
+
+            case WOLFCLU_CERT_SHA256:
+                state.hashType = WC_HASH_TYPE_SHA256;
+                break;
+
+            case WOLFCLU_CERT_SHA384:
+                state.hashType = WC_HASH_TYPE_SHA384;
+                break;
+
+            case WOLFCLU_CERT_SHA512:
+                state.hashType = WC_HASH_TYPE_SHA512;
+                break;
+
+            case WOLFCLU_HELP:
+                wolfCLU_PkeyUtlHelp();
+                return WOLFCLU_SUCCESS;
+
+            case '?':
+            default:
+                WOLFCLU_LOG(WOLFCLU_E0, "Bad argument found");
+                wolfCLU_PkeyUtlHelp();
+                ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS && state.op == WOLFCLU_PKEYUTL_NONE) {
+        WOLFCLU_LOG(WOLFCLU_E0, "One of -sign, -verify, -encrypt, -decrypt or"
+                " -derive is needed");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && keyFile == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "No key given with -inkey");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_PkeyUtlLoadKey(&state, keyFile);
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        state.in = (inFile == NULL)? stdin : XFOPEN(inFile, "rb");
+        if (state.in == XBADFILE) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to open %s", inFile);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        state.out = (outFile == NULL)? stdout : XFOPEN(outFile, "wb");
+        if (state.out == XBADFILE) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to open %s", outFile);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        workers = (WOLFCLU_PKEYUTL_WORKER*)XMALLOC(
+                state.threads * sizeof(WOLFCLU_PKEYUTL_WORKER), HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (workers == NULL) {
+            ret = MEMORY_E;
+        }
+    }
+
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < state.threads; i++) {
+        ret = wolfCLU_PkeyUtlWorkerInit(&state, &workers[i]);
+        inited++;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && state.useBase64) {
+        state.lineSz = 4096;
+        state.line   = (char*)XMALLOC(state.lineSz, HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        state.encSz  = ((state.maxOut + 2) / 3) * 4 + 1;
+        state.enc    = (byte*)XMALLOC(state.encSz, HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (state.line == NULL || state.enc == NULL) {
+            ret = MEMORY_E;
+        }
+        state.encSz--; /* room kept for the newline */
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+    #ifndef SINGLE_THREADED
+        if (state.threads > 1) {
+            ret = wolfCLU_PkeyUtlThreaded(&state, workers);
+        }
+        else
+    #endif
+        {
+            for (;;) {
+                ret = wolfCLU_PkeyUtlFill(&state, &workers[0]);
+                if (ret != WOLFCLU_SUCCESS || workers[0].count == 0) {
+                    break;
+                }
+                wolfCLU_PkeyUtlProcess(&state, &workers[0]);
+                ret = wolfCLU_PkeyUtlWrite(&state, &workers[0]);
+                if (ret != WOLFCLU_SUCCESS) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS && fflush(state.out) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Error writing out results");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && state.failed > 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "pkeyutl: %llu of %llu records did not verify",
+                (unsigned long long)state.failed,
+                (unsigned long long)state.records);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    for (i = 0; i < inited; i++) {
+        wolfCLU_PkeyUtlWorkerFree(&state, &workers[i]);
+    }
+    if (workers != NULL) {
+        XFREE(workers, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    if (state.der != NULL) {
+        wolfCLU_ForceZero(state.der, state.derSz);
+        XFREE(state.der, NULL, DYNAMIC_TYPE_OPENSSL);
+    }
+    wolfCLU_freeBins((byte*)state.line, state.enc, NULL, NULL, NULL);
+    if (state.in != NULL && state.in != XBADFILE && state.in != stdin) {
+        XFCLOSE(state.in);
+    }
+    if (state.out != NULL && state.out != XBADFILE && state.out != stdout) {
+        XFCLOSE(state.out);
+    }
+    return ret;
+}
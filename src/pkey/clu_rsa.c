@@ -69,44 +69,44 @@ int wolfCLU_RSA(int argc, char** argv)
     int noOut = 0;
     int option;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     WOLFSSL_BIO *bioIn  = NULL;
     WOLFSSL_BIO *bioOut = NULL;
     WOLFSSL_RSA *rsa = NULL;
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    rsa_options, &longIndex )) != -1) {
         switch (option) {
             case WOLFCLU_INFILE:
-                bioIn = wolfSSL_BIO_new_file(optarg, "rb");
+                bioIn = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (bioIn == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "unable to open key file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_OUTFILE:
-                bioOut = wolfSSL_BIO_new_file(optarg, "wb");
+                bioOut = wolfSSL_BIO_new_file(opt.arg, "wb");
                 if (bioOut == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "unable to open out file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_INFORM:
-                inForm = wolfCLU_checkInform(optarg);
+                inForm = wolfCLU_checkInform(opt.arg);
                 break;
 
             case WOLFCLU_OUTFORM:
-                outForm = wolfCLU_checkInform(optarg);
+                outForm = wolfCLU_checkInform(opt.arg);
                 break;
 
             case WOLFCLU_PASSWORD:
                 passwordSz = MAX_PASSWORD_SIZE;
-                ret = wolfCLU_GetPassword(password, &passwordSz, optarg);
+                ret = wolfCLU_GetPassword(password, &passwordSz, opt.arg);
                 pass = password;
                 break;
 
@@ -64,6 +64,7 @@ int wolfCLU_CRLVerify(int argc, char** argv)
     int outForm = PEM_FORM;
     int output = 1;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     int option;
     byte* der   = NULL;
     int   derSz = 0;
@@ -72,34 +73,33 @@ int wolfCLU_CRLVerify(int argc, char** argv)
     WOLFSSL_BIO* bioIn  = NULL;
     WOLFSSL_BIO* bioOut = NULL;
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "", crl_options,
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv, crl_options,
                     &longIndex )) != -1) {
         switch (option) {
             case WOLFCLU_OUTFILE:
-                out = optarg;
+                out = opt.arg;
                 break;
 
             case WOLFCLU_INFILE:
-                bioIn = wolfSSL_BIO_new_file(optarg, "rb");
+                bioIn = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (bioIn == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "unable to open input file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_OUTFORM:
-                outForm = wolfCLU_checkInform(optarg);
+                outForm = wolfCLU_checkInform(opt.arg);
                 break;
 
             case WOLFCLU_INFORM:
-                inForm = wolfCLU_checkInform(optarg);
+                inForm = wolfCLU_checkInform(opt.arg);
                 break;
 
             case WOLFCLU_CAFILE:
-                caCert = optarg;
+                caCert = opt.arg;
                 break;
 
             case WOLFCLU_NOOUT:
@@ -194,7 +194,7 @@ int wolfCLU_CRLVerify(int argc, char** argv)
         bioOut = wolfSSL_BIO_new_file(out, "wb");
         if (bioOut == NULL) {
             WOLFCLU_LOG(WOLFCLU_E0, "unable to open output file %s",
-                    optarg);
+                    opt.arg);
             ret = WOLFCLU_FATAL_ERROR;
         }
     }
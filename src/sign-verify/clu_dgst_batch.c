@@ -0,0 +1,1872 @@
+/* clu_dgst_batch.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_optargs.h>
+#include <wolfclu/clu_cache.h>
+#include <wolfclu/sign-verify/clu_sign_verify_setup.h>
+#include <wolfclu/sign-verify/clu_ecc_pool.h>
+#include <wolfclu/pkey/clu_pkey.h>
+#include <wolfclu/benchmark/clu_bench.h>
+#include <wolfssl/wolfcrypt/signature.h>
+
+#ifndef SINGLE_THREADED
+    #include <pthread.h>
+#endif
+
+#if !defined(USE_WINDOWS_API)
+    #include <dirent.h>
+    #include <sys/stat.h>
+#endif
+
+/* each worker reads files this many bytes at a time */
+#define WOLFCLU_DGST_BATCH_BUF_SZ (256 * 1024)
+
+/* large enough for an 8192 bit RSA signature */
+#define WOLFCLU_DGST_BATCH_SIG_SZ 1024
+
+/* longest line of a -filelist */
+#define WOLFCLU_DGST_PATH_SZ 4096
+
+/* keyType of a raw Ed25519 public key, it has no EVP_PKEY type here */
+#define WOLFCLU_DGST_ED25519 (-1)
+
+/* added to the name of a file for the name of its signature */
+#define WOLFCLU_DGST_SIG_EXT ".sig"
+
+/* first line of a -merkle-sign manifest */
+#define WOLFCLU_MERKLE_MAGIC "wolfCLU merkle 1"
+
+/* a tree of 2^31 leaves has 32 levels */
+#define WOLFCLU_MERKLE_MAX_LEVELS 32
+
+/* room for the signed header of a manifest */
+#define WOLFCLU_MERKLE_HEAD_SZ 256
+
+/* longest manifest line, a file name and a proof of every level */
+#define WOLFCLU_MERKLE_LINE_SZ (WOLFCLU_DGST_PATH_SZ + 32 + \
+        WOLFCLU_MERKLE_MAX_LEVELS * WC_MAX_DIGEST_SIZE * 2)
+
+/* leaf and interior node hashes start with these, so that one can not be
+ * passed off as the other */
+#define WOLFCLU_MERKLE_LEAF 0x00
+#define WOLFCLU_MERKLE_NODE 0x01
+
+/* a file to sign or check */
+typedef struct WOLFCLU_DGST_JOB {
+    char*  data;
+    char*  sig;
+    const char* err;    /* why the job failed, NULL if it did not */
+    word64 dataSz;      /* bytes hashed */
+    int    key;         /* index into the batch keys */
+    byte   done;
+} WOLFCLU_DGST_JOB;
+
+/* a key loaded once and kept as DER for the workers to decode */
+typedef struct WOLFCLU_DGST_KEY {
+    char*  file;
+    byte*  der;
+    word32 derSz;
+    int    keyType;     /* EVP_PKEY_RSA, EVP_PKEY_EC or WOLFCLU_DGST_ED25519,
+                         * 0 if it did not load */
+    enum wc_SignatureType sigType;
+    WOLFCLU_ECC_POOL* pool; /* ECDSA nonces when signing with an ECC key */
+} WOLFCLU_DGST_KEY;
+
+typedef struct WOLFCLU_DGST_BATCH {
+    WOLFCLU_DGST_JOB* jobs;
+    int    jobCount;
+    int    jobMax;
+    WOLFCLU_DGST_KEY* keys;
+    int    keyCount;
+    int    keyMax;
+    enum wc_HashType hashType;
+    int    verify;      /* 1 if checking signatures, 0 if making them */
+    int    ph;          /* Ed25519 signatures are Ed25519ph, over SHA-512 */
+    int    merkle;      /* 1 if only hashing the files into tree leaves */
+    byte*  tree;        /* Merkle tree nodes, the leaves first */
+    int    next;        /* next job to hand out */
+    int    reported;    /* results of the jobs before this have been printed */
+    int    failed;
+    word64 bytes;
+#ifndef SINGLE_THREADED
+    pthread_mutex_t lock;
+#endif
+} WOLFCLU_DGST_BATCH;
+
+typedef union WOLFCLU_DGST_WKEY {
+    RsaKey  rsa;
+    ecc_key ecc;
+#ifdef HAVE_ED25519
+    ed25519_key ed;
+#endif
+} WOLFCLU_DGST_WKEY;
+
+/* a worker's own RNG, read buffer and decoded copy of each key it used */
+typedef struct WOLFCLU_DGST_WORKER {
+    WOLFCLU_DGST_BATCH* batch;
+    WC_RNG rng;
+    byte*  buf;
+    WOLFCLU_DGST_WKEY* k;
+    signed char* kState;    /* 1 once k[i] is decoded, -1 if that failed
+                             * and -2 if it failed after k[i] was set up */
+    int    rngInit;
+#ifndef SINGLE_THREADED
+    pthread_t tid;
+#endif
+} WOLFCLU_DGST_WORKER;
+
+
+/* returns a copy of a followed by b, NULL if out of memory */
+static char* wolfCLU_DgstBatchJoin(const char* a, const char* sep,
+        const char* b)
+{
+    size_t aSz = XSTRLEN(a);
+    size_t sepSz = XSTRLEN(sep);
+    size_t bSz = XSTRLEN(b);
+    char*  s;
+
+    s = (char*)XMALLOC(aSz + sepSz + bSz + 1, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (s != NULL) {
+        XMEMCPY(s, a, aSz);
+        XMEMCPY(s + aSz, sep, sepSz);
+        XMEMCPY(s + aSz + sepSz, b, bSz + 1);
+    }
+    return s;
+}
+
+
+/* queues data to be signed or checked with key, sig is data.sig if NULL
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstBatchAdd(WOLFCLU_DGST_BATCH* batch, const char* data,
+        const char* sig, int key)
+{
+    WOLFCLU_DGST_JOB* job;
+    WOLFCLU_DGST_JOB* tmp;
+    int max;
+
+    if (batch->jobCount == batch->jobMax) {
+        max = (batch->jobMax == 0)? 1024 : batch->jobMax * 2;
+        tmp = (WOLFCLU_DGST_JOB*)XREALLOC(batch->jobs,
+                max * sizeof(WOLFCLU_DGST_JOB), HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (tmp == NULL) {
+            return MEMORY_E;
+        }
+        batch->jobs   = tmp;
+        batch->jobMax = max;
+    }
+
+    job = &batch->jobs[batch->jobCount];
+    XMEMSET(job, 0, sizeof(WOLFCLU_DGST_JOB));
+    job->key  = key;
+    job->data = wolfCLU_DgstBatchJoin(data, "", "");
+    job->sig  = (sig != NULL)? wolfCLU_DgstBatchJoin(sig, "", "") :
+                wolfCLU_DgstBatchJoin(data, "", WOLFCLU_DGST_SIG_EXT);
+    if (job->data == NULL || job->sig == NULL) {
+        XFREE(job->data, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(job->sig, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return MEMORY_E;
+    }
+    batch->jobCount++;
+    return WOLFCLU_SUCCESS;
+}
+
+
+#ifdef HAVE_ED25519
+/* loads file as a raw 32 byte Ed25519 public key, the form verify -ed25519
+ * -pubin takes. No PEM or DER key is that small.
+ * returns WOLFCLU_SUCCESS if it was one */
+static int wolfCLU_DgstBatchRawEd25519(WOLFCLU_DGST_KEY* key,
+        const char* file)
+{
+    XFILE f;
+    long  sz = -1;
+    int   ret = WOLFCLU_FATAL_ERROR;
+
+    f = XFOPEN(file, "rb");
+    if (f == XBADFILE) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (XFSEEK(f, 0, XSEEK_END) == 0) {
+        sz = XFTELL(f);
+    }
+    if (sz == ED25519_PUB_KEY_SIZE && XFSEEK(f, 0, XSEEK_SET) == 0) {
+        /* allocated as wolfCLU_pKeytoPubKey does, so either is freed the
+         * same way */
+        key->der = (byte*)XMALLOC(sz, NULL, DYNAMIC_TYPE_OPENSSL);
+        if (key->der != NULL && XFREAD(key->der, 1, sz, f) == (size_t)sz) {
+            key->keyType = WOLFCLU_DGST_ED25519;
+            key->derSz   = (word32)sz;
+            ret = WOLFCLU_SUCCESS;
+        }
+        else {
+            XFREE(key->der, NULL, DYNAMIC_TYPE_OPENSSL);
+            key->der = NULL;
+        }
+    }
+    XFCLOSE(f);
+    return ret;
+}
+#endif
+
+
+/* loads the key in file once, a private key when signing and a public key
+ * when verifying, keeping it as DER. When verifying a key that does not load
+ * is still kept so that each entry using it fails without trying again.
+ * returns the index of the key or a negative value on error */
+static int wolfCLU_DgstBatchAddKey(WOLFCLU_DGST_BATCH* batch,
+        const char* file)
+{
+    WOLFCLU_DGST_KEY* key;
+    WOLFCLU_DGST_KEY* tmp;
+    WOLFSSL_EVP_PKEY* pkey;
+    int derSz;
+    int max;
+    int i;
+    int ret = WOLFCLU_SUCCESS;
+
+    for (i = 0; i < batch->keyCount; i++) {
+        if (XSTRCMP(batch->keys[i].file, file) == 0) {
+            return i;
+        }
+    }
+
+    if (batch->keyCount == batch->keyMax) {
+        max = (batch->keyMax == 0)? 4 : batch->keyMax * 2;
+        tmp = (WOLFCLU_DGST_KEY*)XREALLOC(batch->keys,
+                max * sizeof(WOLFCLU_DGST_KEY), HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (tmp == NULL) {
+            return MEMORY_E;
+        }
+        batch->keys   = tmp;
+        batch->keyMax = max;
+    }
+    key = &batch->keys[batch->keyCount];
+    XMEMSET(key, 0, sizeof(WOLFCLU_DGST_KEY));
+    key->file = wolfCLU_DgstBatchJoin(file, "", "");
+    if (key->file == NULL) {
+        return MEMORY_E;
+    }
+
+#ifdef HAVE_ED25519
+    if (batch->verify && wolfCLU_DgstBatchRawEd25519(key, file) ==
+            WOLFCLU_SUCCESS) {
+        return batch->keyCount++;
+    }
+#endif
+
+    if (batch->verify) {
+        pkey = wolfCLU_LoadPublicKey(file);
+    }
+    else {
+        pkey = wolfCLU_LoadPrivateKey(file);
+    }
+    if (pkey == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to decode %s key %s",
+                batch->verify? "public" : "private", file);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        switch (wolfSSL_EVP_PKEY_id(pkey)) {
+            case EVP_PKEY_RSA:
+                key->keyType = EVP_PKEY_RSA;
+                key->sigType = WC_SIGNATURE_TYPE_RSA_W_ENC;
+                break;
+
+            case EVP_PKEY_EC:
+                key->keyType = EVP_PKEY_EC;
+                key->sigType = WC_SIGNATURE_TYPE_ECC;
+                break;
+
+            default:
+                WOLFCLU_LOG(WOLFCLU_E0, "Key type not yet supported");
+                ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        if (batch->verify) {
+            derSz = wolfCLU_pKeytoPubKey(pkey, &key->der);
+        }
+        else {
+            derSz = wolfCLU_pKeytoPriKey(pkey, &key->der);
+        }
+        if (derSz <= 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to extract der key");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            key->derSz = (word32)derSz;
+        }
+    }
+    wolfSSL_EVP_PKEY_free(pkey);
+
+    if (ret != WOLFCLU_SUCCESS) {
+        if (key->der != NULL) {
+            wolfCLU_ForceZero(key->der, key->derSz);
+            XFREE(key->der, NULL, DYNAMIC_TYPE_OPENSSL);
+            key->der   = NULL;
+            key->derSz = 0;
+        }
+        key->keyType = 0;
+        if (!batch->verify) {
+            XFREE(key->file, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+            return ret;
+        }
+    }
+    return batch->keyCount++;
+}
+
+
+/* queues each file named in list, one per line
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstBatchReadList(WOLFCLU_DGST_BATCH* batch,
+        const char* list, int key)
+{
+    XFILE f;
+    char  line[WOLFCLU_DGST_PATH_SZ];
+    int   ret = WOLFCLU_SUCCESS;
+    int   sz;
+
+    f = XFOPEN(list, "rb");
+    if (f == XBADFILE) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to open file list %s", list);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    while (ret == WOLFCLU_SUCCESS && XFGETS(line, sizeof(line), f) != NULL) {
+        sz = (int)XSTRLEN(line);
+        if (sz > 0 && line[sz - 1] != '\n' && !feof(f)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "File name too long in %s", list);
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        while (sz > 0 && (line[sz - 1] == '\n' || line[sz - 1] == '\r')) {
+            line[--sz] = '\0';
+        }
+        if (sz > 0) {
+            ret = wolfCLU_DgstBatchAdd(batch, line, NULL, key);
+        }
+    }
+
+    XFCLOSE(f);
+    return ret;
+}
+
+
+/* splits the next white space separated field off of *s
+ * returns NULL if there is none */
+static char* wolfCLU_DgstBatchField(char** s)
+{
+    char* start = *s;
+    char* end;
+
+    while (*start == ' ' || *start == '\t') {
+        start++;
+    }
+    if (*start == '\0') {
+        return NULL;
+    }
+    end = start;
+    while (*end != '\0' && *end != ' ' && *end != '\t') {
+        end++;
+    }
+    if (*end != '\0') {
+        *end++ = '\0';
+    }
+    *s = end;
+    return start;
+}
+
+
+/* queues each "<data> <sig> <public key>" line of manifest, loading each
+ * key the first time it is named. Empty lines and lines starting with # are
+ * skipped.
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstBatchReadManifest(WOLFCLU_DGST_BATCH* batch,
+        const char* manifest)
+{
+    XFILE f;
+    char  line[WOLFCLU_DGST_PATH_SZ * 3];
+    char* p;
+    char* data;
+    char* sig;
+    char* keyFile;
+    int   ret = WOLFCLU_SUCCESS;
+    int   lineNum = 0;
+    int   key;
+    int   sz;
+
+    f = XFOPEN(manifest, "rb");
+    if (f == XBADFILE) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to open manifest %s", manifest);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    while (ret == WOLFCLU_SUCCESS && XFGETS(line, sizeof(line), f) != NULL) {
+        lineNum++;
+        sz = (int)XSTRLEN(line);
+        if (sz > 0 && line[sz - 1] != '\n' && !feof(f)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Line %d of %s is too long", lineNum,
+                    manifest);
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        while (sz > 0 && (line[sz - 1] == '\n' || line[sz - 1] == '\r')) {
+            line[--sz] = '\0';
+        }
+
+        p = line;
+        data = wolfCLU_DgstBatchField(&p);
+        if (data == NULL || data[0] == '#') {
+            continue;
+        }
+        sig     = wolfCLU_DgstBatchField(&p);
+        keyFile = wolfCLU_DgstBatchField(&p);
+        if (keyFile == NULL || wolfCLU_DgstBatchField(&p) != NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Line %d of %s is not <data> <sig> "
+                    "<public key>", lineNum, manifest);
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+
+        key = wolfCLU_DgstBatchAddKey(batch, keyFile);
+        if (key < 0) {
+            ret = key;
+        }
+        else {
+            ret = wolfCLU_DgstBatchAdd(batch, data, sig, key);
+        }
+    }
+
+    XFCLOSE(f);
+    return ret;
+}
+
+
+/* queues every file under dir, leaving out signatures from an earlier run
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstBatchWalk(WOLFCLU_DGST_BATCH* batch, const char* dir,
+        int key)
+{
+#if !defined(USE_WINDOWS_API)
+    DIR*   d;
+    struct dirent* ent;
+    struct stat st;
+    char*  path;
+    size_t sz;
+    size_t extSz = XSTRLEN(WOLFCLU_DGST_SIG_EXT);
+    int    ret = WOLFCLU_SUCCESS;
+
+    d = opendir(dir);
+    if (d == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to open directory %s", dir);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    while (ret == WOLFCLU_SUCCESS && (ent = readdir(d)) != NULL) {
+        if (XSTRCMP(ent->d_name, ".") == 0 ||
+                XSTRCMP(ent->d_name, "..") == 0) {
+            continue;
+        }
+        path = wolfCLU_DgstBatchJoin(dir, "/", ent->d_name);
+        if (path == NULL) {
+            ret = MEMORY_E;
+            break;
+        }
+
+        /* symbolic links to directories are not followed, so a loop of
+         * them can not walk forever */
+        if (lstat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            ret = wolfCLU_DgstBatchWalk(batch, path, key);
+        }
+        else if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+            sz = XSTRLEN(path);
+            if (sz < extSz ||
+                    XSTRCMP(path + sz - extSz, WOLFCLU_DGST_SIG_EXT) != 0) {
+                ret = wolfCLU_DgstBatchAdd(batch, path, NULL, key);
+            }
+        }
+        XFREE(path, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+
+    closedir(d);
+    return ret;
+#else
+    (void)batch;
+    (void)dir;
+    (void)key;
+    WOLFCLU_LOG(WOLFCLU_E0, "-r is not supported on this platform");
+    return NOT_COMPILED_IN;
+#endif
+}
+
+
+/* returns the worker's copy of key i, decoding it the first time it is used,
+ * or NULL if it could not be decoded */
+static void* wolfCLU_DgstBatchKey(WOLFCLU_DGST_WORKER* w, int i)
+{
+    const WOLFCLU_DGST_KEY* key = &w->batch->keys[i];
+    word32 idx = 0;
+    int    ret = -1;
+
+    if (w->kState[i] == 0) {
+        w->kState[i] = -1;
+        switch (key->keyType) {
+        #ifndef NO_RSA
+            case EVP_PKEY_RSA:
+                if (wc_InitRsaKey(&w->k[i].rsa, HEAP_HINT) != 0) {
+                    break;
+                }
+                w->kState[i] = -2; /* initialized, still needs freeing */
+                if (w->batch->verify) {
+                    ret = wc_RsaPublicKeyDecode(key->der, &idx, &w->k[i].rsa,
+                            key->derSz);
+                }
+                else {
+                    ret = wc_RsaPrivateKeyDecode(key->der, &idx,
+                            &w->k[i].rsa, key->derSz);
+                }
+            #ifdef WC_RSA_BLINDING
+                if (ret == 0 && !w->batch->verify) {
+                    ret = wc_RsaSetRNG(&w->k[i].rsa, &w->rng);
+                }
+            #endif
+                break;
+        #endif
+
+        #ifdef HAVE_ECC
+            case EVP_PKEY_EC:
+                if (wc_ecc_init(&w->k[i].ecc) != 0) {
+                    break;
+                }
+                w->kState[i] = -2;
+                if (w->batch->verify) {
+                    ret = wc_EccPublicKeyDecode(key->der, &idx, &w->k[i].ecc,
+                            key->derSz);
+                }
+                else {
+                    ret = wc_EccPrivateKeyDecode(key->der, &idx,
+                            &w->k[i].ecc, key->derSz);
+                }
+            #ifdef ECC_TIMING_RESISTANT
+                if (ret == 0 && !w->batch->verify) {
+                    ret = wc_ecc_set_rng(&w->k[i].ecc, &w->rng);
+                }
+            #endif
+                break;
+        #endif
+
+        #ifdef HAVE_ED25519
+            case WOLFCLU_DGST_ED25519:
+                if (wc_ed25519_init(&w->k[i].ed) != 0) {
+                    break;
+                }
+                w->kState[i] = -2;
+                ret = wc_ed25519_import_public(key->der, key->derSz,
+                        &w->k[i].ed);
+                break;
+        #endif
+        }
+        if (ret == 0) {
+            w->kState[i] = 1;
+        }
+    }
+
+    return (w->kState[i] == 1)? (void*)&w->k[i] : NULL;
+}
+
+
+/* hashes preSz bytes of pre, if any, then the file at path into digest,
+ * job->dataSz counting the bytes read
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstBatchHash(WOLFCLU_DGST_WORKER* w, WOLFCLU_DGST_JOB* job,
+        enum wc_HashType hashType, const byte* pre, word32 preSz, byte* digest)
+{
+    wc_HashAlg hash;
+    XFILE  f;
+    size_t sz;
+    int    ret = WOLFCLU_SUCCESS;
+
+    f = XFOPEN(job->data, "rb");
+    if (f == XBADFILE) {
+        job->err = "unable to open";
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    if (wc_HashInit(&hash, hashType) != 0) {
+        job->err = "unable to initialize hash";
+        XFCLOSE(f);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (preSz > 0 && wc_HashUpdate(&hash, hashType, pre, preSz) != 0) {
+        job->err = "error hashing";
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    while (ret == WOLFCLU_SUCCESS &&
+            (sz = XFREAD(w->buf, 1, WOLFCLU_DGST_BATCH_BUF_SZ, f)) > 0) {
+        if (wc_HashUpdate(&hash, hashType, w->buf, (word32)sz) != 0) {
+            job->err = "error hashing";
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        job->dataSz += sz;
+    }
+    if (ret == WOLFCLU_SUCCESS && ferror(f)) {
+        job->err = "error reading";
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == WOLFCLU_SUCCESS && wc_HashFinal(&hash, hashType, digest) != 0) {
+        job->err = "error hashing";
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    wc_HashFree(&hash, hashType);
+    XFCLOSE(f);
+    return ret;
+}
+
+
+/* signs one file, writing its signature next to it */
+static void wolfCLU_DgstBatchSignOne(WOLFCLU_DGST_WORKER* w,
+        WOLFCLU_DGST_JOB* job)
+{
+    const WOLFCLU_DGST_BATCH* batch = w->batch;
+    const WOLFCLU_DGST_KEY* key = &batch->keys[job->key];
+    byte   digest[WC_MAX_DIGEST_SIZE];
+    byte   enc[WOLFCLU_DGST_ENC_SZ];
+    byte   sig[WOLFCLU_DGST_BATCH_SIG_SZ];
+    word32 encSz = 0;
+    word32 sigSz = sizeof(sig);
+    int    pooled = 0;
+    void*  k;
+    XFILE  f;
+
+    k = wolfCLU_DgstBatchKey(w, job->key);
+    if (k == NULL) {
+        job->err = "unable to decode key";
+        return;
+    }
+
+    if (wolfCLU_DgstBatchHash(w, job, batch->hashType, NULL, 0, digest) !=
+            WOLFCLU_SUCCESS) {
+        return;
+    }
+
+#ifdef HAVE_ECC
+    /* a precomputed nonce leaves only the arithmetic mod n, signing in full
+     * when the pool has run dry */
+    if (key->pool != NULL && wolfCLU_EccPoolSign(key->pool, (ecc_key*)k,
+                digest, wc_HashGetDigestSize(batch->hashType), sig, &sigSz) ==
+            WOLFCLU_SUCCESS) {
+        pooled = 1;
+    }
+    else {
+        sigSz = sizeof(sig);
+    }
+#endif
+
+    if (!pooled && (wolfCLU_DgstEncode(batch->hashType, key->sigType,
+                digest, enc, &encSz) != WOLFCLU_SUCCESS ||
+            wc_SignatureGenerateHash(batch->hashType, key->sigType, enc,
+                encSz, sig, &sigSz, k,
+                (key->keyType == EVP_PKEY_RSA)? sizeof(RsaKey) :
+                                                sizeof(ecc_key),
+                &w->rng) != 0)) {
+        job->err = "error signing";
+        return;
+    }
+
+    f = XFOPEN(job->sig, "wb");
+    if (f == XBADFILE) {
+        job->err = "unable to create signature file";
+        return;
+    }
+    if (XFWRITE(sig, 1, sigSz, f) != sigSz) {
+        job->err = "error writing signature";
+    }
+    XFCLOSE(f);
+}
+
+
+#ifdef HAVE_ED25519
+/* checks a PureEdDSA signature over the whole file */
+static void wolfCLU_DgstBatchEd25519(WOLFCLU_DGST_WORKER* w,
+        WOLFCLU_DGST_JOB* job, ed25519_key* key, const byte* sig,
+        word32 sigSz)
+{
+    XFILE  f;
+    size_t sz;
+    int    res = 0;
+    int    ret;
+#ifndef WOLFSSL_ED25519_STREAMING_VERIFY
+    byte*  msg = NULL;
+    long   msgSz = -1;
+#endif
+
+    f = XFOPEN(job->data, "rb");
+    if (f == XBADFILE) {
+        job->err = "unable to open";
+        return;
+    }
+
+#ifdef WOLFSSL_ED25519_STREAMING_VERIFY
+    ret = wc_ed25519_verify_msg_init(sig, sigSz, key, (byte)Ed25519, NULL, 0);
+    while (ret == 0 &&
+            (sz = XFREAD(w->buf, 1, WOLFCLU_DGST_BATCH_BUF_SZ, f)) > 0) {
+        ret = wc_ed25519_verify_msg_update(w->buf, (word32)sz, key);
+        job->dataSz += sz;
+    }
+    if (ret == 0 && ferror(f)) {
+        job->err = "error reading";
+    }
+    else if (ret == 0) {
+        ret = wc_ed25519_verify_msg_final(sig, sigSz, &res, key);
+    }
+#else
+    /* without streaming support wolfCrypt takes the message all at once */
+    (void)w;
+    if (XFSEEK(f, 0, XSEEK_END) == 0) {
+        msgSz = XFTELL(f);
+    }
+    if (msgSz >= 0 && XFSEEK(f, 0, XSEEK_SET) == 0) {
+        msg = (byte*)XMALLOC(msgSz + 1, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    if (msg == NULL) {
+        job->err = "unable to read";
+        ret = -1;
+    }
+    else {
+        sz = XFREAD(msg, 1, msgSz, f);
+        if (sz != (size_t)msgSz) {
+            job->err = "error reading";
+            ret = -1;
+        }
+        else {
+            job->dataSz = sz;
+            ret = wc_ed25519_verify_msg(sig, sigSz, msg, (word32)sz, &res,
+                    key);
+        }
+        XFREE(msg, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+#endif
+    XFCLOSE(f);
+
+    if (job->err == NULL && (ret != 0 || res != 1)) {
+        job->err = "does not verify";
+    }
+}
+#endif
+
+
+/* checks one file against its signature */
+static void wolfCLU_DgstBatchVerifyOne(WOLFCLU_DGST_WORKER* w,
+        WOLFCLU_DGST_JOB* job)
+{
+    const WOLFCLU_DGST_BATCH* batch = w->batch;
+    const WOLFCLU_DGST_KEY* key = &batch->keys[job->key];
+    byte   digest[WC_MAX_DIGEST_SIZE];
+    byte   enc[WOLFCLU_DGST_ENC_SZ];
+    byte   sig[WOLFCLU_DGST_BATCH_SIG_SZ + 1];
+    word32 encSz = 0;
+    size_t sigSz = 0;
+    void*  k;
+    XFILE  f;
+
+    f = XFOPEN(job->sig, "rb");
+    if (f == XBADFILE) {
+        job->err = "unable to open signature";
+        return;
+    }
+    sigSz = XFREAD(sig, 1, sizeof(sig), f);
+    if (sigSz == 0 || sigSz > WOLFCLU_DGST_BATCH_SIG_SZ) {
+        job->err = "bad signature file";
+    }
+    XFCLOSE(f);
+    if (job->err != NULL) {
+        return;
+    }
+
+#ifdef HAVE_ED25519
+    if (key->keyType == WOLFCLU_DGST_ED25519) {
+        k = wolfCLU_DgstBatchKey(w, job->key);
+        if (k == NULL) {
+            job->err = "unable to load key";
+            return;
+        }
+    }
+    if (key->keyType == WOLFCLU_DGST_ED25519 && batch->ph) {
+        int res = 0;
+
+        if (wolfCLU_DgstBatchHash(w, job, WC_HASH_TYPE_SHA512, NULL, 0,
+                    digest) != WOLFCLU_SUCCESS) {
+            return;
+        }
+        if (wc_ed25519ph_verify_hash(sig, (word32)sigSz, digest,
+                    WC_SHA512_DIGEST_SIZE, &res, (ed25519_key*)k, NULL, 0) != 0
+                || res != 1) {
+            job->err = "does not verify";
+        }
+        return;
+    }
+    if (key->keyType == WOLFCLU_DGST_ED25519) {
+        wolfCLU_DgstBatchEd25519(w, job, (ed25519_key*)k, sig, (word32)sigSz);
+        return;
+    }
+#endif
+
+    if (wolfCLU_DgstBatchHash(w, job, batch->hashType, NULL, 0, digest) !=
+            WOLFCLU_SUCCESS) {
+        return;
+    }
+
+    /* RSA and ECC keys come from the thread's key cache, which keeps the
+     * ones used most recently decoded however many the manifest names */
+    k = (key->keyType == 0)? NULL :
+        wolfCLU_KeyCtxGet(key->keyType, key->der, key->derSz);
+    if (k == NULL) {
+        job->err = "unable to load key";
+        return;
+    }
+
+    if (wolfCLU_DgstEncode(batch->hashType, key->sigType, digest, enc,
+                &encSz) != WOLFCLU_SUCCESS ||
+            wc_SignatureVerifyHash(batch->hashType, key->sigType, enc, encSz,
+                sig, (word32)sigSz, k,
+                (key->keyType == EVP_PKEY_RSA)? sizeof(RsaKey) :
+                                                sizeof(ecc_key)) != 0) {
+        job->err = "does not verify";
+    }
+    wolfCLU_KeyCtxPut(k);
+}
+
+
+/* hashes the name and contents of a file into its Merkle tree leaf,
+ * H(0x00 || 32 bit big endian name length || name || contents)
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstMerkleHashLeaf(WOLFCLU_DGST_WORKER* w,
+        WOLFCLU_DGST_JOB* job, enum wc_HashType hashType, byte* leaf)
+{
+    word32 nameSz = (word32)XSTRLEN(job->data);
+    byte*  pre;
+    int    ret;
+
+    pre = (byte*)XMALLOC(nameSz + 5, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (pre == NULL) {
+        job->err = "out of memory";
+        return MEMORY_E;
+    }
+    pre[0] = WOLFCLU_MERKLE_LEAF;
+    pre[1] = (byte)(nameSz >> 24);
+    pre[2] = (byte)(nameSz >> 16);
+    pre[3] = (byte)(nameSz >> 8);
+    pre[4] = (byte)nameSz;
+    XMEMCPY(pre + 5, job->data, nameSz);
+
+    ret = wolfCLU_DgstBatchHash(w, job, hashType, pre, nameSz + 5, leaf);
+    XFREE(pre, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+
+/* fills in the tree leaf of one file */
+static void wolfCLU_DgstMerkleLeaf(WOLFCLU_DGST_WORKER* w,
+        WOLFCLU_DGST_JOB* job)
+{
+    WOLFCLU_DGST_BATCH* batch = w->batch;
+    int dSz = wc_HashGetDigestSize(batch->hashType);
+
+    (void)wolfCLU_DgstMerkleHashLeaf(w, job, batch->hashType,
+            batch->tree + (job - batch->jobs) * dSz);
+}
+
+
+/* records the job as done and prints the results of every job finished so
+ * far, in the order they were queued */
+static void wolfCLU_DgstBatchDone(WOLFCLU_DGST_BATCH* batch,
+        WOLFCLU_DGST_JOB* job)
+{
+    WOLFCLU_DGST_JOB* r;
+
+#ifndef SINGLE_THREADED
+    pthread_mutex_lock(&batch->lock);
+#endif
+    job->done = 1;
+    batch->bytes += job->dataSz;
+    if (job->err != NULL) {
+        batch->failed++;
+    }
+
+    while (batch->reported < batch->jobCount &&
+            batch->jobs[batch->reported].done) {
+        r = &batch->jobs[batch->reported++];
+        if (batch->verify && r->err == NULL) {
+            WOLFCLU_LOG(WOLFCLU_L0, "%s: OK", r->data);
+        }
+        else if (batch->verify) {
+            WOLFCLU_LOG(WOLFCLU_L0, "%s: FAIL (%s)", r->data, r->err);
+        }
+        else if (r->err != NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "%s: %s", r->data, r->err);
+        }
+    }
+#ifndef SINGLE_THREADED
+    pthread_mutex_unlock(&batch->lock);
+#endif
+}
+
+
+/* takes jobs until there are none left */
+static void* wolfCLU_DgstBatchThread(void* arg)
+{
+    WOLFCLU_DGST_WORKER* w = (WOLFCLU_DGST_WORKER*)arg;
+    WOLFCLU_DGST_BATCH*  batch = w->batch;
+    int i;
+
+    wolfCLU_KeyCtxEnable(1);
+    for (;;) {
+    #ifndef SINGLE_THREADED
+        pthread_mutex_lock(&batch->lock);
+    #endif
+        i = batch->next++;
+    #ifndef SINGLE_THREADED
+        pthread_mutex_unlock(&batch->lock);
+    #endif
+        if (i >= batch->jobCount) {
+            break;
+        }
+        if (batch->merkle) {
+            wolfCLU_DgstMerkleLeaf(w, &batch->jobs[i]);
+        }
+        else if (batch->verify) {
+            wolfCLU_DgstBatchVerifyOne(w, &batch->jobs[i]);
+        }
+        else {
+            wolfCLU_DgstBatchSignOne(w, &batch->jobs[i]);
+        }
+        wolfCLU_DgstBatchDone(batch, &batch->jobs[i]);
+    }
+    wolfCLU_KeyCtxEnable(0);
+    return NULL;
+}
+
+
+/* returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstBatchWorkerInit(WOLFCLU_DGST_BATCH* batch,
+        WOLFCLU_DGST_WORKER* w)
+{
+    XMEMSET(w, 0, sizeof(WOLFCLU_DGST_WORKER));
+    w->batch = batch;
+    if (wc_InitRng(&w->rng) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to initialize RNG");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    w->rngInit = 1;
+
+    w->buf = (byte*)XMALLOC(WOLFCLU_DGST_BATCH_BUF_SZ, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    w->k = (WOLFCLU_DGST_WKEY*)XMALLOC(
+            batch->keyCount * sizeof(WOLFCLU_DGST_WKEY), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    w->kState = (signed char*)XMALLOC(batch->keyCount, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (w->buf == NULL || w->k == NULL || w->kState == NULL) {
+        return MEMORY_E;
+    }
+    XMEMSET(w->kState, 0, batch->keyCount);
+    return WOLFCLU_SUCCESS;
+}
+
+
+static void wolfCLU_DgstBatchWorkerFree(WOLFCLU_DGST_BATCH* batch,
+        WOLFCLU_DGST_WORKER* w)
+{
+    int i;
+
+    for (i = 0; w->kState != NULL && i < batch->keyCount; i++) {
+        if (w->kState[i] == 0 || w->kState[i] == -1) {
+            continue;
+        }
+    #ifndef NO_RSA
+        if (batch->keys[i].keyType == EVP_PKEY_RSA) {
+            wc_FreeRsaKey(&w->k[i].rsa);
+        }
+    #endif
+    #ifdef HAVE_ECC
+        if (batch->keys[i].keyType == EVP_PKEY_EC) {
+            wc_ecc_free(&w->k[i].ecc);
+        }
+    #endif
+    #ifdef HAVE_ED25519
+        if (batch->keys[i].keyType == WOLFCLU_DGST_ED25519) {
+            wc_ed25519_free(&w->k[i].ed);
+        }
+    #endif
+    }
+    if (w->rngInit) {
+        wc_FreeRng(&w->rng);
+    }
+    if (w->k != NULL) {
+        wolfCLU_ForceZero(w->k, batch->keyCount * sizeof(WOLFCLU_DGST_WKEY));
+    }
+    XFREE(w->k, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(w->kState, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(w->buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+}
+
+
+/* runs the queued jobs on threads workers and prints a summary
+ * returns WOLFCLU_SUCCESS if every job succeeded */
+static int wolfCLU_DgstBatchRun(WOLFCLU_DGST_BATCH* batch, int threads)
+{
+    WOLFCLU_DGST_WORKER* workers;
+    word64 start;
+    double sec;
+    int    ret = WOLFCLU_SUCCESS;
+    int    inited = 0;
+    int    i;
+
+    if (threads > batch->jobCount) {
+        threads = (batch->jobCount > 0)? batch->jobCount : 1;
+    }
+
+    workers = (WOLFCLU_DGST_WORKER*)XMALLOC(
+            threads * sizeof(WOLFCLU_DGST_WORKER), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (workers == NULL) {
+        return MEMORY_E;
+    }
+
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < threads; i++) {
+        ret = wolfCLU_DgstBatchWorkerInit(batch, &workers[i]);
+        inited++;
+    }
+
+    start = wolfCLU_TimerNs();
+    if (ret == WOLFCLU_SUCCESS && threads == 1) {
+        wolfCLU_DgstBatchThread(&workers[0]);
+    }
+#ifndef SINGLE_THREADED
+    else if (ret == WOLFCLU_SUCCESS) {
+        int started = 0;
+
+        for (i = 0; i < threads; i++) {
+            if (pthread_create(&workers[i].tid, NULL, wolfCLU_DgstBatchThread,
+                        &workers[i]) != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Unable to create thread");
+                break;
+            }
+            started++;
+        }
+
+        /* the threads that did start still finish every job */
+        if (started == 0) {
+            wolfCLU_DgstBatchThread(&workers[0]);
+        }
+        for (i = 0; i < started; i++) {
+            pthread_join(workers[i].tid, NULL);
+        }
+    }
+#endif
+    sec = (double)(wolfCLU_TimerNs() - start) / 1000000000.0;
+
+    if (ret == WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_L0, "dgst: %d files %s, %d failed, %.1f MB "
+                "in %.3f seconds (%.0f files/s, %.1f MB/s)",
+                batch->jobCount - batch->failed,
+                batch->merkle? "hashed" :
+                batch->verify? "verified" : "signed", batch->failed,
+                (double)batch->bytes / MEGABYTE, sec,
+                (sec > 0)? batch->jobCount / sec : 0.0,
+                (sec > 0)? (double)batch->bytes / MEGABYTE / sec : 0.0);
+        if (batch->failed > 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    for (i = 0; i < inited; i++) {
+        wolfCLU_DgstBatchWorkerFree(batch, &workers[i]);
+    }
+    XFREE(workers, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+
+static void wolfCLU_DgstBatchFree(WOLFCLU_DGST_BATCH* batch)
+{
+    int i;
+
+    for (i = 0; i < batch->jobCount; i++) {
+        XFREE(batch->jobs[i].data, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(batch->jobs[i].sig, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    for (i = 0; i < batch->keyCount; i++) {
+    #ifdef HAVE_ECC
+        wolfCLU_EccPoolFree(batch->keys[i].pool);
+    #endif
+        if (batch->keys[i].der != NULL) {
+            wolfCLU_ForceZero(batch->keys[i].der, batch->keys[i].derSz);
+            XFREE(batch->keys[i].der, NULL, DYNAMIC_TYPE_OPENSSL);
+        }
+        XFREE(batch->keys[i].file, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    XFREE(batch->jobs, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(batch->keys, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+#ifndef SINGLE_THREADED
+    pthread_mutex_destroy(&batch->lock);
+#endif
+}
+
+
+/* return WOLFCLU_SUCCESS on success */
+#ifdef HAVE_ECC
+/* starts a nonce pool for the ECC signing key, which is signed with in full
+ * if that is not possible */
+static void wolfCLU_DgstBatchPool(WOLFCLU_DGST_KEY* key, int nonces)
+{
+    ecc_key ecc;
+    word32  idx = 0;
+
+    if (key->keyType != EVP_PKEY_EC || nonces <= 0 ||
+            wc_ecc_init(&ecc) != 0) {
+        return;
+    }
+    if (wc_EccPrivateKeyDecode(key->der, &idx, &ecc, key->derSz) != 0 ||
+            wolfCLU_EccPoolNew(&ecc, nonces, &key->pool) != WOLFCLU_SUCCESS) {
+        key->pool = NULL;
+    }
+    wc_ecc_free(&ecc);
+}
+#endif
+
+
+/* return WOLFCLU_SUCCESS on success */
+int wolfCLU_DgstBatchSign(const char* keyFile, enum wc_HashType hashType,
+        const char* list, const char* dir, int threads, int nonces)
+{
+    WOLFCLU_DGST_BATCH batch;
+    int ret = WOLFCLU_SUCCESS;
+    int key;
+
+    if (hashType == WC_HASH_TYPE_NONE) {
+        WOLFCLU_LOG(WOLFCLU_E0, "No hash algorithm given, such as -sha256");
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    XMEMSET(&batch, 0, sizeof(batch));
+    batch.hashType = hashType;
+#ifndef SINGLE_THREADED
+    pthread_mutex_init(&batch.lock, NULL);
+#endif
+
+    /* the key is read and parsed once for every file */
+    key = wolfCLU_DgstBatchAddKey(&batch, keyFile);
+    if (key < 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && list != NULL) {
+        ret = wolfCLU_DgstBatchReadList(&batch, list, key);
+    }
+    if (ret == WOLFCLU_SUCCESS && dir != NULL) {
+        ret = wolfCLU_DgstBatchWalk(&batch, dir, key);
+    }
+#ifdef HAVE_ECC
+    if (ret == WOLFCLU_SUCCESS) {
+        wolfCLU_DgstBatchPool(&batch.keys[key], nonces);
+    }
+#else
+    (void)nonces;
+#endif
+
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_DgstBatchRun(&batch, threads);
+    }
+
+    wolfCLU_DgstBatchFree(&batch);
+    return ret;
+}
+
+
+/* return WOLFCLU_SUCCESS on success */
+int wolfCLU_DgstBatchVerify(const char* manifest, enum wc_HashType hashType,
+        int threads, int ph)
+{
+    WOLFCLU_DGST_BATCH batch;
+    int ret;
+    int i;
+
+    XMEMSET(&batch, 0, sizeof(batch));
+    batch.hashType = hashType;
+    batch.verify   = 1;
+    batch.ph       = ph;
+#ifndef SINGLE_THREADED
+    pthread_mutex_init(&batch.lock, NULL);
+#endif
+
+    /* each public key is read and parsed once however many entries use it */
+    ret = wolfCLU_DgstBatchReadManifest(&batch, manifest);
+
+    /* Ed25519 signs the data itself, RSA and ECC keys need the hash */
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < batch.keyCount; i++) {
+        if (hashType == WC_HASH_TYPE_NONE &&
+                (batch.keys[i].keyType == EVP_PKEY_RSA ||
+                 batch.keys[i].keyType == EVP_PKEY_EC)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "No hash algorithm given, such as "
+                    "-sha256");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_DgstBatchRun(&batch, threads);
+    }
+
+    wolfCLU_DgstBatchFree(&batch);
+    return ret;
+}
+
+
+static const struct {
+    enum wc_HashType type;
+    const char* name;
+} wolfCLU_DgstMerkleHashes[] = {
+    {WC_HASH_TYPE_MD5,    "md5"   },
+    {WC_HASH_TYPE_SHA,    "sha"   },
+    {WC_HASH_TYPE_SHA224, "sha224"},
+    {WC_HASH_TYPE_SHA256, "sha256"},
+    {WC_HASH_TYPE_SHA384, "sha384"},
+    {WC_HASH_TYPE_SHA512, "sha512"},
+};
+
+
+/* returns the name a manifest uses for hashType, NULL if it has none */
+static const char* wolfCLU_DgstMerkleHashName(enum wc_HashType hashType)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(wolfCLU_DgstMerkleHashes) /
+            sizeof(wolfCLU_DgstMerkleHashes[0]); i++) {
+        if (wolfCLU_DgstMerkleHashes[i].type == hashType) {
+            return wolfCLU_DgstMerkleHashes[i].name;
+        }
+    }
+    return NULL;
+}
+
+
+/* returns the hash named name in a manifest, WC_HASH_TYPE_NONE if unknown */
+static enum wc_HashType wolfCLU_DgstMerkleHashType(const char* name)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(wolfCLU_DgstMerkleHashes) /
+            sizeof(wolfCLU_DgstMerkleHashes[0]); i++) {
+        if (XSTRCMP(wolfCLU_DgstMerkleHashes[i].name, name) == 0) {
+            return wolfCLU_DgstMerkleHashes[i].type;
+        }
+    }
+    return WC_HASH_TYPE_NONE;
+}
+
+
+/* H(0x01 || left || right) into out, the hash of an interior node
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstMerkleNode(enum wc_HashType hashType, const byte* left,
+        const byte* right, word32 dSz, byte* out)
+{
+    wc_HashAlg hash;
+    byte tag = WOLFCLU_MERKLE_NODE;
+    int  ret = WOLFCLU_FATAL_ERROR;
+
+    if (wc_HashInit(&hash, hashType) == 0) {
+        if (wc_HashUpdate(&hash, hashType, &tag, 1) == 0 &&
+                wc_HashUpdate(&hash, hashType, left, dSz) == 0 &&
+                wc_HashUpdate(&hash, hashType, right, dSz) == 0 &&
+                wc_HashFinal(&hash, hashType, out) == 0) {
+            ret = WOLFCLU_SUCCESS;
+        }
+        wc_HashFree(&hash, hashType);
+    }
+    return ret;
+}
+
+
+/* works out where each level of a tree of n leaves starts in its nodes, the
+ * leaves being level 0 and the root the last level. A node left without a
+ * sibling moves up to the next level as it is.
+ * returns the number of levels */
+static int wolfCLU_DgstMerkleLevels(word32 n, word32* off, word32* cnt)
+{
+    word32 at = 0;
+    int    levels = 0;
+
+    for (;;) {
+        off[levels] = at;
+        cnt[levels] = n;
+        at += n;
+        levels++;
+        if (n <= 1) {
+            break;
+        }
+        n = (n + 1) / 2;
+    }
+    return levels;
+}
+
+
+/* returns WOLFCLU_SUCCESS if key loaded and can sign a manifest */
+static int wolfCLU_DgstMerkleKey(const WOLFCLU_DGST_KEY* key)
+{
+    if (key->keyType == EVP_PKEY_RSA || key->keyType == EVP_PKEY_EC) {
+        return WOLFCLU_SUCCESS;
+    }
+    if (key->keyType != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Merkle manifests are signed with RSA or "
+                "ECC keys");
+    }
+    return WOLFCLU_FATAL_ERROR;
+}
+
+
+/* signs the manifest header, or checks sig against it when verifying, with
+ * the one key of batch
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstMerkleHead(WOLFCLU_DGST_BATCH* batch, const char* head,
+        byte* sig, word32* sigSz)
+{
+    WOLFCLU_DGST_WORKER w;
+    const WOLFCLU_DGST_KEY* key = &batch->keys[0];
+    byte   digest[WC_MAX_DIGEST_SIZE];
+    byte   enc[WOLFCLU_DGST_ENC_SZ];
+    word32 encSz = 0;
+    word32 keySz = (key->keyType == EVP_PKEY_RSA)? sizeof(RsaKey) :
+                                                   sizeof(ecc_key);
+    void*  k = NULL;
+    int    ret;
+
+    ret = wolfCLU_DgstBatchWorkerInit(batch, &w);
+    if (ret == WOLFCLU_SUCCESS) {
+        k = wolfCLU_DgstBatchKey(&w, 0);
+        if (k == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to decode key %s", key->file);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS &&
+            (wc_Hash(batch->hashType, (const byte*)head,
+                     (word32)XSTRLEN(head), digest, sizeof(digest)) != 0 ||
+             wolfCLU_DgstEncode(batch->hashType, key->sigType, digest, enc,
+                 &encSz) != WOLFCLU_SUCCESS)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && batch->verify) {
+        if (wc_SignatureVerifyHash(batch->hashType, key->sigType, enc, encSz,
+                    sig, *sigSz, k, keySz) != 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+    else if (ret == WOLFCLU_SUCCESS) {
+        if (wc_SignatureGenerateHash(batch->hashType, key->sigType, enc,
+                    encSz, sig, sigSz, k, keySz, &w.rng) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Error signing the Merkle root");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    wolfCLU_DgstBatchWorkerFree(batch, &w);
+    return ret;
+}
+
+
+/* writes sz bytes of in to f as hex
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstMerkleHex(XFILE f, const byte* in, word32 sz)
+{
+    char   hex[WC_MAX_DIGEST_SIZE * 2 + 1];
+    word32 hexSz;
+    word32 i;
+    word32 n;
+
+    for (i = 0; i < sz; i += n) {
+        n = (sz - i > WC_MAX_DIGEST_SIZE)? WC_MAX_DIGEST_SIZE : sz - i;
+        hexSz = sizeof(hex);
+        if (Base16_Encode(in + i, n, (byte*)hex, &hexSz) != 0 ||
+                XFWRITE(hex, 1, n * 2, f) != n * 2) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* writes the string s to f
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstMerklePuts(XFILE f, const char* s)
+{
+    size_t sz = XSTRLEN(s);
+
+    return (XFWRITE(s, 1, sz, f) == sz)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+/* orders jobs by file name, so that the same files give the same tree
+ * whatever order they were found in */
+static int wolfCLU_DgstMerkleCmp(const void* a, const void* b)
+{
+    return XSTRCMP(((const WOLFCLU_DGST_JOB*)a)->data,
+                   ((const WOLFCLU_DGST_JOB*)b)->data);
+}
+
+
+/* return WOLFCLU_SUCCESS on success */
+int wolfCLU_DgstMerkleSign(const char* keyFile, enum wc_HashType hashType,
+        const char* in, const char* out, int threads)
+{
+    WOLFCLU_DGST_BATCH batch;
+    word32 off[WOLFCLU_MERKLE_MAX_LEVELS + 1];
+    word32 cnt[WOLFCLU_MERKLE_MAX_LEVELS + 1];
+    char   head[WOLFCLU_MERKLE_HEAD_SZ];
+    char   hex[WC_MAX_DIGEST_SIZE * 2 + 1];
+    char   num[16];
+    byte   sig[WOLFCLU_DGST_BATCH_SIG_SZ];
+    word32 sigSz = sizeof(sig);
+    word32 hexSz = sizeof(hex);
+    word32 i, j, sib;
+    const char* name = wolfCLU_DgstMerkleHashName(hashType);
+    XFILE  f;
+    int    dSz = wc_HashGetDigestSize(hashType);
+    int    levels = 0;
+    int    ret = WOLFCLU_SUCCESS;
+    int    key;
+    int    l;
+    int    proof;
+#if !defined(USE_WINDOWS_API)
+    struct stat st;
+#endif
+
+    if (name == NULL || dSz <= 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "No hash algorithm given, such as -sha256");
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    XMEMSET(&batch, 0, sizeof(batch));
+    batch.hashType = hashType;
+    batch.merkle   = 1;
+#ifndef SINGLE_THREADED
+    pthread_mutex_init(&batch.lock, NULL);
+#endif
+
+    key = wolfCLU_DgstBatchAddKey(&batch, keyFile);
+    if (key < 0 || wolfCLU_DgstMerkleKey(&batch.keys[key]) !=
+            WOLFCLU_SUCCESS) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* in is either a directory to walk or a list of files */
+    if (ret == WOLFCLU_SUCCESS) {
+    #if !defined(USE_WINDOWS_API)
+        if (stat(in, &st) == 0 && S_ISDIR(st.st_mode)) {
+            ret = wolfCLU_DgstBatchWalk(&batch, in, key);
+        }
+        else
+    #endif
+        {
+            ret = wolfCLU_DgstBatchReadList(&batch, in, key);
+        }
+    }
+    if (ret == WOLFCLU_SUCCESS && batch.jobCount == 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "No files to sign in %s", in);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* each name is a line of the manifest, found by -merkle-verify */
+    if (ret == WOLFCLU_SUCCESS) {
+        qsort(batch.jobs, batch.jobCount, sizeof(WOLFCLU_DGST_JOB),
+                wolfCLU_DgstMerkleCmp);
+    }
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < (word32)batch.jobCount; i++) {
+        if (XSTRLEN(batch.jobs[i].data) >= WOLFCLU_DGST_PATH_SZ ||
+                XSTRSTR(batch.jobs[i].data, "\n") != NULL ||
+                XSTRSTR(batch.jobs[i].data, "\r") != NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "%s can not be named in a manifest",
+                    batch.jobs[i].data);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else if (i > 0 && XSTRCMP(batch.jobs[i].data,
+                    batch.jobs[i - 1].data) == 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "%s is listed more than once",
+                    batch.jobs[i].data);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        levels = wolfCLU_DgstMerkleLevels((word32)batch.jobCount, off, cnt);
+        batch.tree = (byte*)XMALLOC((off[levels - 1] + 1) * dSz, HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (batch.tree == NULL) {
+            ret = MEMORY_E;
+        }
+    }
+
+    /* the leaves are hashed in parallel, the rest of the tree is small */
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_DgstBatchRun(&batch, threads);
+    }
+    for (l = 1; ret == WOLFCLU_SUCCESS && l < levels; l++) {
+        for (j = 0; ret == WOLFCLU_SUCCESS && j < cnt[l]; j++) {
+            byte* left = batch.tree + (off[l - 1] + 2 * j) * dSz;
+            byte* node = batch.tree + (off[l] + j) * dSz;
+
+            if (2 * j + 1 < cnt[l - 1]) {
+                ret = wolfCLU_DgstMerkleNode(hashType, left, left + dSz, dSz,
+                        node);
+            }
+            else {
+                XMEMCPY(node, left, dSz);
+            }
+        }
+    }
+
+    /* only the header, which holds the root, is signed */
+    if (ret == WOLFCLU_SUCCESS &&
+            Base16_Encode(batch.tree + off[levels - 1] * dSz, dSz,
+                (byte*)hex, &hexSz) != 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        XSNPRINTF(head, sizeof(head), "%s\nhash %s\nleaves %d\nroot %s\n",
+                WOLFCLU_MERKLE_MAGIC, name, batch.jobCount, hex);
+        ret = wolfCLU_DgstMerkleHead(&batch, head, sig, &sigSz);
+    }
+
+    /* each file's line is "<index> <proof> <name>", the proof being the
+     * sibling hashes from the leaf up, or - when it has none */
+    if (ret == WOLFCLU_SUCCESS) {
+        f = XFOPEN(out, "wb");
+        if (f == XBADFILE) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to open output file %s", out);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            if (wolfCLU_DgstMerklePuts(f, head) != WOLFCLU_SUCCESS ||
+                    wolfCLU_DgstMerklePuts(f, "signature ") != WOLFCLU_SUCCESS
+                    || wolfCLU_DgstMerkleHex(f, sig, sigSz) != WOLFCLU_SUCCESS
+                    || wolfCLU_DgstMerklePuts(f, "\n") != WOLFCLU_SUCCESS) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            for (i = 0; ret == WOLFCLU_SUCCESS &&
+                    i < (word32)batch.jobCount; i++) {
+                XSNPRINTF(num, sizeof(num), "%u ", i);
+                ret = wolfCLU_DgstMerklePuts(f, num);
+                proof = 0;
+                for (l = 0, j = i; ret == WOLFCLU_SUCCESS && l < levels - 1;
+                        l++, j >>= 1) {
+                    sib = j ^ 1;
+                    if (sib < cnt[l]) {
+                        ret = wolfCLU_DgstMerkleHex(f,
+                                batch.tree + (off[l] + sib) * dSz, dSz);
+                        proof = 1;
+                    }
+                }
+                if (ret == WOLFCLU_SUCCESS) {
+                    ret = wolfCLU_DgstMerklePuts(f, proof? " " : "- ");
+                }
+                if (ret == WOLFCLU_SUCCESS) {
+                    ret = wolfCLU_DgstMerklePuts(f, batch.jobs[i].data);
+                }
+                if (ret == WOLFCLU_SUCCESS) {
+                    ret = wolfCLU_DgstMerklePuts(f, "\n");
+                }
+            }
+            if (XFCLOSE(f) != 0) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            if (ret != WOLFCLU_SUCCESS) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Error writing %s", out);
+            }
+        }
+    }
+
+    XFREE(batch.tree, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    wolfCLU_DgstBatchFree(&batch);
+    return ret;
+}
+
+
+/* reads the next line of f into line without its line ending
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstMerkleLine(XFILE f, char* line, int sz)
+{
+    int n;
+
+    if (XFGETS(line, sz, f) == NULL) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    n = (int)XSTRLEN(line);
+    if (n > 0 && line[n - 1] != '\n' && !feof(f)) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) {
+        line[--n] = '\0';
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* parses a decimal number of at most 2^31 - 1
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstMerkleNum(const char* s, word32* out)
+{
+    word32 n = 0;
+
+    if (s == NULL || *s == '\0') {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    for (; *s != '\0'; s++) {
+        if (*s < '0' || *s > '9' || n > (0x7FFFFFFF - (word32)(*s - '0')) / 10) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+        n = n * 10 + (word32)(*s - '0');
+    }
+    *out = n;
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* returns the value of "<name> <value>" line, NULL if line is not one */
+static char* wolfCLU_DgstMerkleValue(char* line, const char* name)
+{
+    size_t sz = XSTRLEN(name);
+
+    if (XSTRNCMP(line, name, sz) != 0 || line[sz] != ' ') {
+        return NULL;
+    }
+    return line + sz + 1;
+}
+
+
+/* return WOLFCLU_SUCCESS on success */
+int wolfCLU_DgstMerkleVerify(const char* keyFile, const char* manifest,
+        const char* data)
+{
+    WOLFCLU_DGST_BATCH  batch;
+    WOLFCLU_DGST_WORKER w;
+    WOLFCLU_DGST_JOB    job;
+    XFILE  f;
+    char   line[WOLFCLU_MERKLE_LINE_SZ];
+    char   head[WOLFCLU_MERKLE_HEAD_SZ];
+    byte   root[WC_MAX_DIGEST_SIZE];
+    byte   cur[WC_MAX_DIGEST_SIZE];
+    byte   proof[WOLFCLU_MERKLE_MAX_LEVELS * WC_MAX_DIGEST_SIZE];
+    byte   sig[WOLFCLU_DGST_BATCH_SIG_SZ];
+    word32 rootSz  = sizeof(root);
+    word32 proofSz = 0;
+    word32 sigSz   = sizeof(sig);
+    word32 leaves  = 0;
+    word32 idx     = 0;
+    word32 pos, j, m;
+    const char* err = NULL;
+    char*  p;
+    char*  v;
+    int    dSz = 0;
+    int    found = 0;
+    int    wInit = 0;
+    int    ret = WOLFCLU_SUCCESS;
+    int    i;
+
+    XMEMSET(&batch, 0, sizeof(batch));
+    batch.verify = 1;
+#ifndef SINGLE_THREADED
+    pthread_mutex_init(&batch.lock, NULL);
+#endif
+
+    f = XFOPEN(manifest, "rb");
+    if (f == XBADFILE) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to open manifest %s", manifest);
+        wolfCLU_DgstBatchFree(&batch);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    /* the four header lines are what was signed */
+    head[0] = '\0';
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < 4; i++) {
+        if (wolfCLU_DgstMerkleLine(f, line, sizeof(line)) != WOLFCLU_SUCCESS
+                || XSTRLEN(head) + XSTRLEN(line) + 2 > sizeof(head)) {
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        XSTRNCAT(head, line, sizeof(head) - XSTRLEN(head) - 1);
+        XSTRNCAT(head, "\n", sizeof(head) - XSTRLEN(head) - 1);
+
+        switch (i) {
+            case 0:
+                if (XSTRCMP(line, WOLFCLU_MERKLE_MAGIC) != 0) {
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+                break;
+            case 1:
+                v = wolfCLU_DgstMerkleValue(line, "hash");
+                batch.hashType = (v == NULL)? WC_HASH_TYPE_NONE :
+                                              wolfCLU_DgstMerkleHashType(v);
+                dSz = wc_HashGetDigestSize(batch.hashType);
+                if (batch.hashType == WC_HASH_TYPE_NONE || dSz <= 0) {
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+                break;
+            case 2:
+                if (wolfCLU_DgstMerkleNum(wolfCLU_DgstMerkleValue(line,
+                                "leaves"), &leaves) != WOLFCLU_SUCCESS ||
+                        leaves == 0) {
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+                break;
+            default:
+                v = wolfCLU_DgstMerkleValue(line, "root");
+                if (v == NULL || Base16_Decode((const byte*)v,
+                            (word32)XSTRLEN(v), root, &rootSz) != 0 ||
+                        rootSz != (word32)dSz) {
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+        }
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        if (wolfCLU_DgstMerkleLine(f, line, sizeof(line)) != WOLFCLU_SUCCESS
+                || (v = wolfCLU_DgstMerkleValue(line, "signature")) == NULL
+                || Base16_Decode((const byte*)v, (word32)XSTRLEN(v), sig,
+                    &sigSz) != 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "%s is not a Merkle manifest", manifest);
+    }
+
+    /* only the line for data is needed, with its proof */
+    while (ret == WOLFCLU_SUCCESS && !found &&
+            wolfCLU_DgstMerkleLine(f, line, sizeof(line)) == WOLFCLU_SUCCESS) {
+        p = line;
+        v = wolfCLU_DgstBatchField(&p);
+        if (v == NULL) {
+            continue;
+        }
+        if (wolfCLU_DgstMerkleNum(v, &idx) != WOLFCLU_SUCCESS ||
+                (v = wolfCLU_DgstBatchField(&p)) == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "%s has a bad entry", manifest);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else if (XSTRCMP(p, data) == 0) {
+            found = 1;
+            proofSz = sizeof(proof);
+            if (XSTRCMP(v, "-") == 0) {
+                proofSz = 0;
+            }
+            else if (Base16_Decode((const byte*)v, (word32)XSTRLEN(v), proof,
+                        &proofSz) != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "%s has a bad proof for %s",
+                        manifest, data);
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+        }
+    }
+    XFCLOSE(f);
+    if (ret == WOLFCLU_SUCCESS && !found) {
+        WOLFCLU_LOG(WOLFCLU_E0, "%s is not in %s", data, manifest);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && (wolfCLU_DgstBatchAddKey(&batch, keyFile)
+                != 0 || wolfCLU_DgstMerkleKey(&batch.keys[0]) !=
+                WOLFCLU_SUCCESS)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_DgstBatchWorkerInit(&batch, &w);
+        wInit = 1;
+    }
+
+    /* the leaf, then one node hash for each level up to the root */
+    if (ret == WOLFCLU_SUCCESS) {
+        XMEMSET(&job, 0, sizeof(job));
+        job.data = (char*)data;
+        if (wolfCLU_DgstMerkleHashLeaf(&w, &job, batch.hashType, cur) !=
+                WOLFCLU_SUCCESS) {
+            err = job.err;
+        }
+    }
+    if (ret == WOLFCLU_SUCCESS && err == NULL) {
+        if (idx >= leaves) {
+            err = "index out of range";
+        }
+        for (j = idx, m = leaves, pos = 0; err == NULL && m > 1;
+                j >>= 1, m = (m + 1) / 2) {
+            if ((j ^ 1) >= m) {
+                continue;
+            }
+            if (pos + dSz > proofSz) {
+                err = "proof too short";
+            }
+            else if (wolfCLU_DgstMerkleNode(batch.hashType,
+                        (j & 1)? proof + pos : cur,
+                        (j & 1)? cur : proof + pos, dSz, cur) !=
+                    WOLFCLU_SUCCESS) {
+                err = "error hashing";
+            }
+            pos += dSz;
+        }
+        if (err == NULL && pos != proofSz) {
+            err = "proof too long";
+        }
+        if (err == NULL && XMEMCMP(cur, root, dSz) != 0) {
+            err = "does not match the Merkle root";
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS && err == NULL &&
+            wolfCLU_DgstMerkleHead(&batch, head, sig, &sigSz) !=
+                WOLFCLU_SUCCESS) {
+        err = "manifest signature does not verify";
+    }
+
+    if (ret == WOLFCLU_SUCCESS && err == NULL) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Verify OK");
+    }
+    else if (ret == WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "%s: %s", data, err);
+        WOLFCLU_LOG(WOLFCLU_L0, "Verification failure");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (wInit) {
+        wolfCLU_DgstBatchWorkerFree(&batch, &w);
+    }
+    wolfCLU_DgstBatchFree(&batch);
+    return ret;
+}
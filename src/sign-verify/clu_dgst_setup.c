@@ -22,10 +22,42 @@
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
 #include <wolfclu/clu_optargs.h>
+#include <wolfclu/clu_cache.h>
 #include <wolfclu/sign-verify/clu_sign.h>
 #include <wolfclu/sign-verify/clu_verify.h>
 #include <wolfclu/sign-verify/clu_sign_verify_setup.h>
+#include <wolfclu/sign-verify/clu_signd.h>
+#include <wolfclu/sign-verify/clu_ecc_pool.h>
 #include <wolfclu/pkey/clu_pkey.h>
+#include <wolfclu/clu_stats.h>
+
+/* data is hashed this many bytes at a time */
+#define WOLFCLU_DGST_BUF_SZ MEGABYTE
+
+/* most -verify options in one run */
+#define WOLFCLU_DGST_MAX_SIGS 16
+
+/* a key and the signature made or checked with it */
+typedef struct WOLFCLU_DGST_SIG {
+    char* keyFile;
+    char* sigFile;
+    enum wc_HashType      hashType;
+    enum wc_SignatureType sigType;
+    union {
+        ecc_key ecc;
+        RsaKey  rsa;
+    #ifdef HAVE_ED25519
+        ed25519_key ed;
+    #endif
+    } key;
+    int    keySz;   /* set once key needs freeing */
+    void*  ctx;     /* cached public key used instead of key, given back with
+                     * wolfCLU_KeyCtxPut */
+    byte   ed25519; /* key is a raw Ed25519 key, used as Ed25519ph */
+    byte*  sig;
+    word32 sigSz;
+    int    ret;
+} WOLFCLU_DGST_SIG;
 
 static const struct option dgst_options[] = {
 
@@ -40,6 +72,16 @@ static const struct option dgst_options[] = {
     {"signature", required_argument, 0, WOLFCLU_INFILE    },
     {"verify",    required_argument, 0, WOLFCLU_VERIFY    },
     {"sign",     required_argument, 0, WOLFCLU_SIGN      },
+    {"signd",    required_argument, 0, WOLFCLU_SIGND     },
+    {"keyid",    required_argument, 0, WOLFCLU_KEYID     },
+    {"filelist", required_argument, 0, WOLFCLU_FILELIST  },
+    {"r",        required_argument, 0, WOLFCLU_RECURSIVE },
+    {"threads",  required_argument, 0, WOLFCLU_THREADS   },
+    {"nonces",   required_argument, 0, WOLFCLU_NONCES    },
+    {"verify-manifest", required_argument, 0, WOLFCLU_VERIFY_MANIFEST},
+    {"ph",       no_argument,       0, WOLFCLU_PH        },
+    {"merkle-sign",   required_argument, 0, WOLFCLU_MERKLE_SIGN  },
+    {"merkle-verify", required_argument, 0, WOLFCLU_MERKLE_VERIFY},
     {"h",        no_argument,       0, WOLFCLU_HELP      },
     {"help",     no_argument,       0, WOLFCLU_HELP      },
 
@@ -61,9 +103,33 @@ static void wolfCLU_dgstHelp(void)
     WOLFCLU_LOG(WOLFCLU_L0, "\t-signature file containing the signature");
     WOLFCLU_LOG(WOLFCLU_L0, "\t-verify key used to verify the signature");
     WOLFCLU_LOG(WOLFCLU_L0, "\t-sign   private key used to create the signature");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-signd  socket of a wolfssl signd to create the signature");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-keyid  index of the signd key to use, default 0");
     WOLFCLU_LOG(WOLFCLU_L0, "\t-out    output file for signature");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-filelist file naming one file to sign on each line");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-r      directory to sign every file under, except .sig files");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-verify-manifest file of \"<data> <sig> <public key>\" lines to verify");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t                 a raw 32 byte Ed25519 key checks the data itself, no hash");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-ph     Ed25519 keys in -verify-manifest check the SHA-512 hash, Ed25519ph");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-merkle-sign directory or file list to sign as one Merkle tree, -out names the manifest");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-merkle-verify manifest to check the data file against, as it was named when signed");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-threads number of threads for -filelist, -r, -merkle-sign and -verify-manifest, default 1");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-nonces ECDSA nonces computed ahead for -filelist and -r, default %d, 0 for none", WOLFCLU_ECC_POOL_SIZE);
     WOLFCLU_LOG(WOLFCLU_L0, "Example:");
     WOLFCLU_LOG(WOLFCLU_L0, "\twolfssl dgst -signature test.sig -verify key.pem test");
+    WOLFCLU_LOG(WOLFCLU_L0, "-verify and -signature can be repeated, the first -verify goes with");
+    WOLFCLU_LOG(WOLFCLU_L0, "the first -signature and so on, each using the hash given before it.");
+    WOLFCLU_LOG(WOLFCLU_L0, "The data is hashed once for each hash used.");
+    WOLFCLU_LOG(WOLFCLU_L0, "Raw Ed25519 keys, as -genkey ed25519 -outform der writes, sign and verify");
+    WOLFCLU_LOG(WOLFCLU_L0, "the SHA-512 hash as Ed25519ph, so use -sha512 with them.");
+    WOLFCLU_LOG(WOLFCLU_L0, "With -filelist or -r no data file is given, each file gets a .sig file");
+    WOLFCLU_LOG(WOLFCLU_L0, "\twolfssl dgst -sha256 -sign key.pem -r build -threads 8");
+    WOLFCLU_LOG(WOLFCLU_L0, "\twolfssl dgst -sha256 -verify-manifest artifacts.txt -threads 8");
+    WOLFCLU_LOG(WOLFCLU_L0, "-merkle-sign signs only the root of a tree over every file, and the manifest");
+    WOLFCLU_LOG(WOLFCLU_L0, "holds a proof for each file so that any one can be checked on its own");
+    WOLFCLU_LOG(WOLFCLU_L0, "\twolfssl dgst -sha256 -sign key.pem -merkle-sign build -out build.merkle -threads 8");
+    WOLFCLU_LOG(WOLFCLU_L0, "\twolfssl dgst -verify pub.pem -merkle-verify build.merkle build/lib/libfoo.so");
+    WOLFCLU_LOG(WOLFCLU_L0, "\twolfssl dgst -sha256 -verify a.pem -signature a.sig -sha384 -verify b.pem -signature b.sig test");
 }
 
 
@@ -152,47 +218,483 @@ static int ExtractKey(void* key, WOLFSSL_EVP_PKEY* pkey, int* keySz,
 }
 
 
+/* has s verify with the thread's decoded copy of the public key pkey, only
+ * decoding it when it is not cached
+ * return WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstKeyCtx(WOLFCLU_DGST_SIG* s, WOLFSSL_EVP_PKEY* pkey)
+{
+    byte* der = NULL;
+    int   derSz;
+    int   type = wolfSSL_EVP_PKEY_id(pkey);
+
+    switch (type) {
+        case EVP_PKEY_RSA:
+            s->sigType = WC_SIGNATURE_TYPE_RSA_W_ENC;
+            s->keySz   = (int)sizeof(RsaKey);
+            break;
+
+        case EVP_PKEY_EC:
+            s->sigType = WC_SIGNATURE_TYPE_ECC;
+            s->keySz   = (int)sizeof(ecc_key);
+            break;
+
+        default:
+            WOLFCLU_LOG(WOLFCLU_E0, "Key type not yet supported");
+            return WOLFCLU_FATAL_ERROR;
+    }
+
+    derSz = wolfCLU_pKeytoPubKey(pkey, &der);
+    if (derSz > 0) {
+        s->ctx = wolfCLU_KeyCtxGet(type, der, (word32)derSz);
+    }
+    if (der != NULL) {
+        XFREE(der, NULL, DYNAMIC_TYPE_OPENSSL);
+    }
+    if (s->ctx == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Error decoding public key");
+        s->keySz = 0;
+        return WOLFCLU_FATAL_ERROR;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* hashes everything left in bio with each of the count hash types. The data
+ * is read once, a piece at a time, so its size does not matter
+ * return WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstHash(WOLFSSL_BIO* bio, const enum wc_HashType* types,
+        int count, byte digests[][WC_MAX_DIGEST_SIZE])
+{
+    wc_HashAlg hash[WOLFCLU_DGST_MAX_SIGS];
+    byte* buf;
+    int   ret = WOLFCLU_SUCCESS;
+    int   inited = 0;
+    int   sz = 0;
+    int   phase;
+    int   i;
+
+    buf = (byte*)XMALLOC(WOLFCLU_DGST_BUF_SZ, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (buf == NULL) {
+        return MEMORY_E;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (wc_HashInit(&hash[i], types[i]) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to initialize hash");
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        inited++;
+    }
+
+    while (ret == WOLFCLU_SUCCESS) {
+        phase = wolfCLU_StatsBegin(WOLFCLU_STAT_IO);
+        sz = wolfSSL_BIO_read(bio, buf, WOLFCLU_DGST_BUF_SZ);
+        wolfCLU_StatsEnd(phase);
+        if (sz <= 0) {
+            break;
+        }
+        for (i = 0; i < count; i++) {
+            if (wc_HashUpdate(&hash[i], types[i], buf, (word32)sz) != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Error hashing data");
+                ret = WOLFCLU_FATAL_ERROR;
+                break;
+            }
+        }
+    }
+    if (ret == WOLFCLU_SUCCESS && sz < 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Error reading data");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < count; i++) {
+        if (wc_HashFinal(&hash[i], types[i], digests[i]) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Error hashing data");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+    for (i = 0; i < inited; i++) {
+        wc_HashFree(&hash[i], types[i]);
+    }
+    XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+
+/* return WOLFCLU_SUCCESS on success */
+int wolfCLU_DgstEncode(enum wc_HashType hashType,
+        enum wc_SignatureType sigType, const byte* digest, byte* out,
+        word32* outSz)
+{
+    int digestSz = wc_HashGetDigestSize(hashType);
+
+    if (digestSz <= 0) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (sigType == WC_SIGNATURE_TYPE_RSA_W_ENC) {
+        *outSz = wc_EncodeSignature(out, digest, (word32)digestSz,
+                wc_HashGetOID(hashType));
+        if (*outSz == 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to encode digest");
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+    else {
+        XMEMCPY(out, digest, digestSz);
+        *outSz = (word32)digestSz;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* reads the signature file of one -verify
+ * return WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstReadSig(WOLFCLU_DGST_SIG* s)
+{
+    WOLFSSL_BIO* sigBio;
+    int ret = WOLFCLU_SUCCESS;
+    int sz;
+
+    sigBio = wolfSSL_BIO_new_file(s->sigFile, "rb");
+    if (sigBio == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to read signature file %s",
+                s->sigFile);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    sz = wolfSSL_BIO_get_len(sigBio);
+    if (sz <= 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to get signature size");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        s->sigSz = (word32)sz;
+        s->sig = (byte*)XMALLOC(s->sigSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (s->sig == NULL) {
+            ret = MEMORY_E;
+        }
+        else if (wolfSSL_BIO_read(sigBio, s->sig, s->sigSz) <= 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Error reading sig");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    wolfSSL_BIO_free(sigBio);
+    return ret;
+}
+
+
+#ifdef HAVE_ED25519
+/* loads keyFile if it is a raw Ed25519 key as -genkey ed25519 writes, the
+ * 64 byte private and public key when signing or the 32 byte public key
+ * return WOLFCLU_SUCCESS if it was one */
+static int wolfCLU_DgstLoadEd25519(WOLFCLU_DGST_SIG* s, int signing)
+{
+    byte   buf[ED25519_PRV_KEY_SIZE];
+    word32 want = signing? ED25519_PRV_KEY_SIZE : ED25519_PUB_KEY_SIZE;
+    XFILE  f;
+    long   sz = -1;
+    int    ret = -1;
+
+    f = XFOPEN(s->keyFile, "rb");
+    if (f == XBADFILE) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (XFSEEK(f, 0, XSEEK_END) == 0) {
+        sz = XFTELL(f);
+    }
+    if (sz == (long)want && XFSEEK(f, 0, XSEEK_SET) == 0 &&
+            XFREAD(buf, 1, want, f) == want &&
+            wc_ed25519_init(&s->key.ed) == 0) {
+        if (signing) {
+            ret = wc_ed25519_import_private_key(buf, ED25519_KEY_SIZE,
+                    buf + ED25519_KEY_SIZE, ED25519_PUB_KEY_SIZE, &s->key.ed);
+        }
+        else {
+            ret = wc_ed25519_import_public(buf, want, &s->key.ed);
+        }
+        if (ret == 0) {
+            s->ed25519 = 1;
+            s->keySz   = (int)sizeof(ed25519_key);
+        }
+        else {
+            wc_ed25519_free(&s->key.ed);
+        }
+    }
+    XFCLOSE(f);
+    wolfCLU_ForceZero(buf, sizeof(buf));
+
+    return (ret == 0)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+#endif
+
+
+/* loads the key of one -sign or -verify
+ * return WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstLoadKey(WOLFCLU_DGST_SIG* s, int signing)
+{
+    WOLFSSL_EVP_PKEY* pkey;
+    int ret = WOLFCLU_SUCCESS;
+
+#ifdef HAVE_ED25519
+    /* the hash dgst works out is signed as Ed25519ph, which takes SHA-512 */
+    if (wolfCLU_DgstLoadEd25519(s, signing) == WOLFCLU_SUCCESS) {
+        if (s->hashType != WC_HASH_TYPE_SHA512) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Ed25519 keys sign the SHA-512 hash as "
+                    "Ed25519ph, use -sha512");
+            return WOLFCLU_FATAL_ERROR;
+        }
+        return WOLFCLU_SUCCESS;
+    }
+#endif
+
+    if (signing) {
+        pkey = wolfCLU_LoadPrivateKey(s->keyFile);
+        if (pkey == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to decode private key");
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+    else {
+        pkey = wolfCLU_LoadPublicKey(s->keyFile);
+        if (pkey == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to decode public key");
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (signing == 0) {
+        ret = wolfCLU_DgstKeyCtx(s, pkey);
+    }
+    else if (ExtractKey((void*)&s->key, pkey, &s->keySz, &s->sigType,
+                signing) != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to extract key");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    wolfSSL_EVP_PKEY_free(pkey);
+    return ret;
+}
+
+
+/* return WOLFCLU_SUCCESS on success */
+static int wolfCLU_DgstFreeKey(WOLFCLU_DGST_SIG* s)
+{
+    int ret = WOLFCLU_SUCCESS;
+
+    /* if any key size has been set then try to free the key struct */
+#ifdef HAVE_ED25519
+    if (s->ed25519) {
+        wc_ed25519_free(&s->key.ed);
+    }
+    else
+#endif
+    if (s->ctx != NULL) {
+        wolfCLU_KeyCtxPut(s->ctx);
+    }
+    else if (s->keySz > 0) {
+        switch (s->sigType) {
+            case WC_SIGNATURE_TYPE_RSA:
+            case WC_SIGNATURE_TYPE_RSA_W_ENC:
+                wc_FreeRsaKey(&s->key.rsa);
+                break;
+
+            case WC_SIGNATURE_TYPE_ECC:
+                wc_ecc_free(&s->key.ecc);
+                break;
+
+            case WC_SIGNATURE_TYPE_NONE:
+                FALL_THROUGH;
+
+            default:
+                WOLFCLU_LOG(WOLFCLU_E0, "Key type not yet supported");
+                ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+    if (s->sig != NULL) {
+        XFREE(s->sig, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    return ret;
+}
+
+
+/* return WOLFCLU_SUCCESS if the signature of s is good for hash, which is
+ * encoded as wolfCLU_DgstEncode gives it */
+static int wolfCLU_DgstCheck(WOLFCLU_DGST_SIG* s, const byte* hash,
+        word32 hashSz)
+{
+#ifdef HAVE_ED25519
+    int stat = 0;
+
+    if (s->ed25519) {
+        if (wc_ed25519ph_verify_hash(s->sig, s->sigSz, hash, hashSz, &stat,
+                    &s->key.ed, NULL, 0) != 0 || stat != 1) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+        return WOLFCLU_SUCCESS;
+    }
+#endif
+
+    if (wc_SignatureVerifyHash(s->hashType, s->sigType, hash, hashSz, s->sig,
+                s->sigSz, s->ctx, s->keySz) != 0) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* checks every -verify against the data, hashing it once for each hash type
+ * used. One signature is reported as before, with several each one gets a
+ * line and the run fails if any of them did
+ * return WOLFCLU_SUCCESS if every signature verified */
+static int wolfCLU_DgstVerify(WOLFSSL_BIO* dataBio, WOLFCLU_DGST_SIG* sigs,
+        int count)
+{
+    enum wc_HashType types[WOLFCLU_DGST_MAX_SIGS];
+    byte   digests[WOLFCLU_DGST_MAX_SIGS][WC_MAX_DIGEST_SIZE];
+    byte   enc[WOLFCLU_DGST_ENC_SZ];
+    word32 encSz = 0;
+    int    typeCount = 0;
+    int    loaded = 0;
+    int    failed = 0;
+    int    ret = WOLFCLU_SUCCESS;
+    int    phase;
+    int    i, j;
+
+    for (i = 0; i < count; i++) {
+        if (sigs[i].hashType == WC_HASH_TYPE_NONE) {
+            WOLFCLU_LOG(WOLFCLU_E0, "No hash algorithm given, such as "
+                    "-sha256");
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_IO);
+    for (i = 0; i < count; i++) {
+        sigs[i].ret = wolfCLU_DgstReadSig(&sigs[i]);
+    }
+    wolfCLU_StatsEnd(phase);
+
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_KEY);
+    for (i = 0; i < count; i++) {
+        if (sigs[i].ret == WOLFCLU_SUCCESS) {
+            sigs[i].ret = wolfCLU_DgstLoadKey(&sigs[i], 0);
+        }
+        if (sigs[i].ret == WOLFCLU_SUCCESS) {
+            loaded++;
+        }
+    }
+    wolfCLU_StatsEnd(phase);
+
+    /* each hash type is worked out once, however many keys use it */
+    for (i = 0; i < count; i++) {
+        if (sigs[i].ret != WOLFCLU_SUCCESS) {
+            continue;
+        }
+        for (j = 0; j < typeCount && types[j] != sigs[i].hashType; j++);
+        if (j == typeCount) {
+            types[typeCount++] = sigs[i].hashType;
+        }
+    }
+
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_CRYPTO);
+    if (loaded > 0) {
+        ret = wolfCLU_DgstHash(dataBio, types, typeCount, digests);
+    }
+
+    for (i = 0; i < count; i++) {
+        WOLFCLU_DGST_SIG* s = &sigs[i];
+
+        if (ret == WOLFCLU_SUCCESS && s->ret == WOLFCLU_SUCCESS) {
+            for (j = 0; types[j] != s->hashType; j++);
+            s->ret = wolfCLU_DgstEncode(s->hashType, s->sigType, digests[j],
+                    enc, &encSz);
+            if (s->ret == WOLFCLU_SUCCESS) {
+                s->ret = wolfCLU_DgstCheck(s, enc, encSz);
+            }
+        }
+        else {
+            s->ret = WOLFCLU_FATAL_ERROR;
+        }
+
+        if (s->ret != WOLFCLU_SUCCESS) {
+            failed++;
+        }
+        if (count == 1 && s->ret == WOLFCLU_SUCCESS) {
+            WOLFCLU_LOG(WOLFCLU_L0, "Verify OK");
+        }
+        else if (count == 1) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Verification failure");
+        }
+        else if (s->ret == WOLFCLU_SUCCESS) {
+            WOLFCLU_LOG(WOLFCLU_L0, "%s: Verify OK", s->sigFile);
+        }
+        else {
+            WOLFCLU_LOG(WOLFCLU_E0, "%s: Verification failure", s->sigFile);
+        }
+    }
+    wolfCLU_StatsEnd(phase);
+
+    if (count > 1 && failed > 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "dgst: %d of %d signatures failed to verify",
+                failed, count);
+    }
+    return (failed == 0)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
 /* return WOLFCLU_SUCCESS on success */
 int wolfCLU_dgst_setup(int argc, char** argv)
 {
-    ecc_key ecc;
-    RsaKey  rsa;
+    WOLFCLU_DGST_SIG* sigs = NULL;
+    WOLFCLU_DGST_SIG* s;
     WOLFSSL_BIO *sigBio = NULL;
-    WOLFSSL_BIO *pubKeyBio = NULL;
     WOLFSSL_BIO *dataBio = NULL;
-    WOLFSSL_EVP_PKEY *pkey = NULL;
     int     ret = WOLFCLU_SUCCESS;
-    byte* sig  = NULL;
-    char* data = NULL;
-    char* sigFile = NULL;
-    void* key  = NULL;
-    word32 dataSz = 0;
-    word32 sigSz  = 0;
-    int keySz  = 0;
+    byte  digest[WC_MAX_DIGEST_SIZE];
+    byte  enc[WOLFCLU_DGST_ENC_SZ];
+    char* sigFiles[WOLFCLU_DGST_MAX_SIGS];
+    char* signdPath = NULL;
+    char* fileList  = NULL;
+    char* dir       = NULL;
+    char* manifest  = NULL;
+    char* merkleIn  = NULL;
+    char* merkle    = NULL;
+    word32 encSz = 0;
+    int keyCount = 0;
+    int sigFileCount = 0;
+    int keyId  = 0;
+    int threads = 1;
+    int nonces = WOLFCLU_ECC_POOL_SIZE;
+    int ph = 0;
     int option;
     int longIndex = 2;
+    WOLFCLU_GETOPT opt;
+    int phase;
+    int i;
     byte signing = 0;
 
-    enum wc_HashType      hashType = WC_HASH_TYPE_NONE;
-    enum wc_SignatureType sigType  = WC_SIGNATURE_TYPE_NONE;
+    enum wc_HashType hashType = WC_HASH_TYPE_NONE;
 
     /* signed file should be the last arg */
     if (XSTRNCMP("-h", argv[argc-1], 2) == 0) {
         wolfCLU_dgstHelp();
         return WOLFCLU_SUCCESS;
     }
-    else {
-        dataBio = wolfSSL_BIO_new_file(argv[argc-1], "rb");
-        if (dataBio == NULL) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Unable to open data file %s",
-                    argv[argc-1]);
-            ret = WOLFCLU_FATAL_ERROR;
-        }
+
+    sigs = (WOLFCLU_DGST_SIG*)XMALLOC(
+            WOLFCLU_DGST_MAX_SIGS * sizeof(WOLFCLU_DGST_SIG), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (sigs == NULL) {
+        return MEMORY_E;
     }
+    XMEMSET(sigs, 0, WOLFCLU_DGST_MAX_SIGS * sizeof(WOLFCLU_DGST_SIG));
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_ARGS);
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    dgst_options, &longIndex )) != -1) {
 
         switch (option) {
@@ -225,20 +727,96 @@ int wolfCLU_dgst_setup(int argc, char** argv)
                 signing = 1;
                 FALL_THROUGH;
             case WOLFCLU_VERIFY:
-                pubKeyBio = wolfSSL_BIO_new_file(optarg, "rb");
-                if (pubKeyBio == NULL) {
-                    WOLFCLU_LOG(WOLFCLU_E0, "Unable to open key file %s",
-                            optarg);
+                if (keyCount == WOLFCLU_DGST_MAX_SIGS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "At most %d keys can be given",
+                            WOLFCLU_DGST_MAX_SIGS);
                     ret = WOLFCLU_FATAL_ERROR;
+                    break;
                 }
+                /* the hash option given before the key goes with it */
+                sigs[keyCount].keyFile  = opt.arg;
+                sigs[keyCount].hashType = hashType;
+                keyCount++;
+                break;
+
+            case WOLFCLU_SIGND:
+                signdPath = opt.arg;
+                signing   = 1;
+                break;
+
+            case WOLFCLU_KEYID:
+                if (wolfCLU_ParseNum(opt.arg, 0,
+                            WOLFCLU_SIGND_MAX_KEYS - 1, &keyId)
+                        != WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "-keyid must be between 0 and %d",
+                            WOLFCLU_SIGND_MAX_KEYS - 1);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+                break;
+
+            case WOLFCLU_FILELIST:
+                fileList = opt.arg;
+                break;
+
+            case WOLFCLU_RECURSIVE:
+                dir = opt.arg;
+                break;
+
+            case WOLFCLU_VERIFY_MANIFEST:
+                manifest = opt.arg;
+                break;
+
+            case WOLFCLU_PH:
+                ph = 1;
+                break;
+
+            case WOLFCLU_MERKLE_SIGN:
+                merkleIn = opt.arg;
+                break;
+
+            case WOLFCLU_MERKLE_VERIFY:
+                merkle = opt.arg;
+                break;
+
+            case WOLFCLU_NONCES:
+                if (wolfCLU_ParseNum(opt.arg, 0, WOLFCLU_ECC_POOL_MAX,
+                            &nonces) != WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "-nonces must be between 0 and "
+                            "%d", WOLFCLU_ECC_POOL_MAX);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+                break;
+
+            case WOLFCLU_THREADS:
+                if (wolfCLU_ParseNum(opt.arg, 1, MAX_THREADS, &threads)
+                        != WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "-threads must be between 1 and"
+                            " %d", MAX_THREADS);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+            #ifdef SINGLE_THREADED
+                else if (threads > 1) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "Threads are not available in "
+                            "this build");
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+            #endif
                 break;
 
             case WOLFCLU_INFILE:
-                sigFile = optarg;
+                if (sigFileCount == WOLFCLU_DGST_MAX_SIGS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "At most %d signatures can be "
+                            "given", WOLFCLU_DGST_MAX_SIGS);
+                    ret = WOLFCLU_FATAL_ERROR;
+                    break;
+                }
+                sigFiles[sigFileCount++] = opt.arg;
                 break;
 
             case WOLFCLU_HELP:
                 wolfCLU_dgstHelp();
+                wolfCLU_StatsEnd(phase);
+                XFREE(sigs, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
                 return WOLFCLU_SUCCESS;
 
             case ':':
@@ -250,145 +828,153 @@ int wolfCLU_dgst_setup(int argc, char** argv)
                 (void)ret;
         }
     }
+    wolfCLU_StatsEnd(phase);
 
-    if (ret == WOLFCLU_SUCCESS) {
-        if (dataBio == NULL || sigFile == NULL) {
-            WOLFCLU_LOG(WOLFCLU_E0, "error with reading signature or data");
+    /* check many files, each line of the manifest naming its own key */
+    if (manifest != NULL) {
+        if (ret == WOLFCLU_SUCCESS && (signing == 1 || keyCount != 0)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "-verify-manifest names the keys, do not "
+                    "give -sign or -verify");
             ret = WOLFCLU_FATAL_ERROR;
         }
+        if (ret == WOLFCLU_SUCCESS) {
+            ret = wolfCLU_DgstBatchVerify(manifest, hashType, threads, ph);
+        }
+        XFREE(sigs, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return ret;
     }
 
-    if (ret == WOLFCLU_SUCCESS) {
-        XFILE f;
-
-        /* get data size using raw FILE pointer and seek */
-        if (wolfSSL_BIO_get_fp(dataBio, &f) != WOLFSSL_SUCCESS) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Unable to get raw file pointer");
+    /* one signature over a tree of many files, in a manifest of proofs */
+    if (merkleIn != NULL) {
+        if (ret == WOLFCLU_SUCCESS && (signing == 0 || keyCount != 1 ||
+                    signdPath != NULL || sigFileCount == 0)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "-merkle-sign needs one -sign key and "
+                    "-out for the manifest");
             ret = WOLFCLU_FATAL_ERROR;
         }
+        if (ret == WOLFCLU_SUCCESS) {
+            ret = wolfCLU_DgstMerkleSign(sigs[0].keyFile, hashType, merkleIn,
+                    sigFiles[sigFileCount - 1], threads);
+        }
+        XFREE(sigs, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return ret;
+    }
 
-        if (ret == WOLFCLU_SUCCESS && XFSEEK(f, 0, XSEEK_END) != 0) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Unable to seek end of file");
+    /* check one file of a tree, the manifest gives the hash to use */
+    if (merkle != NULL) {
+        if (ret == WOLFCLU_SUCCESS && (signing == 1 || keyCount != 1)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "-merkle-verify needs one -verify key");
             ret = WOLFCLU_FATAL_ERROR;
         }
-
         if (ret == WOLFCLU_SUCCESS) {
-            dataSz = (word32)XFTELL(f);
-            wolfSSL_BIO_reset(dataBio);
-        }
-
-        if (signing == 0) {
-            sigBio = wolfSSL_BIO_new_file(sigFile, "rb");
-            if (sigBio == NULL) {
-                WOLFCLU_LOG(WOLFCLU_E0, "Unable to read signature file %s",
-                        sigFile);
-                ret = WOLFCLU_FATAL_ERROR;
-            }
-
-            if (ret == WOLFCLU_SUCCESS) {
-                ret = wolfSSL_BIO_get_len(sigBio);
-                if (ret <= 0) {
-                    WOLFCLU_LOG(WOLFCLU_E0, "Unable to get signature size");
-                    ret = WOLFCLU_FATAL_ERROR;
-                }
-                else {
-                    sigSz = (word32)ret;
-                    ret = WOLFCLU_SUCCESS;
-                }
-            }
+            ret = wolfCLU_DgstMerkleVerify(sigs[0].keyFile, merkle,
+                    argv[argc-1]);
         }
+        XFREE(sigs, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return ret;
+    }
 
-        if (dataSz <= 0 || (sigSz <= 0 && signing == 0)) {
-            WOLFCLU_LOG(WOLFCLU_E0, "No signature or data");
+    /* sign many files with one load of the key, no data file is given */
+    if (fileList != NULL || dir != NULL) {
+        if (ret == WOLFCLU_SUCCESS && (signing == 0 || keyCount != 1 ||
+                    signdPath != NULL)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "-filelist and -r need one -sign key");
             ret = WOLFCLU_FATAL_ERROR;
         }
+        if (ret == WOLFCLU_SUCCESS) {
+            ret = wolfCLU_DgstBatchSign(sigs[0].keyFile, hashType, fileList,
+                    dir, threads, nonces);
+        }
+        XFREE(sigs, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return ret;
     }
 
-    /* create buffers and fill them */
     if (ret == WOLFCLU_SUCCESS) {
-        data = (char*)XMALLOC(dataSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (data == NULL) {
-            ret = MEMORY_E;
-        }
-        else {
-            word32 totalRead = 0;
-
-            /* read in 4k at a time because file could be larger than int type
-             * restriction on size input for wolfSSL_BIO_read */
-            while (totalRead < dataSz) {
-                int sz = min(dataSz - totalRead, 4096);
-                if (wolfSSL_BIO_read(dataBio, data + totalRead, sz) != sz) {
-                    WOLFCLU_LOG(WOLFCLU_E0, "Error reading data");
-                    ret = WOLFCLU_FATAL_ERROR;
-                    break;
-                }
-                totalRead += sz;
-            }
+        dataBio = wolfSSL_BIO_new_file(argv[argc-1], "rb");
+        if (dataBio == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to open data file %s",
+                    argv[argc-1]);
+            ret = WOLFCLU_FATAL_ERROR;
         }
     }
 
-    if (ret == WOLFCLU_SUCCESS && signing == 0) {
-        sig = (byte*)XMALLOC(sigSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (sig == NULL) {
-            ret = MEMORY_E;
+    /* with one key the last hash option and file given are used, otherwise
+     * each key goes with the signature file given in the same place */
+    if (ret == WOLFCLU_SUCCESS && keyCount <= 1) {
+        sigs[0].hashType = hashType;
+        sigs[0].sigFile  = (sigFileCount > 0)? sigFiles[sigFileCount - 1] :
+                                               NULL;
+        if (sigs[0].sigFile == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "error with reading signature or data");
+            ret = WOLFCLU_FATAL_ERROR;
         }
-        else {
-            if (wolfSSL_BIO_read(sigBio, sig, sigSz) <= 0) {
-                WOLFCLU_LOG(WOLFCLU_E0, "Error reading sig");
-                ret = WOLFCLU_FATAL_ERROR;
+    }
+    else if (ret == WOLFCLU_SUCCESS) {
+        if (signing) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Only one key can be given with -sign");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else if (sigFileCount != keyCount) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Each -verify needs its own -signature");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        for (i = 0; ret == WOLFCLU_SUCCESS && i < keyCount; i++) {
+            sigs[i].sigFile = sigFiles[i];
+            if (sigs[i].hashType == WC_HASH_TYPE_NONE) {
+                sigs[i].hashType = hashType;
             }
         }
     }
 
-    /* get type of key and size of structure */
+    if (ret == WOLFCLU_SUCCESS && keyCount == 0 && signdPath == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "No key given with -sign or -verify");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
     if (ret == WOLFCLU_SUCCESS && signing == 0) {
-        pkey = wolfSSL_PEM_read_bio_PUBKEY(pubKeyBio, NULL, NULL, NULL);
-        if (pkey == NULL) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Unable to decode public key");
-            ret = WOLFCLU_FATAL_ERROR;
-        }
+        ret = wolfCLU_DgstVerify(dataBio, sigs, keyCount);
     }
 
-    if (ret == WOLFCLU_SUCCESS && signing == 1) {
-        pkey = wolfSSL_PEM_read_bio_PrivateKey(pubKeyBio, NULL, NULL, NULL);
-        if (pkey == NULL) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Unable to decode public key");
-            ret = WOLFCLU_FATAL_ERROR;
-        }
+    /* the rest creates the signature */
+    s = &sigs[0];
+    if (ret == WOLFCLU_SUCCESS && signing == 1 &&
+            s->hashType == WC_HASH_TYPE_NONE) {
+        WOLFCLU_LOG(WOLFCLU_E0, "No hash algorithm given, such as -sha256");
+        ret = WOLFCLU_FATAL_ERROR;
     }
 
-    if (ret == WOLFCLU_SUCCESS) {
-        switch (wolfSSL_EVP_PKEY_id(pkey)) {
-            case EVP_PKEY_RSA:
-                key = (void*)&rsa;
-                break;
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_KEY);
+    if (ret == WOLFCLU_SUCCESS && signing == 1 && signdPath == NULL) {
+        ret = wolfCLU_DgstLoadKey(s, 1);
+    }
+    wolfCLU_StatsEnd(phase);
 
-            case EVP_PKEY_EC:
-                key = (void*)&ecc;
-                break;
-        }
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_CRYPTO);
+    if (ret == WOLFCLU_SUCCESS && signing == 1) {
+        ret = wolfCLU_DgstHash(dataBio, &s->hashType, 1, &digest);
+    }
 
-        if (ExtractKey(key, pkey, &keySz, &sigType, signing) !=
-                WOLFCLU_SUCCESS) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Unable to extract key");
-            ret = WOLFCLU_FATAL_ERROR;
-        }
+    if (ret == WOLFCLU_SUCCESS && signing == 1) {
+        ret = wolfCLU_DgstEncode(s->hashType, s->sigType, digest, enc,
+                &encSz);
     }
 
-    /* if not signing then do verification */
-    if (ret == WOLFCLU_SUCCESS && signing == 0) {
-        if (wc_SignatureVerify(hashType, sigType, (const byte*)data, dataSz,
-                    (const byte*)sig, sigSz, key, keySz) == 0) {
-            WOLFCLU_LOG(WOLFCLU_L0, "Verify OK");
+    /* have a signd create the signature, the key never leaves it */
+    if (ret == WOLFCLU_SUCCESS && signing == 1 && signdPath != NULL) {
+        s->sigSz = WOLFCLU_SIGND_MAX_SIG;
+        s->sig = (byte*)XMALLOC(s->sigSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (s->sig == NULL) {
+            ret = MEMORY_E;
         }
-        else {
-            WOLFCLU_LOG(WOLFCLU_E0, "Verification failure");
-            ret = WOLFCLU_FATAL_ERROR;
+
+        if (ret == WOLFCLU_SUCCESS) {
+            ret = wolfCLU_SignDSign(signdPath, keyId, s->hashType, enc,
+                    encSz, s->sig, &s->sigSz);
         }
     }
 
     /* create the signature if requested */
-    if (ret == WOLFCLU_SUCCESS && signing == 1) {
+    if (ret == WOLFCLU_SUCCESS && signing == 1 && signdPath == NULL) {
         WC_RNG rng;
 
         if (wc_InitRng(&rng) != 0) {
@@ -397,81 +983,79 @@ int wolfCLU_dgst_setup(int argc, char** argv)
         }
 
         /* get expected signature size */
+    #ifdef HAVE_ED25519
+        if (ret == WOLFCLU_SUCCESS && s->ed25519) {
+            s->sigSz = ED25519_SIG_SIZE;
+        }
+        else
+    #endif
         if (ret == WOLFCLU_SUCCESS) {
-            ret = wc_SignatureGetSize(sigType, key, keySz);
+            ret = wc_SignatureGetSize(s->sigType, (void*)&s->key, s->keySz);
             if (ret <= 0) {
                 WOLFCLU_LOG(WOLFCLU_E0, "Error getting signature size");
                 ret = WOLFCLU_FATAL_ERROR;
             }
             else {
-                sigSz = (word32)ret;
+                s->sigSz = (word32)ret;
                 ret = WOLFCLU_SUCCESS;
             }
         }
 
         if (ret == WOLFCLU_SUCCESS) {
-            sig = (byte*)XMALLOC(sigSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-            if (sig == NULL) {
+            s->sig = (byte*)XMALLOC(s->sigSz, HEAP_HINT,
+                    DYNAMIC_TYPE_TMP_BUFFER);
+            if (s->sig == NULL) {
                 ret = MEMORY_E;
             }
         }
 
-        if (ret == WOLFCLU_SUCCESS &&
-                wc_SignatureGenerate(hashType, sigType, (const byte*)data,
-                    dataSz, sig, &sigSz, key, keySz, &rng) != 0) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Error getting signature");
-            ret = WOLFCLU_FATAL_ERROR;
-        }
-
-        /* write out the signature */
-        if (ret == WOLFCLU_SUCCESS) {
-            sigBio = wolfSSL_BIO_new_file(sigFile, "wb");
-            if (sigBio == NULL) {
-                WOLFCLU_LOG(WOLFCLU_E0, "Unable to create signature file %s",
-                        sigFile);
+    #ifdef HAVE_ED25519
+        if (ret == WOLFCLU_SUCCESS && s->ed25519) {
+            if (wc_ed25519ph_sign_hash(enc, encSz, s->sig, &s->sigSz,
+                        &s->key.ed, NULL, 0) != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Error getting signature");
                 ret = WOLFCLU_FATAL_ERROR;
             }
         }
-
+        else
+    #endif
         if (ret == WOLFCLU_SUCCESS &&
-                wolfSSL_BIO_write(sigBio, sig, sigSz) <= 0) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Error writing out signature");
+                wc_SignatureGenerateHash(s->hashType, s->sigType, enc, encSz,
+                    s->sig, &s->sigSz, (void*)&s->key, s->keySz, &rng) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Error getting signature");
             ret = WOLFCLU_FATAL_ERROR;
         }
         wc_FreeRng(&rng);
     }
+    wolfCLU_StatsEnd(phase);
 
-    /* if any key size has been set then try to free the key struct */
-    if (keySz > 0) {
-        switch (sigType) {
-            case WC_SIGNATURE_TYPE_RSA:
-            case WC_SIGNATURE_TYPE_RSA_W_ENC:
-                wc_FreeRsaKey(&rsa);
-                break;
-
-            case WC_SIGNATURE_TYPE_ECC:
-                wc_ecc_free(&ecc);
-                break;
+    /* write out the signature */
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_IO);
+    if (ret == WOLFCLU_SUCCESS && signing == 1) {
+        sigBio = wolfSSL_BIO_new_file(s->sigFile, "wb");
+        if (sigBio == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to create signature file %s",
+                    s->sigFile);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
 
-            case WC_SIGNATURE_TYPE_NONE:
-                FALL_THROUGH;
+    if (ret == WOLFCLU_SUCCESS && signing == 1 &&
+            wolfSSL_BIO_write(sigBio, s->sig, s->sigSz) <= 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Error writing out signature");
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    wolfCLU_StatsEnd(phase);
 
-            default:
-                WOLFCLU_LOG(WOLFCLU_E0, "Key type not yet supported");
-                ret = WOLFCLU_FATAL_ERROR;
+    for (i = 0; i < WOLFCLU_DGST_MAX_SIGS; i++) {
+        if (wolfCLU_DgstFreeKey(&sigs[i]) != WOLFCLU_SUCCESS) {
+            ret = WOLFCLU_FATAL_ERROR;
         }
     }
+    XFREE(sigs, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
 
-    if (data != NULL)
-        XFREE(data, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-    if (sig != NULL)
-        XFREE(sig, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-
-    wolfSSL_EVP_PKEY_free(pkey);
     wolfSSL_BIO_free(sigBio);
-    wolfSSL_BIO_free(pubKeyBio);
     wolfSSL_BIO_free(dataBio);
 
     return ret;
 }
-
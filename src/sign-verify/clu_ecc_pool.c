@@ -0,0 +1,465 @@
+/* clu_ecc_pool.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/sign-verify/clu_ecc_pool.h>
+
+#ifdef WOLFCLU_HAVE_ECC_POOL
+
+#include <pthread.h>
+#include <wolfssl/openssl/bn.h>
+
+/* nonces in a row the thread can fail to make before it stops trying */
+#define WOLFCLU_ECC_POOL_TRIES 8
+
+/* A precomputed nonce, each value big endian and as long as the order n.
+ * With k the nonce and b a random blinding value
+ *     r     = x(k*G) mod n
+ *     br    = b*r mod n
+ *     kbInv = (k*b)^-1 mod n
+ * so that s = kbInv*(b*z + br*d) = k^-1*(z + r*d) mod n, and the private
+ * key d is only multiplied by values that are not public. */
+typedef struct WOLFCLU_ECC_NONCE {
+    byte r[MAX_ECC_BYTES];
+    byte br[MAX_ECC_BYTES];
+    byte b[MAX_ECC_BYTES];
+    byte kbInv[MAX_ECC_BYTES];
+} WOLFCLU_ECC_NONCE;
+
+struct WOLFCLU_ECC_POOL {
+    WOLFCLU_ECC_NONCE* nonces;
+    int    size;
+    int    count;       /* nonces ready, taken from the end */
+    int    curveId;
+    int    keySz;       /* bytes in a coordinate */
+    int    nSz;         /* bytes in the order */
+    WOLFSSL_BIGNUM* order;
+    WC_RNG rng;         /* only used by the pool's thread once it starts */
+    int    rngInit;
+    int    stop;
+    int    started;
+    pthread_t tid;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;   /* signalled when a nonce is taken and on stop */
+};
+
+
+/* writes bn to out as a big endian number of exactly sz bytes
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_EccPoolPut(const WOLFSSL_BIGNUM* bn, byte* out, int sz)
+{
+    int n = wolfSSL_BN_num_bytes(bn);
+
+    if (n < 0 || n > sz) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    XMEMSET(out, 0, sz - n);
+    if (n > 0 && wolfSSL_BN_bn2bin(bn, out + sz - n) != n) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* makes a nonce, doing the k*G that signing with it then leaves out
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_EccPoolMake(WOLFCLU_ECC_POOL* pool,
+        WOLFCLU_ECC_NONCE* nonce)
+{
+    ecc_key eph;
+    byte    buf[MAX_ECC_BYTES + 8];
+    byte    y[MAX_ECC_BYTES];
+    word32  bufSz = sizeof(buf);
+    word32  ySz   = sizeof(y);
+    WOLFSSL_BN_CTX* ctx = wolfSSL_BN_CTX_new();
+    WOLFSSL_BIGNUM* k   = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* x   = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* r   = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* b   = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* kb  = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* t   = wolfSSL_BN_new();
+    int ret = WOLFCLU_FATAL_ERROR;
+    int ephInit = 0;
+
+    if (ctx != NULL && k != NULL && x != NULL && r != NULL && b != NULL &&
+            kb != NULL && t != NULL && wc_ecc_init(&eph) == 0) {
+        ephInit = 1;
+        ret = WOLFCLU_SUCCESS;
+    }
+
+    /* an ephemeral key pair is k and k*G */
+    if (ret == WOLFCLU_SUCCESS &&
+            (wc_ecc_make_key_ex(&pool->rng, pool->keySz, &eph,
+                                pool->curveId) != 0 ||
+             wc_ecc_export_private_only(&eph, buf, &bufSz) != 0 ||
+             wolfSSL_BN_bin2bn(buf, bufSz, k) == NULL)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    bufSz = sizeof(buf);
+    if (ret == WOLFCLU_SUCCESS &&
+            (wc_ecc_export_public_raw(&eph, buf, &bufSz, y, &ySz) != 0 ||
+             wolfSSL_BN_bin2bn(buf, bufSz, x) == NULL ||
+             wolfSSL_BN_mod(r, x, pool->order, ctx) != WOLFSSL_SUCCESS ||
+             wolfSSL_BN_is_zero(r))) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* b is reduced from 64 bits more than n so that it is close to uniform */
+    if (ret == WOLFCLU_SUCCESS &&
+            (wc_RNG_GenerateBlock(&pool->rng, buf, pool->nSz + 8) != 0 ||
+             wolfSSL_BN_bin2bn(buf, pool->nSz + 8, t) == NULL ||
+             wolfSSL_BN_mod(b, t, pool->order, ctx) != WOLFSSL_SUCCESS ||
+             wolfSSL_BN_is_zero(b))) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS &&
+            (wolfSSL_BN_mod_mul(kb, k, b, pool->order, ctx) !=
+                WOLFSSL_SUCCESS ||
+             wolfSSL_BN_mod_inverse(t, kb, pool->order, ctx) == NULL ||
+             wolfCLU_EccPoolPut(t, nonce->kbInv, pool->nSz) !=
+                WOLFCLU_SUCCESS ||
+             wolfSSL_BN_mod_mul(kb, b, r, pool->order, ctx) !=
+                WOLFSSL_SUCCESS ||
+             wolfCLU_EccPoolPut(kb, nonce->br, pool->nSz) !=
+                WOLFCLU_SUCCESS ||
+             wolfCLU_EccPoolPut(b, nonce->b, pool->nSz) != WOLFCLU_SUCCESS ||
+             wolfCLU_EccPoolPut(r, nonce->r, pool->nSz) != WOLFCLU_SUCCESS)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ephInit) {
+        wc_ecc_free(&eph);
+    }
+    wolfCLU_ForceZero(buf, sizeof(buf));
+    wolfSSL_BN_clear_free(k);
+    wolfSSL_BN_clear_free(b);
+    wolfSSL_BN_clear_free(kb);
+    wolfSSL_BN_clear_free(t);
+    wolfSSL_BN_free(x);
+    wolfSSL_BN_free(r);
+    wolfSSL_BN_CTX_free(ctx);
+    if (ret != WOLFCLU_SUCCESS) {
+        wolfCLU_ForceZero(nonce, sizeof(WOLFCLU_ECC_NONCE));
+    }
+    return ret;
+}
+
+
+/* signs hash with the private key of key and nonce, the online part
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_EccPoolFinish(WOLFCLU_ECC_POOL* pool, ecc_key* key,
+        const WOLFCLU_ECC_NONCE* nonce, const byte* hash, word32 hashSz,
+        byte* sig, word32* sigSz)
+{
+    byte   d[MAX_ECC_BYTES];
+    byte   s[MAX_ECC_BYTES];
+    word32 dSz  = sizeof(d);
+    word32 zSz  = hashSz;
+    int    bits = wolfSSL_BN_num_bits(pool->order);
+    WOLFSSL_BN_CTX* ctx = wolfSSL_BN_CTX_new();
+    WOLFSSL_BIGNUM* z   = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* bnD = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* b   = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* br  = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* kbInv = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* t   = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* u   = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* v   = wolfSSL_BN_new();
+    int ret = WOLFCLU_FATAL_ERROR;
+
+    if (ctx != NULL && z != NULL && bnD != NULL && b != NULL && br != NULL &&
+            kbInv != NULL && t != NULL && u != NULL && v != NULL &&
+            key->dp != NULL && key->dp->id == pool->curveId &&
+            wc_ecc_export_private_only(key, d, &dSz) == 0) {
+        ret = WOLFCLU_SUCCESS;
+    }
+
+    /* z is the leftmost bits of the hash, as many as the order has */
+    if (zSz > (word32)pool->nSz) {
+        zSz = pool->nSz;
+    }
+    if (ret == WOLFCLU_SUCCESS &&
+            (wolfSSL_BN_bin2bn(hash, zSz, z) == NULL ||
+             ((int)zSz * 8 > bits &&
+              wolfSSL_BN_rshift(z, z, (int)zSz * 8 - bits) !=
+                WOLFSSL_SUCCESS))) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS &&
+            (wolfSSL_BN_bin2bn(d, dSz, bnD) == NULL ||
+             wolfSSL_BN_bin2bn(nonce->b, pool->nSz, b) == NULL ||
+             wolfSSL_BN_bin2bn(nonce->br, pool->nSz, br) == NULL ||
+             wolfSSL_BN_bin2bn(nonce->kbInv, pool->nSz, kbInv) == NULL)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* s = kbInv*(b*z + br*d) mod n */
+    if (ret == WOLFCLU_SUCCESS &&
+            (wolfSSL_BN_mod_mul(t, b, z, pool->order, ctx) !=
+                WOLFSSL_SUCCESS ||
+             wolfSSL_BN_mod_mul(u, br, bnD, pool->order, ctx) !=
+                WOLFSSL_SUCCESS ||
+             wolfSSL_BN_add(v, t, u) != WOLFSSL_SUCCESS ||
+             wolfSSL_BN_mod(t, v, pool->order, ctx) != WOLFSSL_SUCCESS ||
+             wolfSSL_BN_mod_mul(u, kbInv, t, pool->order, ctx) !=
+                WOLFSSL_SUCCESS ||
+             wolfSSL_BN_is_zero(u) ||
+             wolfCLU_EccPoolPut(u, s, pool->nSz) != WOLFCLU_SUCCESS)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS &&
+            wc_ecc_rs_raw_to_sig(nonce->r, pool->nSz, s, pool->nSz, sig,
+                sigSz) != 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    wolfCLU_ForceZero(d, sizeof(d));
+    wolfCLU_ForceZero(s, sizeof(s));
+    wolfSSL_BN_clear_free(bnD);
+    wolfSSL_BN_clear_free(b);
+    wolfSSL_BN_clear_free(br);
+    wolfSSL_BN_clear_free(kbInv);
+    wolfSSL_BN_clear_free(t);
+    wolfSSL_BN_clear_free(u);
+    wolfSSL_BN_clear_free(v);
+    wolfSSL_BN_free(z);
+    wolfSSL_BN_CTX_free(ctx);
+    return ret;
+}
+
+
+/* keeps the pool full until it is stopped */
+static void* wolfCLU_EccPoolThread(void* arg)
+{
+    WOLFCLU_ECC_POOL* pool = (WOLFCLU_ECC_POOL*)arg;
+    WOLFCLU_ECC_NONCE nonce;
+    int fails = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop && fails < WOLFCLU_ECC_POOL_TRIES) {
+        if (pool->count == pool->size) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        if (wolfCLU_EccPoolMake(pool, &nonce) == WOLFCLU_SUCCESS) {
+            fails = 0;
+        }
+        else {
+            fails++;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (fails == 0 && pool->count < pool->size) {
+            XMEMCPY(&pool->nonces[pool->count], &nonce, sizeof(nonce));
+            pool->count++;
+        }
+        wolfCLU_ForceZero(&nonce, sizeof(nonce));
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (fails > 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to precompute ECDSA nonces, signing "
+                "without them");
+    }
+    return NULL;
+}
+
+
+/* return WOLFCLU_SUCCESS on success */
+int wolfCLU_EccPoolNew(ecc_key* key, int size, WOLFCLU_ECC_POOL** pool)
+{
+    WOLFCLU_ECC_POOL* p;
+    WOLFCLU_ECC_NONCE nonce;
+    byte   hash[WC_SHA256_DIGEST_SIZE];
+    byte   sig[ECC_MAX_SIG_SIZE];
+    word32 sigSz = sizeof(sig);
+    int    verified = 0;
+    int    ret = WOLFCLU_SUCCESS;
+
+    if (key == NULL || key->dp == NULL || pool == NULL || size < 1 ||
+            size > WOLFCLU_ECC_POOL_MAX) {
+        return BAD_FUNC_ARG;
+    }
+
+    p = (WOLFCLU_ECC_POOL*)XMALLOC(sizeof(WOLFCLU_ECC_POOL), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (p == NULL) {
+        return MEMORY_E;
+    }
+    XMEMSET(p, 0, sizeof(WOLFCLU_ECC_POOL));
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    p->size    = size;
+    p->curveId = key->dp->id;
+    p->keySz   = key->dp->size;
+
+    p->nonces = (WOLFCLU_ECC_NONCE*)XMALLOC(sizeof(WOLFCLU_ECC_NONCE) * size,
+            HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (p->nonces == NULL) {
+        ret = MEMORY_E;
+    }
+    if (ret == WOLFCLU_SUCCESS &&
+            wolfSSL_BN_hex2bn(&p->order, key->dp->order) == 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        p->nSz = wolfSSL_BN_num_bytes(p->order);
+        if (p->nSz <= 0 || p->nSz > MAX_ECC_BYTES) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        if (wc_InitRng(&p->rng) != 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            p->rngInit = 1;
+        }
+    }
+
+    /* a pool whose signatures do not verify with key is not used at all */
+    if (ret == WOLFCLU_SUCCESS) {
+        XMEMSET(hash, 0x5a, sizeof(hash));
+        if (wolfCLU_EccPoolMake(p, &nonce) != WOLFCLU_SUCCESS ||
+                wolfCLU_EccPoolFinish(p, key, &nonce, hash, sizeof(hash), sig,
+                    &sigSz) != WOLFCLU_SUCCESS ||
+                wc_ecc_verify_hash(sig, sigSz, hash, sizeof(hash), &verified,
+                    key) != 0 || verified != 1) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        wolfCLU_ForceZero(&nonce, sizeof(nonce));
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        if (pthread_create(&p->tid, NULL, wolfCLU_EccPoolThread, p) != 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            p->started = 1;
+        }
+    }
+
+    if (ret != WOLFCLU_SUCCESS) {
+        wolfCLU_EccPoolFree(p);
+        return ret;
+    }
+    *pool = p;
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* return WOLFCLU_SUCCESS on success */
+int wolfCLU_EccPoolSign(WOLFCLU_ECC_POOL* pool, ecc_key* key,
+        const byte* hash, word32 hashSz, byte* sig, word32* sigSz)
+{
+    WOLFCLU_ECC_NONCE nonce;
+    int ret = WOLFCLU_FATAL_ERROR;
+
+    if (pool == NULL || key == NULL || hash == NULL || sig == NULL ||
+            sigSz == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    /* a nonce leaves the pool before it is used so no two signatures can
+     * share one */
+    pthread_mutex_lock(&pool->lock);
+    if (pool->count > 0) {
+        pool->count--;
+        XMEMCPY(&nonce, &pool->nonces[pool->count], sizeof(nonce));
+        wolfCLU_ForceZero(&pool->nonces[pool->count], sizeof(nonce));
+        pthread_cond_signal(&pool->cond);
+        ret = WOLFCLU_SUCCESS;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_EccPoolFinish(pool, key, &nonce, hash, hashSz, sig,
+                sigSz);
+        wolfCLU_ForceZero(&nonce, sizeof(nonce));
+    }
+    return ret;
+}
+
+
+void wolfCLU_EccPoolFree(WOLFCLU_ECC_POOL* pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    if (pool->started) {
+        pthread_mutex_lock(&pool->lock);
+        pool->stop = 1;
+        pthread_cond_signal(&pool->cond);
+        pthread_mutex_unlock(&pool->lock);
+        pthread_join(pool->tid, NULL);
+    }
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+
+    if (pool->nonces != NULL) {
+        wolfCLU_ForceZero(pool->nonces,
+                sizeof(WOLFCLU_ECC_NONCE) * pool->size);
+        XFREE(pool->nonces, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    wolfSSL_BN_free(pool->order);
+    if (pool->rngInit) {
+        wc_FreeRng(&pool->rng);
+    }
+    XFREE(pool, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+}
+
+#elif defined(HAVE_ECC)
+
+int wolfCLU_EccPoolNew(ecc_key* key, int size, WOLFCLU_ECC_POOL** pool)
+{
+    (void)key;
+    (void)size;
+    (void)pool;
+    return NOT_COMPILED_IN;
+}
+
+
+int wolfCLU_EccPoolSign(WOLFCLU_ECC_POOL* pool, ecc_key* key,
+        const byte* hash, word32 hashSz, byte* sig, word32* sigSz)
+{
+    (void)pool;
+    (void)key;
+    (void)hash;
+    (void)hashSz;
+    (void)sig;
+    (void)sigSz;
+    return NOT_COMPILED_IN;
+}
+
+
+void wolfCLU_EccPoolFree(WOLFCLU_ECC_POOL* pool)
+{
+    (void)pool;
+}
+
+#endif /* WOLFCLU_HAVE_ECC_POOL */
@@ -0,0 +1,1200 @@
+/* clu_keycache.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/sign-verify/clu_keycache.h>
+#include <wolfssl/wolfcrypt/hmac.h>
+#include <wolfssl/openssl/bn.h>
+
+#if !defined(USE_WINDOWS_API)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/types.h>
+    #include <sys/stat.h>
+#endif
+
+/* File layout, numbers big endian:
+ *     magic, salt, u32 entry count, entries, HMAC-SHA256 of all before it
+ * and each entry is
+ *     u32 size of the rest, u8 type, u8 private, u16 curve id,
+ *     SHA-256 of the key file, then each part as a u16 size and its bytes
+ * with the public parts first
+ *     RSA      n e [d p q dP dQ u]
+ *     ECC      x y [d]
+ *     Ed25519  public [private] */
+
+#define KEYCACHE_MAGIC_SZ 8
+#define KEYCACHE_SALT_SZ  16
+#define KEYCACHE_ID_SZ    WC_SHA256_DIGEST_SIZE
+#define KEYCACHE_TAG_SZ   WC_SHA256_DIGEST_SIZE
+#define KEYCACHE_KEY_SZ   32
+#define KEYCACHE_COUNT_OFF (KEYCACHE_MAGIC_SZ + KEYCACHE_SALT_SZ)
+#define KEYCACHE_HDR_SZ   (KEYCACHE_COUNT_OFF + 4)
+#define KEYCACHE_MAX_PARTS 8
+
+/* the size, type, private flag and curve id before the key file hash */
+#define KEYCACHE_ENTRY_HDR_SZ (8 + KEYCACHE_ID_SZ)
+
+static const byte keyCacheMagic[KEYCACHE_MAGIC_SZ] = {
+    'w', 'C', 'L', 'U', 'k', 'c', 0, 3
+};
+
+typedef struct WOLFCLU_KEYCACHE {
+    char*  path;
+    byte   macKey[WC_SHA256_DIGEST_SIZE];
+    byte   salt[KEYCACHE_SALT_SZ];
+    byte*  file;        /* the file as read, its HMAC checked */
+    word32 fileSz;
+    const byte* entries; /* the entries in file */
+    word32 entriesSz;
+    word32 count;
+    byte*  add;         /* entries added since the cache was opened */
+    word32 addSz;
+    word32 addCount;
+    int    on;
+} WOLFCLU_KEYCACHE;
+
+static WOLFCLU_THREAD_LS WOLFCLU_KEYCACHE keyCache;
+
+
+static word32 wolfCLU_KeyCacheGet32(const byte* p)
+{
+    return ((word32)p[0] << 24) | ((word32)p[1] << 16) |
+           ((word32)p[2] << 8)  |  (word32)p[3];
+}
+
+static void wolfCLU_KeyCachePut32(byte* p, word32 v)
+{
+    p[0] = (byte)(v >> 24);
+    p[1] = (byte)(v >> 16);
+    p[2] = (byte)(v >> 8);
+    p[3] = (byte)v;
+}
+
+
+/* number of parts in an entry of type, 0 for an unknown type */
+static int wolfCLU_KeyCacheNumParts(int type, int priv)
+{
+    switch (type) {
+        case WOLFCLU_KEYCACHE_RSA:
+            return priv? 8 : 2;
+        case WOLFCLU_KEYCACHE_ECC:
+            return priv? 3 : 2;
+        case WOLFCLU_KEYCACHE_ED25519:
+            return priv? 2 : 1;
+        default:
+            return 0;
+    }
+}
+
+
+/* tag is the HMAC-SHA256 of in with the cache's key
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheMac(const byte* key, word32 keySz, const byte* in,
+        word32 inSz, byte* tag)
+{
+    Hmac hmac;
+    int  ret;
+
+    ret = wc_HmacInit(&hmac, HEAP_HINT, INVALID_DEVID);
+    if (ret == 0) {
+        ret = wc_HmacSetKey(&hmac, WC_SHA256, key, keySz);
+        if (ret == 0) {
+            ret = wc_HmacUpdate(&hmac, in, inSz);
+        }
+        if (ret == 0) {
+            ret = wc_HmacFinal(&hmac, tag);
+        }
+        wc_HmacFree(&hmac);
+    }
+    return (ret == 0)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+/* makes the HMAC key as the HMAC-SHA256 of the salt and password keyed by
+ * the random key kept next to the cache
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheDeriveKey(const byte* secret, const char* pass,
+        int passSz)
+{
+    Hmac hmac;
+    int  ret;
+
+    ret = wc_HmacInit(&hmac, HEAP_HINT, INVALID_DEVID);
+    if (ret == 0) {
+        ret = wc_HmacSetKey(&hmac, WC_SHA256, secret, KEYCACHE_KEY_SZ);
+        if (ret == 0) {
+            ret = wc_HmacUpdate(&hmac, keyCache.salt, KEYCACHE_SALT_SZ);
+        }
+        if (ret == 0) {
+            ret = wc_HmacUpdate(&hmac, (const byte*)pass, (word32)passSz);
+        }
+        if (ret == 0) {
+            ret = wc_HmacFinal(&hmac, keyCache.macKey);
+        }
+        wc_HmacFree(&hmac);
+    }
+    return (ret == 0)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+/* returns 0 when a and b match, in time that does not depend on where they
+ * first differ */
+static int wolfCLU_KeyCacheCompare(const byte* a, const byte* b, word32 sz)
+{
+    word32 i;
+    byte   diff = 0;
+
+    for (i = 0; i < sz; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff;
+}
+
+
+/* splits the entry at e, of e's own size field, into its parts
+ * returns the number of parts, or -1 when they do not fit the entry */
+static int wolfCLU_KeyCacheParts(const byte* e, const byte** part,
+        word32* partSz)
+{
+    word32 sz  = wolfCLU_KeyCacheGet32(e) + 4;
+    word32 idx = KEYCACHE_ENTRY_HDR_SZ;
+    int    n   = 0;
+
+    while (idx < sz) {
+        if (n == KEYCACHE_MAX_PARTS || sz - idx < 2) {
+            return -1;
+        }
+        partSz[n] = ((word32)e[idx] << 8) | e[idx + 1];
+        idx += 2;
+        if (partSz[n] == 0 || sz - idx < partSz[n]) {
+            return -1;
+        }
+        part[n++] = e + idx;
+        idx += partSz[n - 1];
+    }
+    return n;
+}
+
+
+/* checks the entry at the start of the sz bytes at p and sets entrySz to
+ * the bytes it takes up
+ * returns WOLFCLU_SUCCESS when it is well formed */
+static int wolfCLU_KeyCacheCheckEntry(const byte* p, word32 sz,
+        word32* entrySz)
+{
+    const byte* part[KEYCACHE_MAX_PARTS];
+    word32 partSz[KEYCACHE_MAX_PARTS];
+    word32 len;
+
+    if (sz < KEYCACHE_ENTRY_HDR_SZ) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    len = wolfCLU_KeyCacheGet32(p);
+    if (len < KEYCACHE_ENTRY_HDR_SZ - 4 || len > sz - 4 || p[5] > 1) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (wolfCLU_KeyCacheParts(p, part, partSz) !=
+            wolfCLU_KeyCacheNumParts(p[4], p[5])) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    *entrySz = len + 4;
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* returns the entry for the key file with hash id in the sz bytes of
+ * entries at p, or NULL */
+static const byte* wolfCLU_KeyCacheFind(const byte* p, word32 sz, int type,
+        int priv, const byte* id)
+{
+    word32 idx = 0;
+
+    while (idx < sz) {
+        const byte* e = p + idx;
+        if (e[4] == type && e[5] == priv &&
+                XMEMCMP(e + 8, id, KEYCACHE_ID_SZ) == 0) {
+            return e;
+        }
+        idx += wolfCLU_KeyCacheGet32(e) + 4;
+    }
+    return NULL;
+}
+
+
+/* returns the bytes taken by the first n of the entries at p */
+static word32 wolfCLU_KeyCacheSpan(const byte* p, word32 n)
+{
+    word32 idx = 0;
+
+    while (n-- > 0) {
+        idx += wolfCLU_KeyCacheGet32(p + idx) + 4;
+    }
+    return idx;
+}
+
+
+/* reads all of path into a new buffer
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheReadFile(const char* path, byte** out,
+        word32* outSz)
+{
+    XFILE f;
+    long  sz;
+    int   ret = WOLFCLU_SUCCESS;
+
+    f = XFOPEN(path, "rb");
+    if (f == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", path);
+        return BAD_FUNC_ARG;
+    }
+
+    XFSEEK(f, 0, SEEK_END);
+    sz = XFTELL(f);
+    XFSEEK(f, 0, SEEK_SET);
+    if (sz <= 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        *out = (byte*)XMALLOC(sz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (*out == NULL) {
+            ret = MEMORY_E;
+        }
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        if (XFREAD(*out, 1, sz, f) != (size_t)sz) {
+            XFREE(*out, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+            *out = NULL;
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            *outSz = (word32)sz;
+        }
+    }
+    XFCLOSE(f);
+
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to read file %s", path);
+    }
+    return ret;
+}
+
+
+#if !defined(USE_WINDOWS_API)
+/* reads exactly sz bytes from fd into out
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheReadFd(int fd, byte* out, word32 sz)
+{
+    word32 idx = 0;
+
+    while (idx < sz) {
+        ssize_t r = read(fd, out + idx, sz - idx);
+        if (r <= 0) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+        idx += (word32)r;
+    }
+    return WOLFCLU_SUCCESS;
+}
+#endif
+
+
+/* reads the cache file into a buffer of its own, so the bytes the HMAC is
+ * checked over cannot change after, leaving file NULL when there is none yet
+ * or it is empty
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheReadCache(const char* path)
+{
+#if !defined(USE_WINDOWS_API)
+    struct stat st;
+    int    ret = WOLFCLU_SUCCESS;
+    int    fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return WOLFCLU_SUCCESS;
+        }
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to open key cache %s", path);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size > 0xFFFFFFFFL) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    else if (st.st_size > 0) {
+        keyCache.fileSz = (word32)st.st_size;
+        keyCache.file   = (byte*)XMALLOC(keyCache.fileSz, HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (keyCache.file == NULL) {
+            ret = MEMORY_E;
+        }
+    }
+
+    /* a file cut short while it is read is refused, not half used */
+    if (ret == WOLFCLU_SUCCESS && keyCache.file != NULL) {
+        ret = wolfCLU_KeyCacheReadFd(fd, keyCache.file, keyCache.fileSz);
+    }
+    close(fd);
+
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to read key cache %s", path);
+    }
+    return ret;
+#else
+    XFILE f = XFOPEN(path, "rb");
+
+    if (f == NULL) {
+        return WOLFCLU_SUCCESS;
+    }
+    XFCLOSE(f);
+    return wolfCLU_KeyCacheReadFile(path, &keyCache.file, &keyCache.fileSz);
+#endif
+}
+
+
+/* makes a new random key at keyPath, only readable by its owner, unless
+ * there is one already. The key is written to a temporary file and linked
+ * into place, so a reader never sees it half written and when two runs
+ * start the same new cache both use the key that got there first
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheNewSecret(const char* keyPath)
+{
+    WC_RNG rng;
+    byte   key[KEYCACHE_KEY_SZ];
+    int    ret = WOLFCLU_SUCCESS;
+
+    XMEMSET(&rng, 0, sizeof(rng));
+    if (wc_InitRng(&rng) != 0 ||
+            wc_RNG_GenerateBlock(&rng, key, sizeof(key)) != 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    wc_FreeRng(&rng);
+
+#if !defined(USE_WINDOWS_API)
+    if (ret == WOLFCLU_SUCCESS) {
+        char*  tmp;
+        word32 tmpSz = (word32)XSTRLEN(keyPath) + 8;
+        int    fd = -1;
+
+        tmp = (char*)XMALLOC(tmpSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (tmp == NULL) {
+            ret = MEMORY_E;
+        }
+        else {
+            XSNPRINTF(tmp, tmpSz, "%s.XXXXXX", keyPath);
+            fd = mkstemp(tmp);
+        }
+        if (ret == WOLFCLU_SUCCESS && fd < 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        if (fd >= 0) {
+            if (write(fd, key, sizeof(key)) != (ssize_t)sizeof(key) ||
+                    fsync(fd) != 0) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            close(fd);
+            if (ret == WOLFCLU_SUCCESS && link(tmp, keyPath) != 0 &&
+                    errno != EEXIST) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            unlink(tmp);
+        }
+        if (tmp != NULL) {
+            XFREE(tmp, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        }
+    }
+#else
+    if (ret == WOLFCLU_SUCCESS) {
+        XFILE f = XFOPEN(keyPath, "rb");
+
+        if (f != NULL) {
+            XFCLOSE(f);
+        }
+        else {
+            f = XFOPEN(keyPath, "wb");
+            if (f == NULL || XFWRITE(key, 1, sizeof(key), f) != sizeof(key)) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            if (f != NULL) {
+                XFCLOSE(f);
+            }
+        }
+    }
+#endif
+
+    wolfCLU_ForceZero(key, sizeof(key));
+    return ret;
+}
+
+
+/* reads the random key kept at keyPath, which has to be only readable by
+ * its owner
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheReadSecret(const char* keyPath, byte* secret)
+{
+#if !defined(USE_WINDOWS_API)
+    struct stat st;
+    int ret = WOLFCLU_SUCCESS;
+    int fd;
+
+    fd = open(keyPath, O_RDONLY);
+    if (fd < 0) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+            (st.st_mode & 077) != 0 || st.st_size != KEYCACHE_KEY_SZ) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_KeyCacheReadFd(fd, secret, KEYCACHE_KEY_SZ);
+    }
+    close(fd);
+    return ret;
+#else
+    byte*  buf = NULL;
+    word32 bufSz = 0;
+    int    ret;
+
+    ret = wolfCLU_KeyCacheReadFile(keyPath, &buf, &bufSz);
+    if (ret == WOLFCLU_SUCCESS && bufSz != KEYCACHE_KEY_SZ) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        XMEMCPY(secret, buf, KEYCACHE_KEY_SZ);
+    }
+    if (buf != NULL) {
+        wolfCLU_ForceZero(buf, bufSz);
+        XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    return ret;
+#endif
+}
+
+
+/* makes the HMAC key from the password and the random key kept at
+ * "<path>.key", which a new cache has made first
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheSecretKey(const char* path, int create,
+        const char* pass, int passSz)
+{
+    byte   secret[KEYCACHE_KEY_SZ];
+    char*  keyPath;
+    word32 keyPathSz = (word32)XSTRLEN(path) + 5;
+    int    ret = WOLFCLU_SUCCESS;
+
+    keyPath = (char*)XMALLOC(keyPathSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (keyPath == NULL) {
+        return MEMORY_E;
+    }
+    XSNPRINTF(keyPath, keyPathSz, "%s.key", path);
+
+    if (create) {
+        ret = wolfCLU_KeyCacheNewSecret(keyPath);
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_KeyCacheReadSecret(keyPath, secret);
+    }
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_KeyCacheDeriveKey(secret, pass, passSz);
+    }
+    else {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to use key cache key %s, it has to "
+                "be %d bytes only its owner can read", keyPath,
+                KEYCACHE_KEY_SZ);
+    }
+
+    wolfCLU_ForceZero(secret, sizeof(secret));
+    XFREE(keyPath, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+
+/* checks the file's magic, HMAC and entries
+ * returns WOLFCLU_SUCCESS when it can be used */
+static int wolfCLU_KeyCacheCheck(const char* path, const char* pass,
+        int passSz)
+{
+    byte   tag[KEYCACHE_TAG_SZ];
+    word32 macSz;
+    word32 idx;
+    word32 n = 0;
+    word32 entrySz;
+    int    ret = WOLFCLU_SUCCESS;
+
+    if (keyCache.fileSz < KEYCACHE_HDR_SZ + KEYCACHE_TAG_SZ ||
+            XMEMCMP(keyCache.file, keyCacheMagic, KEYCACHE_MAGIC_SZ) != 0) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    XMEMCPY(keyCache.salt, keyCache.file + KEYCACHE_MAGIC_SZ,
+            KEYCACHE_SALT_SZ);
+    macSz = keyCache.fileSz - KEYCACHE_TAG_SZ;
+
+    ret = wolfCLU_KeyCacheSecretKey(path, 0, pass, passSz);
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_KeyCacheMac(keyCache.macKey, sizeof(keyCache.macKey),
+                keyCache.file, macSz, tag);
+    }
+    if (ret == WOLFCLU_SUCCESS && wolfCLU_KeyCacheCompare(tag,
+                keyCache.file + macSz, KEYCACHE_TAG_SZ) != 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* the HMAC matched, but entries are still checked before any size in
+     * them is trusted */
+    if (ret == WOLFCLU_SUCCESS) {
+        keyCache.count     = wolfCLU_KeyCacheGet32(keyCache.file +
+                KEYCACHE_COUNT_OFF);
+        keyCache.entries   = keyCache.file + KEYCACHE_HDR_SZ;
+        keyCache.entriesSz = macSz - KEYCACHE_HDR_SZ;
+        for (idx = 0; ret == WOLFCLU_SUCCESS && idx < keyCache.entriesSz;
+                idx += entrySz, n++) {
+            ret = wolfCLU_KeyCacheCheckEntry(keyCache.entries + idx,
+                    keyCache.entriesSz - idx, &entrySz);
+        }
+        if (n != keyCache.count) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+    return ret;
+}
+
+
+int wolfCLU_KeyCacheOpen(const char* path, const char* pass, int passSz)
+{
+    WC_RNG rng;
+    int    ret = WOLFCLU_SUCCESS;
+
+    if (path == NULL || pass == NULL || passSz <= 0 || keyCache.on) {
+        return BAD_FUNC_ARG;
+    }
+
+    XMEMSET(&keyCache, 0, sizeof(keyCache));
+    keyCache.path = (char*)XMALLOC(XSTRLEN(path) + 1, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (keyCache.path == NULL) {
+        return MEMORY_E;
+    }
+    XSTRNCPY(keyCache.path, path, XSTRLEN(path) + 1);
+    keyCache.on = 1;
+
+    ret = wolfCLU_KeyCacheReadCache(path);
+    if (ret == WOLFCLU_SUCCESS && keyCache.file != NULL) {
+        ret = wolfCLU_KeyCacheCheck(path, pass, passSz);
+        if (ret != WOLFCLU_SUCCESS) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Key cache %s is damaged or was written "
+                    "with another password", path);
+        }
+    }
+    else if (ret == WOLFCLU_SUCCESS) {
+        /* a new cache, written out on close if a key is added */
+        XMEMSET(&rng, 0, sizeof(rng));
+        if (wc_InitRng(&rng) != 0 ||
+                wc_RNG_GenerateBlock(&rng, keyCache.salt,
+                    KEYCACHE_SALT_SZ) != 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        wc_FreeRng(&rng);
+        if (ret == WOLFCLU_SUCCESS) {
+            ret = wolfCLU_KeyCacheSecretKey(path, 1, pass, passSz);
+        }
+    }
+
+    if (ret != WOLFCLU_SUCCESS) {
+        keyCache.addCount = 0;
+        wolfCLU_KeyCacheClose();
+    }
+    return ret;
+}
+
+
+int wolfCLU_KeyCacheOn(void)
+{
+    return keyCache.on;
+}
+
+
+/* adds an entry of the n parts to the cache and sets entry to it
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheAppend(int type, int priv, int curveId,
+        const byte* id, byte** part, const word32* partSz, int n,
+        const byte** entry)
+{
+    word32 sz = KEYCACHE_ENTRY_HDR_SZ;
+    word32 idx;
+    byte*  add;
+    byte*  e;
+    int    i;
+
+    for (i = 0; i < n; i++) {
+        if (partSz[i] == 0 || partSz[i] > 0xFFFF) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+        sz += 2 + partSz[i];
+    }
+
+    /* copied rather than grown in place so the old buffer can be zeroed */
+    add = (byte*)XMALLOC(keyCache.addSz + sz, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (add == NULL) {
+        return MEMORY_E;
+    }
+    if (keyCache.add != NULL) {
+        XMEMCPY(add, keyCache.add, keyCache.addSz);
+        wolfCLU_ForceZero(keyCache.add, keyCache.addSz);
+        XFREE(keyCache.add, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+
+    e = add + keyCache.addSz;
+    wolfCLU_KeyCachePut32(e, sz - 4);
+    e[4] = (byte)type;
+    e[5] = (byte)priv;
+    e[6] = (byte)(curveId >> 8);
+    e[7] = (byte)curveId;
+    XMEMCPY(e + 8, id, KEYCACHE_ID_SZ);
+    idx = KEYCACHE_ENTRY_HDR_SZ;
+    for (i = 0; i < n; i++) {
+        e[idx++] = (byte)(partSz[i] >> 8);
+        e[idx++] = (byte)partSz[i];
+        XMEMCPY(e + idx, part[i], partSz[i]);
+        idx += partSz[i];
+    }
+
+    keyCache.add    = add;
+    keyCache.addSz += sz;
+    keyCache.addCount++;
+    *entry = e;
+    return WOLFCLU_SUCCESS;
+}
+
+
+#ifndef NO_RSA
+/* writes bn to out as a big endian number of at most *outSz bytes
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheBn(const WOLFSSL_BIGNUM* bn, byte* out,
+        word32* outSz)
+{
+    int n = wolfSSL_BN_num_bytes(bn);
+
+    if (n <= 0 || (word32)n > *outSz || wolfSSL_BN_bn2bin(bn, out) != n) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    *outSz = (word32)n;
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* fills in dP, dQ and u from d, p and q, which wc_RsaExportKey leaves out
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheRsaCrt(byte** part, word32* partSz)
+{
+    WOLFSSL_BN_CTX* ctx = wolfSSL_BN_CTX_new();
+    WOLFSSL_BIGNUM* d = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* p = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* q = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* t = wolfSSL_BN_new();
+    WOLFSSL_BIGNUM* r = wolfSSL_BN_new();
+    int ret = WOLFCLU_FATAL_ERROR;
+
+    if (ctx != NULL && d != NULL && p != NULL && q != NULL && t != NULL &&
+            r != NULL &&
+            wolfSSL_BN_bin2bn(part[2], partSz[2], d) != NULL &&
+            wolfSSL_BN_bin2bn(part[3], partSz[3], p) != NULL &&
+            wolfSSL_BN_bin2bn(part[4], partSz[4], q) != NULL) {
+        ret = WOLFCLU_SUCCESS;
+    }
+
+    /* dP = d mod (p - 1) */
+    if (ret == WOLFCLU_SUCCESS &&
+            (wolfSSL_BN_bin2bn(part[3], partSz[3], t) == NULL ||
+             wolfSSL_BN_sub_word(t, 1) != WOLFSSL_SUCCESS ||
+             wolfSSL_BN_mod(r, d, t, ctx) != WOLFSSL_SUCCESS ||
+             wolfCLU_KeyCacheBn(r, part[5], &partSz[5]) != WOLFCLU_SUCCESS)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* dQ = d mod (q - 1) */
+    if (ret == WOLFCLU_SUCCESS &&
+            (wolfSSL_BN_bin2bn(part[4], partSz[4], t) == NULL ||
+             wolfSSL_BN_sub_word(t, 1) != WOLFSSL_SUCCESS ||
+             wolfSSL_BN_mod(r, d, t, ctx) != WOLFSSL_SUCCESS ||
+             wolfCLU_KeyCacheBn(r, part[6], &partSz[6]) != WOLFCLU_SUCCESS)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* u = q^-1 mod p */
+    if (ret == WOLFCLU_SUCCESS &&
+            (wolfSSL_BN_mod_inverse(r, q, p, ctx) == NULL ||
+             wolfCLU_KeyCacheBn(r, part[7], &partSz[7]) != WOLFCLU_SUCCESS)) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    wolfSSL_BN_clear_free(d);
+    wolfSSL_BN_clear_free(p);
+    wolfSSL_BN_clear_free(q);
+    wolfSSL_BN_clear_free(t);
+    wolfSSL_BN_clear_free(r);
+    wolfSSL_BN_CTX_free(ctx);
+    return ret;
+}
+
+
+static int wolfCLU_KeyCacheAddRsa(const byte* id, const byte* der,
+        word32 derSz, int priv, const byte** entry)
+{
+    RsaKey key;
+    byte*  buf = NULL;
+    byte*  part[KEYCACHE_MAX_PARTS];
+    word32 partSz[KEYCACHE_MAX_PARTS];
+    word32 idx = 0;
+    int    keySz = 0;
+    int    n = wolfCLU_KeyCacheNumParts(WOLFCLU_KEYCACHE_RSA, priv);
+    int    i;
+    int    ret;
+
+    ret = wc_InitRsaKey(&key, HEAP_HINT);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (priv) {
+        ret = wc_RsaPrivateKeyDecode(der, &idx, &key, derSz);
+    }
+    else {
+        ret = wc_RsaPublicKeyDecode(der, &idx, &key, derSz);
+    }
+    if (ret == 0) {
+        keySz = wc_RsaEncryptSize(&key);
+        ret = (keySz > 0)? 0 : WOLFCLU_FATAL_ERROR;
+    }
+    if (ret == 0) {
+        buf = (byte*)XMALLOC(KEYCACHE_MAX_PARTS * keySz, HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        ret = (buf != NULL)? 0 : MEMORY_E;
+    }
+    if (ret == 0) {
+        for (i = 0; i < KEYCACHE_MAX_PARTS; i++) {
+            part[i]   = buf + i * keySz;
+            partSz[i] = (word32)keySz;
+        }
+        if (priv) {
+            ret = wc_RsaExportKey(&key, part[1], &partSz[1], part[0],
+                    &partSz[0], part[2], &partSz[2], part[3], &partSz[3],
+                    part[4], &partSz[4]);
+            if (ret == 0 && wolfCLU_KeyCacheRsaCrt(part, partSz) !=
+                    WOLFCLU_SUCCESS) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+        }
+        else {
+            ret = wc_RsaFlattenPublicKey(&key, part[1], &partSz[1], part[0],
+                    &partSz[0]);
+        }
+    }
+    if (ret == 0) {
+        ret = wolfCLU_KeyCacheAppend(WOLFCLU_KEYCACHE_RSA, priv, 0, id, part,
+                partSz, n, entry);
+    }
+    else {
+        WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode RSA key.\nRET: %d", ret);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (buf != NULL) {
+        wolfCLU_ForceZero(buf, KEYCACHE_MAX_PARTS * keySz);
+        XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    wc_FreeRsaKey(&key);
+    return ret;
+}
+#endif /* !NO_RSA */
+
+
+#ifdef HAVE_ECC
+static int wolfCLU_KeyCacheAddEcc(const byte* id, const byte* der,
+        word32 derSz, int priv, const byte** entry)
+{
+    ecc_key key;
+    byte    buf[3 * MAX_ECC_BYTES];
+    byte*   part[3];
+    word32  partSz[3];
+    word32  idx = 0;
+    int     ret;
+    int     i;
+
+    ret = wc_ecc_init(&key);
+    if (ret != 0) {
+        return ret;
+    }
+
+    for (i = 0; i < 3; i++) {
+        part[i]   = buf + i * MAX_ECC_BYTES;
+        partSz[i] = MAX_ECC_BYTES;
+    }
+
+    if (priv) {
+        ret = wc_EccPrivateKeyDecode(der, &idx, &key, derSz);
+        /* a key file without the public point has it made this once */
+        if (ret == 0 && key.type == ECC_PRIVATEKEY_ONLY) {
+            ret = wc_ecc_make_pub(&key, NULL);
+        }
+        if (ret == 0) {
+            ret = wc_ecc_export_private_raw(&key, part[0], &partSz[0],
+                    part[1], &partSz[1], part[2], &partSz[2]);
+        }
+    }
+    else {
+        ret = wc_EccPublicKeyDecode(der, &idx, &key, derSz);
+        if (ret == 0) {
+            ret = wc_ecc_export_public_raw(&key, part[0], &partSz[0],
+                    part[1], &partSz[1]);
+        }
+    }
+
+    if (ret == 0) {
+        ret = wolfCLU_KeyCacheAppend(WOLFCLU_KEYCACHE_ECC, priv,
+                wc_ecc_get_curve_id(key.idx), id, part, partSz,
+                wolfCLU_KeyCacheNumParts(WOLFCLU_KEYCACHE_ECC, priv), entry);
+    }
+    else {
+        WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode ECC key.\nRET: %d", ret);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    wolfCLU_ForceZero(buf, sizeof(buf));
+    wc_ecc_free(&key);
+    return ret;
+}
+#endif /* HAVE_ECC */
+
+
+#ifdef HAVE_ED25519
+/* the key file is already raw, the private key followed by the public */
+static int wolfCLU_KeyCacheAddEd25519(const byte* id, const byte* raw,
+        word32 rawSz, int priv, const byte** entry)
+{
+    byte*  part[2];
+    word32 partSz[2] = { ED25519_PUB_KEY_SIZE, ED25519_KEY_SIZE };
+
+    if (rawSz < (word32)(priv? ED25519_PRV_KEY_SIZE : ED25519_PUB_KEY_SIZE)) {
+        WOLFCLU_LOG(WOLFCLU_E0, "ED25519 key file is too short");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    part[0] = (byte*)(priv? raw + ED25519_KEY_SIZE : raw);
+    part[1] = (byte*)raw;
+
+    return wolfCLU_KeyCacheAppend(WOLFCLU_KEYCACHE_ED25519, priv, 0, id, part,
+            partSz, wolfCLU_KeyCacheNumParts(WOLFCLU_KEYCACHE_ED25519, priv),
+            entry);
+}
+#endif /* HAVE_ED25519 */
+
+
+/* imports the key in entry into key
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheImport(const byte* entry, void* key)
+{
+    const byte* part[KEYCACHE_MAX_PARTS];
+    word32 partSz[KEYCACHE_MAX_PARTS];
+    int    priv = entry[5];
+    int    ret  = WOLFCLU_FATAL_ERROR;
+
+    if (wolfCLU_KeyCacheParts(entry, part, partSz) < 0) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    switch (entry[4]) {
+    #ifndef NO_RSA
+        case WOLFCLU_KEYCACHE_RSA:
+            if (priv) {
+                ret = wc_RsaPrivateKeyDecodeRaw(part[0], partSz[0], part[1],
+                        partSz[1], part[2], partSz[2], part[7], partSz[7],
+                        part[3], partSz[3], part[4], partSz[4], part[5],
+                        partSz[5], part[6], partSz[6], (RsaKey*)key);
+            }
+            else {
+                ret = wc_RsaPublicKeyDecodeRaw(part[0], partSz[0], part[1],
+                        partSz[1], (RsaKey*)key);
+            }
+            break;
+    #endif
+    #ifdef HAVE_ECC
+        case WOLFCLU_KEYCACHE_ECC:
+            ret = wc_ecc_import_unsigned((ecc_key*)key, part[0], part[1],
+                    priv? part[2] : NULL,
+                    ((int)entry[6] << 8) | entry[7]);
+            break;
+    #endif
+    #ifdef HAVE_ED25519
+        case WOLFCLU_KEYCACHE_ED25519:
+            if (priv) {
+                ret = wc_ed25519_import_private_key(part[1], partSz[1],
+                        part[0], partSz[0], (ed25519_key*)key);
+            }
+            else {
+                ret = wc_ed25519_import_public(part[0], partSz[0],
+                        (ed25519_key*)key);
+            }
+            break;
+    #endif
+        default:
+            break;
+    }
+
+    if (ret != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Failed to load key from key cache.\nRET: %d",
+                ret);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+int wolfCLU_KeyCacheLoad(const char* keyFile, int type, int priv, void* key)
+{
+    const byte* entry = NULL;
+    byte   id[KEYCACHE_ID_SZ];
+    byte*  buf = NULL;
+    word32 bufSz = 0;
+    int    ret;
+
+    if (!keyCache.on || keyFile == NULL || key == NULL ||
+            wolfCLU_KeyCacheNumParts(type, priv) == 0) {
+        return BAD_FUNC_ARG;
+    }
+    priv = (priv != 0);
+
+    ret = wolfCLU_KeyCacheReadFile(keyFile, &buf, &bufSz);
+    if (ret == WOLFCLU_SUCCESS && wc_Sha256Hash(buf, bufSz, id) != 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        entry = wolfCLU_KeyCacheFind(keyCache.entries, keyCache.entriesSz,
+                type, priv, id);
+        if (entry == NULL) {
+            entry = wolfCLU_KeyCacheFind(keyCache.add, keyCache.addSz, type,
+                    priv, id);
+        }
+    }
+
+    /* not seen before, decoded this once */
+    if (ret == WOLFCLU_SUCCESS && entry == NULL) {
+        switch (type) {
+        #ifndef NO_RSA
+            case WOLFCLU_KEYCACHE_RSA:
+                ret = wolfCLU_KeyCacheAddRsa(id, buf, bufSz, priv, &entry);
+                break;
+        #endif
+        #ifdef HAVE_ECC
+            case WOLFCLU_KEYCACHE_ECC:
+                ret = wolfCLU_KeyCacheAddEcc(id, buf, bufSz, priv, &entry);
+                break;
+        #endif
+        #ifdef HAVE_ED25519
+            case WOLFCLU_KEYCACHE_ED25519:
+                ret = wolfCLU_KeyCacheAddEd25519(id, buf, bufSz, priv,
+                        &entry);
+                break;
+        #endif
+            default:
+                ret = NOT_COMPILED_IN;
+        }
+    }
+
+    if (buf != NULL) {
+        wolfCLU_ForceZero(buf, bufSz);
+        XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_KeyCacheImport(entry, key);
+    }
+    return ret;
+}
+
+
+/* writes the sz bytes of out to a file only the owner can read, then moves
+ * it over the cache so that a reader never sees it half written. Each writer
+ * gets its own temporary file, when threads or processes write the same
+ * cache the last one to finish is kept
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheWriteFile(const byte* out, word32 sz)
+{
+    char*  tmp;
+    word32 tmpSz = (word32)XSTRLEN(keyCache.path) + 8;
+    int    ret = WOLFCLU_SUCCESS;
+
+    tmp = (char*)XMALLOC(tmpSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (tmp == NULL) {
+        return MEMORY_E;
+    }
+
+#if !defined(USE_WINDOWS_API)
+    {
+        word32 idx = 0;
+        int fd;
+
+        /* mkstemp creates the file only readable by its owner */
+        XSNPRINTF(tmp, tmpSz, "%s.XXXXXX", keyCache.path);
+        fd = mkstemp(tmp);
+        if (fd < 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        while (ret == WOLFCLU_SUCCESS && idx < sz) {
+            ssize_t w = write(fd, out + idx, sz - idx);
+            if (w <= 0) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            else {
+                idx += (word32)w;
+            }
+        }
+        if (fd >= 0) {
+            if (ret == WOLFCLU_SUCCESS && fsync(fd) != 0) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            close(fd);
+        }
+    }
+#else
+    {
+        XFILE f;
+
+        XSNPRINTF(tmp, tmpSz, "%s.tmp", keyCache.path);
+        f = XFOPEN(tmp, "wb");
+
+        if (f == NULL) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            if (XFWRITE(out, 1, sz, f) != sz) {
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            XFCLOSE(f);
+        }
+        if (ret == WOLFCLU_SUCCESS) {
+            remove(keyCache.path);
+        }
+    }
+#endif
+
+    if (ret == WOLFCLU_SUCCESS && rename(tmp, keyCache.path) != 0) {
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    if (ret != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to write key cache %s",
+                keyCache.path);
+        remove(tmp);
+    }
+    XFREE(tmp, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+
+/* writes the cache out with the entries added, keeping the newest
+ * WOLFCLU_KEYCACHE_MAX
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_KeyCacheWrite(void)
+{
+    const byte* old = keyCache.entries;
+    const byte* add = keyCache.add;
+    word32 oldSz = keyCache.entriesSz;
+    word32 addSz = keyCache.addSz;
+    word32 oldN  = keyCache.count;
+    word32 addN  = keyCache.addCount;
+    word32 drop;
+    word32 sz;
+    byte*  out;
+    int    ret;
+
+    if (oldN + addN > WOLFCLU_KEYCACHE_MAX) {
+        drop = oldN + addN - WOLFCLU_KEYCACHE_MAX;
+        if (drop > oldN) {
+            drop -= oldN;
+            oldN  = oldSz = 0;
+            sz    = wolfCLU_KeyCacheSpan(add, drop);
+            add   += sz;
+            addSz -= sz;
+            addN  -= drop;
+        }
+        else {
+            sz     = wolfCLU_KeyCacheSpan(old, drop);
+            old   += sz;
+            oldSz -= sz;
+            oldN  -= drop;
+        }
+    }
+
+    sz  = KEYCACHE_HDR_SZ + oldSz + addSz + KEYCACHE_TAG_SZ;
+    out = (byte*)XMALLOC(sz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (out == NULL) {
+        return MEMORY_E;
+    }
+
+    XMEMCPY(out, keyCacheMagic, KEYCACHE_MAGIC_SZ);
+    XMEMCPY(out + KEYCACHE_MAGIC_SZ, keyCache.salt, KEYCACHE_SALT_SZ);
+    wolfCLU_KeyCachePut32(out + KEYCACHE_COUNT_OFF, oldN + addN);
+    if (oldSz > 0) {
+        XMEMCPY(out + KEYCACHE_HDR_SZ, old, oldSz);
+    }
+    XMEMCPY(out + KEYCACHE_HDR_SZ + oldSz, add, addSz);
+
+    ret = wolfCLU_KeyCacheMac(keyCache.macKey, sizeof(keyCache.macKey), out,
+            sz - KEYCACHE_TAG_SZ, out + sz - KEYCACHE_TAG_SZ);
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_KeyCacheWriteFile(out, sz);
+    }
+
+    wolfCLU_ForceZero(out, sz);
+    XFREE(out, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+
+int wolfCLU_KeyCacheClose(void)
+{
+    int ret = WOLFCLU_SUCCESS;
+
+    if (!keyCache.on) {
+        return WOLFCLU_SUCCESS;
+    }
+
+    if (keyCache.addCount > 0) {
+        ret = wolfCLU_KeyCacheWrite();
+    }
+
+    if (keyCache.file != NULL) {
+        wolfCLU_ForceZero(keyCache.file, keyCache.fileSz);
+        XFREE(keyCache.file, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    if (keyCache.add != NULL) {
+        wolfCLU_ForceZero(keyCache.add, keyCache.addSz);
+        XFREE(keyCache.add, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    if (keyCache.path != NULL) {
+        XFREE(keyCache.path, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    wolfCLU_ForceZero(&keyCache, sizeof(keyCache));
+    return ret;
+}
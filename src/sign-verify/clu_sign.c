@@ -22,6 +22,7 @@
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
 #include <wolfclu/sign-verify/clu_sign.h>
+#include <wolfclu/sign-verify/clu_keycache.h>
 
 int wolfCLU_sign_data(char* in, char* out, char* privKey, int keyType)
 {
@@ -97,30 +98,40 @@ int wolfCLU_sign_data_rsa(byte* data, char* out, word32 dataSz, char* privKey)
         return ret;
     }
 
-    /* read in and store private key */
-    privKeyFile = XFOPEN(privKey, "rb");
-    if (privKeyFile == NULL) {
-        WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", privKey);
-        return BAD_FUNC_ARG;
+    if (wolfCLU_KeyCacheOn()) {
+        /* already decoded, from the key cache */
+        ret = wolfCLU_KeyCacheLoad(privKey, WOLFCLU_KEYCACHE_RSA, 1, &key);
+        if (ret != WOLFCLU_SUCCESS) {
+            wc_FreeRsaKey(&key);
+            return ret;
+        }
     }
-
-    XFSEEK(privKeyFile, 0, SEEK_END);
-    privFileSz = (int)XFTELL(privKeyFile);
-    keyBuf = (byte*)XMALLOC(privFileSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-    if (keyBuf == NULL) {
+    else {
+        /* read in and store private key */
+        privKeyFile = XFOPEN(privKey, "rb");
+        if (privKeyFile == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", privKey);
+            return BAD_FUNC_ARG;
+        }
+
+        XFSEEK(privKeyFile, 0, SEEK_END);
+        privFileSz = (int)XFTELL(privKeyFile);
+        keyBuf = (byte*)XMALLOC(privFileSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (keyBuf == NULL) {
+            XFCLOSE(privKeyFile);
+            return MEMORY_E;
+        }
+        XFSEEK(privKeyFile, 0, SEEK_SET);
+        XFREAD(keyBuf, 1, privFileSz, privKeyFile);
         XFCLOSE(privKeyFile);
-        return MEMORY_E;
-    }
-    XFSEEK(privKeyFile, 0, SEEK_SET);
-    XFREAD(keyBuf, 1, privFileSz, privKeyFile);
-    XFCLOSE(privKeyFile);
 
-    /* retrieving private key and storing in the RsaKey */
-    ret = wc_RsaPrivateKeyDecode(keyBuf, &index, &key, privFileSz);
-    XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-    if (ret != 0 ) {
-        WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode private key.\nRET: %d", ret);
-        return ret;
+        /* retrieving private key and storing in the RsaKey */
+        ret = wc_RsaPrivateKeyDecode(keyBuf, &index, &key, privFileSz);
+        XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (ret != 0 ) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode private key.\nRET: %d", ret);
+            return ret;
+        }
     }
 
     /* setting up output buffer based on key size */
@@ -207,32 +218,43 @@ int wolfCLU_sign_data_ecc(byte* data, char* out, word32 fSz, char* privKey)
         return ret;
     }
 
-    /* read in and store private key */
-    privKeyFile = XFOPEN(privKey, "rb");
-    if (privKeyFile == NULL) {
-        WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", privKey);
-        wc_FreeRng(&rng);
-        return BAD_FUNC_ARG;
-    }
-
-    XFSEEK(privKeyFile, 0, SEEK_END);
-    privFileSz = (int)XFTELL(privKeyFile);
-    keyBuf = (byte*)XMALLOC(privFileSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-    if (keyBuf == NULL) {
-        wc_FreeRng(&rng);
-        return MEMORY_E;
+    if (wolfCLU_KeyCacheOn()) {
+        /* already decoded, from the key cache */
+        ret = wolfCLU_KeyCacheLoad(privKey, WOLFCLU_KEYCACHE_ECC, 1, &key);
+        if (ret != WOLFCLU_SUCCESS) {
+            wc_ecc_free(&key);
+            wc_FreeRng(&rng);
+            return ret;
+        }
     }
-    XFSEEK(privKeyFile, 0, SEEK_SET);
-    XFREAD(keyBuf, 1, privFileSz, privKeyFile);
-    XFCLOSE(privKeyFile);
+    else {
+        /* read in and store private key */
+        privKeyFile = XFOPEN(privKey, "rb");
+        if (privKeyFile == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", privKey);
+            wc_FreeRng(&rng);
+            return BAD_FUNC_ARG;
+        }
+
+        XFSEEK(privKeyFile, 0, SEEK_END);
+        privFileSz = (int)XFTELL(privKeyFile);
+        keyBuf = (byte*)XMALLOC(privFileSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (keyBuf == NULL) {
+            wc_FreeRng(&rng);
+            return MEMORY_E;
+        }
+        XFSEEK(privKeyFile, 0, SEEK_SET);
+        XFREAD(keyBuf, 1, privFileSz, privKeyFile);
+        XFCLOSE(privKeyFile);
 
-    /* retrieving private key and storing in the Ecc Key */
-    ret = wc_EccPrivateKeyDecode(keyBuf, &index, &key, privFileSz);
-    XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-    if (ret != 0 ) {
-        WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode private key.\nRET: %d", ret);
-        wc_FreeRng(&rng);
-        return ret;
+        /* retrieving private key and storing in the Ecc Key */
+        ret = wc_EccPrivateKeyDecode(keyBuf, &index, &key, privFileSz);
+        XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (ret != 0 ) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode private key.\nRET: %d", ret);
+            wc_FreeRng(&rng);
+            return ret;
+        }
     }
 
     /* setting up output buffer based on key size */
@@ -301,36 +323,46 @@ int wolfCLU_sign_data_ed25519 (byte* data, char* out, word32 fSz, char* privKey)
         return ret;
     }
 
-    /* read in and store private key */
-    privKeyFile = XFOPEN(privKey, "rb");
-    if (privKeyFile == NULL) {
-        WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", privKey);
-        wc_FreeRng(&rng);
-        return BAD_FUNC_ARG;
+    if (wolfCLU_KeyCacheOn()) {
+        ret = wolfCLU_KeyCacheLoad(privKey, WOLFCLU_KEYCACHE_ED25519, 1, &key);
+        if (ret != WOLFCLU_SUCCESS) {
+            wc_ed25519_free(&key);
+            wc_FreeRng(&rng);
+            return ret;
+        }
     }
-
-    XFSEEK(privKeyFile, 0, SEEK_END);
-    privFileSz = (int)XFTELL(privKeyFile);
-    keyBuf = (byte*)XMALLOC(privFileSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-    if (keyBuf == NULL) {
+    else {
+        /* read in and store private key */
+        privKeyFile = XFOPEN(privKey, "rb");
+        if (privKeyFile == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", privKey);
+            wc_FreeRng(&rng);
+            return BAD_FUNC_ARG;
+        }
+
+        XFSEEK(privKeyFile, 0, SEEK_END);
+        privFileSz = (int)XFTELL(privKeyFile);
+        keyBuf = (byte*)XMALLOC(privFileSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (keyBuf == NULL) {
+            XFCLOSE(privKeyFile);
+            wc_FreeRng(&rng);
+            return MEMORY_E;
+        }
+        XFSEEK(privKeyFile, 0, SEEK_SET);
+        XFREAD(keyBuf, 1, privFileSz, privKeyFile);
         XFCLOSE(privKeyFile);
-        wc_FreeRng(&rng);
-        return MEMORY_E;
-    }
-    XFSEEK(privKeyFile, 0, SEEK_SET);
-    XFREAD(keyBuf, 1, privFileSz, privKeyFile);
-    XFCLOSE(privKeyFile);
-
-    /* retrieving private key and storing in the ED25519 Key */
-    ret = wc_ed25519_import_private_key(keyBuf,
-                                    ED25519_KEY_SIZE,
-                                    keyBuf + ED25519_KEY_SIZE,
-                                    ED25519_KEY_SIZE, &key);
-    XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-    if (ret != 0 ) {
-        WOLFCLU_LOG(WOLFCLU_E0, "Failed to import private key.\nRET: %d", ret);
-        wc_FreeRng(&rng);
-        return ret;
+
+        /* retrieving private key and storing in the ED25519 Key */
+        ret = wc_ed25519_import_private_key(keyBuf,
+                                        ED25519_KEY_SIZE,
+                                        keyBuf + ED25519_KEY_SIZE,
+                                        ED25519_KEY_SIZE, &key);
+        XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (ret != 0 ) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Failed to import private key.\nRET: %d", ret);
+            wc_FreeRng(&rng);
+            return ret;
+        }
     }
 
     /* setting up output buffer based on key size */
@@ -366,3 +398,188 @@ int wolfCLU_sign_data_ed25519 (byte* data, char* out, word32 fSz, char* privKey)
     return NOT_COMPILED_IN;
 #endif
 }
+
+
+#ifdef HAVE_ED25519
+/* reads the raw private key file, the private key followed by the public */
+static int wolfCLU_ed25519_load_private(const char* path, ed25519_key* key)
+{
+    byte  keyBuf[ED25519_PRV_KEY_SIZE];
+    XFILE f;
+    int   ret;
+
+    if (wolfCLU_KeyCacheOn()) {
+        return (wolfCLU_KeyCacheLoad(path, WOLFCLU_KEYCACHE_ED25519, 1, key)
+                == WOLFCLU_SUCCESS)? 0 : WOLFCLU_FATAL_ERROR;
+    }
+
+    f = XFOPEN(path, "rb");
+    if (f == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", path);
+        return BAD_FUNC_ARG;
+    }
+    if (XFREAD(keyBuf, 1, sizeof(keyBuf), f) != sizeof(keyBuf)) {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to read ED25519 private key %s",
+                path);
+        XFCLOSE(f);
+        return BAD_FUNC_ARG;
+    }
+    XFCLOSE(f);
+
+    ret = wc_ed25519_import_private_key(keyBuf, ED25519_KEY_SIZE,
+            keyBuf + ED25519_KEY_SIZE, ED25519_PUB_KEY_SIZE, key);
+    wolfCLU_ForceZero(keyBuf, sizeof(keyBuf));
+    if (ret != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Failed to import private key.\nRET: %d", ret);
+    }
+    return ret;
+}
+#endif
+
+
+int wolfCLU_ed25519_input(const char* in, int ph, byte* hash, byte** data,
+        word32* dataSz)
+{
+    wc_HashAlg sha;
+    XFILE  f;
+    byte*  buf = NULL;
+    size_t sz;
+    long   fSz = -1;
+    int    ret = 0;
+
+    f = XFOPEN(in, "rb");
+    if (f == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", in);
+        return BAD_FUNC_ARG;
+    }
+
+    if (ph) {
+        buf = (byte*)XMALLOC(MEGABYTE, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (buf == NULL) {
+            XFCLOSE(f);
+            return MEMORY_E;
+        }
+
+        ret = wc_HashInit(&sha, WC_HASH_TYPE_SHA512);
+        while (ret == 0 && (sz = XFREAD(buf, 1, MEGABYTE, f)) > 0) {
+            ret = wc_HashUpdate(&sha, WC_HASH_TYPE_SHA512, buf, (word32)sz);
+        }
+        if (ret == 0 && ferror(f)) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        if (ret == 0) {
+            ret = wc_HashFinal(&sha, WC_HASH_TYPE_SHA512, hash);
+        }
+        wc_HashFree(&sha, WC_HASH_TYPE_SHA512);
+        XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    else {
+        if (XFSEEK(f, 0, SEEK_END) == 0) {
+            fSz = XFTELL(f);
+        }
+        if (fSz < 0 || XFSEEK(f, 0, SEEK_SET) != 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        if (ret == 0) {
+            /* one more byte so that an empty file is not a zero size malloc */
+            buf = (byte*)XMALLOC(fSz + 1, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+            if (buf == NULL) {
+                ret = MEMORY_E;
+            }
+        }
+        if (ret == 0 && XFREAD(buf, 1, fSz, f) != (size_t)fSz) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        if (ret == 0) {
+            *data   = buf;
+            *dataSz = (word32)fSz;
+        }
+        else {
+            XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        }
+    }
+    XFCLOSE(f);
+
+    if (ret != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Error reading %s", in);
+    }
+    return ret;
+}
+
+
+int wolfCLU_sign_data_ed25519ex(char* in, char* out, char* privKey, int ph,
+        const byte* ctx, byte ctxSz)
+{
+#ifdef HAVE_ED25519
+    ed25519_key key;
+    byte   hash[WC_SHA512_DIGEST_SIZE];
+    byte   sig[ED25519_SIG_SIZE];
+    word32 sigSz = sizeof(sig);
+    byte*  data = NULL;
+    word32 dataSz = 0;
+    XFILE  s;
+    int    ret;
+
+    if (out == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Please specify an output file when signing "
+                "with ED25519.");
+        return BAD_FUNC_ARG;
+    }
+
+    ret = wc_ed25519_init(&key);
+    if (ret != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Failed to initialize ed25519 key\nRET: %d",
+                ret);
+        return ret;
+    }
+
+    ret = wolfCLU_ed25519_load_private(privKey, &key);
+    if (ret == 0) {
+        ret = wolfCLU_ed25519_input(in, ph, hash, &data, &dataSz);
+    }
+
+    if (ret == 0) {
+        if (ph) {
+            ret = wc_ed25519ph_sign_hash(hash, sizeof(hash), sig, &sigSz,
+                    &key, ctx, ctxSz);
+        }
+        else {
+            ret = wc_ed25519ctx_sign_msg(data, dataSz, sig, &sigSz, &key,
+                    ctx, ctxSz);
+        }
+        if (ret != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Failed to sign data with ED25519 private "
+                    "key.\nRET: %d", ret);
+        }
+    }
+
+    if (ret == 0) {
+        s = XFOPEN(out, "wb");
+        if (s == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", out);
+            ret = BAD_FUNC_ARG;
+        }
+        else {
+            if (XFWRITE(sig, 1, sigSz, s) != sigSz) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Error writing out signature");
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            XFCLOSE(s);
+        }
+    }
+
+    if (data != NULL) {
+        XFREE(data, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    wc_ed25519_free(&key);
+    return (ret == 0)? WOLFCLU_SUCCESS : ret;
+#else
+    (void)in;
+    (void)out;
+    (void)privKey;
+    (void)ph;
+    (void)ctx;
+    (void)ctxSz;
+    return NOT_COMPILED_IN;
+#endif
+}
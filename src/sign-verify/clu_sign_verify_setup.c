@@ -23,6 +23,7 @@
 #include <wolfclu/clu_log.h>
 #include <wolfclu/sign-verify/clu_sign.h>
 #include <wolfclu/sign-verify/clu_verify.h>
+#include <wolfclu/sign-verify/clu_keycache.h>
 #include <wolfclu/sign-verify/clu_sign_verify_setup.h>
 
 int wolfCLU_sign_verify_setup(int argc, char** argv)
@@ -32,12 +33,16 @@ int wolfCLU_sign_verify_setup(int argc, char** argv)
     char*   out  = NULL; /* output variable */
     char*   priv = NULL; /* private key variable */
     char*   sig  = NULL;
+    char*   ctx  = NULL; /* Ed25519ph and Ed25519ctx context */
+    char*   keyCache     = NULL;
+    char*   keyCachePass = NULL;
 
     int     algCheck;           /* acceptable algorithm check */
     int     inCheck     = 0;    /* input check */
     int     signCheck   = 0;
     int     verifyCheck = 0;
     int     pubInCheck  = 0;
+    int     phCheck     = 0;
 
     if (wolfCLU_checkForArg("-rsa", 4, argc, argv) > 0) {
         algCheck = RSA_SIG_VER;
@@ -110,6 +115,35 @@ int wolfCLU_sign_verify_setup(int argc, char** argv)
         pubInCheck = 1;
     }
 
+    ret = wolfCLU_checkForArg("-ph", 3, argc, argv);
+    if (ret > 0) {
+        /* sign the SHA-512 hash of the input, Ed25519ph */
+        phCheck = 1;
+    }
+
+    ret = wolfCLU_checkForArg("-context", 8, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        ctx = argv[ret+1];
+    }
+
+    if ((phCheck == 1 || ctx != NULL) && (algCheck != ED25519_SIG_VER ||
+                (ctx != NULL && XSTRLEN(ctx) > WOLFCLU_ED25519_MAX_CTX))) {
+        WOLFCLU_LOG(WOLFCLU_E0, "-ph and -context, of at most %d bytes, are "
+                "only for -ed25519", WOLFCLU_ED25519_MAX_CTX);
+        XFREE(priv, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    ret = wolfCLU_checkForArg("-keycache", 9, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        keyCache = argv[ret+1];
+    }
+
+    ret = wolfCLU_checkForArg("-keycachepass", 13, argc, argv);
+    if (ret > 0 && ret + 1 < argc) {
+        keyCachePass = argv[ret+1];
+    }
+
     ret = wolfCLU_checkForArg("-in", 3, argc, argv);
     if (ret > 0) {
         /* input file/text */
@@ -222,13 +256,53 @@ int wolfCLU_sign_verify_setup(int argc, char** argv)
         }
     }
 
-    if (signCheck == 1) {
+    /* keys are loaded from the cache instead of decoded */
+    if (keyCache != NULL) {
+        char password[MAX_PASSWORD_SIZE];
+        int  passwordSz = MAX_PASSWORD_SIZE;
+
+        if (keyCachePass == NULL || wolfCLU_GetPassword(password, &passwordSz,
+                    keyCachePass) != WOLFCLU_SUCCESS || passwordSz == 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "-keycache needs a password with "
+                    "-keycachepass <stdin|pass:password>");
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        else {
+            ret = wolfCLU_KeyCacheOpen(keyCache, password, passwordSz);
+        }
+        wolfCLU_ForceZero(password, sizeof(password));
+        if (ret != WOLFCLU_SUCCESS) {
+            if (priv)
+                XFREE(priv, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+            if (in)
+                XFREE(in, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+            if (sig)
+                XFREE(sig, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (signCheck == 1 && (phCheck == 1 || ctx != NULL)) {
+        ret = wolfCLU_sign_data_ed25519ex(in, out, priv, phCheck,
+                (const byte*)ctx, (byte)((ctx != NULL)? XSTRLEN(ctx) : 0));
+    }
+    else if (verifyCheck == 1 && (phCheck == 1 || ctx != NULL)) {
+        ret = wolfCLU_verify_signature_ed25519ex(sig, in, priv, pubInCheck,
+                phCheck, (const byte*)ctx,
+                (byte)((ctx != NULL)? XSTRLEN(ctx) : 0));
+    }
+    else if (signCheck == 1) {
         ret = wolfCLU_sign_data(in, out, priv, algCheck);
     }
     else if (verifyCheck == 1) {
         ret = wolfCLU_verify_signature(sig, in, out, priv, algCheck, pubInCheck);
     }
 
+    /* a failure to write the cache out does not undo the signature */
+    if (keyCache != NULL) {
+        wolfCLU_KeyCacheClose();
+    }
+
     if (priv)
         XFREE(priv, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
     if (in)
@@ -0,0 +1,932 @@
+/* clu_signd.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_optargs.h>
+#include <wolfclu/clu_cache.h>
+#include <wolfclu/pkey/clu_pkey.h>
+#include <wolfclu/sign-verify/clu_signd.h>
+#include <wolfclu/sign-verify/clu_ecc_pool.h>
+
+#ifdef WOLFCLU_HAVE_SIGND
+    #include <pthread.h>
+    #include <signal.h>
+    #include <errno.h>
+    #include <unistd.h>
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+
+    #ifndef MSG_NOSIGNAL
+        #define MSG_NOSIGNAL 0 /* SIGPIPE is ignored by the server instead */
+    #endif
+#endif
+
+/* number of workers when -threads is not given */
+#define WOLFCLU_SIGND_THREADS 4
+
+/* connections accepted but not yet picked up by a worker */
+#define WOLFCLU_SIGND_BACKLOG 64
+
+/* largest request, the header and a SHA-512 hash */
+#define WOLFCLU_SIGND_MAX_REQ (WOLFCLU_SIGND_REQ_HDR + WC_MAX_DIGEST_SIZE)
+
+/* key type for a raw Ed25519 key as written by genkey */
+#define WOLFCLU_SIGND_ED25519 (-1)
+
+static const struct option signd_options[] = {
+    {"key",     required_argument, 0, WOLFCLU_KEY    },
+    {"socket",  required_argument, 0, WOLFCLU_SOCKET },
+    {"threads", required_argument, 0, WOLFCLU_THREADS},
+    {"nonces",  required_argument, 0, WOLFCLU_NONCES },
+    {"help",    no_argument,       0, WOLFCLU_HELP   },
+    {"h",       no_argument,       0, WOLFCLU_HELP   },
+
+    {0, 0, 0, 0} /* terminal element */
+};
+
+static void wolfCLU_SignDHelp(void)
+{
+    WOLFCLU_LOG(WOLFCLU_L0, "wolfssl signd -socket <path> -key <file> "
+            "[-key <file> ...] [-threads <n>] [-nonces <n>]");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-socket Unix domain socket to listen on, only"
+            " the current user can connect");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-key    PEM RSA or ECC private key, or a raw"
+            " Ed25519 key from genkey. Keys are numbered from 0");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-threads <n> number of connections served at"
+            " once, default %d", WOLFCLU_SIGND_THREADS);
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-nonces <n> ECDSA nonces computed ahead for"
+            " each ECC key, default %d, 0 for none", WOLFCLU_ECC_POOL_SIZE);
+    WOLFCLU_LOG(WOLFCLU_L0, "Runs until interrupted. Sign with:");
+    WOLFCLU_LOG(WOLFCLU_L0, "\twolfssl dgst -sha256 -signd <path> [-keyid <n>]"
+            " -out file.sig file");
+}
+
+
+#ifdef WOLFCLU_HAVE_SIGND
+
+/* a key as loaded from its file, decoded again by each worker */
+typedef struct WOLFCLU_SIGND_KEYFILE {
+    int    type;    /* EVP_PKEY_RSA, EVP_PKEY_EC or WOLFCLU_SIGND_ED25519 */
+    byte*  der;     /* DER private key, or the 64 byte raw Ed25519 key */
+    word32 derSz;
+    WOLFCLU_ECC_POOL* pool; /* nonces for an ECC key, shared by workers */
+} WOLFCLU_SIGND_KEYFILE;
+
+/* a worker's own copy of a key, so that signing needs no locking */
+typedef struct WOLFCLU_SIGND_KEY {
+    union {
+    #ifndef NO_RSA
+        RsaKey rsa;
+    #endif
+    #ifdef HAVE_ECC
+        ecc_key ecc;
+    #endif
+    #ifdef HAVE_ED25519
+        ed25519_key ed;
+    #endif
+        byte unused;
+    } k;
+    int init;
+} WOLFCLU_SIGND_KEY;
+
+struct WOLFCLU_SIGND_STATE;
+
+typedef struct WOLFCLU_SIGND_WORKER {
+    pthread_t tid;
+    WC_RNG    rng;
+    int       rngInit;
+    int       started;
+    int       fd;       /* connection being served, -1 if none */
+    WOLFCLU_SIGND_KEY keys[WOLFCLU_SIGND_MAX_KEYS];
+    struct WOLFCLU_SIGND_STATE* d;
+} WOLFCLU_SIGND_WORKER;
+
+typedef struct WOLFCLU_SIGND_STATE {
+    WOLFCLU_SIGND_KEYFILE keys[WOLFCLU_SIGND_MAX_KEYS];
+    int keyCount;
+
+    /* accepted connections waiting for a worker */
+    int queue[WOLFCLU_SIGND_BACKLOG];
+    int qHead;
+    int qCount;
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+
+    WOLFCLU_SIGND_WORKER* workers;
+    int threads;
+    int nonces;     /* size of each ECC key's nonce pool */
+} WOLFCLU_SIGND_STATE;
+
+static volatile sig_atomic_t signdStop = 0;
+
+static void wolfCLU_SignDSignal(int sig)
+{
+    (void)sig;
+    signdStop = 1;
+}
+
+
+/* reads or writes all sz bytes, carrying on after signals
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_SignDIo(int fd, byte* buf, word32 sz, int writing)
+{
+    ssize_t n;
+
+    while (sz > 0) {
+        if (writing) {
+            n = send(fd, buf, sz, MSG_NOSIGNAL);
+        }
+        else {
+            n = recv(fd, buf, sz, 0);
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+        buf += n;
+        sz  -= (word32)n;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* sends one length prefixed message
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_SignDSend(int fd, byte* msg, word32 msgSz)
+{
+    byte len[4];
+
+    len[0] = (byte)(msgSz >> 24);
+    len[1] = (byte)(msgSz >> 16);
+    len[2] = (byte)(msgSz >> 8);
+    len[3] = (byte)msgSz;
+    if (wolfCLU_SignDIo(fd, len, sizeof(len), 1) != WOLFCLU_SUCCESS) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    return wolfCLU_SignDIo(fd, msg, msgSz, 1);
+}
+
+
+/* reads one length prefixed message of at most maxSz bytes
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_SignDRecv(int fd, byte* msg, word32 maxSz, word32* msgSz)
+{
+    byte len[4];
+
+    if (wolfCLU_SignDIo(fd, len, sizeof(len), 0) != WOLFCLU_SUCCESS) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    *msgSz = ((word32)len[0] << 24) | ((word32)len[1] << 16) |
+             ((word32)len[2] << 8)  |  (word32)len[3];
+    if (*msgSz > maxSz) {
+        return BUFFER_E;
+    }
+    return wolfCLU_SignDIo(fd, msg, *msgSz, 0);
+}
+
+
+/* loads path as a PEM private key, or a raw Ed25519 key from genkey
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_SignDLoadKey(WOLFCLU_SIGND_KEYFILE* kf, const char* path)
+{
+    WOLFSSL_EVP_PKEY* pkey;
+    int ret = WOLFCLU_SUCCESS;
+    int derSz;
+
+    pkey = wolfCLU_LoadPrivateKey(path);
+    if (pkey != NULL) {
+        kf->type = wolfSSL_EVP_PKEY_id(pkey);
+        if (kf->type != EVP_PKEY_RSA && kf->type != EVP_PKEY_EC) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Key type of %s is not supported", path);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+        if (ret == WOLFCLU_SUCCESS) {
+            derSz = wolfCLU_pKeytoPriKey(pkey, &kf->der);
+            if (derSz <= 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Unable to extract der key");
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+            else {
+                kf->derSz = (word32)derSz;
+            }
+        }
+        wolfSSL_EVP_PKEY_free(pkey);
+        return ret;
+    }
+
+#ifdef HAVE_ED25519
+    {
+        XFILE f;
+        long  sz = -1;
+
+        f = XFOPEN(path, "rb");
+        if (f != XBADFILE) {
+            if (XFSEEK(f, 0, XSEEK_END) == 0) {
+                sz = XFTELL(f);
+            }
+            if (sz == ED25519_PRV_KEY_SIZE && XFSEEK(f, 0, XSEEK_SET) == 0) {
+                /* allocated as wolfCLU_pKeytoPriKey does, so either is freed
+                 * the same way */
+                kf->der = (byte*)XMALLOC(sz, NULL, DYNAMIC_TYPE_OPENSSL);
+                if (kf->der != NULL &&
+                        XFREAD(kf->der, 1, sz, f) == (size_t)sz) {
+                    kf->type  = WOLFCLU_SIGND_ED25519;
+                    kf->derSz = (word32)sz;
+                    XFCLOSE(f);
+                    return WOLFCLU_SUCCESS;
+                }
+                XFREE(kf->der, NULL, DYNAMIC_TYPE_OPENSSL);
+                kf->der = NULL;
+            }
+            XFCLOSE(f);
+        }
+    }
+#endif
+
+    WOLFCLU_LOG(WOLFCLU_E0, "Unable to load private key %s", path);
+    return WOLFCLU_FATAL_ERROR;
+}
+
+
+/* decodes kf into the worker's key k
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_SignDDecodeKey(WOLFCLU_SIGND_WORKER* w,
+        const WOLFCLU_SIGND_KEYFILE* kf, WOLFCLU_SIGND_KEY* k)
+{
+    word32 idx = 0;
+    int    ret = -1;
+
+    switch (kf->type) {
+    #ifndef NO_RSA
+        case EVP_PKEY_RSA:
+            if (wc_InitRsaKey(&k->k.rsa, HEAP_HINT) != 0) {
+                break;
+            }
+            k->init = 1;
+            ret = wc_RsaPrivateKeyDecode(kf->der, &idx, &k->k.rsa, kf->derSz);
+        #ifdef WC_RSA_BLINDING
+            if (ret == 0) {
+                ret = wc_RsaSetRNG(&k->k.rsa, &w->rng);
+            }
+        #endif
+            break;
+    #endif
+
+    #ifdef HAVE_ECC
+        case EVP_PKEY_EC:
+            if (wc_ecc_init(&k->k.ecc) != 0) {
+                break;
+            }
+            k->init = 1;
+            ret = wc_EccPrivateKeyDecode(kf->der, &idx, &k->k.ecc, kf->derSz);
+            break;
+    #endif
+
+    #ifdef HAVE_ED25519
+        case WOLFCLU_SIGND_ED25519:
+            if (wc_ed25519_init(&k->k.ed) != 0) {
+                break;
+            }
+            k->init = 1;
+            ret = wc_ed25519_import_private_key(kf->der, ED25519_KEY_SIZE,
+                    kf->der + ED25519_KEY_SIZE, ED25519_PUB_KEY_SIZE,
+                    &k->k.ed);
+            break;
+    #endif
+    }
+
+    (void)w;
+    (void)idx;
+    return (ret == 0)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+static void wolfCLU_SignDFreeKey(const WOLFCLU_SIGND_KEYFILE* kf,
+        WOLFCLU_SIGND_KEY* k)
+{
+    if (!k->init) {
+        return;
+    }
+    switch (kf->type) {
+    #ifndef NO_RSA
+        case EVP_PKEY_RSA:
+            wc_FreeRsaKey(&k->k.rsa);
+            break;
+    #endif
+    #ifdef HAVE_ECC
+        case EVP_PKEY_EC:
+            wc_ecc_free(&k->k.ecc);
+            break;
+    #endif
+    #ifdef HAVE_ED25519
+        case WOLFCLU_SIGND_ED25519:
+            wc_ed25519_free(&k->k.ed);
+            break;
+    #endif
+    }
+    k->init = 0;
+}
+
+
+/* signs the hash in req, writing the status and signature to resp
+ * returns the size of the response */
+static word32 wolfCLU_SignDHandle(WOLFCLU_SIGND_WORKER* w, const byte* req,
+        word32 reqSz, byte* resp)
+{
+    const WOLFCLU_SIGND_KEYFILE* kf;
+    WOLFCLU_SIGND_KEY* k;
+    enum wc_HashType hashType;
+    const byte* hash;
+    word32 hashSz;
+    word32 sigSz = WOLFCLU_SIGND_MAX_SIG;
+    byte*  sig   = resp + 1;
+    int    ret   = -1;
+
+    if (reqSz < WOLFCLU_SIGND_REQ_HDR || req[0] != WOLFCLU_SIGND_VERSION ||
+            req[1] != WOLFCLU_SIGND_OP_SIGN) {
+        resp[0] = WOLFCLU_SIGND_BAD_REQUEST;
+        return 1;
+    }
+    if (req[2] >= w->d->keyCount) {
+        resp[0] = WOLFCLU_SIGND_BAD_KEY;
+        return 1;
+    }
+    kf       = &w->d->keys[req[2]];
+    k        = &w->keys[req[2]];
+    hashType = (enum wc_HashType)req[3];
+    hash     = req + WOLFCLU_SIGND_REQ_HDR;
+    hashSz   = reqSz - WOLFCLU_SIGND_REQ_HDR;
+    if (hashType == WC_HASH_TYPE_NONE ||
+            wc_HashGetDigestSize(hashType) != (int)hashSz) {
+        resp[0] = WOLFCLU_SIGND_BAD_HASH;
+        return 1;
+    }
+
+    switch (kf->type) {
+    #ifndef NO_RSA
+        case EVP_PKEY_RSA:
+        {
+            /* RSA signs the DER encoded digest, which the *Hash API leaves
+             * to the caller */
+            byte   enc[WC_MAX_DIGEST_SIZE + 32];
+            word32 encSz;
+
+            encSz = wc_EncodeSignature(enc, hash, hashSz,
+                    wc_HashGetOID(hashType));
+            if (encSz > 0) {
+                ret = wc_SignatureGenerateHash(hashType,
+                        WC_SIGNATURE_TYPE_RSA_W_ENC, enc, encSz, sig, &sigSz,
+                        &k->k.rsa, sizeof(RsaKey), &w->rng);
+            }
+            break;
+        }
+    #endif
+    #ifdef HAVE_ECC
+        case EVP_PKEY_EC:
+            /* with a precomputed nonce only the arithmetic mod n is left,
+             * signing in full if the pool has run dry */
+            if (kf->pool != NULL && wolfCLU_EccPoolSign(kf->pool,
+                        &k->k.ecc, hash, hashSz, sig, &sigSz) ==
+                    WOLFCLU_SUCCESS) {
+                ret = 0;
+                break;
+            }
+            sigSz = WOLFCLU_SIGND_MAX_SIG;
+            ret = wc_SignatureGenerateHash(hashType, WC_SIGNATURE_TYPE_ECC,
+                    hash, hashSz, sig, &sigSz, &k->k.ecc, sizeof(ecc_key),
+                    &w->rng);
+            break;
+    #endif
+    #ifdef HAVE_ED25519
+        case WOLFCLU_SIGND_ED25519:
+            /* Ed25519ph, which signs a SHA-512 hash of the message */
+            if (hashType != WC_HASH_TYPE_SHA512) {
+                resp[0] = WOLFCLU_SIGND_BAD_HASH;
+                return 1;
+            }
+            ret = wc_ed25519ph_sign_hash(hash, hashSz, sig, &sigSz, &k->k.ed,
+                    NULL, 0);
+            break;
+    #endif
+    }
+
+    if (ret != 0) {
+        resp[0] = WOLFCLU_SIGND_SIGN_FAILED;
+        return 1;
+    }
+    resp[0] = WOLFCLU_SIGND_OK;
+    return 1 + sigSz;
+}
+
+
+/* answers requests on fd until the client closes it */
+static void wolfCLU_SignDServe(WOLFCLU_SIGND_WORKER* w, int fd)
+{
+    byte   req[WOLFCLU_SIGND_MAX_REQ];
+    byte   resp[1 + WOLFCLU_SIGND_MAX_SIG];
+    word32 reqSz;
+    word32 respSz;
+    int    ret;
+
+    for (;;) {
+        ret = wolfCLU_SignDRecv(fd, req, sizeof(req), &reqSz);
+        if (ret == BUFFER_E) {
+            /* the rest of the message can not be skipped reliably */
+            resp[0] = WOLFCLU_SIGND_BAD_REQUEST;
+            (void)wolfCLU_SignDSend(fd, resp, 1);
+            break;
+        }
+        if (ret != WOLFCLU_SUCCESS) {
+            break;
+        }
+
+        respSz = wolfCLU_SignDHandle(w, req, reqSz, resp);
+        if (wolfCLU_SignDSend(fd, resp, respSz) != WOLFCLU_SUCCESS) {
+            break;
+        }
+    }
+    wolfCLU_ForceZero(resp, sizeof(resp));
+}
+
+
+static void* wolfCLU_SignDWorker(void* arg)
+{
+    WOLFCLU_SIGND_WORKER* w = (WOLFCLU_SIGND_WORKER*)arg;
+    WOLFCLU_SIGND_STATE* d = w->d;
+    int fd;
+
+    for (;;) {
+        pthread_mutex_lock(&d->lock);
+        while (d->qCount == 0 && !d->stop) {
+            pthread_cond_wait(&d->cond, &d->lock);
+        }
+        if (d->stop) {
+            pthread_mutex_unlock(&d->lock);
+            break;
+        }
+        fd = d->queue[d->qHead];
+        d->qHead = (d->qHead + 1) % WOLFCLU_SIGND_BACKLOG;
+        d->qCount--;
+        w->fd = fd;
+        pthread_mutex_unlock(&d->lock);
+
+        wolfCLU_SignDServe(w, fd);
+
+        pthread_mutex_lock(&d->lock);
+        w->fd = -1;
+        pthread_mutex_unlock(&d->lock);
+        close(fd);
+    }
+    return NULL;
+}
+
+
+/* binds and listens on path, replacing a socket left by an earlier run
+ * returns the listening socket or -1 */
+static int wolfCLU_SignDListen(const char* path)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    mode_t old;
+    int fd;
+    int ret;
+
+    if (XSTRLEN(path) >= sizeof(addr.sun_path)) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Socket path %s is too long", path);
+        return -1;
+    }
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "%s exists and is not a socket", path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to create socket");
+        return -1;
+    }
+
+    XMEMSET(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    XMEMCPY(addr.sun_path, path, XSTRLEN(path) + 1);
+
+    /* only the owner may connect */
+    old = umask(0177);
+    ret = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(old);
+    if (ret != 0 || listen(fd, WOLFCLU_SIGND_BACKLOG) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to listen on %s", path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+
+/* accepts connections and hands them to the workers until signalled */
+static void wolfCLU_SignDAccept(WOLFCLU_SIGND_STATE* d, int listenFd)
+{
+    int fd;
+
+    while (!signdStop) {
+        fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno != EINTR && errno != ECONNABORTED) {
+                WOLFCLU_LOG(WOLFCLU_E0, "accept failed, errno %d", errno);
+                break;
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&d->lock);
+        if (d->qCount == WOLFCLU_SIGND_BACKLOG) {
+            pthread_mutex_unlock(&d->lock);
+            WOLFCLU_LOG(WOLFCLU_E0, "Too many waiting connections, closing"
+                    " one");
+            close(fd);
+            continue;
+        }
+        d->queue[(d->qHead + d->qCount) % WOLFCLU_SIGND_BACKLOG] = fd;
+        d->qCount++;
+        pthread_cond_signal(&d->cond);
+        pthread_mutex_unlock(&d->lock);
+    }
+}
+
+
+/* starts the workers, each with its own RNG and copy of the keys, serves
+ * until signalled and then stops them
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_SignDRun(WOLFCLU_SIGND_STATE* d, const char* path)
+{
+    struct sigaction sa;
+    sigset_t block;
+    sigset_t prevMask;
+    WOLFCLU_SIGND_WORKER* w;
+    int ret = WOLFCLU_SUCCESS;
+    int listenFd;
+    int i, j;
+
+    d->workers = (WOLFCLU_SIGND_WORKER*)XMALLOC(
+            sizeof(WOLFCLU_SIGND_WORKER) * d->threads, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (d->workers == NULL) {
+        return MEMORY_E;
+    }
+    XMEMSET(d->workers, 0, sizeof(WOLFCLU_SIGND_WORKER) * d->threads);
+
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < d->threads; i++) {
+        w = &d->workers[i];
+        w->d  = d;
+        w->fd = -1;
+        if (wc_InitRng(&w->rng) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Error initializing RNG");
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        w->rngInit = 1;
+        for (j = 0; ret == WOLFCLU_SUCCESS && j < d->keyCount; j++) {
+            if (wolfCLU_SignDDecodeKey(w, &d->keys[j], &w->keys[j]) !=
+                    WOLFCLU_SUCCESS) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Unable to decode key %d", j);
+                ret = WOLFCLU_FATAL_ERROR;
+            }
+        }
+    }
+
+#ifdef HAVE_ECC
+    /* pools start filling now so that nonces are ready before the first
+     * request, a key without one is signed in full */
+    for (j = 0; ret == WOLFCLU_SUCCESS && d->nonces > 0 && j < d->keyCount;
+            j++) {
+        if (d->keys[j].type == EVP_PKEY_EC &&
+                wolfCLU_EccPoolNew(&d->workers[0].keys[j].k.ecc, d->nonces,
+                    &d->keys[j].pool) != WOLFCLU_SUCCESS) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to precompute nonces for key %d,"
+                    " signing without them", j);
+            d->keys[j].pool = NULL;
+        }
+    }
+#endif
+
+    listenFd = -1;
+    if (ret == WOLFCLU_SUCCESS) {
+        listenFd = wolfCLU_SignDListen(path);
+        if (listenFd < 0) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        pthread_mutex_init(&d->lock, NULL);
+        pthread_cond_init(&d->cond, NULL);
+
+        /* no SA_RESTART so that accept returns when signalled */
+        XMEMSET(&sa, 0, sizeof(sa));
+        sa.sa_handler = wolfCLU_SignDSignal;
+        sigemptyset(&sa.sa_mask);
+        signdStop = 0;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        sa.sa_handler = SIG_IGN;
+        sigaction(SIGPIPE, &sa, NULL);
+
+        /* workers start with the signals blocked so that they are delivered
+         * to this thread, interrupting accept */
+        sigemptyset(&block);
+        sigaddset(&block, SIGINT);
+        sigaddset(&block, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &block, &prevMask);
+        for (i = 0; i < d->threads; i++) {
+            if (pthread_create(&d->workers[i].tid, NULL, wolfCLU_SignDWorker,
+                        &d->workers[i]) != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Unable to start worker thread");
+                signdStop = 1;
+                ret = WOLFCLU_FATAL_ERROR;
+                break;
+            }
+            d->workers[i].started = 1;
+        }
+        pthread_sigmask(SIG_SETMASK, &prevMask, NULL);
+
+        if (ret == WOLFCLU_SUCCESS) {
+            WOLFCLU_LOG(WOLFCLU_L0, "signd listening on %s with %d key(s) and"
+                    " %d thread(s)", path, d->keyCount, d->threads);
+            wolfCLU_SignDAccept(d, listenFd);
+        }
+
+        /* wake the workers, ending the connections they are serving */
+        pthread_mutex_lock(&d->lock);
+        d->stop = 1;
+        for (i = 0; i < d->threads; i++) {
+            if (d->workers[i].fd >= 0) {
+                shutdown(d->workers[i].fd, SHUT_RDWR);
+            }
+        }
+        pthread_cond_broadcast(&d->cond);
+        pthread_mutex_unlock(&d->lock);
+
+        for (i = 0; i < d->threads; i++) {
+            if (d->workers[i].started) {
+                pthread_join(d->workers[i].tid, NULL);
+            }
+        }
+        while (d->qCount > 0) {
+            close(d->queue[d->qHead]);
+            d->qHead = (d->qHead + 1) % WOLFCLU_SIGND_BACKLOG;
+            d->qCount--;
+        }
+
+        close(listenFd);
+        unlink(path);
+        pthread_cond_destroy(&d->cond);
+        pthread_mutex_destroy(&d->lock);
+    }
+
+#ifdef HAVE_ECC
+    for (j = 0; j < d->keyCount; j++) {
+        wolfCLU_EccPoolFree(d->keys[j].pool);
+        d->keys[j].pool = NULL;
+    }
+#endif
+    for (i = 0; i < d->threads; i++) {
+        w = &d->workers[i];
+        for (j = 0; j < d->keyCount; j++) {
+            wolfCLU_SignDFreeKey(&d->keys[j], &w->keys[j]);
+        }
+        if (w->rngInit) {
+            wc_FreeRng(&w->rng);
+        }
+    }
+    wolfCLU_ForceZero(d->workers, sizeof(WOLFCLU_SIGND_WORKER) * d->threads);
+    XFREE(d->workers, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    d->workers = NULL;
+    return ret;
+}
+
+
+/* returns WOLFCLU_SUCCESS on success */
+int wolfCLU_SignDSign(const char* path, int keyIdx, enum wc_HashType hashType,
+        const byte* hash, word32 hashSz, byte* sig, word32* sigSz)
+{
+    struct sockaddr_un addr;
+    byte   req[WOLFCLU_SIGND_MAX_REQ];
+    byte   resp[1 + WOLFCLU_SIGND_MAX_SIG];
+    word32 respSz = 0;
+    int    fd  = -1;
+    int    ret = WOLFCLU_SUCCESS;
+
+    if (hashType == WC_HASH_TYPE_NONE ||
+            wc_HashGetDigestSize(hashType) != (int)hashSz) {
+        WOLFCLU_LOG(WOLFCLU_E0, "-signd needs a hash type such as -sha256");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (keyIdx < 0 || keyIdx >= WOLFCLU_SIGND_MAX_KEYS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "-keyid must be between 0 and %d",
+                WOLFCLU_SIGND_MAX_KEYS - 1);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (XSTRLEN(path) >= sizeof(addr.sun_path)) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Socket path %s is too long", path);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    req[0] = WOLFCLU_SIGND_VERSION;
+    req[1] = WOLFCLU_SIGND_OP_SIGN;
+    req[2] = (byte)keyIdx;
+    req[3] = (byte)hashType;
+    XMEMCPY(req + WOLFCLU_SIGND_REQ_HDR, hash, hashSz);
+
+    if (ret == WOLFCLU_SUCCESS) {
+        XMEMSET(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        XMEMCPY(addr.sun_path, path, XSTRLEN(path) + 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 ||
+                connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to connect to signd at %s", path);
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS &&
+            (wolfCLU_SignDSend(fd, req,
+                WOLFCLU_SIGND_REQ_HDR + hashSz) != WOLFCLU_SUCCESS ||
+             wolfCLU_SignDRecv(fd, resp, sizeof(resp), &respSz) !=
+                WOLFCLU_SUCCESS || respSz < 1)) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Error talking to signd at %s", path);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS && resp[0] != WOLFCLU_SIGND_OK) {
+        switch (resp[0]) {
+            case WOLFCLU_SIGND_BAD_KEY:
+                WOLFCLU_LOG(WOLFCLU_E0, "signd has no key %d", keyIdx);
+                break;
+            case WOLFCLU_SIGND_BAD_HASH:
+                WOLFCLU_LOG(WOLFCLU_E0, "signd can not sign this hash type"
+                        " with key %d", keyIdx);
+                break;
+            default:
+                WOLFCLU_LOG(WOLFCLU_E0, "signd failed to sign, status %d",
+                        resp[0]);
+        }
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        if (respSz - 1 > *sigSz) {
+            ret = BUFFER_E;
+        }
+        else {
+            XMEMCPY(sig, resp + 1, respSz - 1);
+            *sigSz = respSz - 1;
+        }
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    return ret;
+}
+
+#else
+
+int wolfCLU_SignDSign(const char* path, int keyIdx, enum wc_HashType hashType,
+        const byte* hash, word32 hashSz, byte* sig, word32* sigSz)
+{
+    (void)path;
+    (void)keyIdx;
+    (void)hashType;
+    (void)hash;
+    (void)hashSz;
+    (void)sig;
+    (void)sigSz;
+    WOLFCLU_LOG(WOLFCLU_E0, "signd is not available in this build");
+    return NOT_COMPILED_IN;
+}
+
+#endif /* WOLFCLU_HAVE_SIGND */
+
+
+/* return WOLFCLU_SUCCESS on success */
+int wolfCLU_SignDSetup(int argc, char** argv)
+{
+#ifdef WOLFCLU_HAVE_SIGND
+    WOLFCLU_SIGND_STATE d;
+    WOLFCLU_GETOPT opt;
+    const char* path = NULL;
+    int ret = WOLFCLU_SUCCESS;
+    int option;
+    int longIndex = 0;
+    int i;
+
+    XMEMSET(&d, 0, sizeof(d));
+    d.threads = WOLFCLU_SIGND_THREADS;
+    d.nonces  = WOLFCLU_ECC_POOL_SIZE;
+
+    wolfCLU_GetOptInit(&opt);
+    while (ret == WOLFCLU_SUCCESS && (option = wolfCLU_GetOpt(&opt, argc,
+                    argv, signd_options, &longIndex)) != -1) {
+        switch (option) {
+            case WOLFCLU_KEY:
+                if (d.keyCount == WOLFCLU_SIGND_MAX_KEYS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "At most %d keys can be loaded",
+                            WOLFCLU_SIGND_MAX_KEYS);
+                    ret = WOLFCLU_FATAL_ERROR;
+                    break;
+                }
+                ret = wolfCLU_SignDLoadKey(&d.keys[d.keyCount], opt.arg);
+                if (ret == WOLFCLU_SUCCESS) {
+                    d.keyCount++;
+                }
+                break;
+
+            case WOLFCLU_SOCKET:
+                path = opt.arg;
+                break;
+
+            case WOLFCLU_THREADS:
+                if (wolfCLU_ParseNum(opt.arg, 1, MAX_THREADS, &d.threads)
+                        != WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "-threads must be between 1 and "
+                            "%d", MAX_THREADS);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+                break;
+
+            case WOLFCLU_NONCES:
+                if (wolfCLU_ParseNum(opt.arg, 0, WOLFCLU_ECC_POOL_MAX,
+                            &d.nonces) != WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "-nonces must be between 0 and "
+                            "%d", WOLFCLU_ECC_POOL_MAX);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+                break;
+
+            case WOLFCLU_HELP:
+                wolfCLU_SignDHelp();
+                for (i = 0; i < d.keyCount; i++) {
+                    wolfCLU_ForceZero(d.keys[i].der, d.keys[i].derSz);
+                    XFREE(d.keys[i].der, NULL, DYNAMIC_TYPE_OPENSSL);
+                }
+                return WOLFCLU_SUCCESS;
+
+            default:
+                WOLFCLU_LOG(WOLFCLU_E0, "Bad argument found");
+                wolfCLU_SignDHelp();
+                ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS && (path == NULL || d.keyCount == 0)) {
+        WOLFCLU_LOG(WOLFCLU_E0, "signd needs -socket and at least one -key");
+        wolfCLU_SignDHelp();
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_SignDRun(&d, path);
+    }
+
+    for (i = 0; i < d.keyCount; i++) {
+        wolfCLU_ForceZero(d.keys[i].der, d.keys[i].derSz);
+        XFREE(d.keys[i].der, NULL, DYNAMIC_TYPE_OPENSSL);
+    }
+    return ret;
+#else
+    (void)argc;
+    (void)argv;
+    (void)signd_options;
+    wolfCLU_SignDHelp();
+    WOLFCLU_LOG(WOLFCLU_E0, "signd is not available in this build");
+    return NOT_COMPILED_IN;
+#endif
+}
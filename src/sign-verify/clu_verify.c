@@ -21,7 +21,9 @@
 
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
+#include <wolfclu/clu_cache.h>
 #include <wolfclu/sign-verify/clu_verify.h>
+#include <wolfclu/sign-verify/clu_keycache.h>
 #include <wolfclu/sign-verify/clu_sign.h> /* for RSA_SIG_VER, ECC_SIG_VER,
                                              ED25519_SIG_VER */
 
@@ -260,35 +262,49 @@ int wolfCLU_verify_signature(char* sig, char* hashFile, char* out,
     return ret;
 }
 
+#ifndef NO_RSA
+/* releases a key from wolfCLU_KeyCtxGet, or the one loaded into pub */
+static void wolfCLU_verify_rsa_free(RsaKey* key, RsaKey* pub)
+{
+    if (key == pub) {
+        wc_FreeRsaKey(pub);
+    }
+    else {
+        wolfCLU_KeyCtxPut(key);
+    }
+}
+#endif
+
 int wolfCLU_verify_signature_rsa(byte* sig, char* out, int sigSz, char* keyPath,
                                  int pubIn)
 {
 #ifndef NO_RSA
     int ret;
     int keyFileSz = 0;
-    word32 index = 0;
     XFILE keyPathFile;
-    RsaKey key;
-    WC_RNG rng;
+    RsaKey  pub;
+    RsaKey* key = NULL;
     byte* keyBuf = NULL;
     byte* outBuf = NULL;
     int   outBufSz = 0;
 
-    XMEMSET(&rng, 0, sizeof(rng));
-    XMEMSET(&key, 0, sizeof(key));
-
-    ret = wc_InitRsaKey(&key, NULL);
-    if (ret != 0) {
-        WOLFCLU_LOG(WOLFCLU_E0, "Failed to initialize RsaKey.\nRet: %d", ret);
-        return ret;
+    if (wolfCLU_KeyCacheOn()) {
+        /* a private key file has its public key in the key cache too */
+        if (wc_InitRsaKey(&pub, HEAP_HINT) == 0) {
+            if (wolfCLU_KeyCacheLoad(keyPath, WOLFCLU_KEYCACHE_RSA, !pubIn,
+                        &pub) == WOLFCLU_SUCCESS) {
+                key = &pub;
+            }
+            else {
+                wc_FreeRsaKey(&pub);
+            }
+        }
     }
-
-    if (pubIn == 1) {
+    else if (pubIn == 1) {
         /* read in and store rsa key */
         keyPathFile = XFOPEN(keyPath, "rb");
         if (keyPathFile == NULL) {
             WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", keyPath);
-            wc_FreeRsaKey(&key);
             return BAD_FUNC_ARG;
         }
 
@@ -305,38 +321,37 @@ int wolfCLU_verify_signature_rsa(byte* sig, char* out, int sigSz, char* keyPath,
         keyBuf = wolfCLU_generate_public_key_rsa(keyPath, keyBuf, &keyFileSz);
         if (keyFileSz < 0) {
                 WOLFCLU_LOG(WOLFCLU_E0, "Failed to derive public key from private key.");
-                wc_FreeRsaKey(&key);
-                return ret;
+                return WOLFCLU_FATAL_ERROR;
         }
     }
 
-    /* retrieving public key and storing in the RsaKey */
-    ret = wc_RsaPublicKeyDecode(keyBuf, &index, &key, keyFileSz);
     if (keyBuf != NULL) {
+        /* the decoded key is kept when verifying many times with it */
+        key = (RsaKey*)wolfCLU_KeyCtxGet(EVP_PKEY_RSA, keyBuf,
+                (word32)keyFileSz);
         XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
     }
 
-    if (ret < 0 ) {
-        WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode public key.\nRET: %d", ret);
-        wc_FreeRsaKey(&key);
-        return ret;
+    if (key == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode public key.");
+        return WOLFCLU_FATAL_ERROR;
     }
 
     /* setting up output buffer based on key size */
-    outBufSz = wc_RsaEncryptSize(&key);
+    outBufSz = wc_RsaEncryptSize(key);
     outBuf = (byte*)XMALLOC(outBufSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
     if (outBuf == NULL) {
         WOLFCLU_LOG(WOLFCLU_E0, "Failed to malloc output buffer");
-        wc_FreeRsaKey(&key);
+        wolfCLU_verify_rsa_free(key, &pub);
         return MEMORY_E;
     }
     XMEMSET(outBuf, 0, outBufSz);
 
-    ret = wc_RsaSSL_Verify(sig, sigSz, outBuf, (word32)outBufSz, &key);
+    ret = wc_RsaSSL_Verify(sig, sigSz, outBuf, (word32)outBufSz, key);
     if (ret < 0) {
         WOLFCLU_LOG(WOLFCLU_E0, "Failed to verify data with RSA public key.\nRET: %d", ret);
         XFREE(outBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        wc_FreeRsaKey(&key);
+        wolfCLU_verify_rsa_free(key, &pub);
         return ret;
     }
     else {
@@ -354,7 +369,7 @@ int wolfCLU_verify_signature_rsa(byte* sig, char* out, int sigSz, char* keyPath,
     if (outBuf != NULL) {
         XFREE(outBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
     }
-    wc_FreeRsaKey(&key);
+    wolfCLU_verify_rsa_free(key, &pub);
     return (ret < 0)? ret : WOLFCLU_SUCCESS;
 #else
     return NOT_COMPILED_IN;
@@ -371,58 +386,84 @@ int wolfCLU_verify_signature_ecc(byte* sig, int sigSz, byte* hash, int hashSz,
     word32 index = 0;
 
     XFILE   keyPathFile;
-    ecc_key key;
-    WC_RNG  rng;
+    ecc_key priv;
+    ecc_key* key = NULL;
     byte*   keyBuf;
 
-    XMEMSET(&rng, 0, sizeof(rng));
-    XMEMSET(&key, 0, sizeof(key));
+    XMEMSET(&priv, 0, sizeof(priv));
 
-    ret = wc_ecc_init(&key);
-    if (ret != 0) {
-        WOLFCLU_LOG(WOLFCLU_E0, "Failed to initialize ecc key.\nRet: %d", ret);
-        return ret;
+    if (wolfCLU_KeyCacheOn()) {
+        /* a private key file has its public key in the key cache too */
+        ret = wc_ecc_init(&priv);
+        if (ret != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Failed to initialize ecc key.\nRet: %d", ret);
+            return ret;
+        }
+        key = &priv;
+        if (wolfCLU_KeyCacheLoad(keyPath, WOLFCLU_KEYCACHE_ECC, !pubIn,
+                    key) != WOLFCLU_SUCCESS) {
+            wc_ecc_free(&priv);
+            return WOLFCLU_FATAL_ERROR;
+        }
     }
+    else {
+        /* read in and store ecc key */
+        keyPathFile = XFOPEN(keyPath, "rb");
+        if (keyPathFile == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", keyPath);
+            return BAD_FUNC_ARG;
+        }
 
-    /* read in and store ecc key */
-    keyPathFile = XFOPEN(keyPath, "rb");
-    if (keyPathFile == NULL) {
-        WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", keyPath);
-        return BAD_FUNC_ARG;
-    }
+        XFSEEK(keyPathFile, 0, SEEK_END);
+        keyFileSz = (int)XFTELL(keyPathFile);
+        keyBuf = (byte*)XMALLOC(keyFileSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (keyBuf != NULL) {
+            XFSEEK(keyPathFile, 0, SEEK_SET);
+            XFREAD(keyBuf, 1, keyFileSz, keyPathFile);
+        }
+        XFCLOSE(keyPathFile);
 
-    XFSEEK(keyPathFile, 0, SEEK_END);
-    keyFileSz = (int)XFTELL(keyPathFile);
-    keyBuf = (byte*)XMALLOC(keyFileSz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-    if (keyBuf != NULL) {
-        XFSEEK(keyPathFile, 0, SEEK_SET);
-        XFREAD(keyBuf, 1, keyFileSz, keyPathFile);
-    }
-    XFCLOSE(keyPathFile);
+        if (pubIn == 1) {
+            /* the decoded public key is kept when verifying many times with it */
+            key = (ecc_key*)wolfCLU_KeyCtxGet(EVP_PKEY_EC, keyBuf,
+                    (word32)keyFileSz);
+            if (key == NULL) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode public key.");
+                XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+                return WOLFCLU_FATAL_ERROR;
+            }
+        }
+        else {
+            ret = wc_ecc_init(&priv);
+            if (ret != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Failed to initialize ecc key.\nRet: %d", ret);
+                XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+                return ret;
+            }
 
-    if (pubIn == 1) {
-        /* retrieving public key and storing in the ecc key */
-        ret = wc_EccPublicKeyDecode(keyBuf, &index, &key, keyFileSz);
-        if (ret < 0 ) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode public key.\nRET: %d", ret);
-            XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-            return ret;
+            /* retrieving private key and storing in the Ecc Key */
+            ret = wc_EccPrivateKeyDecode(keyBuf, &index, &priv, keyFileSz);
+            if (ret != 0 ) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode private key.\nRET: %d", ret);
+                XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+                wc_ecc_free(&priv);
+                return ret;
+            }
+            key = &priv;
         }
-    }
-    else {
-        /* retrieving private key and storing in the Ecc Key */
-        ret = wc_EccPrivateKeyDecode(keyBuf, &index, &key, keyFileSz);
-        if (ret != 0 ) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode private key.\nRET: %d", ret);
+
+        if (keyBuf)
             XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-            return ret;
-        }
     }
 
-    if (keyBuf)
-        XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    ret = wc_ecc_verify_hash(sig, sigSz, hash, hashSz, &stat, key);
+    if (key == &priv) {
+        wc_ecc_free(&priv);
+    }
+    else {
+        wolfCLU_KeyCtxPut(key);
+    }
 
-    ret = wc_ecc_verify_hash(sig, sigSz, hash, hashSz, &stat, &key);
     if (ret < 0) {
         WOLFCLU_LOG(WOLFCLU_E0, "Failed to verify data with Ecc public key.\nRET: %d", ret);
         return ret;
@@ -466,34 +507,45 @@ int wolfCLU_verify_signature_ed25519(byte* sig, int sigSz,
         return ret;
     }
 
-    /* retrieving public key and storing in the ED25519 key */
-    if (pubIn == 1) {
-        /* read in and store ED25519 key */
-        keyPathFile = XFOPEN(keyPath, "rb");
-        if (keyPathFile == NULL) {
-            XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-            return BAD_FUNC_ARG;
+    if (wolfCLU_KeyCacheOn()) {
+        /* a private key file has its public key in the key cache too */
+        ret = wolfCLU_KeyCacheLoad(keyPath, WOLFCLU_KEYCACHE_ED25519, !pubIn,
+                &key);
+        XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        if (ret != WOLFCLU_SUCCESS) {
+            return ret;
         }
-        XFREAD(keyBuf, 1, ED25519_KEY_SIZE, keyPathFile);
-        XFCLOSE(keyPathFile);
-
     }
     else {
-        ret = wolfCLU_generate_public_key_ed25519(keyPath, keyBuf);
-        if (ret != 0) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Failed to derive public key from private key.");
+        /* retrieving public key and storing in the ED25519 key */
+        if (pubIn == 1) {
+            /* read in and store ED25519 key */
+            keyPathFile = XFOPEN(keyPath, "rb");
+            if (keyPathFile == NULL) {
+                XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+                return BAD_FUNC_ARG;
+            }
+            XFREAD(keyBuf, 1, ED25519_KEY_SIZE, keyPathFile);
+            XFCLOSE(keyPathFile);
+
+        }
+        else {
+            ret = wolfCLU_generate_public_key_ed25519(keyPath, keyBuf);
+            if (ret != 0) {
+                WOLFCLU_LOG(WOLFCLU_E0, "Failed to derive public key from private key.");
+                XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+                return ret;
+            }
+        }
+
+        ret = wc_ed25519_import_public(keyBuf, ED25519_KEY_SIZE, &key);
+        if (ret != 0 ) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode public key.\nRET: %d", ret);
             XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
             return ret;
         }
-    }
-
-    ret = wc_ed25519_import_public(keyBuf, ED25519_KEY_SIZE, &key);
-    if (ret != 0 ) {
-        WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode public key.\nRET: %d", ret);
         XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        return ret;
     }
-    XFREE(keyBuf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
 
     ret = wc_ed25519_verify_msg(sig, sigSz, hash, hashSz, &stat, &key);
     if (ret != 0) {
@@ -512,3 +564,106 @@ int wolfCLU_verify_signature_ed25519(byte* sig, int sigSz,
     return NOT_COMPILED_IN;
 #endif
 }
+
+
+int wolfCLU_verify_signature_ed25519ex(char* sigFile, char* in, char* keyPath,
+        int pubIn, int ph, const byte* ctx, byte ctxSz)
+{
+#ifdef HAVE_ED25519
+    ed25519_key key;
+    byte   hash[WC_SHA512_DIGEST_SIZE];
+    byte   pub[ED25519_PUB_KEY_SIZE];
+    byte   sig[ED25519_SIG_SIZE];
+    size_t sigSz = 0;
+    byte*  data = NULL;
+    word32 dataSz = 0;
+    XFILE  f;
+    int    stat = 0;
+    int    ret;
+
+    f = XFOPEN(sigFile, "rb");
+    if (f == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", sigFile);
+        return BAD_FUNC_ARG;
+    }
+    sigSz = XFREAD(sig, 1, sizeof(sig), f);
+    XFCLOSE(f);
+
+    if (wolfCLU_KeyCacheOn()) {
+        ret = 0; /* loaded into key below */
+    }
+    else if (pubIn == 1) {
+        f = XFOPEN(keyPath, "rb");
+        if (f == NULL) {
+            WOLFCLU_LOG(WOLFCLU_E0, "unable to open file %s", keyPath);
+            return BAD_FUNC_ARG;
+        }
+        ret = (XFREAD(pub, 1, sizeof(pub), f) == sizeof(pub))? 0 :
+                BAD_FUNC_ARG;
+        XFCLOSE(f);
+    }
+    else {
+        ret = wolfCLU_generate_public_key_ed25519(keyPath, pub);
+    }
+    if (ret != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Failed to get ED25519 public key.");
+        return ret;
+    }
+
+    ret = wc_ed25519_init(&key);
+    if (ret != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Failed to initialize ED25519 key.\nRet: %d",
+                ret);
+        return ret;
+    }
+
+    if (wolfCLU_KeyCacheOn()) {
+        ret = (wolfCLU_KeyCacheLoad(keyPath, WOLFCLU_KEYCACHE_ED25519, !pubIn,
+                    &key) == WOLFCLU_SUCCESS)? 0 : WOLFCLU_FATAL_ERROR;
+    }
+    else {
+        ret = wc_ed25519_import_public(pub, sizeof(pub), &key);
+        if (ret != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Failed to decode public key.\nRET: %d",
+                    ret);
+        }
+    }
+
+    if (ret == 0) {
+        ret = wolfCLU_ed25519_input(in, ph, hash, &data, &dataSz);
+    }
+
+    if (ret == 0) {
+        if (ph) {
+            ret = wc_ed25519ph_verify_hash(sig, (word32)sigSz, hash,
+                    sizeof(hash), &stat, &key, ctx, ctxSz);
+        }
+        else {
+            ret = wc_ed25519ctx_verify_msg(sig, (word32)sigSz, data, dataSz,
+                    &stat, &key, ctx, ctxSz);
+        }
+    }
+
+    if (ret == 0 && stat == 1) {
+        WOLFCLU_LOG(WOLFCLU_L0, "Valid Signature.");
+    }
+    else {
+        WOLFCLU_LOG(WOLFCLU_E0, "Invalid Signature.");
+    }
+
+    if (data != NULL) {
+        XFREE(data, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    wc_ed25519_free(&key);
+    return (ret == 0 && stat == 1)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+#else
+    (void)sigFile;
+    (void)in;
+    (void)keyPath;
+    (void)pubIn;
+    (void)ph;
+    (void)ctx;
+    (void)ctxSz;
+    return NOT_COMPILED_IN;
+#endif
+}
@@ -48,6 +48,7 @@ int wolfCLU_x509Verify(int argc, char** argv)
     int inForm = PEM_FORM;
     int crlCheck  = 0;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     int option;
     char* caCert     = NULL;
     char* verifyCert = NULL;
@@ -71,9 +72,8 @@ int wolfCLU_x509Verify(int argc, char** argv)
     if (ret == WOLFCLU_SUCCESS) {
         WOLFCLU_LOG(WOLFCLU_L0, "verifying certificate file %s", verifyCert);
 
-        opterr = 0; /* do not display unrecognized options */
-        optind = 0; /* start at indent 0 */
-        while ((option = getopt_long_only(argc - 1, argv, "",
+        wolfCLU_GetOptInit(&opt);
+        while ((option = wolfCLU_GetOpt(&opt, argc - 1, argv,
                        verify_options, &longIndex )) != -1) {
             switch (option) {
                 case WOLFCLU_CHECK_CRL:
@@ -85,12 +85,12 @@ int wolfCLU_x509Verify(int argc, char** argv)
                     break;
 
                 case WOLFCLU_CAFILE:
-                    WOLFCLU_LOG(WOLFCLU_L0, "using CA file %s", optarg);
-                    caCert = optarg;
+                    WOLFCLU_LOG(WOLFCLU_L0, "using CA file %s", opt.arg);
+                    caCert = opt.arg;
                     break;
 
                 case WOLFCLU_INFORM:
-                    inForm = wolfCLU_checkInform(optarg);
+                    inForm = wolfCLU_checkInform(opt.arg);
                     break;
 
                 case WOLFCLU_HELP:
@@ -0,0 +1,497 @@
+/* clu_batch.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_optargs.h>
+#include <wolfclu/clu_cache.h>
+#include <wolfclu/clu_stats.h>
+
+#ifndef SINGLE_THREADED
+    #include <pthread.h>
+#endif
+
+/* longest command line read from the batch file */
+#define WOLFCLU_BATCH_LINE_SZ 4096
+
+/* most arguments on one line, including the program name */
+#define WOLFCLU_BATCH_MAX_ARGS 256
+
+/* modes that keep state in globals, such as s_client's option parsing and
+ * bench's timer calibration, and so can not run on worker threads */
+static const char* const batchSerialModes[] = {
+    "bench", "s_client", "signd", NULL
+};
+
+static const struct option batch_options[] = {
+    {"j",             required_argument, 0, WOLFCLU_THREADS      },
+    {"stop-on-error", no_argument,       0, WOLFCLU_STOP_ON_ERROR},
+    {"help",          no_argument,       0, WOLFCLU_HELP         },
+    {"h",             no_argument,       0, WOLFCLU_HELP         },
+
+    {0, 0, 0, 0} /* terminal element */
+};
+
+static void wolfCLU_BatchHelp(void)
+{
+    WOLFCLU_LOG(WOLFCLU_L0, "wolfssl batch <file|-> [-j <n>] [-stop-on-error]");
+    WOLFCLU_LOG(WOLFCLU_L0, "\truns one command per line, as it would be given"
+            " after wolfssl, in this process");
+    WOLFCLU_LOG(WOLFCLU_L0, "\tblank lines and lines starting with # are"
+            " skipped, quotes and \\ work as in the shell");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-j <n> run up to n lines at once, output of"
+            " lines without -out can interleave");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t\ta batch with bench, s_client or signd"
+            " lines runs one line at a time");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-stop-on-error do not start any more lines"
+            " once one fails");
+}
+
+
+/* one line of the batch file */
+typedef struct WOLFCLU_BATCH_LINE {
+    char* text;     /* split into args in place when it is run */
+    int   num;      /* line number in the file, from 1 */
+    int   ret;
+} WOLFCLU_BATCH_LINE;
+
+typedef struct WOLFCLU_BATCH_STATE {
+    WOLFCLU_BATCH_LINE* lines;
+    int   count;
+    int   next;     /* next line to be run */
+    int   failed;
+    int   stopOnError;
+    int   threads;
+    int   serialLine; /* first line with a mode in batchSerialModes */
+    wolfCLU_CommandFunc run;
+#ifndef SINGLE_THREADED
+    pthread_mutex_t lock;
+#endif
+} WOLFCLU_BATCH_STATE;
+
+
+/* splits line into args in place, the way a shell would split a simple
+ * command. Text in single quotes is taken as is, in double quotes and outside
+ * of quotes a \ takes the next character as is. A # at the start of a word
+ * starts a comment
+ *
+ * returns the number of args or -1 for an unterminated quote or too many
+ * args */
+static int wolfCLU_BatchSplit(char* line, char** args, int maxArgs)
+{
+    char* in  = line;
+    char* out = line;
+    char  quote;
+    int   count = 0;
+
+    for (;;) {
+        while (*in == ' ' || *in == '\t' || *in == '\r' || *in == '\n') {
+            in++;
+        }
+        if (*in == '\0' || *in == '#') {
+            break;
+        }
+        if (count == maxArgs) {
+            return -1;
+        }
+
+        args[count++] = out;
+        quote = 0;
+        while (*in != '\0' && (quote != 0 || (*in != ' ' && *in != '\t' &&
+                        *in != '\r' && *in != '\n'))) {
+            if (quote == 0 && (*in == '\'' || *in == '"')) {
+                quote = *in++;
+                continue;
+            }
+            if (quote != 0 && *in == quote) {
+                quote = 0;
+                in++;
+                continue;
+            }
+            if (*in == '\\' && quote != '\'' && in[1] != '\0') {
+                in++;
+            }
+            *out++ = *in++;
+        }
+        if (quote != 0) {
+            return -1;
+        }
+        if (*in != '\0') {
+            in++;
+        }
+        *out++ = '\0'; /* out never passes in, so this only ends the arg */
+    }
+
+    return count;
+}
+
+
+/* drops a leading "wolfssl" from the count args of a split line
+ * returns the mode of the line, without any leading -, or NULL for an empty
+ * line */
+static const char* wolfCLU_BatchMode(char** args, int* count)
+{
+    if (*count > 0 && XSTRCMP(args[0], "wolfssl") == 0) {
+        XMEMMOVE(&args[0], &args[1], (*count - 1) * sizeof(char*));
+        (*count)--;
+    }
+    if (*count == 0) {
+        return NULL;
+    }
+    return (args[0][0] == '-')? args[0] + 1 : args[0];
+}
+
+
+/* returns 1 when line has a mode that can not run on worker threads */
+static int wolfCLU_BatchIsSerial(char* line)
+{
+    char* args[WOLFCLU_BATCH_MAX_ARGS];
+    const char* mode;
+    int   count;
+    int   i;
+
+    count = wolfCLU_BatchSplit(line, args, WOLFCLU_BATCH_MAX_ARGS - 1);
+    mode  = (count > 0)? wolfCLU_BatchMode(args, &count) : NULL;
+    for (i = 0; mode != NULL && batchSerialModes[i] != NULL; i++) {
+        if (XSTRCMP(mode, batchSerialModes[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/* reads every line of path, or stdin for "-", that is not blank or a
+ * comment into batch->lines
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_BatchRead(WOLFCLU_BATCH_STATE* batch, const char* path)
+{
+    char   buf[WOLFCLU_BATCH_LINE_SZ];
+    XFILE  f;
+    int    ret = WOLFCLU_SUCCESS;
+    int    max = 0;
+    int    num = 0;
+    int    sz;
+    char*  p;
+
+    if (XSTRCMP(path, "-") == 0) {
+        f = stdin;
+    }
+    else {
+        f = XFOPEN(path, "rb");
+        if (f == XBADFILE) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to open batch file %s", path);
+            return WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    while (ret == WOLFCLU_SUCCESS && XFGETS(buf, sizeof(buf), f) != NULL) {
+        num++;
+        sz = (int)XSTRLEN(buf);
+        if (sz == (int)sizeof(buf) - 1 && buf[sz - 1] != '\n' && !feof(f)) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Line %d is longer than %d characters",
+                    num, WOLFCLU_BATCH_LINE_SZ - 2);
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+
+        p = buf;
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+            p++;
+        }
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+
+        if (batch->count == max) {
+            WOLFCLU_BATCH_LINE* tmp;
+
+            max = (max == 0)? 64 : max * 2;
+            tmp = (WOLFCLU_BATCH_LINE*)XREALLOC(batch->lines,
+                    max * sizeof(WOLFCLU_BATCH_LINE), HEAP_HINT,
+                    DYNAMIC_TYPE_TMP_BUFFER);
+            if (tmp == NULL) {
+                ret = MEMORY_E;
+                break;
+            }
+            batch->lines = tmp;
+        }
+
+        batch->lines[batch->count].text = (char*)XMALLOC(sz + 1, HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (batch->lines[batch->count].text == NULL) {
+            ret = MEMORY_E;
+            break;
+        }
+        XMEMCPY(batch->lines[batch->count].text, buf, sz + 1);
+        batch->lines[batch->count].num = num;
+        batch->lines[batch->count].ret = WOLFCLU_SUCCESS;
+        batch->count++;
+
+        /* buf is split in place, the line keeps its own copy */
+        if (batch->threads > 1 && batch->serialLine == 0 &&
+                wolfCLU_BatchIsSerial(buf)) {
+            batch->serialLine = num;
+        }
+    }
+
+    if (f != stdin) {
+        XFCLOSE(f);
+    }
+    return ret;
+}
+
+
+/* splits and runs one line
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_BatchRunLine(WOLFCLU_BATCH_STATE* batch,
+        WOLFCLU_BATCH_LINE* line)
+{
+    char* args[WOLFCLU_BATCH_MAX_ARGS + 1];
+    const char* mode;
+    int   count;
+    int   ret;
+
+    /* args[0] is the program name, as in main */
+    args[0] = (char*)"wolfssl";
+    count = wolfCLU_BatchSplit(line->text, args + 1,
+            WOLFCLU_BATCH_MAX_ARGS - 1);
+    if (count < 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "line %d: unterminated quote or more than "
+                "%d arguments", line->num, WOLFCLU_BATCH_MAX_ARGS - 1);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    mode = wolfCLU_BatchMode(args + 1, &count);
+    if (mode == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "line %d: no command", line->num);
+        return WOLFCLU_FATAL_ERROR;
+    }
+    count++;
+    args[count] = NULL;
+
+    if (XSTRCMP(mode, "batch") == 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "line %d: batch can not be nested", line->num);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    /* the line is freed once the batch is done, so the tag goes back to
+     * batch before the status is logged */
+    wolfCLU_LogSetCommand(mode);
+    ret = batch->run(count, args);
+    wolfCLU_LogSetCommand("batch");
+    WOLFCLU_LOG(WOLFCLU_E0, "line %d: %s %s", line->num, mode,
+            (ret == WOLFCLU_SUCCESS)? "ok" : "failed");
+    return (ret == WOLFCLU_SUCCESS)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+}
+
+
+/* runs lines until there are none left, or until one fails with
+ * -stop-on-error. Keys, certificates and configs are cached for the thread
+ * while it runs */
+static void wolfCLU_BatchRunLines(WOLFCLU_BATCH_STATE* batch)
+{
+    WOLFCLU_BATCH_LINE* line;
+
+    wolfCLU_CacheEnable(1);
+    for (;;) {
+    #ifndef SINGLE_THREADED
+        pthread_mutex_lock(&batch->lock);
+    #endif
+        line = NULL;
+        if (batch->next < batch->count &&
+                !(batch->stopOnError && batch->failed > 0)) {
+            line = &batch->lines[batch->next++];
+        }
+    #ifndef SINGLE_THREADED
+        pthread_mutex_unlock(&batch->lock);
+    #endif
+        if (line == NULL) {
+            break;
+        }
+
+        line->ret = wolfCLU_BatchRunLine(batch, line);
+        if (line->ret != WOLFCLU_SUCCESS) {
+        #ifndef SINGLE_THREADED
+            pthread_mutex_lock(&batch->lock);
+        #endif
+            batch->failed++;
+        #ifndef SINGLE_THREADED
+            pthread_mutex_unlock(&batch->lock);
+        #endif
+        }
+    }
+    wolfCLU_CacheEnable(0);
+}
+
+
+#ifndef SINGLE_THREADED
+/* each worker logs with its own copy of the settings so the command name in
+ * JSON lines and wolfCLU_OutputOFF stay with the line that set them */
+static void* wolfCLU_BatchWorker(void* arg)
+{
+    WOLFCLU_BATCH_STATE* batch = (WOLFCLU_BATCH_STATE*)arg;
+    WOLFCLU_LOG_CONFIG log;
+
+    wolfCLU_LogConfigGet(&log);
+    wolfCLU_LogSetThreadConfig(&log);
+    wolfCLU_BatchRunLines(batch);
+    wolfCLU_LogSetThreadConfig(NULL);
+    return NULL;
+}
+#endif
+
+
+/* returns WOLFCLU_SUCCESS if every line ran successfully */
+int wolfCLU_Batch(int argc, char** argv, wolfCLU_CommandFunc run)
+{
+    WOLFCLU_BATCH_STATE batch;
+    WOLFCLU_GETOPT opt;
+    const char* path = NULL;
+    int ret = WOLFCLU_SUCCESS;
+    int option;
+    int longIndex = 0;
+    int i;
+
+    XMEMSET(&batch, 0, sizeof(batch));
+    batch.run     = run;
+    batch.threads = 1;
+
+    /* the file is the first argument after the mode that is not an option
+     * or the value of one */
+    wolfCLU_GetOptInit(&opt);
+    opt.ind = 2;
+    while (ret == WOLFCLU_SUCCESS) {
+        if (opt.ind < argc && (argv[opt.ind][0] != '-' ||
+                    argv[opt.ind][1] == '\0')) {
+            if (path == NULL) {
+                path = argv[opt.ind];
+            }
+            opt.ind++;
+            continue;
+        }
+
+        option = wolfCLU_GetOpt(&opt, argc, argv, batch_options, &longIndex);
+        if (option == -1) {
+            break;
+        }
+        switch (option) {
+            case WOLFCLU_THREADS:
+                if (wolfCLU_ParseNum(opt.arg, 1, MAX_THREADS, &batch.threads)
+                        != WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "-j must be between 1 and %d",
+                            MAX_THREADS);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+            #ifdef SINGLE_THREADED
+                else if (batch.threads > 1) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "Threads are not available in "
+                            "this build");
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+            #endif
+                break;
+
+            case WOLFCLU_STOP_ON_ERROR:
+                batch.stopOnError = 1;
+                break;
+
+            case WOLFCLU_HELP:
+                wolfCLU_BatchHelp();
+                return WOLFCLU_SUCCESS;
+
+            case '?':
+            default:
+                WOLFCLU_LOG(WOLFCLU_E0, "Bad argument found");
+                wolfCLU_BatchHelp();
+                ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    if (ret == WOLFCLU_SUCCESS && path == NULL) {
+        WOLFCLU_LOG(WOLFCLU_E0, "No batch file given, use - for stdin");
+        wolfCLU_BatchHelp();
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+
+    /* -stats keeps one set of counters for the process, which only makes
+     * sense with one command running at a time */
+    if (ret == WOLFCLU_SUCCESS && batch.threads > 1 && wolfCLU_StatsEnabled()) {
+        WOLFCLU_LOG(WOLFCLU_E0, "-stats runs the batch one line at a time");
+        batch.threads = 1;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+        ret = wolfCLU_BatchRead(&batch, path);
+    }
+
+    /* as with -stats, one line that can not share the process with another
+     * running at the same time makes the whole batch run in order */
+    if (ret == WOLFCLU_SUCCESS && batch.threads > 1 && batch.serialLine > 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "line %d: mode can not run on worker "
+                "threads, the batch runs one line at a time",
+                batch.serialLine);
+        batch.threads = 1;
+    }
+
+    if (ret == WOLFCLU_SUCCESS) {
+    #ifndef SINGLE_THREADED
+        pthread_t tids[MAX_THREADS];
+        int started = 0;
+
+        if (batch.threads > batch.count) {
+            batch.threads = batch.count;
+        }
+        pthread_mutex_init(&batch.lock, NULL);
+        if (batch.threads > 1) {
+            for (i = 0; i < batch.threads; i++) {
+                if (pthread_create(&tids[i], NULL, wolfCLU_BatchWorker,
+                            &batch) != 0) {
+                    break;
+                }
+                started++;
+            }
+            for (i = 0; i < started; i++) {
+                pthread_join(tids[i], NULL);
+            }
+        }
+        /* any lines left, if no thread could be started */
+        wolfCLU_BatchRunLines(&batch);
+        pthread_mutex_destroy(&batch.lock);
+    #else
+        wolfCLU_BatchRunLines(&batch);
+    #endif
+
+        WOLFCLU_LOG(WOLFCLU_E0, "batch: %d of %d lines failed%s",
+                batch.failed, batch.count,
+                (batch.next < batch.count)? ", the rest were not run" : "");
+        if (batch.failed > 0 || batch.next < batch.count) {
+            ret = WOLFCLU_FATAL_ERROR;
+        }
+    }
+
+    for (i = 0; i < batch.count; i++) {
+        XFREE(batch.lines[i].text, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    if (batch.lines != NULL) {
+        XFREE(batch.lines, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    return ret;
+}
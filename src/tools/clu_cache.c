@@ -0,0 +1,579 @@
+/* clu_cache.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_cache.h>
+
+/* most files kept per thread, the least recently used is dropped first */
+#ifndef WOLFCLU_CACHE_MAX
+#define WOLFCLU_CACHE_MAX 32
+#endif
+
+/* largest file that is read in to be cached */
+#define WOLFCLU_CACHE_MAX_FILE (1024 * 1024)
+
+/* most decoded public keys kept per thread, the least recently used one not
+ * in use is dropped first */
+#ifndef WOLFCLU_KEYCTX_MAX
+#define WOLFCLU_KEYCTX_MAX 8
+#endif
+
+enum {
+    WOLFCLU_CACHE_PRIVKEY,
+    WOLFCLU_CACHE_PUBKEY,
+    WOLFCLU_CACHE_CERT,
+    WOLFCLU_CACHE_CONF
+};
+
+/* a parsed file along with the contents it was parsed from, the contents
+ * are compared on each lookup so a file rewritten by an earlier command is
+ * never served stale, whatever its size and time stamps */
+typedef struct WOLFCLU_CACHE_ENTRY {
+    struct WOLFCLU_CACHE_ENTRY* next;
+    int    type;
+    char*  path;
+    byte*  data;
+    word32 dataSz;
+    void*  obj;
+    int    users;   /* configs handed out and not yet given back */
+} WOLFCLU_CACHE_ENTRY;
+
+/* a public key decoded into the form wolfCrypt verifies with, found by the
+ * SHA-256 hash of its SubjectPublicKeyInfo. The key comes first so that the
+ * pointer handed out is also the entry's */
+typedef struct WOLFCLU_KEYCTX {
+    union {
+    #ifndef NO_RSA
+        RsaKey  rsa;
+    #endif
+    #ifdef HAVE_ECC
+        ecc_key ecc;
+    #endif
+        byte    unused;
+    } key;
+    struct WOLFCLU_KEYCTX* next;
+    byte   id[WC_SHA256_DIGEST_SIZE];
+    int    type;    /* EVP_PKEY_RSA or EVP_PKEY_EC */
+    int    users;   /* handed out and not yet given back */
+} WOLFCLU_KEYCTX;
+
+static WOLFCLU_THREAD_LS int cacheOn = 0;
+static WOLFCLU_THREAD_LS WOLFCLU_CACHE_ENTRY* cacheList = NULL;
+/* configs dropped from the cache while a command was still using them */
+static WOLFCLU_THREAD_LS WOLFCLU_CACHE_ENTRY* cacheOrphans = NULL;
+/* how many callers have key caching on, it stays on until all turn it off */
+static WOLFCLU_THREAD_LS int keyCtxOn = 0;
+static WOLFCLU_THREAD_LS WOLFCLU_KEYCTX* keyCtxList = NULL;
+
+
+static void wolfCLU_CacheFreeObj(int type, void* obj)
+{
+    switch (type) {
+        case WOLFCLU_CACHE_PRIVKEY:
+        case WOLFCLU_CACHE_PUBKEY:
+            wolfSSL_EVP_PKEY_free((WOLFSSL_EVP_PKEY*)obj);
+            break;
+        case WOLFCLU_CACHE_CERT:
+            wolfSSL_X509_free((WOLFSSL_X509*)obj);
+            break;
+        case WOLFCLU_CACHE_CONF:
+            wolfSSL_NCONF_free((WOLFSSL_CONF*)obj);
+            break;
+    }
+}
+
+
+static void wolfCLU_CacheFreeEntry(WOLFCLU_CACHE_ENTRY* e)
+{
+    if (e->data != NULL) {
+        wolfCLU_ForceZero(e->data, e->dataSz);
+        XFREE(e->data, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        e->data = NULL;
+    }
+
+    if (e->users > 0) {
+        /* keys and certificates are reference counted but configs are not,
+         * this one is freed when wolfCLU_FreeConfig gives it back */
+        e->next = cacheOrphans;
+        cacheOrphans = e;
+        return;
+    }
+
+    wolfCLU_CacheFreeObj(e->type, e->obj);
+    XFREE(e->path, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(e, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+}
+
+
+void wolfCLU_CacheEnable(int on)
+{
+    WOLFCLU_CACHE_ENTRY* e;
+
+    if (!on) {
+        while (cacheList != NULL) {
+            e = cacheList;
+            cacheList = e->next;
+            wolfCLU_CacheFreeEntry(e);
+        }
+    }
+    if ((on != 0) != (cacheOn != 0)) {
+        wolfCLU_KeyCtxEnable(on);
+    }
+    cacheOn = on;
+}
+
+
+/* reads all of path into a new buffer
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_CacheReadFile(const char* path, byte** data, word32* dataSz)
+{
+    XFILE f;
+    long  sz;
+    byte* buf;
+    int   ret = WOLFCLU_SUCCESS;
+
+    f = XFOPEN(path, "rb");
+    if (f == XBADFILE) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    if (XFSEEK(f, 0, XSEEK_END) != 0 || (sz = XFTELL(f)) < 0 ||
+            sz > WOLFCLU_CACHE_MAX_FILE || XFSEEK(f, 0, XSEEK_SET) != 0) {
+        XFCLOSE(f);
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    /* one extra byte so an empty file still gets a buffer */
+    buf = (byte*)XMALLOC(sz + 1, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (buf == NULL) {
+        ret = MEMORY_E;
+    }
+    else if ((long)XFREAD(buf, 1, sz, f) != sz) {
+        XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        ret = WOLFCLU_FATAL_ERROR;
+    }
+    XFCLOSE(f);
+
+    if (ret == WOLFCLU_SUCCESS) {
+        *data   = buf;
+        *dataSz = (word32)sz;
+    }
+    return ret;
+}
+
+
+/* finds path in the cache, moving it to the front. An entry whose file has
+ * changed since it was parsed is dropped */
+static WOLFCLU_CACHE_ENTRY* wolfCLU_CacheFind(int type, const char* path,
+        const byte* data, word32 dataSz)
+{
+    WOLFCLU_CACHE_ENTRY** prev = &cacheList;
+    WOLFCLU_CACHE_ENTRY*  e;
+
+    for (e = cacheList; e != NULL; prev = &e->next, e = e->next) {
+        if (e->type != type || XSTRCMP(e->path, path) != 0) {
+            continue;
+        }
+
+        *prev = e->next;
+        if (e->dataSz != dataSz || XMEMCMP(e->data, data, dataSz) != 0) {
+            wolfCLU_CacheFreeEntry(e);
+            return NULL;
+        }
+        e->next   = cacheList;
+        cacheList = e;
+        return e;
+    }
+    return NULL;
+}
+
+
+/* adds obj at the front of the cache, taking ownership of data on success */
+static int wolfCLU_CacheAdd(int type, const char* path, byte* data,
+        word32 dataSz, void* obj)
+{
+    WOLFCLU_CACHE_ENTRY*  e;
+    WOLFCLU_CACHE_ENTRY** last;
+    int count = 0;
+
+    e = (WOLFCLU_CACHE_ENTRY*)XMALLOC(sizeof(WOLFCLU_CACHE_ENTRY), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (e == NULL) {
+        return MEMORY_E;
+    }
+    e->path = (char*)XMALLOC(XSTRLEN(path) + 1, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (e->path == NULL) {
+        XFREE(e, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        return MEMORY_E;
+    }
+    XMEMCPY(e->path, path, XSTRLEN(path) + 1);
+    e->type   = type;
+    e->data   = data;
+    e->dataSz = dataSz;
+    e->obj    = obj;
+    e->users  = 0;
+    e->next   = cacheList;
+    cacheList = e;
+
+    /* drop the least recently used entry once over the limit */
+    for (last = &cacheList; *last != NULL; last = &(*last)->next) {
+        if (++count > WOLFCLU_CACHE_MAX) {
+            wolfCLU_CacheFreeEntry(*last);
+            *last = NULL;
+            break;
+        }
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* takes another reference to a cached object for the caller
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_CacheRef(WOLFCLU_CACHE_ENTRY* e)
+{
+    switch (e->type) {
+        case WOLFCLU_CACHE_PRIVKEY:
+        case WOLFCLU_CACHE_PUBKEY:
+            return (wolfSSL_EVP_PKEY_up_ref((WOLFSSL_EVP_PKEY*)e->obj) ==
+                    WOLFSSL_SUCCESS)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+        case WOLFCLU_CACHE_CERT:
+            return (wolfSSL_X509_up_ref((WOLFSSL_X509*)e->obj) ==
+                    WOLFSSL_SUCCESS)? WOLFCLU_SUCCESS : WOLFCLU_FATAL_ERROR;
+        default:
+            e->users++;
+            return WOLFCLU_SUCCESS;
+    }
+}
+
+
+/* parses data, or the file at path when data is NULL */
+static void* wolfCLU_CacheParse(int type, const char* path, const byte* data,
+        word32 dataSz, long* line)
+{
+    WOLFSSL_BIO*  bio;
+    WOLFSSL_CONF* conf;
+    void* obj = NULL;
+
+    switch (type) {
+        case WOLFCLU_CACHE_PRIVKEY:
+        case WOLFCLU_CACHE_PUBKEY:
+            if (data != NULL) {
+                bio = wolfSSL_BIO_new_mem_buf(data, (int)dataSz);
+            }
+            else {
+                bio = wolfSSL_BIO_new_file(path, "rb");
+            }
+            if (bio != NULL) {
+                if (type == WOLFCLU_CACHE_PRIVKEY) {
+                    obj = wolfSSL_PEM_read_bio_PrivateKey(bio, NULL, NULL,
+                            NULL);
+                }
+                else {
+                    obj = wolfSSL_PEM_read_bio_PUBKEY(bio, NULL, NULL, NULL);
+                }
+                wolfSSL_BIO_free(bio);
+            }
+            break;
+
+        case WOLFCLU_CACHE_CERT:
+            if (data != NULL) {
+                obj = wolfSSL_X509_load_certificate_buffer(data, (int)dataSz,
+                        WOLFSSL_FILETYPE_PEM);
+            }
+            else {
+                obj = wolfSSL_X509_load_certificate_file(path,
+                        WOLFSSL_FILETYPE_PEM);
+            }
+            break;
+
+        case WOLFCLU_CACHE_CONF:
+            /* wolfSSL only parses configs from a file */
+            conf = wolfSSL_NCONF_new(NULL);
+            if (conf != NULL &&
+                    wolfSSL_NCONF_load(conf, path, line) != WOLFSSL_SUCCESS) {
+                wolfSSL_NCONF_free(conf);
+                conf = NULL;
+            }
+            obj = conf;
+            break;
+    }
+    return obj;
+}
+
+
+static void* wolfCLU_CacheLoad(int type, const char* path, long* line)
+{
+    WOLFCLU_CACHE_ENTRY* e;
+    byte*  data = NULL;
+    word32 dataSz = 0;
+    void*  obj;
+
+    if (path == NULL) {
+        return NULL;
+    }
+
+    /* pipes and very large files are parsed as before and not cached */
+    if (wolfCLU_CacheReadFile(path, &data, &dataSz) != WOLFCLU_SUCCESS) {
+        return wolfCLU_CacheParse(type, path, NULL, 0, line);
+    }
+
+    if (cacheOn) {
+        e = wolfCLU_CacheFind(type, path, data, dataSz);
+        if (e != NULL && wolfCLU_CacheRef(e) == WOLFCLU_SUCCESS) {
+            wolfCLU_ForceZero(data, dataSz);
+            XFREE(data, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+            return e->obj;
+        }
+    }
+
+    obj = wolfCLU_CacheParse(type, path, data, dataSz, line);
+    if (obj != NULL && cacheOn &&
+            wolfCLU_CacheAdd(type, path, data, dataSz, obj) ==
+            WOLFCLU_SUCCESS) {
+        data = NULL; /* owned by the cache now */
+        if (wolfCLU_CacheRef(cacheList) != WOLFCLU_SUCCESS) {
+            obj = NULL; /* the cache keeps the only reference */
+        }
+    }
+
+    if (data != NULL) {
+        wolfCLU_ForceZero(data, dataSz);
+        XFREE(data, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    return obj;
+}
+
+
+WOLFSSL_EVP_PKEY* wolfCLU_LoadPrivateKey(const char* path)
+{
+    return (WOLFSSL_EVP_PKEY*)wolfCLU_CacheLoad(WOLFCLU_CACHE_PRIVKEY, path,
+            NULL);
+}
+
+
+WOLFSSL_EVP_PKEY* wolfCLU_LoadPublicKey(const char* path)
+{
+    return (WOLFSSL_EVP_PKEY*)wolfCLU_CacheLoad(WOLFCLU_CACHE_PUBKEY, path,
+            NULL);
+}
+
+
+WOLFSSL_X509* wolfCLU_LoadCertificate(const char* path)
+{
+    return (WOLFSSL_X509*)wolfCLU_CacheLoad(WOLFCLU_CACHE_CERT, path, NULL);
+}
+
+
+WOLFSSL_CONF* wolfCLU_LoadConfig(const char* path, long* line)
+{
+    return (WOLFSSL_CONF*)wolfCLU_CacheLoad(WOLFCLU_CACHE_CONF, path, line);
+}
+
+
+void wolfCLU_FreeConfig(WOLFSSL_CONF* conf)
+{
+    WOLFCLU_CACHE_ENTRY** prev;
+    WOLFCLU_CACHE_ENTRY*  e;
+
+    if (conf == NULL) {
+        return;
+    }
+
+    for (e = cacheList; e != NULL; e = e->next) {
+        if (e->obj == conf) {
+            e->users--;
+            return; /* still cached */
+        }
+    }
+
+    for (prev = &cacheOrphans; *prev != NULL; prev = &(*prev)->next) {
+        e = *prev;
+        if (e->obj == conf) {
+            if (--e->users == 0) {
+                *prev = e->next;
+                wolfCLU_CacheFreeEntry(e);
+            }
+            return;
+        }
+    }
+
+    wolfSSL_NCONF_free(conf);
+}
+
+
+static void wolfCLU_KeyCtxFree(WOLFCLU_KEYCTX* e)
+{
+    switch (e->type) {
+    #ifndef NO_RSA
+        case EVP_PKEY_RSA:
+            wc_FreeRsaKey(&e->key.rsa);
+            break;
+    #endif
+    #ifdef HAVE_ECC
+        case EVP_PKEY_EC:
+            wc_ecc_free(&e->key.ecc);
+            break;
+    #endif
+    }
+    XFREE(e, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+}
+
+
+/* drops the least recently used keys not in use once over the limit */
+static void wolfCLU_KeyCtxTrim(int max)
+{
+    WOLFCLU_KEYCTX** prev = &keyCtxList;
+    WOLFCLU_KEYCTX*  e;
+    int count = 0;
+
+    while ((e = *prev) != NULL) {
+        if (++count > max && e->users == 0) {
+            *prev = e->next;
+            wolfCLU_KeyCtxFree(e);
+            continue;
+        }
+        prev = &e->next;
+    }
+}
+
+
+void wolfCLU_KeyCtxEnable(int on)
+{
+    if (on) {
+        keyCtxOn++;
+        return;
+    }
+    if (keyCtxOn > 0 && --keyCtxOn == 0) {
+        /* keys still in use are freed when they are given back */
+        wolfCLU_KeyCtxTrim(0);
+        keyCtxList = NULL;
+    }
+}
+
+
+/* decodes der into a new entry
+ * returns NULL if it is not a public key of that type */
+static WOLFCLU_KEYCTX* wolfCLU_KeyCtxDecode(int type, const byte* der,
+        word32 derSz)
+{
+    WOLFCLU_KEYCTX* e;
+    word32 idx = 0;
+    int    ret = -1;
+
+    e = (WOLFCLU_KEYCTX*)XMALLOC(sizeof(WOLFCLU_KEYCTX), HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (e == NULL) {
+        return NULL;
+    }
+    XMEMSET(e, 0, sizeof(WOLFCLU_KEYCTX));
+
+    switch (type) {
+    #ifndef NO_RSA
+        case EVP_PKEY_RSA:
+            if (wc_InitRsaKey(&e->key.rsa, HEAP_HINT) == 0) {
+                e->type = type;
+                ret = wc_RsaPublicKeyDecode(der, &idx, &e->key.rsa, derSz);
+            }
+            break;
+    #endif
+    #ifdef HAVE_ECC
+        case EVP_PKEY_EC:
+            if (wc_ecc_init(&e->key.ecc) == 0) {
+                e->type = type;
+                ret = wc_EccPublicKeyDecode(der, &idx, &e->key.ecc, derSz);
+            }
+            break;
+    #endif
+    }
+
+    if (ret != 0) {
+        wolfCLU_KeyCtxFree(e);
+        return NULL;
+    }
+    e->users = 1;
+    return e;
+}
+
+
+void* wolfCLU_KeyCtxGet(int type, const byte* der, word32 derSz)
+{
+    WOLFCLU_KEYCTX*  e = NULL;
+#ifndef NO_SHA256
+    WOLFCLU_KEYCTX** prev;
+    byte id[WC_SHA256_DIGEST_SIZE];
+
+    if (der == NULL) {
+        return NULL;
+    }
+
+    if (keyCtxOn && wc_Sha256Hash(der, derSz, id) == 0) {
+        for (prev = &keyCtxList; *prev != NULL; prev = &(*prev)->next) {
+            e = *prev;
+            if (e->type == type && XMEMCMP(e->id, id, sizeof(id)) == 0) {
+                *prev = e->next;
+                e->next = keyCtxList;
+                keyCtxList = e;
+                e->users++;
+                return &e->key;
+            }
+        }
+
+        e = wolfCLU_KeyCtxDecode(type, der, derSz);
+        if (e != NULL) {
+            XMEMCPY(e->id, id, sizeof(id));
+            e->next = keyCtxList;
+            keyCtxList = e;
+            wolfCLU_KeyCtxTrim(WOLFCLU_KEYCTX_MAX);
+        }
+        return (e != NULL)? (void*)&e->key : NULL;
+    }
+#endif
+
+    /* not cached, given back to be freed */
+    if (der != NULL) {
+        e = wolfCLU_KeyCtxDecode(type, der, derSz);
+    }
+    return (e != NULL)? (void*)&e->key : NULL;
+}
+
+
+void wolfCLU_KeyCtxPut(void* key)
+{
+    WOLFCLU_KEYCTX* k = (WOLFCLU_KEYCTX*)key;
+    WOLFCLU_KEYCTX* e;
+
+    if (k == NULL) {
+        return;
+    }
+
+    for (e = keyCtxList; e != NULL; e = e->next) {
+        if (e == k) {
+            /* keys held past the limit can be dropped now */
+            if (--e->users == 0) {
+                wolfCLU_KeyCtxTrim(WOLFCLU_KEYCTX_MAX);
+            }
+            return;
+        }
+    }
+    wolfCLU_KeyCtxFree(k);
+}
@@ -30,8 +30,6 @@
 #define SALT_SIZE       8
 #define DES3_BLOCK_SIZE 24
 
-static int loop = 0;
-
 static const struct option crypt_algo_options[] = {
     /* AES */
     {"aes-128-ctr", no_argument, 0, WOLFCLU_AES128CTR},
@@ -61,6 +59,7 @@ static const struct option crypt_algo_options[] = {
     WOLFCLU_LOG(WOLFCLU_L0, "-help           Help, print out this help menu");
     WOLFCLU_LOG(WOLFCLU_L0, " ");
     WOLFCLU_LOG(WOLFCLU_L0, "Only set one of the following.\n");
+    WOLFCLU_LOG(WOLFCLU_L0, "batch          Run the commands in a file, one per line");
     WOLFCLU_LOG(WOLFCLU_L0, "ca             Used for signing certificates");
     WOLFCLU_LOG(WOLFCLU_L0, "bench          Benchmark one of the algorithms");
     WOLFCLU_LOG(WOLFCLU_L0, "decrypt        Decrypt an encrypted file");
@@ -73,7 +72,9 @@ static const struct option crypt_algo_options[] = {
     WOLFCLU_LOG(WOLFCLU_L0, "hash           Hash a file or input");
     WOLFCLU_LOG(WOLFCLU_L0, "md5            Creates and MD5 hash");
     WOLFCLU_LOG(WOLFCLU_L0, "pkey           Used for key operations");
+    WOLFCLU_LOG(WOLFCLU_L0, "pkeyutl        Sign, verify, encrypt, decrypt or derive a stream of records");
     WOLFCLU_LOG(WOLFCLU_L0, "req            Request for certificate generation");
+    WOLFCLU_LOG(WOLFCLU_L0, "signd          Keep keys loaded and sign over a Unix socket");
     WOLFCLU_LOG(WOLFCLU_L0, "-rsa           Legacy RSA signing and signature verification");
     WOLFCLU_LOG(WOLFCLU_L0, "rsa            RSA key operations");
     WOLFCLU_LOG(WOLFCLU_L0, "x509           X509 certificate processing");
@@ -94,6 +95,12 @@ static const struct option crypt_algo_options[] = {
            "                This flag takes no arguments.");
     WOLFCLU_LOG(WOLFCLU_L0, "-time           used by Benchmark, set time in seconds to run.");
     WOLFCLU_LOG(WOLFCLU_L0, "-verbose        display a more verbose help menu");
+    WOLFCLU_LOG(WOLFCLU_L0, "-memstats       print heap use to stderr when the command exits");
+    WOLFCLU_LOG(WOLFCLU_L0, "-stats          print time, RSS and I/O per phase to stderr on exit");
+    WOLFCLU_LOG(WOLFCLU_L0, "-stats-trace <file> as -stats and write a Chrome trace JSON file");
+    WOLFCLU_LOG(WOLFCLU_L0, "-quiet          only print errors, other messages are not formatted");
+    WOLFCLU_LOG(WOLFCLU_L0, "-logjson        print messages as JSON lines with time, level and command");
+    WOLFCLU_LOG(WOLFCLU_L0, "-logasync       queue messages and write them from a background thread");
     WOLFCLU_LOG(WOLFCLU_L0, "-inform         input format of the certificate file [PEM/DER]");
     WOLFCLU_LOG(WOLFCLU_L0, "-outform        format to output [PEM/DER]");
     WOLFCLU_LOG(WOLFCLU_L0, "-output         used with -genkey option to specify which keys to"
@@ -250,6 +257,9 @@ void wolfCLU_encryptHelp()
     WOLFCLU_LOG(WOLFCLU_L0, "\t-k another option for password input");
     WOLFCLU_LOG(WOLFCLU_L0, "\t-base64 handle decoding a base64 input");
     WOLFCLU_LOG(WOLFCLU_L0, "\t-nosalt do not use a salt input to kdf");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-iter PBKDF2 iteration count (implies -pbkdf2)");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-iter auto:<ms> use as many iterations as run in <ms>");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t      milliseconds, the count is stored in the output");
     WOLFCLU_LOG(WOLFCLU_L0, " ");
     WOLFCLU_LOG(WOLFCLU_L0, "***************************************************************");
     WOLFCLU_LOG(WOLFCLU_L0, "\nENCRYPT USAGE: wolfssl -encrypt <-algorithm> -in <filename> "
@@ -282,6 +292,8 @@ void wolfCLU_decryptHelp()
     WOLFCLU_LOG(WOLFCLU_L0, "***************************************************************");
     WOLFCLU_LOG(WOLFCLU_L0, "\nDECRYPT USAGE: wolfssl -decrypt <algorithm> -in <encrypted file> "
            "-pwd <password> -out <output file name>\n");
+    WOLFCLU_LOG(WOLFCLU_L0, "Use -iter <n> if the file was encrypted with -iter <n>, the"
+           " count from\n-iter auto:<ms> is read from the file.\n");
     WOLFCLU_LOG(WOLFCLU_L0, "***************************************************************");
     WOLFCLU_LOG(WOLFCLU_L0, "\nEXAMPLE: \n\nwolfssl -decrypt aes-cbc-128 -pwd Thi$i$myPa$$w0rd"
            " -in encryptedfile.txt -out decryptedfile.txt\n");
@@ -373,6 +385,36 @@ void wolfCLU_benchHelp()
 #endif
 #ifdef HAVE_BLAKE2
         , "blake2b"
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+        , "aes-128-gcm"
+        , "aes-256-gcm"
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESCCM)
+        , "aes-ccm"
+#endif
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+        , "chacha20-poly1305"
+#endif
+#ifndef NO_PWDBASED
+#ifndef NO_SHA
+        , "pbkdf2-sha"
+#endif
+#ifndef NO_SHA256
+        , "pbkdf2-sha256"
+#endif
+#ifdef WOLFSSL_SHA384
+        , "pbkdf2-sha384"
+#endif
+#ifdef WOLFSSL_SHA512
+        , "pbkdf2-sha512"
+#endif
+#if defined(HAVE_PKCS12) && !defined(NO_SHA256)
+        , "pkcs12-sha256"
+#endif
+#endif
+#ifndef WC_NO_RNG
+        , "drbg"
 #endif
     };
 
@@ -386,6 +428,27 @@ void wolfCLU_benchHelp()
     WOLFCLU_LOG(WOLFCLU_L0, "***************************************************************");
     WOLFCLU_LOG(WOLFCLU_L0, "USAGE: wolfssl -bench [alg] -time [time in seconds [1-10]]"
            "       or\n       wolfssl -bench -time 10 -all (to test all)");
+    WOLFCLU_LOG(WOLFCLU_L0, "Results include MB/s and, where a cycle counter is available,");
+    WOLFCLU_LOG(WOLFCLU_L0, "cycles per byte and cycles per operation.");
+    WOLFCLU_LOG(WOLFCLU_L0, "-latency    time each operation and report percentiles");
+    WOLFCLU_LOG(WOLFCLU_L0, "-warmup <n> untimed operations before each latency run");
+    WOLFCLU_LOG(WOLFCLU_L0, "-reps <n>   latency runs per test, for confidence intervals");
+    WOLFCLU_LOG(WOLFCLU_L0, "-perf       read hardware counters (Linux perf_event_open)");
+    WOLFCLU_LOG(WOLFCLU_L0, "            and report IPC, core clock and misses per KB");
+    WOLFCLU_LOG(WOLFCLU_L0, "AEAD tests time encrypt and decrypt+verify for each size pair:");
+    WOLFCLU_LOG(WOLFCLU_L0, "-msgsz <list> message sizes, default 16,256,1024,16384");
+    WOLFCLU_LOG(WOLFCLU_L0, "-aadsz <list> AAD sizes, default 0,13");
+    WOLFCLU_LOG(WOLFCLU_L0, "KDF tests report derivations and iterations per second.");
+    WOLFCLU_LOG(WOLFCLU_L0, "-e2e        run hash, enc, dec and dgst over a corpus of files");
+    WOLFCLU_LOG(WOLFCLU_L0, "            and report files/s, MB/s, I/O and crypto time");
+    WOLFCLU_LOG(WOLFCLU_L0, "-files <n>  files in the -e2e corpus, default 100");
+    WOLFCLU_LOG(WOLFCLU_L0, "-filesz <min>-<max> or <list>  file sizes, default 10-1048576");
+    WOLFCLU_LOG(WOLFCLU_L0, "-dir <dir>  where to make the corpus, default /dev/shm");
+    WOLFCLU_LOG(WOLFCLU_L0, "-keep       do not remove the corpus afterwards");
+    WOLFCLU_LOG(WOLFCLU_L0, "-tls        in-memory TLS handshakes/s and record MB/s");
+    WOLFCLU_LOG(WOLFCLU_L0, "            per suite and group, -msgsz sets the record sizes");
+    WOLFCLU_LOG(WOLFCLU_L0, "-suite <s>  only TLS suites with s in the name");
+    WOLFCLU_LOG(WOLFCLU_L0, "-group <g>  only TLS groups with g in the name (P-256, X25519)");
     WOLFCLU_LOG(WOLFCLU_L0, "***************************************************************");
     WOLFCLU_LOG(WOLFCLU_L0, "\nEXAMPLE: \n\nwolfssl -bench aes-cbc -time 10"
            " -in encryptedfile.txt -out decryptedfile.txt\n");
@@ -479,6 +542,10 @@ void wolfCLU_signHelp(int keyType)
             case ED25519_SIG_VER:
                 WOLFCLU_LOG(WOLFCLU_L0, "ED25519 Sign Usage: \nwolfssl -ed25519 -sign -inkey "
                        "<priv_key> -in <filename> -out <filename>\n");
+                WOLFCLU_LOG(WOLFCLU_L0, "-ph signs the SHA-512 hash of the input (Ed25519ph),"
+                       " reading it a piece at a time so any size of file can be signed");
+                WOLFCLU_LOG(WOLFCLU_L0, "-context <string> adds a context (Ed25519ctx, or"
+                       " Ed25519ph with -ph)\n");
                 WOLFCLU_LOG(WOLFCLU_L0, "***************************************************************");
                 break;
             #endif
@@ -491,6 +558,9 @@ void wolfCLU_signHelp(int keyType)
             default:
                 WOLFCLU_LOG(WOLFCLU_L0, "No valid key type defined.\n");
         }
+        WOLFCLU_LOG(WOLFCLU_L0, "-keycache <file> -keycachepass <stdin|pass:password>"
+               " loads the key from a key cache file, adding it there the"
+               " first time\n");
 }
 
 void wolfCLU_verifyHelp(int keyType) {
@@ -538,6 +608,8 @@ void wolfCLU_verifyHelp(int keyType) {
                        "wolfssl -ed25519 -verify -inkey "
                        "<pub_key> -sigfile <filename> -in <original> -pubin"
                        "\n");
+                WOLFCLU_LOG(WOLFCLU_L0, "-ph and -context <string> verify Ed25519ph and"
+                       " Ed25519ctx signatures\n");
                 WOLFCLU_LOG(WOLFCLU_L0, "***************************************************************");
                 break;
             #endif
@@ -551,6 +623,9 @@ void wolfCLU_verifyHelp(int keyType) {
             default:
                 WOLFCLU_LOG(WOLFCLU_L0, "No valid key type defined.\n");
         }
+        WOLFCLU_LOG(WOLFCLU_L0, "-keycache <file> -keycachepass <stdin|pass:password>"
+               " loads the key from a key cache file, adding it there the"
+               " first time\n");
 }
 
 void wolfCLU_certgenHelp() {
@@ -857,12 +932,13 @@ int wolfCLU_getAlgo(int argc, char** argv, int* alg, char** mode, int* size)
 {
     int ret = 0;
     int longIndex = 2;
+    WOLFCLU_GETOPT opt;
     int option;
     char name[80];
     char *argvCopy[argc];
     int i;
 
-    /* make a copy of args because getopt_long_only reorders them */
+    /* make a copy of args since wolfCLU_oldAlgo rewrites them */
     for (i = 0; i < argc; i++) argvCopy[i] = argv[i];
 
     /* first just try the 3rd argument for backwords compatibility */
@@ -877,8 +953,8 @@ int wolfCLU_getAlgo(int argc, char** argv, int* alg, char** mode, int* size)
 
     /* next check for -cipher option passed through args */
     if (ret < 0) {
-        opterr = 0; /* do not print out unknown options */
-        while ((option = getopt_long_only(argc, argvCopy, "",
+        wolfCLU_GetOptInit(&opt);
+        while ((option = wolfCLU_GetOpt(&opt, argc, argvCopy,
                        crypt_algo_options, &longIndex )) != -1) {
             switch (option) {
                 /* AES */
@@ -964,15 +1040,6 @@ void wolfCLU_append(char* s, char c)
     s[len+1] = '\0';
 }
 
-/*
- * resets benchmarking loop
- */
-void wolfCLU_stop(int signo)
-{
-    (void) signo; /* type cast to void for unused variable */
-    loop = 0;
-}
-
 /*
  * gets current time durring program execution
  */
@@ -1276,6 +1343,23 @@ void wolfCLU_ForceZero(void* mem, unsigned int len)
 }
 
 
+int wolfCLU_ParseNum(const char* arg, int min, int max, int* val)
+{
+    char* end = NULL;
+    long  num;
+
+    if (arg == NULL || val == NULL || *arg < '0' || *arg > '9') {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    num = strtol(arg, &end, 10);
+    if (*end != '\0' || num < min || num > max) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    *val = (int)num;
+    return WOLFCLU_SUCCESS;
+}
+
+
 int wolfCLU_GetPassword(char* password, int* passwordSz, char* arg)
 {
     int ret = WOLFCLU_SUCCESS;
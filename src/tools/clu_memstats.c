@@ -0,0 +1,285 @@
+/* clu_memstats.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_memstats.h>
+
+#if defined(USE_WOLFSSL_MEMORY) && !defined(WOLFSSL_STATIC_MEMORY)
+    #define WOLFCLU_HAVE_MEMSTATS
+#endif
+
+#ifdef WOLFCLU_HAVE_MEMSTATS
+
+/* each block is prefixed with its size, the prefix is kept at 16 bytes so
+ * the pointer handed back has the same alignment malloc gives */
+#define WOLFCLU_MEM_HDR_SZ 16
+
+#if defined(__GNUC__) || defined(__clang__)
+    /* rand -threads allocates from several threads at once */
+    #define WOLFCLU_MEM_ADD(v, n) \
+        __atomic_add_fetch(&(v), (n), __ATOMIC_RELAXED)
+    #define WOLFCLU_MEM_SUB(v, n) \
+        __atomic_sub_fetch(&(v), (n), __ATOMIC_RELAXED)
+    #define WOLFCLU_MEM_LOAD(v) __atomic_load_n(&(v), __ATOMIC_RELAXED)
+    #define WOLFCLU_MEM_STORE(v, n) \
+        __atomic_store_n(&(v), (n), __ATOMIC_RELAXED)
+    #define WOLFCLU_MEM_CAS(v, old, new) \
+        __atomic_compare_exchange_n(&(v), &(old), (new), 1, \
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#else
+    #define WOLFCLU_MEM_ADD(v, n)        ((v) += (n))
+    #define WOLFCLU_MEM_SUB(v, n)        ((v) -= (n))
+    #define WOLFCLU_MEM_LOAD(v)          (v)
+    #define WOLFCLU_MEM_STORE(v, n)      ((v) = (n))
+    #define WOLFCLU_MEM_CAS(v, old, new) ((v) = (new), 1)
+#endif
+
+static WOLFCLU_MEM_STATS memStats;
+static int memStatsOn = 0;
+
+/* peak and largest allocation since the last wolfCLU_MemStatsMark, kept
+ * apart so the totals for the whole command are not reset by a mark */
+static word64 markPeak = 0;
+static word64 markMax  = 0;
+
+
+/* raises v to val if val is larger */
+static void wolfCLU_MemRaise(word64* v, word64 val)
+{
+    word64 old = WOLFCLU_MEM_LOAD(*v);
+
+    while (val > old) {
+        if (WOLFCLU_MEM_CAS(*v, old, val)) {
+            break;
+        }
+    }
+}
+
+
+/* records a new block of sz bytes */
+static void wolfCLU_MemAdd(size_t sz)
+{
+    word64 cur;
+
+    WOLFCLU_MEM_ADD(memStats.allocs, 1);
+    WOLFCLU_MEM_ADD(memStats.totalBytes, (word64)sz);
+    cur = WOLFCLU_MEM_ADD(memStats.curBytes, (word64)sz);
+    wolfCLU_MemRaise(&memStats.peakBytes, cur);
+    wolfCLU_MemRaise(&memStats.maxAlloc, (word64)sz);
+    wolfCLU_MemRaise(&markPeak, cur);
+    wolfCLU_MemRaise(&markMax, (word64)sz);
+}
+
+
+#ifdef WOLFSSL_DEBUG_MEMORY
+static void* wolfCLU_MemMalloc(size_t sz, const char* func, unsigned int line)
+#else
+static void* wolfCLU_MemMalloc(size_t sz)
+#endif
+{
+    byte* p;
+
+#ifdef WOLFSSL_DEBUG_MEMORY
+    (void)func;
+    (void)line;
+#endif
+    p = (byte*)malloc(sz + WOLFCLU_MEM_HDR_SZ);
+    if (p == NULL) {
+        return NULL;
+    }
+    *(size_t*)p = sz;
+    wolfCLU_MemAdd(sz);
+    return p + WOLFCLU_MEM_HDR_SZ;
+}
+
+
+#ifdef WOLFSSL_DEBUG_MEMORY
+static void wolfCLU_MemFree(void* ptr, const char* func, unsigned int line)
+#else
+static void wolfCLU_MemFree(void* ptr)
+#endif
+{
+    byte* p;
+
+#ifdef WOLFSSL_DEBUG_MEMORY
+    (void)func;
+    (void)line;
+#endif
+    if (ptr == NULL) {
+        return;
+    }
+    p = (byte*)ptr - WOLFCLU_MEM_HDR_SZ;
+    WOLFCLU_MEM_ADD(memStats.frees, 1);
+    WOLFCLU_MEM_SUB(memStats.curBytes, (word64)*(size_t*)p);
+    free(p);
+}
+
+
+#ifdef WOLFSSL_DEBUG_MEMORY
+static void* wolfCLU_MemRealloc(void* ptr, size_t sz, const char* func,
+        unsigned int line)
+#else
+static void* wolfCLU_MemRealloc(void* ptr, size_t sz)
+#endif
+{
+    byte*  p;
+    size_t oldSz;
+
+#ifdef WOLFSSL_DEBUG_MEMORY
+    (void)func;
+    (void)line;
+#endif
+    if (ptr == NULL) {
+        p = (byte*)malloc(sz + WOLFCLU_MEM_HDR_SZ);
+        oldSz = 0;
+    }
+    else {
+        oldSz = *(size_t*)((byte*)ptr - WOLFCLU_MEM_HDR_SZ);
+        p = (byte*)realloc((byte*)ptr - WOLFCLU_MEM_HDR_SZ,
+                sz + WOLFCLU_MEM_HDR_SZ);
+    }
+    if (p == NULL) {
+        return NULL;
+    }
+    *(size_t*)p = sz;
+
+    /* counted as freeing the old block and allocating the new one */
+    if (ptr != NULL) {
+        WOLFCLU_MEM_ADD(memStats.frees, 1);
+        WOLFCLU_MEM_SUB(memStats.curBytes, (word64)oldSz);
+    }
+    wolfCLU_MemAdd(sz);
+    return p + WOLFCLU_MEM_HDR_SZ;
+}
+#endif /* WOLFCLU_HAVE_MEMSTATS */
+
+
+int wolfCLU_MemStatsInstall(void)
+{
+#ifdef WOLFCLU_HAVE_MEMSTATS
+    if (memStatsOn) {
+        return WOLFCLU_SUCCESS;
+    }
+    if (wolfSSL_SetAllocators(wolfCLU_MemMalloc, wolfCLU_MemFree,
+                wolfCLU_MemRealloc) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to install counting allocators");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    XMEMSET(&memStats, 0, sizeof(memStats));
+    memStatsOn = 1;
+    return WOLFCLU_SUCCESS;
+#else
+    WOLFCLU_LOG(WOLFCLU_E0, "-memstats needs wolfSSL built with its default "
+            "allocators");
+    return WOLFCLU_FATAL_ERROR;
+#endif
+}
+
+
+int wolfCLU_MemStatsEnabled(void)
+{
+#ifdef WOLFCLU_HAVE_MEMSTATS
+    return memStatsOn;
+#else
+    return 0;
+#endif
+}
+
+
+void wolfCLU_MemStatsGet(WOLFCLU_MEM_STATS* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+#ifdef WOLFCLU_HAVE_MEMSTATS
+    stats->allocs     = WOLFCLU_MEM_LOAD(memStats.allocs);
+    stats->frees      = WOLFCLU_MEM_LOAD(memStats.frees);
+    stats->totalBytes = WOLFCLU_MEM_LOAD(memStats.totalBytes);
+    stats->curBytes   = WOLFCLU_MEM_LOAD(memStats.curBytes);
+    stats->peakBytes  = WOLFCLU_MEM_LOAD(memStats.peakBytes);
+    stats->maxAlloc   = WOLFCLU_MEM_LOAD(memStats.maxAlloc);
+#else
+    XMEMSET(stats, 0, sizeof(WOLFCLU_MEM_STATS));
+#endif
+}
+
+
+void wolfCLU_MemStatsMark(WOLFCLU_MEM_STATS* mark)
+{
+#ifdef WOLFCLU_HAVE_MEMSTATS
+    /* other threads may be raising these at the same time */
+    WOLFCLU_MEM_STORE(markPeak, WOLFCLU_MEM_LOAD(memStats.curBytes));
+    WOLFCLU_MEM_STORE(markMax, (word64)0);
+#endif
+    wolfCLU_MemStatsGet(mark);
+}
+
+
+void wolfCLU_MemStatsSince(const WOLFCLU_MEM_STATS* mark,
+        WOLFCLU_MEM_STATS* out)
+{
+    WOLFCLU_MEM_STATS now;
+
+    if (mark == NULL || out == NULL) {
+        return;
+    }
+    wolfCLU_MemStatsGet(&now);
+#ifdef WOLFCLU_HAVE_MEMSTATS
+    now.peakBytes = WOLFCLU_MEM_LOAD(markPeak);
+    now.maxAlloc  = WOLFCLU_MEM_LOAD(markMax);
+#endif
+    out->allocs     = now.allocs - mark->allocs;
+    out->frees      = now.frees - mark->frees;
+    out->totalBytes = now.totalBytes - mark->totalBytes;
+    out->curBytes   = (now.curBytes > mark->curBytes)?
+        now.curBytes - mark->curBytes : 0;
+    out->peakBytes  = (now.peakBytes > mark->curBytes)?
+        now.peakBytes - mark->curBytes : 0;
+    out->maxAlloc   = now.maxAlloc;
+}
+
+
+void wolfCLU_MemStatsReport(void)
+{
+    WOLFCLU_MEM_STATS stats;
+
+    if (!wolfCLU_MemStatsEnabled()) {
+        return;
+    }
+    wolfCLU_MemStatsGet(&stats);
+
+    /* logged at the error level so it goes to stderr and does not mix with
+     * data written to stdout */
+    WOLFCLU_LOG(WOLFCLU_E0, "Memory statistics:");
+    WOLFCLU_LOG(WOLFCLU_E0, "  allocations      = %llu",
+            (unsigned long long)stats.allocs);
+    WOLFCLU_LOG(WOLFCLU_E0, "  frees            = %llu",
+            (unsigned long long)stats.frees);
+    WOLFCLU_LOG(WOLFCLU_E0, "  total bytes      = %llu",
+            (unsigned long long)stats.totalBytes);
+    WOLFCLU_LOG(WOLFCLU_E0, "  peak live bytes  = %llu",
+            (unsigned long long)stats.peakBytes);
+    WOLFCLU_LOG(WOLFCLU_E0, "  largest alloc    = %llu",
+            (unsigned long long)stats.maxAlloc);
+    WOLFCLU_LOG(WOLFCLU_E0, "  bytes not freed  = %llu",
+            (unsigned long long)stats.curBytes);
+}
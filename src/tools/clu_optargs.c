@@ -0,0 +1,126 @@
+/* clu_optargs.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_optargs.h>
+
+
+void wolfCLU_GetOptInit(WOLFCLU_GETOPT* opt)
+{
+    if (opt != NULL) {
+        opt->ind = 1;
+        opt->arg = NULL;
+    }
+}
+
+
+/* finds name, of length nameSz, in longOpts. An exact match wins, otherwise
+ * a prefix is accepted if every option it matches is handled the same way
+ * returns the index found or -1 */
+static int wolfCLU_GetOptFind(const struct option* longOpts, const char* name,
+        int nameSz)
+{
+    int i;
+    int found = -1;
+    int ambiguous = 0;
+
+    for (i = 0; longOpts[i].name != NULL; i++) {
+        if (XSTRNCMP(longOpts[i].name, name, nameSz) != 0) {
+            continue;
+        }
+        if ((int)XSTRLEN(longOpts[i].name) == nameSz) {
+            return i;
+        }
+        if (found < 0) {
+            found = i;
+        }
+        else if (longOpts[found].has_arg != longOpts[i].has_arg ||
+                 longOpts[found].flag    != longOpts[i].flag    ||
+                 longOpts[found].val     != longOpts[i].val) {
+            ambiguous = 1;
+        }
+    }
+
+    return ambiguous ? -1 : found;
+}
+
+
+int wolfCLU_GetOpt(WOLFCLU_GETOPT* opt, int argc, char** argv,
+        const struct option* longOpts, int* longIndex)
+{
+    const struct option* match;
+    char* name;
+    char* value;
+    int   nameSz;
+    int   idx;
+
+    if (opt == NULL || argv == NULL || longOpts == NULL) {
+        return -1;
+    }
+    opt->arg = NULL;
+
+    /* skip over entries that are not options */
+    while (opt->ind < argc && argv[opt->ind] != NULL &&
+            (argv[opt->ind][0] != '-' || argv[opt->ind][1] == '\0')) {
+        opt->ind++;
+    }
+    if (opt->ind >= argc || argv[opt->ind] == NULL) {
+        return -1;
+    }
+
+    name = argv[opt->ind++];
+    if (XSTRCMP(name, "--") == 0) {
+        opt->ind = argc; /* everything after "--" is left alone */
+        return -1;
+    }
+    name += (name[1] == '-') ? 2 : 1;
+
+    value  = XSTRSTR(name, "=");
+    nameSz = (value != NULL) ? (int)(value - name) : (int)XSTRLEN(name);
+    idx    = wolfCLU_GetOptFind(longOpts, name, nameSz);
+    if (idx < 0) {
+        return '?';
+    }
+    match = &longOpts[idx];
+    if (longIndex != NULL) {
+        *longIndex = idx;
+    }
+
+    if (value != NULL) {
+        if (match->has_arg == no_argument) {
+            return '?';
+        }
+        opt->arg = value + 1;
+    }
+    else if (match->has_arg == required_argument) {
+        if (opt->ind >= argc || argv[opt->ind] == NULL) {
+            return '?';
+        }
+        opt->arg = argv[opt->ind++];
+    }
+
+    if (match->flag != NULL) {
+        *match->flag = match->val;
+        return 0;
+    }
+    return match->val;
+}
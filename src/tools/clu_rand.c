@@ -23,9 +23,31 @@
 #include <wolfclu/clu_log.h>
 #include <wolfclu/clu_optargs.h>
 
+#ifndef SINGLE_THREADED
+    #include <pthread.h>
+#endif
+
+/* largest single request the Hash DRBG accepts */
+#ifndef RNG_MAX_BLOCK_LEN
+    #define RNG_MAX_BLOCK_LEN 0x10000
+#endif
+
+/* bytes generated and written at a time, a multiple of the 48 bytes that
+ * make up one 64 character base64 line so encoded chunks can be joined */
+#define WOLFCLU_RAND_CHUNK (48 * 16384)
+
+/* base64 of a full chunk, 64 characters and a newline per 48 bytes */
+#define WOLFCLU_RAND_ENC_SZ ((WOLFCLU_RAND_CHUNK / 48) * 65)
+
+/* default number of bytes drawn from one RNG instance before it is
+ * re-instantiated with fresh entropy */
+#define WOLFCLU_RAND_RESEED ((word64)1 << 30)
+
 static const struct option rand_options[] = {
-    {"out",    required_argument, 0, WOLFCLU_OUTFILE},
-    {"base64", no_argument,       0, WOLFCLU_BASE64 },
+    {"out",     required_argument, 0, WOLFCLU_OUTFILE},
+    {"base64",  no_argument,       0, WOLFCLU_BASE64 },
+    {"threads", required_argument, 0, WOLFCLU_THREADS},
+    {"reseed",  required_argument, 0, WOLFCLU_RESEED },
 
     {0, 0, 0, 0} /* terminal element */
 };
@@ -35,19 +57,326 @@ static void wolfCLU_RandHelp(void)
     WOLFCLU_LOG(WOLFCLU_L0, "wolfssl rand <num bytes>");
     WOLFCLU_LOG(WOLFCLU_L0, "\t-out the file to output data to (default to stdout)");
     WOLFCLU_LOG(WOLFCLU_L0, "\t-base64 output the results in base64 encoding");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-threads <n> generate with n threads, each with its own RNG");
+    WOLFCLU_LOG(WOLFCLU_L0, "\t-reseed <bytes> bytes drawn from an RNG before it is"
+            " reseeded");
+    WOLFCLU_LOG(WOLFCLU_L0, "\tsizes may end in K, M or G, i.e. wolfssl rand -out f 4G");
+}
+
+
+#ifndef WC_NO_RNG
+
+/* one generator, with the output of the chunk it last filled */
+typedef struct WOLFCLU_RAND_WORKER {
+    WC_RNG  rng;
+    word64  rngBytes;   /* bytes drawn since the RNG was seeded */
+    byte*   raw;        /* WOLFCLU_RAND_CHUNK bytes of random data */
+    byte*   enc;        /* base64 of raw, NULL if not encoding */
+    byte*   out;        /* raw or enc, whichever is written out */
+    word32  outSz;
+    int     ret;
+    int     rngInit;
+#ifndef SINGLE_THREADED
+    pthread_t       tid;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int             full;   /* out holds a chunk not yet written */
+    int             stop;   /* set by the writer to end the worker early */
+    int             id;
+    const struct WOLFCLU_RAND_STATE* state;
+#endif
+} WOLFCLU_RAND_WORKER;
+
+/* settings shared by all workers */
+typedef struct WOLFCLU_RAND_STATE {
+    word64 total;       /* bytes of random data to produce */
+    word64 chunks;      /* number of WOLFCLU_RAND_CHUNK sized pieces */
+    word64 reseed;
+    int    useBase64;
+    int    threads;
+} WOLFCLU_RAND_STATE;
+
+
+/* returns WOLFCLU_SUCCESS on success */
+int wolfCLU_RandGenerate(WC_RNG* rng, byte* out, word32 sz)
+{
+    word32 len;
+
+    while (sz > 0) {
+        len = (sz > RNG_MAX_BLOCK_LEN)? RNG_MAX_BLOCK_LEN : sz;
+        if (wc_RNG_GenerateBlock(rng, out, len) != 0) {
+            return WOLFCLU_FATAL_ERROR;
+        }
+        out += len;
+        sz  -= len;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* parses a byte count with an optional K, M or G suffix
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_RandParseSize(const char* in, word64* sz)
+{
+    char* end = NULL;
+    unsigned long long val;
+    int shift = 0;
+
+    if (in == NULL || *in == '-') {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    val = strtoull(in, &end, 10);
+    if (end == in) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    switch (*end) {
+        case '\0':
+            break;
+        case 'k': case 'K':
+            shift = 10;
+            break;
+        case 'm': case 'M':
+            shift = 20;
+            break;
+        case 'g': case 'G':
+            shift = 30;
+            break;
+        default:
+            return WOLFCLU_FATAL_ERROR;
+    }
+    if (shift > 0 && end[1] != '\0') {
+        return WOLFCLU_FATAL_ERROR;
+    }
+    if (val == 0 || val > (0xFFFFFFFFFFFFFFFFULL >> shift)) {
+        return WOLFCLU_FATAL_ERROR;
+    }
+
+    *sz = (word64)val << shift;
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* fills the worker's buffer with chunk number 'idx' of the output
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_RandFill(const WOLFCLU_RAND_STATE* state,
+        WOLFCLU_RAND_WORKER* w, word64 idx)
+{
+    word64 left = state->total - idx * WOLFCLU_RAND_CHUNK;
+    word32 sz   = (left > WOLFCLU_RAND_CHUNK)? WOLFCLU_RAND_CHUNK :
+                                               (word32)left;
+    word32 encSz;
+
+    if (w->rngBytes >= state->reseed) {
+        wc_FreeRng(&w->rng);
+        w->rngInit = 0;
+        if (wc_InitRng(&w->rng) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to reseed RNG");
+            return WOLFCLU_FATAL_ERROR;
+        }
+        w->rngInit  = 1;
+        w->rngBytes = 0;
+    }
+
+    if (wolfCLU_RandGenerate(&w->rng, w->raw, sz) != WOLFCLU_SUCCESS) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to generate RNG block");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    w->rngBytes += sz;
+    w->out   = w->raw;
+    w->outSz = sz;
+
+    if (state->useBase64) {
+        encSz = WOLFCLU_RAND_ENC_SZ;
+        if (Base64_Encode(w->raw, sz, w->enc, &encSz) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Error base64 encoding");
+            return WOLFCLU_FATAL_ERROR;
+        }
+        wolfCLU_ForceZero(w->raw, sz);
+        w->out   = w->enc;
+        w->outSz = encSz;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+/* returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_RandWorkerInit(const WOLFCLU_RAND_STATE* state,
+        WOLFCLU_RAND_WORKER* w)
+{
+    XMEMSET(w, 0, sizeof(WOLFCLU_RAND_WORKER));
+    w->raw = (byte*)XMALLOC(WOLFCLU_RAND_CHUNK, HEAP_HINT,
+            DYNAMIC_TYPE_TMP_BUFFER);
+    if (w->raw == NULL) {
+        return MEMORY_E;
+    }
+    if (state->useBase64) {
+        w->enc = (byte*)XMALLOC(WOLFCLU_RAND_ENC_SZ, HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (w->enc == NULL) {
+            return MEMORY_E;
+        }
+    }
+    if (wc_InitRng(&w->rng) != 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to initialize RNG");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    w->rngInit = 1;
+    return WOLFCLU_SUCCESS;
 }
 
 
+static void wolfCLU_RandWorkerFree(WOLFCLU_RAND_WORKER* w)
+{
+    if (w->rngInit) {
+        wc_FreeRng(&w->rng);
+    }
+    if (w->raw != NULL) {
+        wolfCLU_ForceZero(w->raw, WOLFCLU_RAND_CHUNK);
+    }
+    if (w->enc != NULL) {
+        wolfCLU_ForceZero(w->enc, WOLFCLU_RAND_ENC_SZ);
+    }
+    wolfCLU_freeBins(w->raw, w->enc, NULL, NULL, NULL);
+    w->raw = NULL;
+    w->enc = NULL;
+}
+
+
+/* writes out a filled chunk
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_RandWrite(WOLFSSL_BIO* bioOut, WOLFCLU_RAND_WORKER* w)
+{
+    if (wolfSSL_BIO_write(bioOut, w->out, (int)w->outSz) != (int)w->outSz) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Error writing out RNG data");
+        return WOLFCLU_FATAL_ERROR;
+    }
+    return WOLFCLU_SUCCESS;
+}
+
+
+#ifndef SINGLE_THREADED
+/* worker 'id' fills chunks id, id + threads, ... handing each one to the
+ * writer and waiting for it to be written before reusing the buffer */
+static void* wolfCLU_RandThread(void* arg)
+{
+    WOLFCLU_RAND_WORKER* w = (WOLFCLU_RAND_WORKER*)arg;
+    const WOLFCLU_RAND_STATE* state = w->state;
+    word64 idx;
+    int ret;
+
+    for (idx = (word64)w->id; idx < state->chunks;
+            idx += (word64)state->threads) {
+        pthread_mutex_lock(&w->lock);
+        while (w->full && !w->stop) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+        pthread_mutex_unlock(&w->lock);
+        if (w->stop) {
+            break;
+        }
+
+        ret = wolfCLU_RandFill(state, w, idx);
+
+        pthread_mutex_lock(&w->lock);
+        w->ret  = ret;
+        w->full = 1;
+        pthread_cond_signal(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+        if (ret != WOLFCLU_SUCCESS) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+
+/* generates with state->threads workers while this thread writes the chunks
+ * out in order
+ * returns WOLFCLU_SUCCESS on success */
+static int wolfCLU_RandThreaded(const WOLFCLU_RAND_STATE* state,
+        WOLFCLU_RAND_WORKER* workers, WOLFSSL_BIO* bioOut)
+{
+    int ret = WOLFCLU_SUCCESS;
+    int started = 0;
+    int i;
+    word64 idx;
+    WOLFCLU_RAND_WORKER* w;
+
+    for (i = 0; i < state->threads; i++) {
+        workers[i].id    = i;
+        workers[i].state = state;
+        pthread_mutex_init(&workers[i].lock, NULL);
+        pthread_cond_init(&workers[i].cond, NULL);
+    }
+
+    for (i = 0; i < state->threads; i++) {
+        if (pthread_create(&workers[i].tid, NULL, wolfCLU_RandThread,
+                    &workers[i]) != 0) {
+            WOLFCLU_LOG(WOLFCLU_E0, "Unable to create thread");
+            ret = WOLFCLU_FATAL_ERROR;
+            break;
+        }
+        started++;
+    }
+
+    for (idx = 0; ret == WOLFCLU_SUCCESS && idx < state->chunks; idx++) {
+        w = &workers[idx % (word64)state->threads];
+
+        pthread_mutex_lock(&w->lock);
+        while (!w->full) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+        pthread_mutex_unlock(&w->lock);
+
+        ret = w->ret;
+        if (ret == WOLFCLU_SUCCESS) {
+            ret = wolfCLU_RandWrite(bioOut, w);
+        }
+
+        pthread_mutex_lock(&w->lock);
+        w->full = 0;
+        pthread_cond_signal(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+
+    /* on error release any workers still waiting on the writer */
+    for (i = 0; i < started; i++) {
+        pthread_mutex_lock(&workers[i].lock);
+        workers[i].stop = 1;
+        pthread_cond_signal(&workers[i].cond);
+        pthread_mutex_unlock(&workers[i].lock);
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(workers[i].tid, NULL);
+    }
+    for (i = 0; i < state->threads; i++) {
+        pthread_mutex_destroy(&workers[i].lock);
+        pthread_cond_destroy(&workers[i].cond);
+    }
+
+    return ret;
+}
+#endif /* !SINGLE_THREADED */
+#endif /* !WC_NO_RNG */
+
+
 int wolfCLU_Rand(int argc, char** argv)
 {
 #ifndef WC_NO_RNG
     int ret       = WOLFCLU_SUCCESS;
     int useBase64 = 0;
-    int size      = 0;
+    int threads   = 1;
     int option;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
+    int i;
+    word64 size   = 0;
+    word64 reseed = WOLFCLU_RAND_RESEED;
+    word64 idx;
     WOLFSSL_BIO *bioOut = NULL;
-    byte *buf = NULL;
+    WOLFCLU_RAND_STATE   state;
+    WOLFCLU_RAND_WORKER* workers = NULL;
 
     /* last parameter is the rand bytes output size */
     if (XSTRNCMP("-h", argv[argc-1], 2) == 0) {
@@ -55,17 +384,15 @@ int wolfCLU_Rand(int argc, char** argv)
         return WOLFCLU_SUCCESS;
     }
     else {
-        size = XATOI(argv[argc-1]);
-        if (size <= 0) {
+        if (wolfCLU_RandParseSize(argv[argc-1], &size) != WOLFCLU_SUCCESS) {
             WOLFCLU_LOG(WOLFCLU_E0, "Unable to convert %s to a number",
                     argv[argc-1]);
             ret = WOLFCLU_FATAL_ERROR;
         }
     }
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "",
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv,
                    rand_options, &longIndex )) != -1) {
         switch (option) {
             case WOLFCLU_BASE64:
@@ -73,16 +400,41 @@ int wolfCLU_Rand(int argc, char** argv)
                 break;
 
             case WOLFCLU_OUTFILE:
-                bioOut = wolfSSL_BIO_new_file(optarg, "wb");
+                bioOut = wolfSSL_BIO_new_file(opt.arg, "wb");
                 if (bioOut == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open output file %s",
-                            optarg);
+                            opt.arg);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+                break;
+
+            case WOLFCLU_THREADS:
+                if (wolfCLU_ParseNum(opt.arg, 1, MAX_THREADS, &threads)
+                        != WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "-threads must be between 1 and "
+                            "%d", MAX_THREADS);
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+            #ifdef SINGLE_THREADED
+                else if (threads > 1) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "Threads are not available in "
+                            "this build");
+                    ret = WOLFCLU_FATAL_ERROR;
+                }
+            #endif
+                break;
+
+            case WOLFCLU_RESEED:
+                if (wolfCLU_RandParseSize(opt.arg, &reseed) !=
+                        WOLFCLU_SUCCESS) {
+                    WOLFCLU_LOG(WOLFCLU_E0, "Invalid -reseed size %s", opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_HELP:
                 wolfCLU_RandHelp();
+                wolfSSL_BIO_free(bioOut);
                 return WOLFCLU_SUCCESS;
 
             case ':':
@@ -95,29 +447,34 @@ int wolfCLU_Rand(int argc, char** argv)
         }
     }
 
+    XMEMSET(&state, 0, sizeof(state));
+    state.total     = size;
+    state.chunks    = (size + WOLFCLU_RAND_CHUNK - 1) / WOLFCLU_RAND_CHUNK;
+    state.reseed    = reseed;
+    state.useBase64 = useBase64;
+    state.threads   = threads;
 
-    if (ret == WOLFCLU_SUCCESS) {
-        buf = (byte*)XMALLOC(size, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (buf == NULL) {
-            ret = WOLFCLU_FATAL_ERROR;
-        }
+    /* no point in more workers than there are chunks */
+    if ((word64)state.threads > state.chunks) {
+        state.threads = (int)state.chunks;
     }
 
     if (ret == WOLFCLU_SUCCESS) {
-        WC_RNG rng;
-        if (wc_InitRng(&rng) != 0) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Unable to initialize RNG");
-            ret = WOLFCLU_FATAL_ERROR;
+        workers = (WOLFCLU_RAND_WORKER*)XMALLOC(
+                sizeof(WOLFCLU_RAND_WORKER) * state.threads, HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (workers == NULL) {
+            ret = MEMORY_E;
         }
         else {
-            if (wc_RNG_GenerateBlock(&rng, buf, size) != 0) {
-                WOLFCLU_LOG(WOLFCLU_E0, "Unable to generate RNG block");
-                ret = WOLFCLU_FATAL_ERROR;
-            }
-            wc_FreeRng(&rng);
+            XMEMSET(workers, 0, sizeof(WOLFCLU_RAND_WORKER) * state.threads);
         }
     }
 
+    for (i = 0; ret == WOLFCLU_SUCCESS && i < state.threads; i++) {
+        ret = wolfCLU_RandWorkerInit(&state, &workers[i]);
+    }
+
     /* setup output bio to stdout if not set */
     if (ret == WOLFCLU_SUCCESS && bioOut == NULL) {
         bioOut = wolfSSL_BIO_new(wolfSSL_BIO_s_file());
@@ -132,49 +489,30 @@ int wolfCLU_Rand(int argc, char** argv)
         }
     }
 
-    /* check and convert to base64 */
-    if (ret == WOLFCLU_SUCCESS && useBase64) {
-        byte *base64 = NULL;
-        word32 base64Sz;
-
-        if (Base64_Encode(buf, size, NULL, &base64Sz) != LENGTH_ONLY_E) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Error getting size for base64");
-            ret = WOLFCLU_FATAL_ERROR;
-        }
-
-        base64 = (byte*)XMALLOC(base64Sz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-        if (base64 == NULL) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Error malloc'ing for base64");
-            ret = WOLFCLU_FATAL_ERROR;
-        }
-
-        if (Base64_Encode(buf, size, base64, &base64Sz) != 0) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Error base64 encoding");
-            ret = WOLFCLU_FATAL_ERROR;
-        }
-
-        if (ret == WOLFCLU_SUCCESS) {
-            wolfCLU_ForceZero(buf, size);
-            XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
-            buf  = base64;
-            size = base64Sz;
+    /* generate and write out one chunk at a time */
+    if (ret == WOLFCLU_SUCCESS) {
+    #ifndef SINGLE_THREADED
+        if (state.threads > 1) {
+            ret = wolfCLU_RandThreaded(&state, workers, bioOut);
         }
-        else {
-            XFREE(base64, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        else
+    #endif
+        {
+            for (idx = 0; ret == WOLFCLU_SUCCESS && idx < state.chunks;
+                    idx++) {
+                ret = wolfCLU_RandFill(&state, &workers[0], idx);
+                if (ret == WOLFCLU_SUCCESS) {
+                    ret = wolfCLU_RandWrite(bioOut, &workers[0]);
+                }
+            }
         }
     }
 
-    /* write out the results */
-    if (ret == WOLFCLU_SUCCESS) {
-        if (wolfSSL_BIO_write(bioOut, buf, size) != size) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Error writing out RNG data");
-            ret = WOLFCLU_FATAL_ERROR;
+    if (workers != NULL) {
+        for (i = 0; i < state.threads; i++) {
+            wolfCLU_RandWorkerFree(&workers[i]);
         }
-    }
-
-    if (buf != NULL) {
-        wolfCLU_ForceZero(buf, size);
-        XFREE(buf, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(workers, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
     }
     wolfSSL_BIO_free(bioOut);
 
@@ -184,4 +522,3 @@ int wolfCLU_Rand(int argc, char** argv)
     return WOLFCLU_FATAL_ERROR;
 #endif
 }
-
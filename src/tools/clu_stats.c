@@ -0,0 +1,350 @@
+/* clu_stats.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfclu/clu_header_main.h>
+#include <wolfclu/clu_log.h>
+#include <wolfclu/clu_stats.h>
+#include <wolfclu/benchmark/clu_bench.h>
+
+#if !defined(USE_WINDOWS_API)
+    #include <fcntl.h>
+    #include <sys/resource.h>
+    #define WOLFCLU_HAVE_RUSAGE
+#endif
+
+/* trace events are kept in memory until the report so that writing them
+ * out is not counted, this is how many are kept at most */
+#define WOLFCLU_STATS_MAX_EVENTS 100000
+#define WOLFCLU_STATS_FIRST_EVENTS 1024
+
+/* counters read each time the phase changes */
+typedef struct WOLFCLU_STAT_SAMPLE {
+    word64 ns;
+    word64 userUs;
+    word64 sysUs;
+    word64 rd;      /* bytes read by the process */
+    word64 wr;      /* bytes written by the process */
+} WOLFCLU_STAT_SAMPLE;
+
+/* one span of a single phase for the trace file */
+typedef struct WOLFCLU_STAT_EVENT {
+    int    phase;
+    word64 startNs;
+    word64 durNs;
+    word64 rd;
+    word64 wr;
+} WOLFCLU_STAT_EVENT;
+
+static const char* statNames[WOLFCLU_STAT_COUNT] = {
+    "other", "init", "args", "key", "crypto", "io", "format"
+};
+
+static int statsOn    = 0;
+static int statsPhase = WOLFCLU_STAT_OTHER;
+static WOLFCLU_STAT_SAMPLE statsFirst;
+static WOLFCLU_STAT_SAMPLE statsLast;
+static WOLFCLU_STAT_SAMPLE statsTotal[WOLFCLU_STAT_COUNT];
+static word64 statsSpans[WOLFCLU_STAT_COUNT];
+
+/* /proc/self/io, kept open so each sample is a single pread */
+static int    statsIoFd   = -1;
+static word64 statsIoSelf = 0; /* bytes the process read from statsIoFd */
+
+static const char* statsTracePath = NULL;
+static WOLFCLU_STAT_EVENT* statsEvents = NULL;
+static int statsEventCount = 0;
+static int statsEventMax   = 0;
+static word64 statsDropped = 0;
+
+
+/* reads the rchar and wchar counters, which include reads and writes of
+ * terminals and pipes as well as files, leaving them at 0 if unavailable */
+static void wolfCLU_StatsReadIo(WOLFCLU_STAT_SAMPLE* s)
+{
+#ifdef WOLFCLU_HAVE_RUSAGE
+    char    buf[512];
+    char*   line;
+    ssize_t n;
+
+    if (statsIoFd < 0) {
+        return;
+    }
+    n = pread(statsIoFd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) {
+        return;
+    }
+    buf[n] = '\0';
+
+    line = XSTRSTR(buf, "rchar:");
+    if (line != NULL) {
+        /* do not count reading the counters themselves */
+        s->rd = (word64)strtoull(line + 6, NULL, 10) - statsIoSelf;
+    }
+    line = XSTRSTR(buf, "wchar:");
+    if (line != NULL) {
+        s->wr = (word64)strtoull(line + 6, NULL, 10);
+    }
+    statsIoSelf += (word64)n;
+#else
+    (void)s;
+#endif
+}
+
+
+static void wolfCLU_StatsSample(WOLFCLU_STAT_SAMPLE* s)
+{
+#ifdef WOLFCLU_HAVE_RUSAGE
+    struct rusage ru;
+#endif
+
+    XMEMSET(s, 0, sizeof(WOLFCLU_STAT_SAMPLE));
+    s->ns = wolfCLU_TimerNs();
+#ifdef WOLFCLU_HAVE_RUSAGE
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        s->userUs = (word64)ru.ru_utime.tv_sec * 1000000 +
+                    (word64)ru.ru_utime.tv_usec;
+        s->sysUs  = (word64)ru.ru_stime.tv_sec * 1000000 +
+                    (word64)ru.ru_stime.tv_usec;
+    }
+#endif
+    wolfCLU_StatsReadIo(s);
+}
+
+
+/* keeps a span for the trace file, growing the list as needed */
+static void wolfCLU_StatsAddEvent(int phase, const WOLFCLU_STAT_SAMPLE* from,
+        const WOLFCLU_STAT_SAMPLE* to)
+{
+    WOLFCLU_STAT_EVENT* ev;
+
+    if (statsTracePath == NULL || to->ns == from->ns) {
+        return;
+    }
+
+    if (statsEventCount == statsEventMax) {
+        int newMax = (statsEventMax == 0)? WOLFCLU_STATS_FIRST_EVENTS :
+                                           statsEventMax * 2;
+
+        if (newMax > WOLFCLU_STATS_MAX_EVENTS) {
+            statsDropped++;
+            return;
+        }
+        ev = (WOLFCLU_STAT_EVENT*)XREALLOC(statsEvents,
+                newMax * sizeof(WOLFCLU_STAT_EVENT), HEAP_HINT,
+                DYNAMIC_TYPE_TMP_BUFFER);
+        if (ev == NULL) {
+            statsDropped++;
+            return;
+        }
+        statsEvents   = ev;
+        statsEventMax = newMax;
+    }
+
+    ev = &statsEvents[statsEventCount++];
+    ev->phase   = phase;
+    ev->startNs = from->ns - statsFirst.ns;
+    ev->durNs   = to->ns - from->ns;
+    ev->rd      = to->rd - from->rd;
+    ev->wr      = to->wr - from->wr;
+}
+
+
+/* charges everything since the last change to the current phase and moves
+ * to next */
+static void wolfCLU_StatsSwitch(int next)
+{
+    WOLFCLU_STAT_SAMPLE  now;
+    WOLFCLU_STAT_SAMPLE* t = &statsTotal[statsPhase];
+
+    wolfCLU_StatsSample(&now);
+    t->ns     += now.ns - statsLast.ns;
+    t->userUs += now.userUs - statsLast.userUs;
+    t->sysUs  += now.sysUs - statsLast.sysUs;
+    t->rd     += now.rd - statsLast.rd;
+    t->wr     += now.wr - statsLast.wr;
+    wolfCLU_StatsAddEvent(statsPhase, &statsLast, &now);
+
+    statsLast  = now;
+    statsPhase = next;
+}
+
+
+int wolfCLU_StatsEnable(const char* tracePath)
+{
+    if (statsOn) {
+        return WOLFCLU_SUCCESS;
+    }
+
+#ifdef WOLFCLU_HAVE_RUSAGE
+    statsIoFd = open("/proc/self/io", O_RDONLY);
+#endif
+    statsTracePath = tracePath;
+    statsOn = 1;
+
+    wolfCLU_StatsSample(&statsFirst);
+    statsLast = statsFirst;
+    return WOLFCLU_SUCCESS;
+}
+
+
+int wolfCLU_StatsEnabled(void)
+{
+    return statsOn;
+}
+
+
+int wolfCLU_StatsBegin(int phase)
+{
+    int prev = statsPhase;
+
+    if (!statsOn || phase == prev || phase < 0 ||
+            phase >= WOLFCLU_STAT_COUNT) {
+        return prev;
+    }
+    wolfCLU_StatsSwitch(phase);
+    statsSpans[phase]++;
+    return prev;
+}
+
+
+void wolfCLU_StatsEnd(int prev)
+{
+    if (!statsOn || prev == statsPhase) {
+        return;
+    }
+    wolfCLU_StatsSwitch(prev);
+}
+
+
+static void wolfCLU_StatsWriteTrace(void)
+{
+    XFILE f;
+    int   i;
+
+    f = XFOPEN(statsTracePath, "wb");
+    if (f == XBADFILE) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Unable to open trace file %s",
+                statsTracePath);
+        return;
+    }
+
+    /* Chrome trace event format, times are in microseconds */
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (i = 0; i < statsEventCount; i++) {
+        const WOLFCLU_STAT_EVENT* ev = &statsEvents[i];
+
+        fprintf(f, "{\"name\":\"%s\",\"cat\":\"wolfssl\",\"ph\":\"X\","
+                "\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"read\":%llu,\"written\":%llu}}%s\n",
+                statNames[ev->phase], (double)ev->startNs / 1000.0,
+                (double)ev->durNs / 1000.0, (unsigned long long)ev->rd,
+                (unsigned long long)ev->wr,
+                (i + 1 < statsEventCount)? "," : "");
+    }
+    fprintf(f, "]}\n");
+    XFCLOSE(f);
+
+    if (statsDropped > 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "Trace is missing %llu spans past the first "
+                "%d", (unsigned long long)statsDropped,
+                WOLFCLU_STATS_MAX_EVENTS);
+    }
+}
+
+
+static void wolfCLU_StatsLine(const char* name, const WOLFCLU_STAT_SAMPLE* t)
+{
+    char mbs[16];
+
+    if (t->ns > 0 && (t->rd + t->wr) > 0) {
+        XSNPRINTF(mbs, sizeof(mbs), "%.1f", ((double)(t->rd + t->wr) /
+                    MEGABYTE) / ((double)t->ns / 1000000000.0));
+    }
+    else {
+        XSNPRINTF(mbs, sizeof(mbs), "%s", "-");
+    }
+    WOLFCLU_LOG(WOLFCLU_E0, "%-7s%10.3f%10.3f%10.3f%12llu%12llu%9s", name,
+            (double)t->ns / 1000000.0, (double)t->userUs / 1000.0,
+            (double)t->sysUs / 1000.0, (unsigned long long)t->rd,
+            (unsigned long long)t->wr, mbs);
+}
+
+
+void wolfCLU_StatsReport(void)
+{
+    WOLFCLU_STAT_SAMPLE sum;
+    int i;
+#ifdef WOLFCLU_HAVE_RUSAGE
+    struct rusage ru;
+#endif
+
+    if (!statsOn) {
+        return;
+    }
+
+    /* so output still buffered by stdio is counted */
+    fflush(stdout);
+    wolfCLU_StatsSwitch(WOLFCLU_STAT_OTHER);
+
+    /* logged at the error level so it goes to stderr and does not mix with
+     * data written to stdout */
+    WOLFCLU_LOG(WOLFCLU_E0, "Phase statistics:");
+    WOLFCLU_LOG(WOLFCLU_E0, "%-7s%10s%10s%10s%12s%12s%9s", "phase", "wall ms",
+            "user ms", "sys ms", "read B", "written B", "MB/s");
+    XMEMSET(&sum, 0, sizeof(sum));
+    for (i = 0; i < WOLFCLU_STAT_COUNT; i++) {
+        if (statsSpans[i] == 0 && statsTotal[i].ns == 0) {
+            continue;
+        }
+        wolfCLU_StatsLine(statNames[i], &statsTotal[i]);
+        sum.ns     += statsTotal[i].ns;
+        sum.userUs += statsTotal[i].userUs;
+        sum.sysUs  += statsTotal[i].sysUs;
+        sum.rd     += statsTotal[i].rd;
+        sum.wr     += statsTotal[i].wr;
+    }
+    wolfCLU_StatsLine("total", &sum);
+#ifdef WOLFCLU_HAVE_RUSAGE
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        /* kilobytes on Linux, bytes on macOS */
+    #ifdef __APPLE__
+        ru.ru_maxrss /= 1024;
+    #endif
+        WOLFCLU_LOG(WOLFCLU_E0, "max RSS = %ld KB", (long)ru.ru_maxrss);
+    }
+    if (statsIoFd < 0) {
+        WOLFCLU_LOG(WOLFCLU_E0, "byte counts need /proc/self/io");
+    }
+    else {
+        close(statsIoFd);
+        statsIoFd = -1;
+    }
+#endif
+
+    if (statsTracePath != NULL) {
+        wolfCLU_StatsWriteTrace();
+    }
+    if (statsEvents != NULL) {
+        XFREE(statsEvents, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+        statsEvents = NULL;
+    }
+    statsOn = 0;
+}
@@ -22,6 +22,7 @@
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
 #include <wolfclu/clu_optargs.h>
+#include <wolfclu/clu_cache.h>
 #include <wolfclu/x509/clu_request.h>
 #include <wolfclu/x509/clu_cert.h>
 #include <wolfclu/x509/clu_x509_sign.h>
@@ -63,10 +64,10 @@ static void wolfCLU_CAHelp(void)
 int wolfCLU_CASetup(int argc, char** argv)
 {
     WOLFCLU_CERT_SIGN* signer = NULL;
-    WOLFSSL_BIO *keyIn  = NULL;
     WOLFSSL_BIO *reqIn  = NULL;
     WOLFSSL_X509 *x509  = NULL;
     WOLFSSL_X509 *ca    = NULL;
+    char* keyFile = NULL;
     WOLFSSL_EVP_PKEY* pkey = NULL;
     enum wc_HashType hashType = WC_HASH_TYPE_NONE;
 
@@ -78,20 +79,20 @@ int wolfCLU_CASetup(int argc, char** argv)
     int inForm  = PEM_FORM;
     int option;
     int longIndex = 1;
+    WOLFCLU_GETOPT opt;
     int days = 0;
     int selfSigned = 0;
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "", ca_options,
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv, ca_options,
                     &longIndex )) != -1) {
 
         switch (option) {
             case WOLFCLU_INFILE:
-                reqIn = wolfSSL_BIO_new_file(optarg, "rb");
+                reqIn = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (reqIn == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open CSR file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
@@ -101,26 +102,20 @@ int wolfCLU_CASetup(int argc, char** argv)
                 break;
 
             case WOLFCLU_KEY:
-                keyIn = wolfSSL_BIO_new_file(optarg, "rb");
-                if (keyIn == NULL) {
-                    WOLFCLU_LOG(WOLFCLU_E0, "Unable to open private key file %s",
-                            optarg);
-                    ret = WOLFCLU_FATAL_ERROR;
-                }
+                keyFile = opt.arg;
                 break;
 
             case WOLFCLU_CAFILE:
-                ca = wolfSSL_X509_load_certificate_file(optarg,
-                        WOLFSSL_FILETYPE_PEM);
+                ca = wolfCLU_LoadCertificate(opt.arg);
                 if (ca == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open ca file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_MD:
-                hashType = wolfCLU_StringToHashType(optarg);
+                hashType = wolfCLU_StringToHashType(opt.arg);
                 if (hashType == WC_HASH_TYPE_NONE) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Invalid digest name");
                     ret = WOLFCLU_FATAL_ERROR;
@@ -128,23 +123,23 @@ int wolfCLU_CASetup(int argc, char** argv)
                 break;
 
             case WOLFCLU_OUTFILE:
-                out = optarg;
+                out = opt.arg;
                 break;
 
             case WOLFCLU_INFORM:
-                inForm = wolfCLU_checkInform(optarg);
+                inForm = wolfCLU_checkInform(opt.arg);
                 break;
 
             case WOLFCLU_CONFIG:
-                config = optarg;
+                config = opt.arg;
                 break;
 
             case WOLFCLU_DAYS:
-                days = XATOI(optarg);
+                days = XATOI(opt.arg);
                 break;
 
             case WOLFCLU_EXTENSIONS:
-                ext = optarg;
+                ext = opt.arg;
                 break;
 
             case WOLFCLU_HELP:
@@ -185,10 +180,10 @@ int wolfCLU_CASetup(int argc, char** argv)
         wolfCLU_CertSignSetHash(signer, hashType);
     }
 
-    if (ret == WOLFCLU_SUCCESS && keyIn != NULL) {
-        pkey = wolfSSL_PEM_read_bio_PrivateKey(keyIn, NULL, NULL, NULL);
+    if (ret == WOLFCLU_SUCCESS && keyFile != NULL) {
+        pkey = wolfCLU_LoadPrivateKey(keyFile);
         if (pkey == NULL) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Error reading key from file");
+            WOLFCLU_LOG(WOLFCLU_E0, "Error reading key from file %s", keyFile);
             ret = USER_INPUT_ERROR;
         }
     }
@@ -241,7 +236,6 @@ int wolfCLU_CASetup(int argc, char** argv)
     }
 
     wolfSSL_BIO_free(reqIn);
-    wolfSSL_BIO_free(keyIn);
     if (!selfSigned) {
         wolfSSL_X509_free(x509);
     }
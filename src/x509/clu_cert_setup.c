@@ -27,12 +27,14 @@
 #include <wolfclu/clu_error_codes.h>
 #include <wolfclu/x509/clu_cert.h>
 #include <wolfclu/x509/clu_parse.h>
+#include <wolfclu/clu_stats.h>
 
 /* return WOLFCLU_SUCCESS on success */
 int wolfCLU_certSetup(int argc, char** argv)
 {
     int idx;
     int ret = WOLFCLU_SUCCESS;
+    int phase;
     int textFlag    = 0;   /* does user desire human readable cert info */
     int textPubkey  = 0;   /* does user desire human readable pubkey info */
     int nooutFlag   = 0;   /* are we outputting a file */
@@ -64,6 +66,7 @@ int wolfCLU_certSetup(int argc, char** argv)
         wolfCLU_certHelp();
         return WOLFCLU_SUCCESS;
     }
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_ARGS);
 
 /*---------------------------------------------------------------------------*/
 /* text */
@@ -169,6 +172,9 @@ int wolfCLU_certSetup(int argc, char** argv)
 /*---------------------------------------------------------------------------*/
 /* END ARG PROCESSING */
 /*---------------------------------------------------------------------------*/
+    wolfCLU_StatsEnd(phase);
+
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_KEY);
     if (ret == WOLFCLU_SUCCESS) {
         if (inForm == PEM_FORM) {
             x509 = wolfSSL_PEM_read_bio_X509(in, NULL, NULL, NULL);
@@ -185,6 +191,10 @@ int wolfCLU_certSetup(int argc, char** argv)
 
     /* done with input file */
     wolfSSL_BIO_free(in);
+    wolfCLU_StatsEnd(phase);
+
+    /* everything past here prints parts of the certificate */
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_FORMAT);
 
     /* try to open output file if set */
     if (ret == WOLFCLU_SUCCESS && outFile != NULL) {
@@ -492,6 +502,7 @@ int wolfCLU_certSetup(int argc, char** argv)
 
     wolfSSL_BIO_free(out);
     wolfSSL_X509_free(x509);
+    wolfCLU_StatsEnd(phase);
     return ret;
 }
 
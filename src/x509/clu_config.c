@@ -24,6 +24,7 @@
 #include <wolfclu/clu_error_codes.h>
 #include <wolfclu/x509/clu_parse.h>
 #include <wolfclu/x509/clu_x509_sign.h>
+#include <wolfclu/clu_cache.h>
 
 
 /* return WOLFCLU_SUCCESS on success */
@@ -503,8 +504,11 @@ int wolfCLU_readConfig(WOLFSSL_X509* x509, char* config, char* sect, char* ext)
     long defaultBits = 0;
     char *defaultKey = NULL;
 
-    conf = wolfSSL_NCONF_new(NULL);
-    wolfSSL_NCONF_load(conf, config, &line);
+    conf = wolfCLU_LoadConfig(config, &line);
+    if (conf == NULL) {
+        /* carry on with an empty config, as when the load fails */
+        conf = wolfSSL_NCONF_new(NULL);
+    }
 
     wolfSSL_NCONF_get_number(conf, sect, "default_bits", &defaultBits);
     defaultKey = wolfSSL_NCONF_get_string(conf, sect, "default_keyfile");
@@ -522,7 +526,7 @@ int wolfCLU_readConfig(WOLFSSL_X509* x509, char* config, char* sect, char* ext)
             wolfSSL_NCONF_get_string(conf, sect, "distinguished_name"));
 
     (void)defaultKey;
-    wolfSSL_NCONF_free(conf);
+    wolfCLU_FreeConfig(conf);
     return WOLFCLU_SUCCESS;
 }
 
@@ -22,10 +22,12 @@
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
 #include <wolfclu/clu_optargs.h>
+#include <wolfclu/clu_cache.h>
 #include <wolfclu/x509/clu_request.h>
 #include <wolfclu/x509/clu_cert.h>
 #include <wolfclu/pkey/clu_pkey.h>
 #include <wolfclu/certgen/clu_certgen.h>
+#include <wolfclu/clu_stats.h>
 
 #ifdef WOLFSSL_CERT_REQ
 static const struct option req_options[] = {
@@ -493,7 +495,6 @@ int wolfCLU_requestSetup(int argc, char** argv)
     return NOT_COMPILED_IN;
 #else
     WOLFSSL_BIO *bioOut = NULL;
-    WOLFSSL_BIO *keyIn  = NULL;
     WOLFSSL_BIO *reqIn  = NULL;
     WOLFSSL_X509 *x509  = NULL;
     const WOLFSSL_EVP_MD *md  = NULL;
@@ -515,6 +516,7 @@ int wolfCLU_requestSetup(int argc, char** argv)
     int     inForm  = PEM_FORM;
     int     option;
     int     longIndex = 1;
+    WOLFCLU_GETOPT opt;
     int     days = 0;
     int     genX509 = 0;
 
@@ -523,15 +525,16 @@ int wolfCLU_requestSetup(int argc, char** argv)
     byte reSign    = 0; /* flag for if resigning req is needed */
     byte noOut     = 0;
     byte useDes    = 1;
+    int  phase;
 
-    opterr = 0; /* do not display unrecognized options */
-    optind = 0; /* start at indent 0 */
-    while ((option = getopt_long_only(argc, argv, "", req_options,
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_ARGS);
+    wolfCLU_GetOptInit(&opt);
+    while ((option = wolfCLU_GetOpt(&opt, argc, argv, req_options,
                     &longIndex )) != -1) {
 
         switch (option) {
             case WOLFCLU_EXTENSIONS:
-                ext = optarg;
+                ext = opt.arg;
                 break;
 
             case WOLFCLU_NODES:
@@ -539,11 +542,11 @@ int wolfCLU_requestSetup(int argc, char** argv)
                 break;
 
             case WOLFCLU_OUTKEY:
-                keyOut = optarg;
+                keyOut = opt.arg;
                 break;
 
             case WOLFCLU_NEWKEY:
-                if (XSTRSTR(optarg, ":") == NULL) {
+                if (XSTRSTR(opt.arg, ":") == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "key string does not have ':'");
                     ret = WOLFCLU_FATAL_ERROR;
                 }
@@ -551,60 +554,55 @@ int wolfCLU_requestSetup(int argc, char** argv)
                 if (ret == WOLFCLU_SUCCESS) {
                     int idx;
 
-                    idx     = (int)strcspn(optarg, ":");
+                    idx     = (int)strcspn(opt.arg, ":");
                     keyType = (char*)XMALLOC(idx + 1, HEAP_HINT,
                             DYNAMIC_TYPE_TMP_BUFFER);
                     if (keyType == NULL) {
                         ret = WOLFCLU_FATAL_ERROR;
                     }
                     else {
-                        XMEMCPY(keyType, optarg, idx);
+                        XMEMCPY(keyType, opt.arg, idx);
                         keyType[idx] = '\0';
                     }
 
                     if (ret == WOLFCLU_SUCCESS) {
-                        keyInfo = optarg + idx + 1;
+                        keyInfo = opt.arg + idx + 1;
                     }
                 }
                 break;
 
             case WOLFCLU_INFILE:
-                reqIn = wolfSSL_BIO_new_file(optarg, "rb");
+                reqIn = wolfSSL_BIO_new_file(opt.arg, "rb");
                 if (reqIn == NULL) {
                     WOLFCLU_LOG(WOLFCLU_E0, "Unable to open input file %s",
-                            optarg);
+                            opt.arg);
                     ret = WOLFCLU_FATAL_ERROR;
                 }
                 break;
 
             case WOLFCLU_KEY:
-                in = optarg;
-                keyIn = wolfSSL_BIO_new_file(optarg, "rb");
-                if (keyIn == NULL) {
-                    WOLFCLU_LOG(WOLFCLU_E0, "Unable to open public key file %s",
-                            optarg);
-                    ret = WOLFCLU_FATAL_ERROR;
-                }
+                in = opt.arg;
                 break;
 
             case WOLFCLU_OUTFILE:
-                out = optarg;
+                out = opt.arg;
                 break;
 
             case WOLFCLU_INFORM:
-                inForm = wolfCLU_checkInform(optarg);
+                inForm = wolfCLU_checkInform(opt.arg);
                 break;
 
             case WOLFCLU_OUTFORM:
-                outForm = wolfCLU_checkOutform(optarg);
+                outForm = wolfCLU_checkOutform(opt.arg);
                 break;
 
             case WOLFCLU_SUBJECT:
-                subj = optarg;
+                subj = opt.arg;
                 break;
 
             case WOLFCLU_HELP:
                 wolfCLU_certgenHelp();
+                wolfCLU_StatsEnd(phase);
                 return WOLFCLU_SUCCESS;
 
             case WOLFCLU_RSA:
@@ -616,11 +614,11 @@ int wolfCLU_requestSetup(int argc, char** argv)
                 break;
 
             case WOLFCLU_CONFIG:
-                config = optarg;
+                config = opt.arg;
                 break;
 
             case WOLFCLU_DAYS:
-                days = XATOI(optarg);
+                days = XATOI(opt.arg);
                 break;
 
             case WOLFCLU_CERT_SHA:
@@ -686,7 +684,9 @@ int wolfCLU_requestSetup(int argc, char** argv)
         md  = wolfSSL_EVP_sha256();
         oid = SHA_HASH256;
     }
+    wolfCLU_StatsEnd(phase);
 
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_KEY);
     if (ret == WOLFCLU_SUCCESS) {
         if (reqIn == NULL) {
             x509 = wolfSSL_X509_new();
@@ -731,10 +731,10 @@ int wolfCLU_requestSetup(int argc, char** argv)
         reSign = 1; /* re-sign after date change */
     }
 
-    if (ret == WOLFCLU_SUCCESS && keyIn != NULL) {
-        pkey = wolfSSL_PEM_read_bio_PrivateKey(keyIn, NULL, NULL, NULL);
+    if (ret == WOLFCLU_SUCCESS && in != NULL) {
+        pkey = wolfCLU_LoadPrivateKey(in);
         if (pkey == NULL) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Error reading key from file");
+            WOLFCLU_LOG(WOLFCLU_E0, "Error reading key from file %s", in);
             ret = USER_INPUT_ERROR;
         }
 
@@ -744,7 +744,10 @@ int wolfCLU_requestSetup(int argc, char** argv)
         }
     }
 
+    wolfCLU_StatsEnd(phase);
+
     /* generate key for -newkey */
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_CRYPTO);
     if (ret == WOLFCLU_SUCCESS && keyType != NULL && keyInfo != NULL &&
             pkey == NULL) {
         WOLFSSL_EVP_PKEY_CTX* ctx = NULL;
@@ -779,6 +782,7 @@ int wolfCLU_requestSetup(int argc, char** argv)
             ret = WOLFCLU_FATAL_ERROR;
         }
     }
+    wolfCLU_StatsEnd(phase);
 
     if (ret == WOLFCLU_SUCCESS && reqIn == NULL && pkey == NULL) {
         WOLFCLU_LOG(WOLFCLU_E0, "Please specify a -key <key> option when "
@@ -856,6 +860,7 @@ int wolfCLU_requestSetup(int argc, char** argv)
     }
 
     /* sign the req/cert */
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_CRYPTO);
     if (ret == WOLFCLU_SUCCESS && (reqIn == NULL || reSign)) {
         if (genX509) {
             /* default to version 3 which supports extensions */
@@ -905,7 +910,9 @@ int wolfCLU_requestSetup(int argc, char** argv)
             }
         }
     }
+    wolfCLU_StatsEnd(phase);
 
+    phase = wolfCLU_StatsBegin(WOLFCLU_STAT_FORMAT);
     if (ret == WOLFCLU_SUCCESS && doTextOut) {
         wolfSSL_X509_REQ_print(bioOut, x509);
     }
@@ -984,10 +991,10 @@ int wolfCLU_requestSetup(int argc, char** argv)
     }
 
     wolfSSL_BIO_free(reqIn);
-    wolfSSL_BIO_free(keyIn);
     wolfSSL_BIO_free(bioOut);
     wolfSSL_X509_free(x509);
     wolfSSL_EVP_PKEY_free(pkey);
+    wolfCLU_StatsEnd(phase);
     return ret;
 #endif
 }
@@ -22,6 +22,7 @@
 #include <wolfclu/clu_header_main.h>
 #include <wolfclu/clu_log.h>
 #include <wolfclu/clu_error_codes.h>
+#include <wolfclu/clu_cache.h>
 #include <wolfclu/x509/clu_parse.h>
 #include <wolfclu/x509/clu_x509_sign.h>
 
@@ -89,7 +90,7 @@ int wolfCLU_CertSignFree(WOLFCLU_CERT_SIGN* csign)
         }
 
         if (csign->config != NULL) {
-            wolfSSL_NCONF_free(csign->config);
+            wolfCLU_FreeConfig(csign->config);
             csign->config = NULL;
         }
 
@@ -846,16 +847,8 @@ WOLFCLU_CERT_SIGN* wolfCLU_readSignConfig(char* config, char* sect)
 
     ret = wolfCLU_CertSignNew();
     if (ret != NULL) {
-        ret->config = wolfSSL_NCONF_new(NULL);
+        ret->config = wolfCLU_LoadConfig(config, &line);
         if (ret->config == NULL) {
-            WOLFCLU_LOG(WOLFCLU_E0, "Unable to create new config struct");
-            wolfCLU_CertSignFree(ret);
-            ret = NULL;
-        }
-    }
-
-    if (ret != NULL) {
-        if (wolfSSL_NCONF_load(ret->config, config, &line) != WOLFSSL_SUCCESS) {
             WOLFCLU_LOG(WOLFCLU_E0, "Unable to open config file %s", config);
             (void)wolfCLU_CertSignFree(ret);
             ret = NULL;
@@ -902,7 +895,7 @@ WOLFCLU_CERT_SIGN* wolfCLU_readSignConfig(char* config, char* sect)
     if (ret != NULL) {
         tmp = wolfSSL_NCONF_get_string(conf, CAsection, "certificate");
         if (tmp != NULL) {
-            ca = wolfSSL_X509_load_certificate_file(tmp, WOLFSSL_FILETYPE_PEM);
+            ca = wolfCLU_LoadCertificate(tmp);
             if (ca == NULL) {
                 WOLFCLU_LOG(WOLFCLU_E0, "Unable to open CA file %s", tmp);
                 (void)wolfCLU_CertSignFree(ret);
@@ -966,17 +959,13 @@ WOLFCLU_CERT_SIGN* wolfCLU_readSignConfig(char* config, char* sect)
         /* get signing key */
         tmp = wolfSSL_NCONF_get_string(conf, CAsection, "private_key");
         if (tmp != NULL) {
-            WOLFSSL_BIO* in = wolfSSL_BIO_new_file(tmp, "rb");
-            if (in == NULL) {
+            caKey = wolfCLU_LoadPrivateKey(tmp);
+            if (caKey == NULL) {
                 WOLFCLU_LOG(WOLFCLU_E0, "Unable to open private key file %s",
                         tmp);
                 (void)wolfCLU_CertSignFree(ret);
                 ret = NULL;
             }
-            else {
-                caKey = wolfSSL_PEM_read_bio_PrivateKey(in, NULL, NULL, NULL);
-                wolfSSL_BIO_free(in);
-            }
         }
     }
 
@@ -1014,9 +1003,8 @@ WOLFCLU_CERT_SIGN* wolfCLU_readSignConfig(char* config, char* sect)
 
     wolfCLU_CertSignSetCA(ret, ca, caKey, keyType);
 
-    /* in fail case free up memory */
+    /* in fail case free up memory, the config went with wolfCLU_CertSignFree */
     if (ret == NULL) {
-        wolfSSL_NCONF_free(conf);
         wolfSSL_X509_free(ca);
         wolfSSL_EVP_PKEY_free(caKey);
     }
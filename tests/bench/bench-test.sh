@@ -0,0 +1,136 @@
+#!/bin/bash
+
+run_success() {
+    RESULT=`./wolfssl $1`
+    if [ $? != 0 ]; then
+        echo "Failed on test \"$1\""
+        exit 99
+    fi
+}
+
+run_success "-bench sha256 -time 1"
+echo "$RESULT" | grep "Average MB/s" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing throughput in bench output"
+    exit 99
+fi
+
+run_success "-bench aes-cbc -time 1"
+echo "$RESULT" | grep "AES-CBC took" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing AES-CBC results in bench output"
+    exit 99
+fi
+
+# counters may not be available, in that case a message is printed instead
+RESULT=`./wolfssl -bench sha256 -time 1 -perf 2>&1`
+if [ $? != 0 ]; then
+    echo "Failed on test \"-bench sha256 -time 1 -perf\""
+    exit 99
+fi
+echo "$RESULT" | grep -e "IPC" -e "Running without -perf" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing counters or fallback message in -perf output"
+    exit 99
+fi
+
+run_success "-bench sha256 -time 1 -latency -warmup 10 -reps 2"
+echo "$RESULT" | grep "p99.9" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing percentiles in latency output"
+    exit 99
+fi
+echo "$RESULT" | grep "95% CI" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing confidence interval in latency output"
+    exit 99
+fi
+
+# AEAD tests are only present when wolfSSL was built with them
+./wolfssl -bench -help | grep "aes-128-gcm" > /dev/null
+if [ $? == 0 ]; then
+    run_success "-bench aes-128-gcm -time 1 -msgsz 64,1024 -aadsz 0,13"
+    echo "$RESULT" | grep "AES-128-GCM" > /dev/null
+    if [ $? != 0 ]; then
+        echo "Missing AES-128-GCM results in bench output"
+        exit 99
+    fi
+fi
+
+RESULT=`./wolfssl -bench aes-128-gcm -msgsz 0`
+if [ $? == 0 ]; then
+    echo "Expected failure with a zero message size"
+    exit 99
+fi
+
+# key derivation tests report iterations instead of MB/s
+./wolfssl -bench -help | grep "pbkdf2-sha256" > /dev/null
+if [ $? == 0 ]; then
+    run_success "-bench pbkdf2-sha256 -time 1"
+    echo "$RESULT" | grep "Iterations/s" > /dev/null
+    if [ $? != 0 ]; then
+        echo "Missing iteration rate in PBKDF2 bench output"
+        exit 99
+    fi
+fi
+
+run_success "-bench drbg -time 1"
+echo "$RESULT" | grep "DRBG took" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing DRBG results in bench output"
+    exit 99
+fi
+
+# run the commands over a small corpus of files
+run_success "-bench -e2e -files 4 -filesz 10-20000 -time 1"
+echo "$RESULT" | grep "Files/s" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing files/s in -e2e output"
+    exit 99
+fi
+
+RESULT=`./wolfssl -bench -e2e -filesz 100-10`
+if [ $? == 0 ]; then
+    echo "Expected failure with a bad -filesz range"
+    exit 99
+fi
+
+# in-memory TLS handshakes and records for a single suite and group
+run_success "-bench -tls -suite TLS13-AES128 -group P-256 -msgsz 1024 -time 1"
+echo "$RESULT" | grep "handshakes/s" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing handshakes/s in -tls output"
+    exit 99
+fi
+
+RESULT=`./wolfssl -bench -tls -suite NOT-A-SUITE -time 1`
+if [ $? == 0 ]; then
+    echo "Expected failure with an unknown -suite"
+    exit 99
+fi
+
+# the allocation counts are only printed if wolfSSL uses its own allocators
+RESULT=`./wolfssl -memstats -bench sha256 -time 1 2>&1`
+if [ $? == 0 ]; then
+    echo "$RESULT" | grep "Sha256 heap: peak" > /dev/null
+    if [ $? != 0 ]; then
+        echo "Missing per algorithm heap use in -memstats bench output"
+        exit 99
+    fi
+fi
+
+# bench keeps its timer calibration in globals, so a batch with a bench line
+# runs one line at a time even when -j is given
+RESULT=`printf 'bench sha256 -time 1\nbench sha256 -time 1\n' | ./wolfssl batch - -j 2 2>&1`
+if [ $? != 0 ]; then
+    echo "Failed running bench lines in batch with -j 2"
+    exit 99
+fi
+echo "$RESULT" | grep "line 1: mode can not run on worker threads" > /dev/null
+if [ $? != 0 ]; then
+    echo "batch -j ran bench lines on worker threads"
+    exit 99
+fi
+
+echo "Done"
+exit 0
@@ -46,6 +46,18 @@ run "dgst -sha256 -verify ./certs/server-keyPub.pem -signature ./tests/dgst/5000
 run "dgst -sha256 -sign ./certs/server-key.pem -out 5000-server-key.sig ./large-test.txt"
 run "dgst -sha256 -verify ./certs/server-keyPub.pem -signature ./5000-server-key.sig ./large-test.txt"
 
+# the file is hashed a piece at a time, RSA signatures must still match the
+# one made from the whole file at once
+cmp -s ./5000-server-key.sig ./tests/dgst/5000-server-key.sig
+if [ $? -ne 0 ]; then
+    echo "Signature of large file changed"
+    exit 99
+fi
+run "dgst -sha384 -sign ./certs/ecc-key.pem -out 5000-ecc-key.sig ./large-test.txt"
+run "dgst -sha384 -verify ./certs/ecc-keyPub.pem -signature ./5000-ecc-key.sig ./large-test.txt"
+run_fail "dgst -sha256 -verify ./certs/ecc-keyPub.pem -signature ./5000-ecc-key.sig ./large-test.txt"
+rm -f 5000-ecc-key.sig
+
 # run some hash tests on large file while available
 run "-hash sha256 -in ./large-test.txt"
 echo $RESULT | grep "3e5915162b1974ac0d57a5a45113a1efcc1edc5e71e5e55ca69f9a7c60ca11fd"
@@ -67,7 +79,147 @@ run_fail "dgst -sha256 -verify ./certs/ecc-key.pem -signature configure.sig conf
 run_fail "dgst -sha256 -verify bad-key.pem -signature configure.sig configure.ac"
 run_fail "dgst -sha256 -verify ./certs/server-keyPub.pem -signature configure.sig configure.ac"
 run "dgst -sha256 -verify ./certs/ecc-keyPub.pem -signature configure.sig configure.ac"
-rm -f configure.sig
+
+# several signatures checked in one run, each with its own hash
+run "dgst -sha384 -sign ./certs/server-key.pem -out configure-rsa.sig configure.ac"
+run "dgst -sha256 -verify ./certs/ecc-keyPub.pem -signature configure.sig -sha384 -verify ./certs/server-keyPub.pem -signature configure-rsa.sig configure.ac"
+echo "$RESULT" | grep -q "configure-rsa.sig: Verify OK"
+if [ $? -ne 0 ]; then
+    echo "Missing result of second signature"
+    exit 99
+fi
+run_fail "dgst -sha256 -verify ./certs/ecc-keyPub.pem -signature configure.sig -sha256 -verify ./certs/server-keyPub.pem -signature configure-rsa.sig configure.ac"
+run_fail "dgst -sha256 -verify ./certs/ecc-keyPub.pem -signature configure.sig -verify ./certs/server-keyPub.pem configure.ac"
+
+# in batch mode later lines verify with the keys decoded by earlier ones
+V1="dgst -sha256 -verify ./certs/ecc-keyPub.pem -signature configure.sig configure.ac"
+V2="dgst -sha384 -verify ./certs/server-keyPub.pem -signature configure-rsa.sig configure.ac"
+V3="dgst -sha384 -verify ./certs/server-keyPub.pem -signature configure-rsa.sig README.md"
+printf '%s\n%s\n%s\n%s\n' "$V1" "$V2" "$V1" "$V2" | ./wolfssl batch - > /dev/null 2>&1
+if [ $? != 0 ]; then
+    echo "Failed verifying again with cached keys in batch mode"
+    exit 99
+fi
+RESULT=`printf '%s\n%s\n%s\n' "$V2" "$V3" "$V2" | ./wolfssl batch - 2>&1 >/dev/null`
+echo "$RESULT" | grep "batch: 1 of 3 lines failed" > /dev/null
+if [ $? != 0 ]; then
+    echo "Cached key verified a signature over other data"
+    exit 99
+fi
+rm -f configure.sig configure-rsa.sig
+
+# batch signing, the key is loaded once for every file
+rm -rf dgst-batch
+mkdir -p dgst-batch/sub
+cp configure.ac dgst-batch/one
+cp ./certs/server-key.der dgst-batch/sub/two
+cp ./certs/ca-cert.pem dgst-batch/sub/three
+run "dgst -sha256 -sign ./certs/ecc-key.pem -r dgst-batch -threads 2"
+for f in dgst-batch/one dgst-batch/sub/two dgst-batch/sub/three; do
+    run "dgst -sha256 -verify ./certs/ecc-keyPub.pem -signature $f.sig $f"
+done
+# signatures from the last run are not signed again
+run "dgst -sha256 -sign ./certs/server-key.pem -r dgst-batch"
+if [ -e dgst-batch/one.sig.sig ]; then
+    echo "Signature file was signed"
+    exit 99
+fi
+run "dgst -sha256 -verify ./certs/server-keyPub.pem -signature dgst-batch/sub/two.sig dgst-batch/sub/two"
+
+printf "dgst-batch/one\ndgst-batch/sub/three\n" > dgst-batch.list
+rm -f dgst-batch/one.sig dgst-batch/sub/three.sig
+run "dgst -sha384 -sign ./certs/ecc-key.pem -filelist dgst-batch.list -threads 4"
+run "dgst -sha384 -verify ./certs/ecc-keyPub.pem -signature dgst-batch/one.sig dgst-batch/one"
+run "dgst -sha384 -verify ./certs/ecc-keyPub.pem -signature dgst-batch/sub/three.sig dgst-batch/sub/three"
+echo "dgst-batch/missing" >> dgst-batch.list
+run_fail "dgst -sha384 -sign ./certs/ecc-key.pem -filelist dgst-batch.list"
+# without precomputed ECDSA nonces every signature is made in full
+printf "dgst-batch/one\ndgst-batch/sub/three\n" > dgst-batch.list
+run "dgst -sha384 -sign ./certs/ecc-key.pem -filelist dgst-batch.list -nonces 0"
+run "dgst -sha384 -verify ./certs/ecc-keyPub.pem -signature dgst-batch/one.sig dgst-batch/one"
+run_fail "dgst -sha384 -sign ./certs/ecc-key.pem -filelist dgst-batch.list -nonces -1"
+run_fail "dgst -sha384 -sign ./certs/ecc-key.pem -filelist dgst-batch.list -nonces 4x"
+run_fail "dgst -sha384 -sign ./certs/ecc-key.pem -filelist dgst-batch.list -threads 2x"
+run_fail "dgst -sha384 -sign ./certs/ecc-key.pem -filelist dgst-batch.list -threads +2"
+echo "dgst-batch/missing" >> dgst-batch.list
+run_fail "dgst -sha256 -verify ./certs/ecc-keyPub.pem -filelist dgst-batch.list"
+
+# manifest of data, signature and public key, each key loaded once
+cat > dgst-batch.manifest << EOF
+# data signature key
+dgst-batch/one dgst-batch/one.sig ./certs/ecc-keyPub.pem
+dgst-batch/sub/three dgst-batch/sub/three.sig ./certs/ecc-keyPub.pem
+dgst-batch/sub/two dgst-batch/sub/two.sig ./certs/server-keyPub.pem
+EOF
+run "dgst -sha384 -sign ./certs/server-key.pem -out dgst-batch/sub/two.sig dgst-batch/sub/two"
+run "dgst -sha384 -verify-manifest dgst-batch.manifest -threads 2"
+echo "$RESULT" | grep -q "dgst-batch/sub/two: OK"
+if [ $? -ne 0 ]; then
+    echo "Missing OK line from -verify-manifest"
+    exit 99
+fi
+echo "dgst-batch/sub/two dgst-batch/one.sig ./certs/server-keyPub.pem" >> dgst-batch.manifest
+run_fail "dgst -sha384 -verify-manifest dgst-batch.manifest -threads 2"
+echo "$RESULT" | grep -q "dgst-batch/sub/two: FAIL"
+if [ $? -ne 0 ]; then
+    echo "Missing FAIL line from -verify-manifest"
+    exit 99
+fi
+run_fail "dgst -sha256 -verify-manifest dgst-batch.manifest"
+run_fail "dgst -sha384 -verify-manifest no-such.manifest"
+
+# one signature over a Merkle tree of the files, each checked on its own
+run "dgst -sha256 -sign ./certs/ecc-key.pem -merkle-sign dgst-batch -out dgst-batch.merkle -threads 2"
+run "dgst -verify ./certs/ecc-keyPub.pem -merkle-verify dgst-batch.merkle dgst-batch/sub/two"
+run "dgst -verify ./certs/ecc-keyPub.pem -merkle-verify dgst-batch.merkle dgst-batch/one"
+run_fail "dgst -verify ./certs/server-keyPub.pem -merkle-verify dgst-batch.merkle dgst-batch/one"
+run_fail "dgst -verify ./certs/ecc-keyPub.pem -merkle-verify dgst-batch.merkle dgst-batch/missing"
+run_fail "dgst -sha256 -sign ./certs/ecc-key.pem -merkle-sign dgst-batch"
+printf "dgst-batch/one\ndgst-batch/sub/three\n" > dgst-batch.list
+run "dgst -sha384 -sign ./certs/server-key.pem -merkle-sign dgst-batch.list -out dgst-batch.merkle"
+run "dgst -verify ./certs/server-keyPub.pem -merkle-verify dgst-batch.merkle dgst-batch/sub/three"
+echo "changed" >> dgst-batch/sub/three
+run_fail "dgst -verify ./certs/server-keyPub.pem -merkle-verify dgst-batch.merkle dgst-batch/sub/three"
+run "dgst -verify ./certs/server-keyPub.pem -merkle-verify dgst-batch.merkle dgst-batch/one"
+rm -rf dgst-batch dgst-batch.list dgst-batch.manifest dgst-batch.merkle
+
+# signing through signd, key 0 is ECC and key 1 is RSA
+./wolfssl signd 2>&1 | grep -q "not available"
+if [ $? -ne 0 ]; then
+    # malformed numbers are refused before signd starts listening
+    run_fail "signd -socket signd-test.sock -key ./certs/ecc-key.pem -threads 2x"
+    run_fail "signd -socket signd-test.sock -key ./certs/ecc-key.pem -nonces abc"
+    run_fail "signd -socket signd-test.sock -key ./certs/ecc-key.pem -nonces -1"
+    rm -f signd-test.sock
+    ./wolfssl signd -socket signd-test.sock -key ./certs/ecc-key.pem -key ./certs/server-key.pem -threads 2 -nonces 8 > /dev/null &
+    SIGND_PID=$!
+    for i in 1 2 3 4 5 6 7 8 9 10; do
+        [ -S signd-test.sock ] && break
+        sleep 1
+    done
+
+    run "dgst -sha256 -signd signd-test.sock -out configure.sig configure.ac"
+    run "dgst -sha256 -verify ./certs/ecc-keyPub.pem -signature configure.sig configure.ac"
+    # more ECDSA signatures than the nonce pool holds, longer hash than key
+    for i in `seq 1 20`; do
+        run "dgst -sha512 -signd signd-test.sock -out configure.sig configure.ac"
+        run "dgst -sha512 -verify ./certs/ecc-keyPub.pem -signature configure.sig configure.ac"
+    done
+    run "dgst -sha256 -signd signd-test.sock -keyid 1 -out configure.sig configure.ac"
+    run "dgst -sha256 -verify ./certs/server-keyPub.pem -signature configure.sig configure.ac"
+    run_fail "dgst -sha256 -signd signd-test.sock -keyid 2 -out configure.sig configure.ac"
+    run_fail "dgst -sha256 -signd signd-test.sock -keyid 1x -out configure.sig configure.ac"
+    run_fail "dgst -sha256 -signd signd-test.sock -keyid +1 -out configure.sig configure.ac"
+    run_fail "dgst -sha256 -signd no-such-signd.sock -out configure.sig configure.ac"
+
+    kill $SIGND_PID
+    wait $SIGND_PID
+    if [ -e signd-test.sock ]; then
+        echo "signd did not remove its socket"
+        exit 99
+    fi
+    rm -f configure.sig
+fi
 
 echo "Done"
 exit 0
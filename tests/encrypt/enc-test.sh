@@ -65,6 +65,67 @@ fi
 rm -f configure.ac.dec
 rm -f configure.ac.enc
 
+# explicit iteration count, the same count is needed to decrypt
+run "enc -aes-256-cbc -iter 20000 -in certs/crl.der -out test-enc.der" "test password"
+run_fail "enc -d -aes-256-cbc -pbkdf2 -in test-enc.der -out test-dec.der" "test password"
+run "enc -d -aes-256-cbc -iter 20000 -in test-enc.der -out test-dec.der" "test password"
+diff "./certs/crl.der" "./test-dec.der" &> /dev/null
+if [ $? != 0 ]; then
+    echo "issue with -iter decryption"
+    exit 99
+fi
+rm -f test-dec.der
+rm -f test-enc.der
+
+# calibrated iteration count is stored in the file
+export WOLFCLU_ITER_CACHE=./test-iter-cache
+run "enc -aes-256-cbc -iter auto:20 -in certs/crl.der -out test-enc.der" "test password"
+run "enc -d -aes-256-cbc -in test-enc.der -out test-dec.der" "test password"
+diff "./certs/crl.der" "./test-dec.der" &> /dev/null
+if [ $? != 0 ]; then
+    echo "issue with -iter auto decryption"
+    exit 99
+fi
+if [ ! -s ./test-iter-cache ]; then
+    echo "iteration rate was not cached"
+    exit 99
+fi
+rm -f test-dec.der
+rm -f test-enc.der
+
+# out of range rates in the cache file are measured again, not used
+rm -f test-iter-cache
+for md in $(seq 0 1100); do
+    for len in 16 24 32 48 64; do
+        echo "$md $len 1e30" >> test-iter-cache
+    done
+done
+LINES=`wc -l < test-iter-cache`
+run "enc -aes-256-cbc -iter auto:20 -in certs/crl.der -out test-enc.der" "test password"
+if [ "`wc -l < test-iter-cache`" == "$LINES" ]; then
+    echo "out of range iteration rate was used"
+    exit 99
+fi
+rm -f test-enc.der
+rm -f test-iter-cache
+unset WOLFCLU_ITER_CACHE
+
+# a stored iteration count out of range, and a salt cut short, are refused
+printf 'wcluIter\x7f\xff\xff\xffSalted__01234567' > test-enc.der
+cat certs/crl.der.enc >> test-enc.der
+run_fail "enc -d -aes-256-cbc -in test-enc.der -out test-dec.der" "test password"
+printf 'wcluIter\x00\x00\x00\x01Salted__01234567' > test-enc.der
+cat certs/crl.der.enc >> test-enc.der
+run_fail "enc -d -aes-256-cbc -in test-enc.der -out test-dec.der" "test password"
+printf 'wcluIter\x00\x00\x27\x10Salt' > test-enc.der
+run_fail "enc -d -aes-256-cbc -in test-enc.der -out test-dec.der" "test password"
+rm -f test-enc.der test-dec.der
+
+run_fail "enc -aes-256-cbc -iter auto:0 -in certs/crl.der -out test-enc.der" "test password"
+run_fail "enc -aes-256-cbc -iter 0 -in certs/crl.der -out test-enc.der" "test password"
+run_fail "enc -aes-256-cbc -nosalt -iter auto:20 -in certs/crl.der -out test-enc.der" "test password"
+rm -f test-enc.der
+
 # interoperability testing
 openssl enc --help &> /dev/null
 if [ $? == 0 ]; then
@@ -108,6 +169,17 @@ if [ $? == 0 ]; then
     fi
     rm -f test-dec.der
     rm -f test-enc.der
+
+    # openssl -iter sets the PBKDF2 iteration count
+    openssl enc -base64 -aes-256-cbc -iter 20000 -k 'test password' -in certs/crl.der -out test-enc.der &> /dev/null
+    run "enc -base64 -d -aes-256-cbc -iter 20000 -in test-enc.der -out test-dec.der" "test password"
+    diff "./certs/crl.der" "./test-dec.der" &> /dev/null
+    if [ $? != 0 ]; then
+        echo "issue openssl enc and wolfssl dec with -iter"
+        exit 99
+    fi
+    rm -f test-dec.der
+    rm -f test-enc.der
 fi
 
 echo "Done"
@@ -38,6 +38,14 @@ cleanup_genkey_sign_ver(){
     rm rsa-sigout.private_result
     rm rsa-sigout.public_result
     rm sign-this.txt
+    rm -f ed-manifest.txt
+    rm -f ed-ph.sig
+    rm -f ed-dgst.sig
+    rm -f ed-ctx.sig
+    rm -f keycache.bin
+    rm -f keycache.bin.key
+    rm -f keycache.sig
+    rm -f keycache.result
 }
 trap cleanup_genkey_sign_ver INT TERM EXIT
 
@@ -114,6 +122,83 @@ KEYFILENAME="edkey"
 SIGOUTNAME="ed-signed.sig"
 gen_key_sign_ver_test ${ALGORITHM} ${KEYFILENAME} ${SIGOUTNAME}
 
+# Ed25519 signatures in a dgst -verify-manifest batch
+printf '%s\n' "sign-this.txt ed-signed.sig edkey.pub" > ed-manifest.txt
+./wolfssl dgst -verify-manifest ed-manifest.txt -threads 2
+RESULT=$?
+printf '%s\n' "manifest verify RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed ed25519 manifest verify" && exit -1
+
+printf '%s\n' "ed-manifest.txt ed-signed.sig edkey.pub" >> ed-manifest.txt
+./wolfssl dgst -verify-manifest ed-manifest.txt
+RESULT=$?
+printf '%s\n' "bad manifest verify RESULT - $RESULT"
+[ $RESULT -eq 0 ] && printf '%s\n' "Passed bad ed25519 manifest verify" && exit -1
+
+# Ed25519ph signs the SHA-512 hash of the input, streamed through
+./wolfssl -ed25519 -sign -ph -inkey edkey.priv -in sign-this.txt -out ed-ph.sig
+RESULT=$?
+printf '%s\n' "ph sign RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed ed25519 -ph sign" && exit -1
+
+./wolfssl -ed25519 -verify -ph -inkey edkey.pub -sigfile ed-ph.sig \
+          -in sign-this.txt -pubin
+RESULT=$?
+printf '%s\n' "ph verify RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed ed25519 -ph verify" && exit -1
+
+./wolfssl -ed25519 -verify -inkey edkey.pub -sigfile ed-ph.sig \
+          -in sign-this.txt -pubin
+RESULT=$?
+printf '%s\n' "ph as pure verify RESULT - $RESULT"
+[ $RESULT -eq 0 ] && printf '%s\n' "Passed ed25519ph sig as PureEdDSA" && exit -1
+
+# dgst uses Ed25519ph over -sha512 with raw Ed25519 keys
+./wolfssl dgst -sha512 -verify edkey.pub -signature ed-ph.sig sign-this.txt
+RESULT=$?
+printf '%s\n' "dgst ph verify RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed dgst ed25519ph verify" && exit -1
+
+./wolfssl dgst -sha512 -sign edkey.priv -out ed-dgst.sig sign-this.txt
+RESULT=$?
+printf '%s\n' "dgst ph sign RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed dgst ed25519ph sign" && exit -1
+
+./wolfssl -ed25519 -verify -ph -inkey edkey.pub -sigfile ed-dgst.sig \
+          -in sign-this.txt -pubin
+RESULT=$?
+printf '%s\n' "dgst sig ph verify RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed verify of dgst ed25519ph sig" && exit -1
+
+./wolfssl dgst -sha256 -sign edkey.priv -out ed-dgst.sig sign-this.txt
+RESULT=$?
+[ $RESULT -eq 0 ] && printf '%s\n' "Passed dgst ed25519 with -sha256" && exit -1
+
+printf '%s\n' "sign-this.txt ed-ph.sig edkey.pub" > ed-manifest.txt
+./wolfssl dgst -verify-manifest ed-manifest.txt -ph
+RESULT=$?
+printf '%s\n' "ph manifest verify RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed ed25519ph manifest verify" && exit -1
+
+# Ed25519ctx binds the signature to a context string
+./wolfssl -ed25519 -sign -context "wolfCLU test" -inkey edkey.priv \
+          -in sign-this.txt -out ed-ctx.sig
+RESULT=$?
+printf '%s\n' "ctx sign RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed ed25519 -context sign" && exit -1
+
+./wolfssl -ed25519 -verify -context "wolfCLU test" -inkey edkey.pub \
+          -sigfile ed-ctx.sig -in sign-this.txt -pubin
+RESULT=$?
+printf '%s\n' "ctx verify RESULT - $RESULT"
+[ $RESULT -ne 0 ] && printf '%s\n' "Failed ed25519 -context verify" && exit -1
+
+./wolfssl -ed25519 -verify -context "other" -inkey edkey.pub \
+          -sigfile ed-ctx.sig -in sign-this.txt -pubin
+RESULT=$?
+printf '%s\n' "wrong ctx verify RESULT - $RESULT"
+[ $RESULT -eq 0 ] && printf '%s\n' "Passed ed25519 wrong -context" && exit -1
+
 ALGORITHM="ecc"
 KEYFILENAME="ecckey"
 SIGOUTNAME="ecc-signed.sig"
@@ -125,4 +210,84 @@ SIGOUTNAME="rsa-signed.sig"
 VERIFYOUTNAME="rsa-sigout"
 gen_key_sign_ver_test ${ALGORITHM} ${KEYFILENAME} ${SIGOUTNAME} ${VERIFYOUTNAME}
 
+# keys from a -keycache file, added to it the first time they are used
+keycache_test(){
+    for i in 1 2; do
+        ./wolfssl -$1 -sign -inkey $2.priv -in sign-this.txt -out keycache.sig \
+                  -keycache keycache.bin -keycachepass pass:wolfCLU
+        RESULT=$?
+        printf '%s\n' "keycache sign RESULT - $RESULT"
+        [ $RESULT -ne 0 ] && printf '%s\n' "Failed $1 keycache sign" && exit -1
+    done
+
+    for KEY in "$2.priv" "$2.pub -pubin"; do
+        ./wolfssl -$1 -verify -inkey $KEY -sigfile keycache.sig \
+                  -in sign-this.txt -out keycache.result \
+                  -keycache keycache.bin -keycachepass pass:wolfCLU
+        RESULT=$?
+        printf '%s\n' "keycache verify RESULT - $RESULT"
+        [ $RESULT -ne 0 ] && printf '%s\n' "Failed $1 keycache verify" && exit -1
+    done
+
+    # the second sign above used the cached key, its signature has to verify
+    # with the key decoded from the key file as well
+    for KEY in "$2.priv" "$2.pub -pubin"; do
+        ./wolfssl -$1 -verify -inkey $KEY -sigfile keycache.sig \
+                  -in sign-this.txt -out keycache.result
+        RESULT=$?
+        printf '%s\n' "keycache signature verify RESULT - $RESULT"
+        [ $RESULT -ne 0 ] && \
+            printf '%s\n' "Failed $1 verify of keycache signature" && exit -1
+    done
+
+    ./wolfssl -$1 -sign -inkey $2.priv -in sign-this.txt -out keycache.sig \
+              -keycache keycache.bin -keycachepass pass:wrong
+    RESULT=$?
+    printf '%s\n' "keycache wrong password RESULT - $RESULT"
+    [ $RESULT -eq 0 ] && printf '%s\n' "Passed $1 keycache wrong password" && \
+    exit -1
+}
+
+keycache_test ed25519 edkey
+keycache_test ecc ecckey
+keycache_test rsa rsakey
+
+# the cache is refused without the random key kept next to it
+mv keycache.bin.key keycache.bin.key.bak
+./wolfssl -ecc -sign -inkey ecckey.priv -in sign-this.txt -out keycache.sig \
+          -keycache keycache.bin -keycachepass pass:wolfCLU
+RESULT=$?
+mv keycache.bin.key.bak keycache.bin.key
+printf '%s\n' "keycache without key file RESULT - $RESULT"
+[ $RESULT -eq 0 ] && printf '%s\n' "Passed keycache without key file" && exit -1
+
+# nanoseconds taken by 20 ECC signs with the given extra arguments
+keycache_time(){
+    START=$(date +%s%N)
+    for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+        ./wolfssl -ecc -sign -inkey ecckey.priv -in sign-this.txt \
+                  -out keycache.sig $@ > /dev/null 2>&1 || return 1
+    done
+    END=$(date +%s%N)
+    printf '%s\n' "$((END - START))"
+}
+
+# opening the cache must not cost more than decoding the key file saves,
+# with a quarter of slack for timing noise
+case "$(date +%N)" in
+*N*)
+    printf '%s\n' "date has no %N, skipping keycache timing"
+    ;;
+*)
+    PLAIN=$(keycache_time)
+    CACHED=$(keycache_time -keycache keycache.bin -keycachepass pass:wolfCLU)
+    printf '%s\n' "20 signs: $PLAIN ns decoding, $CACHED ns from keycache"
+    if [ -z "$PLAIN" ] || [ -z "$CACHED" ] || \
+            [ "$CACHED" -gt $((PLAIN + PLAIN / 4)) ]; then
+        printf '%s\n' "Failed, keycache signs are slower than decoding"
+        exit -1
+    fi
+    ;;
+esac
+
 exit 0
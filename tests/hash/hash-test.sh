@@ -86,6 +86,89 @@ then
     exit 99
 fi
 
+# -memstats reports on stderr and leaves the hash output unchanged
+run_success "-memstats sha256 certs/ca-cert.pem"
+EXPECTED="c68d5b8d17f551e3a9881968c2fe281bf8af9e6a16a1ecc97740a76d23858053"
+if [ "$RESULT" != "$EXPECTED" ]
+then
+    echo "found unexpected output with -memstats"
+    exit 99
+fi
+
+RESULT=`./wolfssl -hash sha256 -in certs/ca-cert.pem -memstats 2>&1 >/dev/null`
+echo "$RESULT" | grep "peak live bytes" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing -memstats report"
+    exit 99
+fi
+
+# -quiet drops messages but keeps the hash, -logasync leaves it unchanged
+run_success "-quiet sha256 certs/ca-cert.pem"
+if [ "$RESULT" != "$EXPECTED" ]
+then
+    echo "found unexpected output with -quiet"
+    exit 99
+fi
+
+run_success "-logasync sha256 certs/ca-cert.pem"
+if [ "$RESULT" != "$EXPECTED" ]
+then
+    echo "found unexpected output with -logasync"
+    exit 99
+fi
+
+RESULT=`./wolfssl -hash sha256 -in does-not-exist.pem -logjson 2>&1 >/dev/null`
+echo "$RESULT" | grep '"level":"error","cmd":"hash"' > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing JSON error line with -logjson"
+    exit 99
+fi
+
+# batch runs each line as its own command, status lines go to stderr
+RESULT=`printf 'sha256 certs/ca-cert.pem\n# comment\n\n-hash sha256 -in certs/ca-cert.pem\n' | ./wolfssl batch - 2>/dev/null`
+if [ $? != 0 ]; then
+    echo "Failed on batch from stdin"
+    exit 99
+fi
+if [ "$RESULT" != "$EXPECTED
+$EXPECTED" ]
+then
+    echo "found unexpected output with batch"
+    exit 99
+fi
+
+RESULT=`printf 'sha256 certs/ca-cert.pem\nsha256 does-not-exist.pem\nsha256 certs/ca-cert.pem\n' | ./wolfssl batch - -j 2 2>&1 >/dev/null`
+if [ $? == 0 ]; then
+    echo "batch should fail when a line fails"
+    exit 99
+fi
+echo "$RESULT" | grep "batch: 1 of 3 lines failed" > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing batch summary"
+    exit 99
+fi
+
+# -j takes a whole number only
+for j in 4x abc 0; do
+    printf 'sha256 certs/ca-cert.pem\n' | ./wolfssl batch - -j $j > /dev/null 2>&1
+    if [ $? == 0 ]; then
+        echo "batch accepted -j $j"
+        exit 99
+    fi
+done
+
+# queued JSON lines from batch workers keep the command they were logged with
+RESULT=`printf 'sha256 does-not-exist.pem\nsha256 certs/ca-cert.pem\n' | ./wolfssl -logasync -logjson batch - -j 2 2>&1 >/dev/null`
+echo "$RESULT" | grep '"cmd":"batch","msg":"line 1: sha256 failed"' > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing batch JSON status line with -logasync"
+    exit 99
+fi
+echo "$RESULT" | grep '"level":"error","cmd":"sha256"' > /dev/null
+if [ $? != 0 ]; then
+    echo "Missing JSON error line from a batch worker with -logasync"
+    exit 99
+fi
 
 echo "Done"
 exit 0
@@ -0,0 +1,226 @@
+/* lib-thread-test.c
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* runs libwolfclu commands on several threads at once, each with its own
+ * WOLFCLU_CTX, and checks every thread gets the same results as the command
+ * line tests in tests/hash and tests/dgst. The manifest verify starts worker
+ * threads of its own, which use the timer and each keep a cache of decoded
+ * keys */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfclu/clu_lib.h>
+
+#ifndef SINGLE_THREADED
+    #include <pthread.h>
+#endif
+
+#define TEST_THREADS 4
+#define TEST_LOOPS   8
+
+#define TEST_MANIFEST "lib-thread-test.manifest"
+
+#ifndef SINGLE_THREADED
+
+/* sha256 of certs/ca-cert.pem, as in tests/hash/hash-test.sh */
+static const unsigned char expectedSha256[32] = {
+    0xc6, 0x8d, 0x5b, 0x8d, 0x17, 0xf5, 0x51, 0xe3,
+    0xa9, 0x88, 0x19, 0x68, 0xc2, 0xfe, 0x28, 0x1b,
+    0xf8, 0xaf, 0x9e, 0x6a, 0x16, 0xa1, 0xec, 0xc9,
+    0x77, 0x40, 0xa7, 0x6d, 0x23, 0x85, 0x80, 0x53
+};
+
+typedef struct TEST_THREAD {
+    pthread_t tid;
+    pthread_t self; /* set by the thread itself, tid may not be yet */
+    int  id;
+    int  verifyOk; /* "Verify OK" messages seen by this thread's callback */
+    int  other;    /* messages logged on another thread's context */
+    int  failed;
+} TEST_THREAD;
+
+
+static void testLogCb(void* cbCtx, int logLevel, const char *const logMsg)
+{
+    TEST_THREAD* t = (TEST_THREAD*)cbCtx;
+
+    (void)logLevel;
+    if (!pthread_equal(t->self, pthread_self())) {
+        t->other++;
+    }
+    else if (strcmp(logMsg, "Verify OK") == 0) {
+        t->verifyOk++;
+    }
+}
+
+
+/* checks the raw digest written to out */
+static int testCheckDigest(const char* out)
+{
+    unsigned char digest[sizeof(expectedSha256) + 1];
+    size_t sz;
+    FILE* f;
+
+    f = fopen(out, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    sz = fread(digest, 1, sizeof(digest), f);
+    fclose(f);
+    if (sz != sizeof(expectedSha256) ||
+            memcmp(digest, expectedSha256, sz) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+
+static void* testThread(void* arg)
+{
+    TEST_THREAD* t = (TEST_THREAD*)arg;
+    WOLFCLU_CTX* ctx;
+    char out[64];
+    int  i;
+
+    const char* verifyRsa[] = {"-sha256", "-verify",
+        "./certs/server-keyPub.pem", "-signature",
+        "./tests/dgst/sha256-rsa.sig", "./certs/server-key.der"};
+    const char* verifyEcc[] = {"-sha256", "-verify", "./certs/ecc-keyPub.pem",
+        "-signature", "./tests/dgst/sha256-ecc.sig", "./certs/server-key.der"};
+    const char* verifyBad[] = {"-sha256", "-verify", "./certs/ecc-keyPub.pem",
+        "-signature", "./tests/dgst/sha256-rsa.sig", "./certs/server-key.der"};
+    const char* hash[] = {"sha256", "-in", "certs/ca-cert.pem", "-out", out};
+    const char* manifest[] = {"-sha256", "-verify-manifest", TEST_MANIFEST,
+        "-threads", "2"};
+
+    t->self = pthread_self();
+    snprintf(out, sizeof(out), "lib-thread-test-%d.bin", t->id);
+
+    ctx = wolfCLU_CTX_new();
+    if (ctx == NULL ||
+            wolfCLU_CTX_SetLoggingCb(ctx, testLogCb, t) != WOLFCLU_SUCCESS) {
+        t->failed = 1;
+        wolfCLU_CTX_free(ctx);
+        return NULL;
+    }
+
+    for (i = 0; i < TEST_LOOPS && !t->failed; i++) {
+        remove(out);
+        if (wolfCLU_Hash(ctx, 5, hash) != WOLFCLU_SUCCESS ||
+                testCheckDigest(out) != 0) {
+            fprintf(stderr, "thread %d: sha256 gave the wrong digest\n", t->id);
+            t->failed = 1;
+        }
+        if (wolfCLU_Dgst(ctx, 6, verifyRsa) != WOLFCLU_SUCCESS ||
+                wolfCLU_Dgst(ctx, 6, verifyEcc) != WOLFCLU_SUCCESS) {
+            fprintf(stderr, "thread %d: dgst -verify failed\n", t->id);
+            t->failed = 1;
+        }
+        if (wolfCLU_Dgst(ctx, 6, verifyBad) == WOLFCLU_SUCCESS) {
+            fprintf(stderr, "thread %d: dgst -verify passed a bad signature\n",
+                    t->id);
+            t->failed = 1;
+        }
+        if (wolfCLU_Dgst(ctx, 5, manifest) != WOLFCLU_SUCCESS) {
+            fprintf(stderr, "thread %d: dgst -verify-manifest failed\n",
+                    t->id);
+            t->failed = 1;
+        }
+    }
+    remove(out);
+
+    if (!t->failed && t->verifyOk != 2 * TEST_LOOPS) {
+        fprintf(stderr, "thread %d: logged %d Verify OK, expected %d\n",
+                t->id, t->verifyOk, 2 * TEST_LOOPS);
+        t->failed = 1;
+    }
+    if (t->other != 0) {
+        fprintf(stderr, "thread %d: got %d messages from other threads\n",
+                t->id, t->other);
+        t->failed = 1;
+    }
+
+    wolfCLU_CTX_free(ctx);
+    return NULL;
+}
+
+#endif /* !SINGLE_THREADED */
+
+
+int main(void)
+{
+#ifdef SINGLE_THREADED
+    /* 77 tells automake the test was skipped */
+    return 77;
+#else
+    TEST_THREAD threads[TEST_THREADS];
+    struct stat st;
+    FILE* f;
+    int ret = 0;
+    int i;
+
+    if (stat("./certs/", &st) != 0) {
+        return 77;
+    }
+
+    /* the signatures checked by verifyRsa and verifyEcc */
+    f = fopen(TEST_MANIFEST, "w");
+    if (f == NULL) {
+        fprintf(stderr, "unable to write %s\n", TEST_MANIFEST);
+        return 99;
+    }
+    fprintf(f, "./certs/server-key.der ./tests/dgst/sha256-rsa.sig "
+            "./certs/server-keyPub.pem\n");
+    fprintf(f, "./certs/server-key.der ./tests/dgst/sha256-ecc.sig "
+            "./certs/ecc-keyPub.pem\n");
+    fclose(f);
+
+    if (wolfCLU_LibInit() != WOLFCLU_SUCCESS) {
+        fprintf(stderr, "wolfCLU_LibInit failed\n");
+        return 99;
+    }
+
+    memset(threads, 0, sizeof(threads));
+    for (i = 0; i < TEST_THREADS; i++) {
+        threads[i].id = i;
+        if (pthread_create(&threads[i].tid, NULL, testThread,
+                    &threads[i]) != 0) {
+            fprintf(stderr, "unable to start thread %d\n", i);
+            return 99;
+        }
+    }
+    for (i = 0; i < TEST_THREADS; i++) {
+        pthread_join(threads[i].tid, NULL);
+        if (threads[i].failed) {
+            ret = 99;
+        }
+    }
+
+    wolfCLU_LibCleanup();
+    remove(TEST_MANIFEST);
+    return ret;
+#endif
+}
@@ -0,0 +1,123 @@
+#!/bin/bash
+
+if [ ! -d ./certs/ ]; then
+    #return 77 to indicate to automake that the test was skipped
+    exit 77
+fi
+
+run() {
+    RESULT=`./wolfssl $1`
+    if [ $? != 0 ]; then
+        echo "Failed on test \"./wolfssl $1\""
+        exit 99
+    fi
+}
+
+run_fail() {
+    RESULT=`./wolfssl $1`
+    if [ $? == 0 ]; then
+        echo "Failed on test \"./wolfssl $1\""
+        exit 99
+    fi
+}
+
+# base64 records, one per line
+rm -f pkeyutl-in.txt
+for i in $(seq 100 399); do
+    echo "cmVjb3Jk${i}A" >> pkeyutl-in.txt
+done
+
+# RSA signatures are the same each time, so threads must not change the output
+run "pkeyutl -sign -inkey ./certs/server-key.pem -base64 -in pkeyutl-in.txt -out pkeyutl-sig1.txt"
+run "pkeyutl -sign -inkey ./certs/server-key.pem -base64 -threads 4 -in pkeyutl-in.txt -out pkeyutl-sig4.txt"
+cmp -s pkeyutl-sig1.txt pkeyutl-sig4.txt
+if [ $? -ne 0 ]; then
+    echo "pkeyutl -threads changed the output"
+    exit 99
+fi
+
+# each record is followed by its signature
+paste -d '\n' pkeyutl-in.txt pkeyutl-sig1.txt > pkeyutl-ver.txt
+run "pkeyutl -verify -pubin -inkey ./certs/server-keyPub.pem -base64 -threads 3 -in pkeyutl-ver.txt"
+if [ "`echo "$RESULT" | grep -c OK`" != "300" ]; then
+    echo "pkeyutl -verify did not verify every record"
+    exit 99
+fi
+
+# a signature paired with the wrong record
+(head -n 1 pkeyutl-in.txt; sed -n 2p pkeyutl-sig1.txt) > pkeyutl-ver.txt
+run_fail "pkeyutl -verify -inkey ./certs/server-key.pem -base64 -in pkeyutl-ver.txt"
+if [ "$RESULT" != "FAIL" ]; then
+    echo "pkeyutl -verify did not report the bad signature"
+    exit 99
+fi
+
+# ECC
+run "pkeyutl -sign -inkey ./certs/ecc-key.pem -sha512 -base64 -threads 2 -in pkeyutl-in.txt -out pkeyutl-sig1.txt"
+paste -d '\n' pkeyutl-in.txt pkeyutl-sig1.txt > pkeyutl-ver.txt
+run "pkeyutl -verify -pubin -inkey ./certs/ecc-keyPub.pem -sha512 -base64 -threads 2 -in pkeyutl-ver.txt"
+if [ "`echo "$RESULT" | grep -c OK`" != "300" ]; then
+    echo "pkeyutl -verify did not verify every ECC record"
+    exit 99
+fi
+run_fail "pkeyutl -verify -pubin -inkey ./certs/ecc-keyPub.pem -sha256 -base64 -in pkeyutl-ver.txt"
+
+# RSA encrypt and decrypt round trip
+run "pkeyutl -encrypt -pubin -inkey ./certs/server-keyPub.pem -base64 -in pkeyutl-in.txt -out pkeyutl-enc.txt"
+run "pkeyutl -decrypt -inkey ./certs/server-key.pem -base64 -threads 4 -in pkeyutl-enc.txt -out pkeyutl-dec.txt"
+cmp -s pkeyutl-in.txt pkeyutl-dec.txt
+if [ $? -ne 0 ]; then
+    echo "pkeyutl -decrypt did not give back the records"
+    exit 99
+fi
+
+# an empty record encrypts and decrypts back to an empty record
+printf 'cmVjb3Jk\n\ncmVjb3Jk\n' > pkeyutl-empty.txt
+run "pkeyutl -encrypt -pubin -inkey ./certs/server-keyPub.pem -base64 -in pkeyutl-empty.txt -out pkeyutl-enc.txt"
+run "pkeyutl -decrypt -inkey ./certs/server-key.pem -base64 -in pkeyutl-enc.txt -out pkeyutl-dec.txt"
+cmp -s pkeyutl-empty.txt pkeyutl-dec.txt
+if [ $? -ne 0 ]; then
+    echo "pkeyutl -decrypt did not give back an empty record"
+    exit 99
+fi
+printf '\x00\x00\x00\x00' > pkeyutl-in.bin
+run "pkeyutl -encrypt -pubin -inkey ./certs/server-keyPub.pem -in pkeyutl-in.bin -out pkeyutl-sig.bin"
+run "pkeyutl -decrypt -inkey ./certs/server-key.pem -in pkeyutl-sig.bin -out pkeyutl-res.bin"
+cmp -s pkeyutl-in.bin pkeyutl-res.bin
+if [ $? -ne 0 ]; then
+    echo "pkeyutl -decrypt wrote data for an empty record"
+    exit 99
+fi
+
+# ECDH with a DER public key
+echo "MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEuzOsTCdQSsZKpQTDPN6fNttyLc6U6iv6yyAJOSwW6GEC6a9N0wKTmjFbl5Ihf/DPGNqREQI0huggWDMLgDSJ2A==" > pkeyutl-peer.txt
+run "pkeyutl -derive -inkey ./certs/ecc-key.pem -base64 -in pkeyutl-peer.txt"
+if [ ${#RESULT} != 44 ]; then
+    echo "pkeyutl -derive gave an unexpected secret"
+    exit 99
+fi
+
+# length prefixed records
+printf '\x00\x00\x00\x05hello' > pkeyutl-in.bin
+run "pkeyutl -sign -inkey ./certs/ecc-key.pem -in pkeyutl-in.bin -out pkeyutl-sig.bin"
+cat pkeyutl-in.bin pkeyutl-sig.bin > pkeyutl-ver.bin
+run "pkeyutl -verify -inkey ./certs/ecc-key.pem -in pkeyutl-ver.bin -out pkeyutl-res.bin"
+if [ "`od -An -tx1 pkeyutl-res.bin | tr -d ' \n'`" != "0000000101" ]; then
+    echo "pkeyutl -verify gave an unexpected result record"
+    exit 99
+fi
+printf '\x00\x00\x00\x09hello' > pkeyutl-in.bin
+run_fail "pkeyutl -sign -inkey ./certs/ecc-key.pem -in pkeyutl-in.bin"
+
+run_fail "pkeyutl -derive -inkey ./certs/server-key.pem -base64 -in pkeyutl-peer.txt"
+run_fail "pkeyutl -sign -pubin -inkey ./certs/server-keyPub.pem -base64 -in pkeyutl-in.txt"
+run_fail "pkeyutl -encrypt -inkey ./certs/ecc-key.pem -base64 -in pkeyutl-in.txt"
+run_fail "pkeyutl -sign -base64 -in pkeyutl-in.txt"
+run_fail "pkeyutl -sign -inkey ./certs/server-key.pem -base64 -threads 4x -in pkeyutl-in.txt"
+
+rm -f pkeyutl-in.txt pkeyutl-sig1.txt pkeyutl-sig4.txt pkeyutl-ver.txt
+rm -f pkeyutl-enc.txt pkeyutl-dec.txt pkeyutl-peer.txt pkeyutl-empty.txt
+rm -f pkeyutl-in.bin pkeyutl-sig.bin pkeyutl-ver.bin pkeyutl-res.bin
+
+echo "Done"
+exit 0
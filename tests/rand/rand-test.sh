@@ -31,6 +31,53 @@ if [ ! -f "entropy.txt" ]; then
 fi
 rm -f entropy.txt
 
+# larger than one chunk and the DRBG request limit, written as it is made
+./wolfssl rand -out entropy.txt 3M
+if [ $? != 0 ]; then
+    echo "Failed on test \"./wolfssl rand -out entropy.txt 3M\""
+    exit 99
+fi
+if [ `wc -c < entropy.txt` != 3145728 ]; then
+    echo "entropy.txt is not 3M bytes"
+    exit 99
+fi
+rm -f entropy.txt
+
+./wolfssl rand -threads 4 -reseed 1M -out entropy.txt 5000000
+if [ $? != 0 ]; then
+    echo "Failed on test \"./wolfssl rand -threads 4\""
+    exit 99
+fi
+if [ `wc -c < entropy.txt` != 5000000 ]; then
+    echo "threaded entropy.txt is not 5000000 bytes"
+    exit 99
+fi
+rm -f entropy.txt
+
+# streamed base64 must decode back to the requested size
+./wolfssl rand -base64 -threads 2 -out entropy.txt 1000000
+if [ $? != 0 ]; then
+    echo "Failed on test \"./wolfssl rand -base64 -threads 2\""
+    exit 99
+fi
+if [ `base64 -d entropy.txt | wc -c` != 1000000 ]; then
+    echo "base64 output does not decode to 1000000 bytes"
+    exit 99
+fi
+rm -f entropy.txt
+
+./wolfssl rand -threads 0 10
+if [ $? == 0 ]; then
+    echo "Expected failure with 0 threads"
+    exit 99
+fi
+
+./wolfssl rand -threads 2x 10
+if [ $? == 0 ]; then
+    echo "Expected failure with -threads 2x"
+    exit 99
+fi
+
 echo "Done"
 
 exit 0
@@ -253,6 +253,22 @@ run_success "ca -config ca.conf -in tmp-ca.csr -out tmp.pem -md sha256 -keyfile
 run_success "req -key ./certs/server-key.pem -subj O=Sawtooth/CN=www.wolfclu.com/C=US/ST=MT/L=Bozeman/OU=org-unit -out tmp-ca.csr"
 run_fail "ca -config ca-match.conf -in tmp-ca.csr -out tmp.pem -md sha256 -keyfile ./certs/ca-key.pem"
 
+echo "Testing batch, the config and CA key are read once for both lines"
+cat << EOF > batch.txt
+# two requests signed by the same CA
+req -key ./certs/server-key.pem -subj "O=Sawtooth/CN=batch-1.wolfclu.com/C=US/ST=MT/L=Bozeman/OU=org-unit" -out batch-1.csr
+req -key ./certs/server-key.pem -subj "O=Sawtooth/CN=batch-2.wolfclu.com/C=US/ST=MT/L=Bozeman/OU=org-unit" -out batch-2.csr
+ca -config ca.conf -in batch-1.csr -out batch-1.pem -md sha256 -keyfile ./certs/ca-key.pem
+wolfssl ca -config ca.conf -in batch-2.csr -out batch-2.pem -md sha256 -keyfile ./certs/ca-key.pem
+EOF
+run_success "batch batch.txt"
+run_success "verify -CAfile ./certs/ca-cert.pem batch-1.pem"
+run_success "verify -CAfile ./certs/ca-cert.pem batch-2.pem"
+
+echo "ca -config ca.conf -in does-not-exist.csr -out batch-3.pem" > batch.txt
+run_fail "batch batch.txt"
+rm -f batch.txt batch-1.csr batch-2.csr batch-1.pem batch-2.pem batch-3.pem
+
 rm -f tmp.pm
 rm -f rand-file-test
 rm -f serial-file-test
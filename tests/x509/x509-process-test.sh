@@ -234,10 +234,43 @@ run4() {
     fail_case "-inform pem -in ca-cert.pem -outform pem -out out.txt"
 }
 
+run5() {
+    echo "TEST 5: -stats"
+    echo "TEST 5.a"
+    EXPECTED=$(./wolfssl x509 -in certs/ca-cert.pem -noout -subject)
+    OUTPUT=$(./wolfssl x509 -in certs/ca-cert.pem -noout -subject -stats 2>stats.txt)
+    if [ $? != 0 ] || [ "$OUTPUT" != "$EXPECTED" ]; then
+        echo "-stats changed the command output"
+        exit 99
+    fi
+    grep "max RSS" stats.txt > /dev/null
+    if [ $? != 0 ]; then
+        echo "Missing -stats report"
+        exit 99
+    fi
+    grep "^key " stats.txt > /dev/null
+    if [ $? != 0 ]; then
+        echo "Missing key phase in -stats report"
+        exit 99
+    fi
+    rm -f stats.txt
+
+    echo "TEST 5.b"
+    rm -f trace.json
+    ./wolfssl -stats-trace trace.json x509 -in certs/ca-cert.pem -noout 2>/dev/null
+    grep "traceEvents" trace.json > /dev/null
+    if [ $? != 0 ]; then
+        echo "Missing -stats-trace file"
+        exit 99
+    fi
+    rm -f trace.json
+}
+
 run1
 run2
 run3
 run4
+run5
 
 rm -f out.txt
 rm -f tmp.pem
@@ -0,0 +1,258 @@
+/* clu_bench.h
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef WOLFCLU_BENCH_H
+#define WOLFCLU_BENCH_H
+
+#include <wolfssl/wolfcrypt/types.h>
+
+/* minimum amount of time spent in one batch of operations before the clock
+ * is read again, in nanoseconds */
+#define WOLFCLU_BENCH_BATCH_NS 1000000
+
+/* results of one timed benchmark run */
+typedef struct WOLFCLU_BENCH_RESULT {
+    word64 ops;     /* number of operations completed */
+    word64 bytes;   /* number of bytes processed */
+    word64 ns;      /* elapsed time in nanoseconds */
+    word64 cycles;  /* elapsed cycle counter ticks, 0 if not available */
+} WOLFCLU_BENCH_RESULT;
+
+/* a single benchmarked operation, returns 0 on success */
+typedef int (*wolfCLU_BenchOp)(void* ctx);
+
+/* default number of untimed operations run before recording latencies */
+#define WOLFCLU_BENCH_WARMUP 100
+
+/* most message or AAD sizes that can be given for an AEAD sweep */
+#define WOLFCLU_BENCH_MAX_SIZES 16
+
+/* largest message or AAD size accepted for an AEAD sweep */
+#define WOLFCLU_BENCH_MAX_SWEEP_SZ MEGABYTE
+
+/* largest file size accepted for the -e2e corpus */
+#define WOLFCLU_BENCH_MAX_FILE_SZ (64 * MEGABYTE)
+
+/* default -e2e corpus, 10 bytes to 1 MB like tests/somejunk */
+#define WOLFCLU_BENCH_E2E_FILES  100
+#define WOLFCLU_BENCH_E2E_MIN_SZ 10
+#define WOLFCLU_BENCH_E2E_MAX_SZ MEGABYTE
+
+/* most files accepted for the -e2e corpus */
+#define WOLFCLU_BENCH_E2E_MAX_FILES 100000
+
+/* settings for a bench run, filled in from the command line */
+typedef struct WOLFCLU_BENCH_OPTS {
+    int timer;      /* seconds to run each test for */
+    int latency;    /* set to 1 to record per operation latency */
+    int perf;       /* set to 1 to read hardware performance counters */
+    int warmup;     /* untimed operations run before each latency run */
+    int reps;       /* number of latency runs per algorithm */
+    word32 msgSz[WOLFCLU_BENCH_MAX_SIZES];  /* AEAD message sizes */
+    int    msgSzCount;
+    word32 aadSz[WOLFCLU_BENCH_MAX_SIZES];  /* AEAD AAD sizes */
+    int    aadSzCount;
+    int    e2e;         /* set to 1 to run commands over a file corpus */
+    int    e2eFiles;    /* number of files in the corpus */
+    int    e2eKeep;     /* set to 1 to leave the corpus in place */
+    const char* e2eDir; /* where the corpus is made, NULL for the default */
+    word32 fileSz[WOLFCLU_BENCH_MAX_SIZES]; /* corpus file sizes */
+    int    fileSzCount;
+    int    fileSzRange; /* 1 if fileSz holds a minimum and maximum */
+    int    tls;             /* set to 1 to run the in-memory TLS tests */
+    const char* tlsSuite;   /* only run suites containing this, or NULL */
+    const char* tlsGroup;   /* only run groups containing this, or NULL */
+    int    all;             /* set to 1 to run every algorithm */
+} WOLFCLU_BENCH_OPTS;
+
+/* log-linear histogram sub-buckets per power of two, 2^5 keeps the error of
+ * a recorded value under about 3% */
+#define WOLFCLU_HIST_SUB_BITS  5
+#define WOLFCLU_HIST_SUB_COUNT (1 << WOLFCLU_HIST_SUB_BITS)
+#define WOLFCLU_HIST_BUCKETS   \
+    ((64 - WOLFCLU_HIST_SUB_BITS + 1) * WOLFCLU_HIST_SUB_COUNT)
+
+/* HDR style histogram of operation durations, values are in timer ticks */
+typedef struct WOLFCLU_BENCH_HIST {
+    word64 counts[WOLFCLU_HIST_BUCKETS];
+    word64 total;   /* number of values recorded */
+    word64 min;
+    word64 max;
+    double sum;     /* sum and sum of squares for the mean and stddev */
+    double sumSq;
+} WOLFCLU_BENCH_HIST;
+
+/* hardware counters read around each run with -perf */
+enum {
+    WOLFCLU_PERF_CYCLES = 0,
+    WOLFCLU_PERF_INSTR,
+    WOLFCLU_PERF_L1D_MISS,
+    WOLFCLU_PERF_LLC_MISS,
+    WOLFCLU_PERF_BR_MISS,
+    WOLFCLU_PERF_COUNT
+};
+
+/* open perf_event_open counters and the values read after the last run */
+typedef struct WOLFCLU_BENCH_PERF {
+    int    fd[WOLFCLU_PERF_COUNT];      /* -1 if the counter is unavailable */
+    word64 counts[WOLFCLU_PERF_COUNT];  /* scaled for multiplexing */
+    int    valid[WOLFCLU_PERF_COUNT];
+    int    enabled;
+} WOLFCLU_BENCH_PERF;
+
+/* opens the hardware counters for this thread, logging why if they can not
+ * be used
+ *
+ * @return WOLFCLU_SUCCESS if at least cycles and instructions are counted
+ */
+int wolfCLU_PerfOpen(WOLFCLU_BENCH_PERF* perf);
+
+/* closes any counters opened by wolfCLU_PerfOpen */
+void wolfCLU_PerfClose(WOLFCLU_BENCH_PERF* perf);
+
+/* resets and starts the counters, does nothing if perf is not enabled */
+void wolfCLU_PerfStart(WOLFCLU_BENCH_PERF* perf);
+
+/* stops the counters and reads them into perf->counts */
+void wolfCLU_PerfStop(WOLFCLU_BENCH_PERF* perf);
+
+/* returns the printable name of counter idx */
+const char* wolfCLU_PerfName(int idx);
+
+/* prints IPC, core clock and misses per KB (or per op when res has no
+ * bytes) for the counts read by the last wolfCLU_PerfStop
+ *
+ * @param label printed at the start of each line, can be NULL
+ */
+void wolfCLU_PerfReport(const WOLFCLU_BENCH_PERF* perf, const char* label,
+        const WOLFCLU_BENCH_RESULT* res);
+
+/* calibrates the cycle counter against the monotonic clock, only does the
+ * calibration work on the first call */
+void wolfCLU_TimerInit(void);
+
+/* returns a monotonic time stamp in nanoseconds */
+word64 wolfCLU_TimerNs(void);
+
+/* returns the current cycle counter value, 0 if not available */
+word64 wolfCLU_TimerCycles(void);
+
+/* returns 1 if a calibrated cycle counter is available */
+int wolfCLU_TimerHasCycles(void);
+
+/* runs op back to back for 'timer' seconds, reading the clock only between
+ * batches of operations
+ *
+ * @param op the operation to benchmark
+ * @param ctx passed to each call of op
+ * @param opSz number of bytes processed by one call of op
+ * @param timer number of seconds to run for
+ * @param res filled with the results of the run
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_benchRun(wolfCLU_BenchOp op, void* ctx, word32 opSz, int timer,
+        WOLFCLU_BENCH_RESULT* res);
+
+/* returns a time stamp in the finest unit available, cycle counter ticks
+ * when calibrated and nanoseconds otherwise */
+word64 wolfCLU_TimerTicks(void);
+
+/* converts values from wolfCLU_TimerTicks to nanoseconds */
+double wolfCLU_TimerTicksToNs(double ticks);
+
+/* resets a histogram so it can be reused */
+void wolfCLU_HistInit(WOLFCLU_BENCH_HIST* hist);
+
+/* adds one value to the histogram */
+void wolfCLU_HistRecord(WOLFCLU_BENCH_HIST* hist, word64 value);
+
+/* adds all values recorded in src to dst */
+void wolfCLU_HistMerge(WOLFCLU_BENCH_HIST* dst, const WOLFCLU_BENCH_HIST* src);
+
+/* returns the value at or below which 'pct' percent of values fall */
+word64 wolfCLU_HistPercentile(const WOLFCLU_BENCH_HIST* hist, double pct);
+
+/* runs op for 'timer' seconds timing every call into hist, after first
+ * running 'warmup' untimed calls
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_benchLatency(wolfCLU_BenchOp op, void* ctx, int timer,
+        int warmup, WOLFCLU_BENCH_HIST* hist);
+
+/* prints out the latency percentiles and spread of all runs in hist
+ *
+ * @param name the name of the algorithm benchmarked
+ * @param hist histogram holding every run
+ * @param runMeans mean latency of each run in ticks
+ * @param runP99s 99th percentile latency of each run in ticks
+ * @param reps number of entries in runMeans and runP99s
+ * @param warmup number of untimed operations before each run
+ */
+void wolfCLU_benchLatencyReport(const char* name,
+        const WOLFCLU_BENCH_HIST* hist, const double* runMeans,
+        const double* runP99s, int reps, int warmup);
+
+/* counts the algorithms named in argv, or all of them with opts->all
+ *
+ * @param opts settings from the command line
+ * @return the number of algorithms wolfCLU_benchmark would run
+ */
+int wolfCLU_benchSelected(const WOLFCLU_BENCH_OPTS* opts, int argc,
+        char** argv);
+
+/* runs the algorithms named in argv, or all of them with opts->all
+ *
+ * @param opts settings from the command line
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_benchmark(const WOLFCLU_BENCH_OPTS* opts, int argc, char** argv);
+
+/* writes a corpus of files and runs the hash, enc, dec and dgst command
+ * entry points over it, reporting files/s, MB/s and how the time of each
+ * command splits between file I/O, crypto and everything else
+ *
+ * @param opts settings from the command line, the e2e and fileSz fields
+ *        describe the corpus
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_benchE2E(const WOLFCLU_BENCH_OPTS* opts);
+
+/* pairs a client and server in memory, with no sockets, and reports full
+ * and resumed handshakes per second for each cipher suite and key exchange
+ * group, then record throughput for each of the -msgsz sizes
+ *
+ * @param opts settings from the command line, tlsSuite and tlsGroup limit
+ *        what is run
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_benchTls(const WOLFCLU_BENCH_OPTS* opts);
+
+/* prints out the throughput and cycle counts of a benchmark run
+ *
+ * @param name the name of the algorithm benchmarked
+ * @param opSz number of bytes processed by one operation
+ * @param res results from wolfCLU_benchRun
+ */
+void wolfCLU_benchReport(const char* name, word32 opSz,
+        const WOLFCLU_BENCH_RESULT* res);
+
+#endif /* WOLFCLU_BENCH_H */
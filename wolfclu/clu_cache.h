@@ -0,0 +1,83 @@
+/* clu_cache.h
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef WOLFCLU_CACHE_H
+#define WOLFCLU_CACHE_H
+
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Loaders for files that several commands in a row tend to read, such as a
+ * CA key, certificate and config file. When the calling thread has caching
+ * turned on the parsed result is kept and handed out again for as long as
+ * the file's contents stay the same. With caching off, the default, they
+ * load the file every time. */
+
+/* turns caching on or off for the calling thread, turning it off frees
+ * everything the thread has cached */
+void wolfCLU_CacheEnable(int on);
+
+/* loads a PEM private key, free with wolfSSL_EVP_PKEY_free
+ *
+ * @return the key or NULL if the file can not be read or parsed
+ */
+WOLFSSL_EVP_PKEY* wolfCLU_LoadPrivateKey(const char* path);
+
+/* loads a PEM public key, free with wolfSSL_EVP_PKEY_free */
+WOLFSSL_EVP_PKEY* wolfCLU_LoadPublicKey(const char* path);
+
+/* loads a PEM certificate, free with wolfSSL_X509_free */
+WOLFSSL_X509* wolfCLU_LoadCertificate(const char* path);
+
+/* loads a config file, free with wolfCLU_FreeConfig since a cached config is
+ * shared and must not be freed with wolfSSL_NCONF_free
+ *
+ * @param line set to the line of a syntax error
+ */
+WOLFSSL_CONF* wolfCLU_LoadConfig(const char* path, long* line);
+void wolfCLU_FreeConfig(WOLFSSL_CONF* conf);
+
+/* Public keys decoded for verifying are kept the same way, found by the
+ * SHA-256 hash of their SubjectPublicKeyInfo rather than a path, so a key
+ * used again skips decoding and setup. wolfCLU_CacheEnable turns this on
+ * too, and workers that check many signatures turn on just this. */
+
+/* turns key caching on or off for the calling thread. Calls nest, so each
+ * on needs an off, and the keys are freed by the last one */
+void wolfCLU_KeyCtxEnable(int on);
+
+/* returns the RsaKey or ecc_key for the DER public key der, decoding it only
+ * when the thread has not got it cached. Give it back with wolfCLU_KeyCtxPut
+ *
+ * @param type EVP_PKEY_RSA or EVP_PKEY_EC
+ * @return the key or NULL if der is not a public key of that type
+ */
+void* wolfCLU_KeyCtxGet(int type, const byte* der, word32 derSz);
+void  wolfCLU_KeyCtxPut(void* key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WOLFCLU_CACHE_H */
@@ -84,6 +84,16 @@
 
 #include <wolfssl/wolfcrypt/coding.h>
 
+/* per thread storage for state that commands keep while they run, so that
+ * libwolfclu and batch -j can run several commands at once */
+#if defined(__GNUC__) || defined(__clang__)
+    #define WOLFCLU_THREAD_LS __thread
+#elif defined(_MSC_VER)
+    #define WOLFCLU_THREAD_LS __declspec(thread)
+#else
+    #define WOLFCLU_THREAD_LS
+#endif
+
 #define BLOCK_SIZE 16384
 #define MEGABYTE (1024*1024)
 #define MAX_TERM_WIDTH 80
@@ -219,12 +229,6 @@ const WOLFSSL_EVP_CIPHER* wolfCLU_CipherTypeFromAlgo(int alg);
  */
 void wolfCLU_append(char* s, char c);
 
-/* interrupt function
- *
- * @param signo gets type cast to void, interrupts the loop.
- */
-void wolfCLU_stop(int signo);
-
 /* finds current time during runtime */
 double wolfCLU_getTime(void);
 
@@ -327,19 +331,30 @@ int wolfCLU_decrypt(int alg, char* mode, byte* pwdKey, byte* key, int size,
  * @param pbkVersion WOLFCLU_PBKDF2 or WOLFCLU_PBKDF1
  * @param hashType the hash type to use with key/iv generation
  * @param printOut set to 1 for debug print outs
+ * @param iter PBKDF2 iteration count, 0 for the default of 10000
+ * @param iterMs if not 0 then when encrypting the iteration count is picked
+ *        to take about this many milliseconds and is stored in the header
  */
 int wolfCLU_evp_crypto(const WOLFSSL_EVP_CIPHER* cphr, char* mode, byte* pwdKey,
         byte* key, int keySz, char* fileIn, char* fileOut, char* hexIn,
         byte* iv, int hexOut, int enc, int pbkVersion,
         const WOLFSSL_EVP_MD* hashType, int printOut, int isBase64,
-        int noSalt);
+        int noSalt, int iter, int iterMs);
 
-/* benchmarking function
+/**
+ * @brief finds the PBKDF2 iteration count that takes about 'ms' milliseconds
+ *  on this machine. The measured rate is cached in memory and in the file
+ *  named by the WOLFCLU_ITER_CACHE environment variable, or
+ *  $HOME/.wolfclu_iter_cache, so later runs do not measure again.
  *
- * @param timer a timer to be started and stopped for benchmarking purposes
- * @param option a flag to allow benchmark execution
+ * @param md the hash used with PBKDF2
+ * @param keyLen number of bytes derived
+ * @param ms the time to target in milliseconds
+ * @param iter set to the iteration count found
+ * @return WOLFCLU_SUCCESS on success
  */
-int wolfCLU_benchmark(int timer, int* option);
+int wolfCLU_PBKDF2AutoIter(const WOLFSSL_EVP_MD* md, int keyLen, int ms,
+        int* iter);
 
 /* hashing function
  *
@@ -474,6 +489,14 @@ int wolfCLU_PKCS12(int argc, char** argv);
  */
 void wolfCLU_ForceZero(void* mem, unsigned int len);
 
+/**
+ * @brief parses the whole of arg as a decimal number from min to max into
+ *  val, no sign, spaces or trailing characters are allowed
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_ParseNum(const char* arg, int min, int max, int* val);
+
 /**
  * @brief example client
  */
@@ -492,6 +515,15 @@ int wolfCLU_GetPassword(char* password, int* passwordSz, char* arg);
 int wolfCLU_Rand(int argc, char** argv);
 
 
+/**
+ * @brief fills 'out' from 'rng', splitting the request into pieces no
+ *  larger than the DRBG allows in one call
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_RandGenerate(WC_RNG* rng, byte* out, word32 sz);
+
+
 /**
  * @brief function to generate dsa params and keys
  */
@@ -503,6 +535,19 @@ int wolfCLU_DsaParamSetup(int argc, char** argv);
 int wolfCLU_DhParamSetup(int argc, char** argv);
 
 
+/* runs one command line, argv[0] is the program name and argv[1] the mode */
+typedef int (*wolfCLU_CommandFunc)(int argc, char** argv);
+
+/**
+ * @brief runs the command lines in a file, or stdin for "-", one per line in
+ *  one process. Used by the batch mode
+ *
+ * @param run runs a single line, called with the line split into argv
+ * @return WOLFCLU_SUCCESS if every line succeeded
+ */
+int wolfCLU_Batch(int argc, char** argv, wolfCLU_CommandFunc run);
+
+
 /**
  * @brief function to prompt user for password from stdin
  */
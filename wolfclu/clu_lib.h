@@ -0,0 +1,97 @@
+/* clu_lib.h
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* libwolfclu, runs wolfssl commands in process.
+ *
+ * Call wolfCLU_LibInit once, then create a WOLFCLU_CTX per caller. Each
+ * command takes the same arguments as on the command line after the command
+ * name, for example {"sha256", "-in", "file.txt"} for wolfCLU_Hash. Commands
+ * keep no state outside of the WOLFCLU_CTX and the call, so they can run on
+ * many threads at once as long as each thread uses its own WOLFCLU_CTX.
+ * Output that would go to stdout when no -out is given still goes to
+ * stdout, messages go to the callback set with wolfCLU_CTX_SetLoggingCb. */
+
+#ifndef WOLFCLU_LIB_H
+#define WOLFCLU_LIB_H
+
+#include <wolfclu/clu_error_codes.h>
+#include <wolfclu/clu_log.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(BUILDING_WOLFCLU) && (defined(__GNUC__) || defined(__clang__))
+    #define WOLFCLU_API __attribute__ ((visibility("default")))
+#elif defined(BUILDING_WOLFCLU) && defined(_MSC_VER)
+    #define WOLFCLU_API __declspec(dllexport)
+#else
+    #define WOLFCLU_API
+#endif
+
+typedef struct WOLFCLU_CTX WOLFCLU_CTX;
+
+/* initializes wolfCrypt, and checks the FIPS module when built with it
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+WOLFCLU_API int wolfCLU_LibInit(void);
+
+/* undoes wolfCLU_LibInit, once every WOLFCLU_CTX is freed */
+WOLFCLU_API void wolfCLU_LibCleanup(void);
+
+/* @return a new context logging text to stdout and stderr, NULL on failure */
+WOLFCLU_API WOLFCLU_CTX* wolfCLU_CTX_new(void);
+WOLFCLU_API void wolfCLU_CTX_free(WOLFCLU_CTX* ctx);
+
+/* sends messages to cb instead of stdout and stderr, cbCtx is passed back
+ * to it unchanged. A NULL cb goes back to stdout and stderr */
+WOLFCLU_API int wolfCLU_CTX_SetLoggingCb(WOLFCLU_CTX* ctx,
+        wolfCLU_LoggingCtxCb cb, void* cbCtx);
+
+/* as -quiet, only errors are logged */
+WOLFCLU_API int wolfCLU_CTX_SetQuiet(WOLFCLU_CTX* ctx, int quiet);
+
+/* as -logjson, format is WOLFCLU_LOG_TEXT or WOLFCLU_LOG_JSON */
+WOLFCLU_API int wolfCLU_CTX_SetLogFormat(WOLFCLU_CTX* ctx, int format);
+
+/* run a command, argv is not changed and need not be NULL terminated
+ *
+ * @return WOLFCLU_SUCCESS on success, a negative error code otherwise
+ */
+WOLFCLU_API int wolfCLU_Hash(WOLFCLU_CTX* ctx, int argc,
+        const char* const* argv);
+WOLFCLU_API int wolfCLU_Enc(WOLFCLU_CTX* ctx, int argc,
+        const char* const* argv);
+WOLFCLU_API int wolfCLU_Dgst(WOLFCLU_CTX* ctx, int argc,
+        const char* const* argv);
+WOLFCLU_API int wolfCLU_X509(WOLFCLU_CTX* ctx, int argc,
+        const char* const* argv);
+WOLFCLU_API int wolfCLU_Req(WOLFCLU_CTX* ctx, int argc,
+        const char* const* argv);
+WOLFCLU_API int wolfCLU_CA(WOLFCLU_CTX* ctx, int argc,
+        const char* const* argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WOLFCLU_LIB_H */
@@ -33,10 +33,74 @@ extern "C" {
 #define WOLFCLU_L2 2
 #define WOLFCLU_E0 -1
 
+/* output formats for logged messages */
+#define WOLFCLU_LOG_TEXT 0
+#define WOLFCLU_LOG_JSON 1
+
 typedef void (*wolfCLU_LoggingCb)(int logLevel, const char *const logMsg);
+
+/* callback with a caller supplied pointer, gets each message that would have
+ * been printed */
+typedef void (*wolfCLU_LoggingCtxCb)(void* cbCtx, int logLevel,
+        const char *const logMsg);
+
+/* logging settings. The process shares one copy unless a thread installs its
+ * own with wolfCLU_LogSetThreadConfig, the functions below change whichever
+ * copy the calling thread is using */
+typedef struct WOLFCLU_LOG_CONFIG {
+    int level;      /* highest level printed */
+    int enabled;    /* cleared by wolfCLU_OutputOFF, errors still print */
+    int quiet;
+    int format;     /* WOLFCLU_LOG_TEXT or WOLFCLU_LOG_JSON */
+    const char* command;
+    wolfCLU_LoggingCtxCb cb; /* NULL to write to stdout and stderr */
+    void* cbCtx;
+} WOLFCLU_LOG_CONFIG;
+
+/* sets cfg to the defaults: text to stdout and stderr at level 0 */
+void wolfCLU_LogConfigInit(WOLFCLU_LOG_CONFIG* cfg);
+
+/* copies the settings the calling thread logs with into cfg */
+void wolfCLU_LogConfigGet(WOLFCLU_LOG_CONFIG* cfg);
+
+/* makes the calling thread log with cfg, or with the shared settings again
+ * when cfg is NULL. cfg must stay valid until it is replaced
+ *
+ * @return the config the thread was using before, NULL for the shared one
+ */
+WOLFCLU_LOG_CONFIG* wolfCLU_LogSetThreadConfig(WOLFCLU_LOG_CONFIG* cfg);
+
 void wolfCLU_OutputON(void);
 void wolfCLU_OutputOFF(void);
 
+/* when set only errors are logged, other messages return before they are
+ * formatted */
+void wolfCLU_LogSetQuiet(int quiet);
+
+/* sets WOLFCLU_LOG_TEXT or WOLFCLU_LOG_JSON, JSON writes one object per line
+ * with a UTC time stamp, the level, the command and the message
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_LogSetFormat(int format);
+
+/* sets the command name added to JSON lines, cmd must stay valid */
+void wolfCLU_LogSetCommand(const char* cmd);
+
+/* queues messages in a lock-free ring written out by a background thread
+ * instead of writing each one as it is logged. Messages from any thread's
+ * settings are queued unless they have a callback, and keep the format and
+ * command they were logged with. wolfCLU_LogStop must be called before
+ * exiting so queued messages are not lost
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_LogStartAsync(void);
+
+/* writes out any queued messages, stops the background thread and flushes
+ * stdout and stderr */
+void wolfCLU_LogStop(void);
+
 #ifdef __GNUC__
     #define FMTCHECK __attribute__((format(printf,2,3)))
 #else
@@ -0,0 +1,74 @@
+/* clu_memstats.h
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef WOLFCLU_MEMSTATS_H
+#define WOLFCLU_MEMSTATS_H
+
+#include <wolfssl/wolfcrypt/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* heap use seen through the wolfSSL allocators */
+typedef struct WOLFCLU_MEM_STATS {
+    word64 allocs;      /* number of malloc and realloc calls */
+    word64 frees;       /* number of free calls */
+    word64 totalBytes;  /* sum of every requested size */
+    word64 curBytes;    /* bytes currently allocated */
+    word64 peakBytes;   /* most bytes allocated at any one time */
+    word64 maxAlloc;    /* largest single request */
+} WOLFCLU_MEM_STATS;
+
+/* installs counting allocators with wolfSSL_SetAllocators, must be called
+ * before wolfCrypt_Init so every allocation is seen
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_MemStatsInstall(void);
+
+/* returns 1 if the counting allocators are installed */
+int wolfCLU_MemStatsEnabled(void);
+
+/* copies the current counters into stats */
+void wolfCLU_MemStatsGet(WOLFCLU_MEM_STATS* stats);
+
+/* starts a new measurement window, its peak starts at the bytes currently
+ * allocated and its largest allocation is cleared, the totals for the whole
+ * command are not changed
+ *
+ * @param mark filled with the counters at this point
+ */
+void wolfCLU_MemStatsMark(WOLFCLU_MEM_STATS* mark);
+
+/* fills out with what happened since wolfCLU_MemStatsMark was called, the
+ * peak is reported relative to the bytes allocated at the mark */
+void wolfCLU_MemStatsSince(const WOLFCLU_MEM_STATS* mark,
+        WOLFCLU_MEM_STATS* out);
+
+/* prints the counters to stderr so that command output is not changed */
+void wolfCLU_MemStatsReport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WOLFCLU_MEMSTATS_H */
@@ -45,6 +45,9 @@ enum {
     WOLFCLU_CA,
     WOLFCLU_DSA,
     WOLFCLU_DH,
+    WOLFCLU_BATCH,
+    WOLFCLU_SIGND,
+    WOLFCLU_PKEYUTL,
 
     WOLFCLU_CONNECT,
     WOLFCLU_STARTTLS,
@@ -95,6 +98,20 @@ enum {
     WOLFCLU_HELP,
     WOLFCLU_DEBUG,
     WOLFCLU_CHECK,
+    WOLFCLU_ITER,
+    WOLFCLU_THREADS,
+    WOLFCLU_RESEED,
+    WOLFCLU_STOP_ON_ERROR,
+    WOLFCLU_SOCKET,
+    WOLFCLU_KEYID,
+    WOLFCLU_DERIVE,
+    WOLFCLU_FILELIST,
+    WOLFCLU_RECURSIVE,
+    WOLFCLU_VERIFY_MANIFEST,
+    WOLFCLU_PH,
+    WOLFCLU_NONCES,
+    WOLFCLU_MERKLE_SIGN,
+    WOLFCLU_MERKLE_VERIFY,
 
 };
 
@@ -132,5 +149,29 @@ enum {
 #define WOLFCLU_PBKDF2 2
 #define WOLFCLU_PBKDF1 1
 
+
+/* parser state for wolfCLU_GetOpt, kept by the caller instead of in the
+ * optind and optarg globals so that commands can be parsed on many threads
+ * at once */
+typedef struct WOLFCLU_GETOPT {
+    int   ind;  /* next argv entry to look at */
+    char* arg;  /* argument of the option just returned, or NULL */
+} WOLFCLU_GETOPT;
+
+/* starts parsing at argv[1] */
+void wolfCLU_GetOptInit(WOLFCLU_GETOPT* opt);
+
+/* reentrant replacement for getopt_long_only(argc, argv, "", longOpts, idx)
+ * with opterr set to 0. Options may start with "-" or "--", take their
+ * argument as "-opt=value" or as the next entry and may be shortened to any
+ * unique prefix. Entries that are not options are skipped over and argv is
+ * never reordered.
+ *
+ * @return the option's val (or 0 after setting *flag), '?' for an unknown,
+ *         ambiguous or malformed option and -1 once argv is used up
+ */
+int wolfCLU_GetOpt(WOLFCLU_GETOPT* opt, int argc, char** argv,
+        const struct option* longOpts, int* longIndex);
+
 #endif /* WOLFCLU_OPTARGS_H */
 
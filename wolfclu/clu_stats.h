@@ -0,0 +1,75 @@
+/* clu_stats.h
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef WOLFCLU_STATS_H
+#define WOLFCLU_STATS_H
+
+#include <wolfssl/wolfcrypt/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* phases time is split between with -stats, time outside of any span is
+ * counted as WOLFCLU_STAT_OTHER */
+enum {
+    WOLFCLU_STAT_OTHER = 0,
+    WOLFCLU_STAT_INIT,      /* library init and FIPS check */
+    WOLFCLU_STAT_ARGS,      /* argument parsing */
+    WOLFCLU_STAT_KEY,       /* key and certificate load and parse */
+    WOLFCLU_STAT_CRYPTO,
+    WOLFCLU_STAT_IO,        /* reading input and writing output data */
+    WOLFCLU_STAT_FORMAT,    /* printing and encoding output */
+    WOLFCLU_STAT_COUNT
+};
+
+/* starts collecting per phase statistics, called once from main
+ *
+ * @param tracePath if not NULL a Chrome trace JSON file is written here by
+ *        wolfCLU_StatsReport
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_StatsEnable(const char* tracePath);
+
+/* returns 1 if -stats was given */
+int wolfCLU_StatsEnabled(void);
+
+/* enters phase, time and I/O from now on are counted against it until
+ * wolfCLU_StatsEnd is called, spans can be nested and only the innermost
+ * one is charged
+ *
+ * @return the phase that was active, to be passed to wolfCLU_StatsEnd
+ */
+int wolfCLU_StatsBegin(int phase);
+
+/* leaves the current span and returns to prev */
+void wolfCLU_StatsEnd(int prev);
+
+/* prints wall, user and system time, bytes read and written and MB/s for
+ * each phase and the maximum RSS to stderr, then writes the trace file if
+ * one was asked for */
+void wolfCLU_StatsReport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WOLFCLU_STATS_H */
@@ -45,6 +45,10 @@ int wolfCLU_pKeyPEMtoPriKeyEnc(WOLFSSL_BIO* bio, WOLFSSL_EVP_PKEY* pkey,
 
 int wolfCLU_RSA(int argc, char** argv);
 
+/* handles the pkeyutl mode, signs, verifies, encrypts, decrypts or derives
+ * with one key for each record read */
+int wolfCLU_PkeyUtl(int argc, char** argv);
+
 int wolfCLU_pKeytoPubKey(WOLFSSL_EVP_PKEY* pkey, unsigned char** out);
 int wolfCLU_pKeytoPriKey(WOLFSSL_EVP_PKEY* pkey, unsigned char** out);
 #endif /* CLU_PKEY_H */
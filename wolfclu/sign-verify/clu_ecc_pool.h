@@ -0,0 +1,73 @@
+/* clu_ecc_pool.h
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef WOLFCLU_ECC_POOL_H
+#define WOLFCLU_ECC_POOL_H
+
+/* Most of the cost of an ECDSA signature is k*G, which does not depend on
+ * the message. A pool has a background thread compute nonces ahead of time
+ * so that signing with one is only arithmetic mod the curve order. Each
+ * nonce is used once, kept only in memory and zeroed when taken. */
+
+#if defined(HAVE_ECC) && !defined(SINGLE_THREADED)
+    #define WOLFCLU_HAVE_ECC_POOL
+#endif
+
+/* nonces kept ready by default */
+#define WOLFCLU_ECC_POOL_SIZE 64
+
+/* most nonces a pool can be asked to keep */
+#define WOLFCLU_ECC_POOL_MAX 65536
+
+typedef struct WOLFCLU_ECC_POOL WOLFCLU_ECC_POOL;
+
+#ifdef HAVE_ECC
+
+/**
+ * @brief creates a pool of size nonces for the curve of key and starts its
+ * thread. One signature is made and checked with key before it is used.
+ *
+ * @param key ECC private key, with its public part, that the pool signs for
+ * @param pool set to the new pool, free with wolfCLU_EccPoolFree
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_EccPoolNew(ecc_key* key, int size, WOLFCLU_ECC_POOL** pool);
+
+/**
+ * @brief signs hash with key using a nonce from the pool, safe to call from
+ * several threads at once with their own key
+ *
+ * @param key a key on the curve the pool was made for
+ * @param sig buffer of *sigSz bytes, set to the DER encoded signature size
+ * @return WOLFCLU_SUCCESS on success, anything else when the pool was empty
+ * or the signature could not be made, with sig left for the caller to sign
+ * the usual way
+ */
+int wolfCLU_EccPoolSign(WOLFCLU_ECC_POOL* pool, ecc_key* key,
+        const byte* hash, word32 hashSz, byte* sig, word32* sigSz);
+
+/**
+ * @brief stops the pool's thread and zeroes the nonces left
+ */
+void wolfCLU_EccPoolFree(WOLFCLU_ECC_POOL* pool);
+#endif /* HAVE_ECC */
+
+#endif /* WOLFCLU_ECC_POOL_H */
@@ -0,0 +1,83 @@
+/* clu_keycache.h
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef WOLFCLU_KEYCACHE_H
+#define WOLFCLU_KEYCACHE_H
+
+/* A key cache file holds keys that sign and verify have decoded before as
+ * the raw numbers of the key, private and public, so that a later run
+ * imports them without any ASN.1 decoding and without making the public key
+ * from the private one. An entry is found by the SHA-256 of the key file,
+ * which is still read each time so that a changed key file never matches an
+ * old entry.
+ *
+ * The file is protected with an HMAC-SHA256 keyed from a password and a
+ * random key kept in "<file>.key", made with the cache and only readable by
+ * its owner, so opening a cache costs two HMACs rather than a slow password
+ * hash on every run. The cache holds private keys unencrypted, like the key
+ * files it is made from, so it is only ever written readable by its owner.
+ * Each thread has its own open cache. */
+
+enum {
+    WOLFCLU_KEYCACHE_RSA = 1,
+    WOLFCLU_KEYCACHE_ECC,
+    WOLFCLU_KEYCACHE_ED25519
+};
+
+/* most entries kept, the oldest are dropped when a new one is added */
+#define WOLFCLU_KEYCACHE_MAX 64
+
+/**
+ * @brief opens the cache at path, or starts a new one when there is no file,
+ * for wolfCLU_KeyCacheLoad to use until wolfCLU_KeyCacheClose
+ *
+ * @param pass password the file's HMAC key is made from, with the key in
+ * "<path>.key"
+ * @return WOLFCLU_SUCCESS on success, WOLFCLU_FATAL_ERROR when the file is
+ * damaged, its key file is missing or it was written with another password
+ */
+int wolfCLU_KeyCacheOpen(const char* path, const char* pass, int passSz);
+
+/**
+ * @brief returns 1 when a cache is open
+ */
+int wolfCLU_KeyCacheOn(void);
+
+/**
+ * @brief loads the key in keyFile into key from the open cache, decoding the
+ * file and adding an entry for it when there is none
+ *
+ * @param type WOLFCLU_KEYCACHE_RSA, _ECC or _ED25519
+ * @param priv 1 when keyFile holds a private key, which is loaded along
+ * with its public key, 0 when it holds only a public key
+ * @param key an RsaKey, ecc_key or ed25519_key already initialized
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_KeyCacheLoad(const char* keyFile, int type, int priv, void* key);
+
+/**
+ * @brief writes out the cache when entries were added and closes it
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_KeyCacheClose(void);
+
+#endif /* WOLFCLU_KEYCACHE_H */
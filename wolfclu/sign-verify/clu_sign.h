@@ -44,4 +44,15 @@ int wolfCLU_sign_data_rsa(byte*, char*, word32, char*);
 int wolfCLU_sign_data_ecc(byte*, char*, word32, char*);
 int wolfCLU_sign_data_ed25519(byte*, char*, word32, char*);
 
+/* largest -context Ed25519ph and Ed25519ctx take */
+#define WOLFCLU_ED25519_MAX_CTX 255
 
+/* gets what Ed25519ph or Ed25519ctx work on from the file in: with ph set
+ * its SHA-512 hash, read a piece at a time into hash, otherwise the whole
+ * file in *data to be freed by the caller */
+int wolfCLU_ed25519_input(const char* in, int ph, byte* hash, byte** data,
+        word32* dataSz);
+
+/* signs in as Ed25519ph when ph is set, streaming it, or as Ed25519ctx */
+int wolfCLU_sign_data_ed25519ex(char* in, char* out, char* privKey, int ph,
+        const byte* ctx, byte ctxSz);
@@ -34,5 +34,68 @@ int wolfCLU_sign_verify_setup(int, char**);
  */
 int wolfCLU_dgst_setup(int argc, char** argv);
 
+/* DER DigestInfo of the largest hash, what RSA signs */
+#define WOLFCLU_DGST_ENC_SZ (WC_MAX_DIGEST_SIZE + 32)
+
+/**
+ * @brief puts a digest in the form wc_SignatureGenerateHash and
+ * wc_SignatureVerifyHash expect, which for RSA is DER encoded
+ *
+ * @param out buffer of at least WOLFCLU_DGST_ENC_SZ bytes
+ * @param outSz set to the size of out
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_DgstEncode(enum wc_HashType hashType,
+        enum wc_SignatureType sigType, const byte* digest, byte* out,
+        word32* outSz);
+
+/**
+ * @brief signs each file named in list and each file under dir, writing the
+ * signature of a file to file.sig. The key is loaded once and the files are
+ * split between threads workers.
+ *
+ * @param list file with one file name on each line, or NULL
+ * @param dir directory to walk, or NULL
+ * @param nonces ECDSA nonces to compute ahead with an ECC key, 0 for none
+ *
+ * @return WOLFCLU_SUCCESS if every file was signed
+ */
+int wolfCLU_DgstBatchSign(const char* keyFile, enum wc_HashType hashType,
+        const char* list, const char* dir, int threads, int nonces);
+
+/**
+ * @brief checks each "<data> <sig> <public key>" line of manifest, printing
+ * "<data>: OK" or "<data>: FAIL (reason)" for each in order. Each distinct
+ * key is loaded once and the entries are split between threads workers.
+ *
+ * @param ph check Ed25519 entries as Ed25519ph rather than PureEdDSA
+ *
+ * @return WOLFCLU_SUCCESS if every entry verified
+ */
+int wolfCLU_DgstBatchVerify(const char* manifest, enum wc_HashType hashType,
+        int threads, int ph);
+
+/**
+ * @brief hashes every file of in, a directory or a list of files, on threads
+ * workers into the leaves of a Merkle tree and signs its root once. The
+ * manifest written to out holds the signed root and, for each file, the
+ * sibling hashes that lead from its leaf up to the root.
+ *
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_DgstMerkleSign(const char* keyFile, enum wc_HashType hashType,
+        const char* in, const char* out, int threads);
+
+/**
+ * @brief checks data against a manifest from wolfCLU_DgstMerkleSign, hashing
+ * only data and its path up to the root before checking the signature
+ *
+ * @param data the file, named the same way as when the manifest was made
+ * @return WOLFCLU_SUCCESS if data is in the manifest and verifies
+ */
+int wolfCLU_DgstMerkleVerify(const char* keyFile, const char* manifest,
+        const char* data);
+
 #endif /* WOLFCLU_SIGN_VERIFY_H */
 
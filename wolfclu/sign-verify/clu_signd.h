@@ -0,0 +1,78 @@
+/* clu_signd.h
+ *
+ * Copyright (C) 2006-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef WOLFCLU_SIGND_H
+#define WOLFCLU_SIGND_H
+
+/* signd keeps private keys loaded and signs hashes sent to it over a Unix
+ * domain socket. Each message, in both directions, is a 4 byte big endian
+ * length followed by that many bytes.
+ *
+ * request:  version, op, key index, wc_HashType, then the hash
+ * response: status, then the signature when status is WOLFCLU_SIGND_OK
+ *
+ * A connection can be used for any number of requests. */
+
+#if !defined(USE_WINDOWS_API) && !defined(SINGLE_THREADED)
+    #define WOLFCLU_HAVE_SIGND
+#endif
+
+#define WOLFCLU_SIGND_VERSION 1
+#define WOLFCLU_SIGND_OP_SIGN 1
+
+/* bytes before the hash in a request */
+#define WOLFCLU_SIGND_REQ_HDR 4
+
+/* large enough for an 8192 bit RSA signature */
+#define WOLFCLU_SIGND_MAX_SIG 1024
+
+/* most -key options the server takes */
+#define WOLFCLU_SIGND_MAX_KEYS 16
+
+/* response status values */
+enum {
+    WOLFCLU_SIGND_OK = 0,
+    WOLFCLU_SIGND_BAD_REQUEST,
+    WOLFCLU_SIGND_BAD_KEY,      /* no key with that index */
+    WOLFCLU_SIGND_BAD_HASH,     /* unknown hash type, wrong size for it, or
+                                 * not usable with the key */
+    WOLFCLU_SIGND_SIGN_FAILED
+};
+
+/**
+ * @brief handles the signd mode, runs the server until SIGINT or SIGTERM
+ *
+ * @return WOLFCLU_SUCCESS on a clean shutdown
+ */
+int wolfCLU_SignDSetup(int argc, char** argv);
+
+/**
+ * @brief has the signd listening on path sign a hash, used by dgst -signd
+ *
+ * @param keyIdx index of the key, in the order the server was given them
+ * @param sig buffer of *sigSz bytes, at least WOLFCLU_SIGND_MAX_SIG
+ * @param sigSz set to the size of the signature
+ * @return WOLFCLU_SUCCESS on success
+ */
+int wolfCLU_SignDSign(const char* path, int keyIdx, enum wc_HashType hashType,
+        const byte* hash, word32 hashSz, byte* sig, word32* sigSz);
+
+#endif /* WOLFCLU_SIGND_H */
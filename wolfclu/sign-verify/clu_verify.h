@@ -39,3 +39,7 @@ int wolfCLU_verify_signature(char* , char*, char*, char*, int, int);
 int wolfCLU_verify_signature_rsa(byte* , char*, int, char*, int);
 int wolfCLU_verify_signature_ecc(byte*, int, byte*, int, char*, int);
 int wolfCLU_verify_signature_ed25519(byte*, int, byte*, int, char*, int);
+
+/* verifies an Ed25519ph signature when ph is set, or an Ed25519ctx one */
+int wolfCLU_verify_signature_ed25519ex(char* sigFile, char* in, char* keyPath,
+        int pubIn, int ph, const byte* ctx, byte ctxSz);